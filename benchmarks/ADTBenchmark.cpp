@@ -0,0 +1,85 @@
+//===-- ADTBenchmark.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/DiscretePDF.h"
+#include "klee/ADT/ImmutableMap.h"
+#include "klee/ADT/RNG.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+using Map = ImmutableMap<uint64_t, uint64_t>;
+
+Map buildMap(int64_t size) {
+  Map map;
+  for (int64_t i = 0; i < size; ++i)
+    map = map.insert({i * 64, i});
+  return map;
+}
+
+/// Forking a state copies its address space map, after which each fork
+/// writes to its own copy.
+void BM_ImmutableMapForkInsert(benchmark::State &state) {
+  Map base = buildMap(state.range(0));
+  uint64_t key = 1;
+  for (auto _ : state) {
+    Map fork = base;
+    for (unsigned i = 0; i < 8; ++i, key += 64)
+      fork = fork.replace({key % (state.range(0) * 64), key});
+    benchmark::DoNotOptimize(fork.size());
+  }
+}
+BENCHMARK(BM_ImmutableMapForkInsert)->RangeMultiplier(8)->Range(8, 32768);
+
+void BM_ImmutableMapLookup(benchmark::State &state) {
+  Map map = buildMap(state.range(0));
+  uint64_t key = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.lookup_previous(key));
+    key = (key + 8191) % (state.range(0) * 64);
+  }
+}
+BENCHMARK(BM_ImmutableMapLookup)->RangeMultiplier(8)->Range(8, 32768);
+
+/// The weighted random path searchers update and sample one of these on
+/// every selection.
+void BM_DiscretePDF(benchmark::State &state) {
+  RNG rng;
+  DiscretePDF<uint64_t> pdf;
+  for (int64_t i = 0; i < state.range(0); ++i)
+    pdf.insert(i, rng.getDoubleL() + 0.5);
+
+  for (auto _ : state) {
+    uint64_t item = pdf.choose(rng.getDoubleL());
+    pdf.update(item, rng.getDoubleL() + 0.5);
+  }
+}
+BENCHMARK(BM_DiscretePDF)->RangeMultiplier(8)->Range(8, 32768);
+
+void BM_DiscretePDFInsertRemove(benchmark::State &state) {
+  DiscretePDF<uint64_t> pdf;
+  for (int64_t i = 0; i < state.range(0); ++i)
+    pdf.insert(2 * i, 1.0);
+
+  uint64_t item = 1;
+  for (auto _ : state) {
+    pdf.insert(item, 1.0);
+    pdf.remove(item);
+    item = (item + 2) % (2 * state.range(0));
+  }
+}
+BENCHMARK(BM_DiscretePDFInsertRemove)->RangeMultiplier(8)->Range(8, 32768);
+
+} // namespace
@@ -0,0 +1,31 @@
+//===-- BenchmarkMain.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Config/CompileTimeInfo.h"
+#include "klee/Config/config.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <benchmark/benchmark.h>
+
+int main(int argc, char **argv) {
+  // Google Benchmark consumes its own --benchmark_* flags, the remaining ones
+  // are KLEE options (e.g. --solver-backend for the Executor)
+  benchmark::Initialize(&argc, argv);
+  llvm::cl::ParseCommandLineOptions(argc, argv, "KLEE micro-benchmarks\n");
+
+  // Recorded in the JSON output, to tell apart the runs being compared
+  benchmark::AddCustomContext("klee_version", PACKAGE_STRING);
+  benchmark::AddCustomContext("klee_revision", KLEE_BUILD_REVISION);
+  benchmark::AddCustomContext("klee_build_mode", KLEE_BUILD_MODE);
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,135 @@
+//===-- ExprBenchmark.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprBuilder.h"
+#include "klee/Expr/ExprHashMap.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+enum BuilderKind { Default, ConstantFolding, Simplifying };
+
+std::unique_ptr<ExprBuilder> createBuilder(int64_t kind) {
+  ExprBuilder *builder = createDefaultExprBuilder();
+  if (kind >= ConstantFolding)
+    builder = createConstantFoldingExprBuilder(builder);
+  if (kind >= Simplifying)
+    builder = createSimplifyingExprBuilder(builder);
+  return std::unique_ptr<ExprBuilder>(builder);
+}
+
+/// A weighted sum over the bytes of \p array, with constants that the
+/// folding builders can combine, in the shape of typical index arithmetic.
+ref<Expr> buildSum(ExprBuilder &b, const Array *array, unsigned terms) {
+  UpdateList ul(array, nullptr);
+  ref<Expr> sum = b.Constant(0, Expr::Int32);
+  for (unsigned i = 0; i < terms; ++i) {
+    ref<Expr> byte = b.ZExt(
+        b.Read(ul, b.Constant(i % array->size, Expr::Int32)), Expr::Int32);
+    sum = b.Add(b.Add(sum, b.Constant(i, Expr::Int32)),
+                b.Mul(b.Constant(i + 1, Expr::Int32), byte));
+  }
+  return b.Ult(sum, b.Constant(1000, Expr::Int32));
+}
+
+void BM_ExprBuilderChain(benchmark::State &state) {
+  ArrayCache ac;
+  const Array *array = ac.CreateArray("arr", 64);
+  std::unique_ptr<ExprBuilder> builder = createBuilder(state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(buildSum(*builder, array, 64));
+  state.SetItemsProcessed(state.iterations() * 64);
+}
+BENCHMARK(BM_ExprBuilderChain)
+    ->ArgName("builder")
+    ->Arg(Default)
+    ->Arg(ConstantFolding)
+    ->Arg(Simplifying);
+
+/// All the nodes of \p e, children first.
+void collectNodes(const ref<Expr> &e, std::vector<ref<Expr>> &nodes) {
+  for (unsigned i = 0; i < e->getNumKids(); ++i)
+    collectNodes(e->getKid(i), nodes);
+  nodes.push_back(e);
+}
+
+void BM_ExprHash(benchmark::State &state) {
+  ArrayCache ac;
+  std::unique_ptr<ExprBuilder> builder = createBuilder(Default);
+  std::vector<ref<Expr>> nodes;
+  collectNodes(buildSum(*builder, ac.CreateArray("arr", 64), 64), nodes);
+  for (auto _ : state) {
+    for (const ref<Expr> &e : nodes)
+      benchmark::DoNotOptimize(e->computeHash());
+  }
+  state.SetItemsProcessed(state.iterations() * nodes.size());
+}
+BENCHMARK(BM_ExprHash);
+
+void BM_ExprCompare(benchmark::State &state) {
+  ArrayCache ac;
+  const Array *array = ac.CreateArray("arr", 64);
+  std::unique_ptr<ExprBuilder> builder = createBuilder(Default);
+  // Structurally equal, but distinct objects, so that compare() has to
+  // descend into the whole DAG
+  ref<Expr> a = buildSum(*builder, array, state.range(0));
+  ref<Expr> b = buildSum(*builder, array, state.range(0));
+  for (auto _ : state)
+    benchmark::DoNotOptimize(a->compare(*b));
+}
+BENCHMARK(BM_ExprCompare)->RangeMultiplier(4)->Range(4, 256);
+
+void BM_ExprHashMap(benchmark::State &state) {
+  ArrayCache ac;
+  const Array *array = ac.CreateArray("arr", 64);
+  std::unique_ptr<ExprBuilder> builder = createBuilder(Default);
+  std::vector<ref<Expr>> keys;
+  for (unsigned i = 0; i < state.range(0); ++i)
+    keys.push_back(builder->Add(Expr::createTempRead(array, Expr::Int32),
+                                builder->Constant(i, Expr::Int32)));
+
+  for (auto _ : state) {
+    ExprHashMap<unsigned> map;
+    for (unsigned i = 0; i < keys.size(); ++i)
+      map.emplace(keys[i], i);
+    for (const ref<Expr> &key : keys)
+      benchmark::DoNotOptimize(map.find(key));
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_ExprHashMap)->RangeMultiplier(8)->Range(8, 4096);
+
+/// Reads at concrete indices over an update list with one symbolic write
+/// followed by a long run of concrete ones.
+void BM_ReadLongUpdateList(benchmark::State &state) {
+  ArrayCache ac;
+  const Array *array = ac.CreateArray("arr", 4096);
+  UpdateList ul(array, nullptr);
+  ul.extend(Expr::createTempRead(ac.CreateArray("index", 4), Expr::Int32),
+            ConstantExpr::create(0, Expr::Int8));
+  for (int64_t i = 0; i < state.range(0); ++i)
+    ul.extend(ConstantExpr::create(i * 7 % 4096, Expr::Int32),
+              ConstantExpr::create(i % 256, Expr::Int8));
+
+  unsigned next = 0;
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ReadExpr::create(
+        ul, ConstantExpr::create(next++ % 4096, Expr::Int32)));
+}
+BENCHMARK(BM_ReadLongUpdateList)->RangeMultiplier(8)->Range(8, 4096);
+
+} // namespace
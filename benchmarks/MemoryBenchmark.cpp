@@ -0,0 +1,166 @@
+//===-- MemoryBenchmark.cpp -----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+#define KLEE_UNITTEST
+
+#include "Core/AddressSpace.h"
+#include "Core/Context.h"
+#include "Core/ExecutionState.h"
+#include "Core/Executor.h"
+#include "Core/Memory.h"
+#include "Core/MemoryManager.h"
+#include "klee/Core/Interpreter.h"
+#include "klee/Expr/ArrayCache.h"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// Just enough of a handler to create an Executor, which symbolic-index
+/// accesses to an ObjectState need for reporting errors.
+class NullHandler : public InterpreterHandler {
+public:
+  llvm::raw_ostream &getInfoStream() const override { return llvm::nulls(); }
+  std::string getOutputFilename(const std::string &) override {
+    return "/dev/null";
+  }
+  std::unique_ptr<llvm::raw_fd_ostream>
+  openOutputFile(const std::string &) override {
+    return nullptr;
+  }
+  void incPathsCompleted() override {}
+  void incPathsExplored(std::uint32_t) override {}
+  void processTestCase(const ExecutionState &, const char *,
+                       const char *) override {}
+};
+
+Executor &getExecutor() {
+  static NullHandler handler;
+  static llvm::LLVMContext context;
+  static std::unique_ptr<Interpreter> executor;
+  if (!executor) {
+    llvm::InitializeNativeTarget();
+    executor.reset(Interpreter::create(
+        context, Interpreter::InterpreterOptions(), &handler));
+  }
+  return static_cast<Executor &>(*executor);
+}
+
+/// Shared by all benchmarks, as setting up the deterministic allocator's
+/// address ranges for each run would be wasteful.
+MemoryManager &getMemory() {
+  static ArrayCache arrayCache;
+  static MemoryManager memory(&arrayCache);
+  // Normally set up by the Executor for the module's target
+  static bool initialized = (Context::initialize(true, Expr::Int64), true);
+  (void)initialized;
+  return memory;
+}
+
+ArrayCache &getArrayCache() { return *getMemory().getArrayCache(); }
+
+constexpr unsigned objectSize = 256;
+
+ref<MemoryObject> createObject(uint64_t size) {
+  static uint64_t address = 0x10000;
+  address += size;
+  return getMemory().allocateFixed(address - size, size, nullptr);
+}
+
+void BM_ObjectStateConcrete(benchmark::State &state) {
+  ref<MemoryObject> mo = createObject(objectSize);
+  ObjectState os(mo.get());
+  os.initializeToZero();
+  for (auto _ : state) {
+    for (unsigned offset = 0; offset < objectSize; offset += 4) {
+      os.write32(offset, offset);
+      benchmark::DoNotOptimize(os.read(offset, Expr::Int32));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * objectSize / 4);
+}
+BENCHMARK(BM_ObjectStateConcrete);
+
+/// Each iteration works on a fresh copy of the object, as a forked state
+/// would, so that its update list does not grow across iterations.
+void BM_ObjectStateSymbolic(benchmark::State &state) {
+  ref<MemoryObject> mo = createObject(objectSize);
+  ObjectState base(mo.get(),
+                   getArrayCache().CreateArray("contents", objectSize));
+  const Array *array = getArrayCache().CreateArray("value", 4);
+  ref<Expr> value = Expr::createTempRead(array, Expr::Int32);
+  for (auto _ : state) {
+    ObjectState os(base);
+    for (unsigned offset = 0; offset < objectSize; offset += 4) {
+      os.write(offset, value);
+      benchmark::DoNotOptimize(os.read(objectSize - offset - 4, Expr::Int32));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * objectSize / 4);
+}
+BENCHMARK(BM_ObjectStateSymbolic);
+
+void BM_ObjectStateSymbolicIndex(benchmark::State &state) {
+  Executor &executor = getExecutor();
+  ExecutionState es;
+  ref<MemoryObject> mo = createObject(objectSize);
+  ObjectState base(mo.get());
+  base.initializeToZero();
+  ref<Expr> index = ZExtExpr::create(
+      Expr::createTempRead(getArrayCache().CreateArray("index", 1), Expr::Int8),
+      Expr::Int32);
+  std::vector<ref<Expr>> offsets;
+  for (unsigned i = 0; i < 16; ++i)
+    offsets.push_back(
+        AddExpr::create(index, ConstantExpr::create(i * 8, Expr::Int32)));
+  ref<Expr> value = ConstantExpr::create(42, Expr::Int32);
+
+  for (auto _ : state) {
+    ObjectState os(base);
+    for (const ref<Expr> &offset : offsets) {
+      os.write(executor, es, offset, value);
+      benchmark::DoNotOptimize(os.read(executor, es, offset, Expr::Int32));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * offsets.size());
+}
+BENCHMARK(BM_ObjectStateSymbolicIndex);
+
+void BM_AddressSpaceResolveOne(benchmark::State &state) {
+  AddressSpace addressSpace;
+  std::vector<const MemoryObject *> objects;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    ref<MemoryObject> mo = createObject(128);
+    addressSpace.bindObject(mo.get(), new ObjectState(mo.get()));
+    objects.push_back(mo.get());
+  }
+
+  std::vector<ref<ConstantExpr>> addresses;
+  for (int64_t i = 0; i < 1024; ++i)
+    addresses.push_back(ConstantExpr::create(
+        objects[i * 7919 % objects.size()]->address + i % 128, Expr::Int64));
+
+  unsigned next = 0;
+  for (auto _ : state) {
+    ObjectPair op;
+    benchmark::DoNotOptimize(
+        addressSpace.resolveOne(addresses[next++ % addresses.size()], op));
+  }
+}
+BENCHMARK(BM_AddressSpaceResolveOne)->RangeMultiplier(8)->Range(8, 4096);
+
+} // namespace
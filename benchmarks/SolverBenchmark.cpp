@@ -0,0 +1,161 @@
+//===-- SolverBenchmark.cpp -----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+/// Answers every query with the all-zero assignment, so that the benchmarks
+/// measure the solver layers above it rather than a core solver. The queries
+/// below are all satisfied by it.
+class ZeroSolver : public SolverImpl {
+public:
+  bool computeTruth(const Query &, bool &isValid) override {
+    isValid = false;
+    return true;
+  }
+  bool computeValue(const Query &query, ref<Expr> &result) override {
+    result = ConstantExpr::create(0, query.expr->getWidth());
+    return true;
+  }
+  bool computeInitialValues(const Query &,
+                            const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char>> &values,
+                            bool &hasSolution) override {
+    values.clear();
+    for (const Array *array : objects)
+      values.emplace_back(array->size, 0);
+    hasSolution = true;
+    return true;
+  }
+  SolverRunStatus getOperationStatusCode() override {
+    return SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+  }
+};
+
+std::unique_ptr<Solver> createZeroSolver() {
+  return std::make_unique<Solver>(std::make_unique<ZeroSolver>());
+}
+
+/// Symbolic 32-bit values, each read from an array of its own.
+std::vector<ref<Expr>> createVariables(ArrayCache &ac, unsigned n) {
+  std::vector<ref<Expr>> vars;
+  for (unsigned i = 0; i < n; ++i)
+    vars.push_back(Expr::createTempRead(
+        ac.CreateArray("v" + std::to_string(i), 4), Expr::Int32));
+  return vars;
+}
+
+ref<Expr> constant(uint64_t value) {
+  return ConstantExpr::create(value, Expr::Int32);
+}
+
+void BM_AddConstraint(benchmark::State &state) {
+  ArrayCache ac;
+  std::vector<ref<Expr>> vars = createVariables(ac, state.range(0));
+  // Every fourth constraint is an equality, which rewrites the others
+  std::vector<ref<Expr>> constraints;
+  for (unsigned i = 0; i < vars.size(); ++i) {
+    ref<Expr> sum = AddExpr::create(vars[i], vars[(i + 1) % vars.size()]);
+    constraints.push_back(i % 4 == 3 ? EqExpr::create(constant(0), vars[i])
+                                     : UltExpr::create(sum, constant(100)));
+  }
+
+  for (auto _ : state) {
+    ConstraintSet cs;
+    ConstraintManager cm(cs);
+    for (const ref<Expr> &c : constraints)
+      cm.addConstraint(c);
+    benchmark::DoNotOptimize(cs.size());
+  }
+  state.SetItemsProcessed(state.iterations() * constraints.size());
+}
+BENCHMARK(BM_AddConstraint)->RangeMultiplier(4)->Range(4, 256);
+
+void BM_SimplifyExpr(benchmark::State &state) {
+  ArrayCache ac;
+  std::vector<ref<Expr>> vars = createVariables(ac, state.range(0));
+  ConstraintSet cs;
+  ConstraintManager cm(cs);
+  ref<Expr> sum = constant(0);
+  for (unsigned i = 0; i < vars.size(); ++i) {
+    if (i % 2 == 0)
+      cm.addConstraint(EqExpr::create(constant(i), vars[i]));
+    else
+      cm.addConstraint(UltExpr::create(vars[i], constant(100)));
+    sum = AddExpr::create(sum, vars[i]);
+  }
+  ref<Expr> e = UltExpr::create(sum, constant(1000));
+
+  for (auto _ : state)
+    benchmark::DoNotOptimize(ConstraintManager::simplifyExpr(cs, e));
+}
+BENCHMARK(BM_SimplifyExpr)->RangeMultiplier(4)->Range(4, 256);
+
+/// The query depends on a single one of many unrelated constraints, which the
+/// independent solver has to find.
+void BM_IndependentSolver(benchmark::State &state) {
+  ArrayCache ac;
+  std::vector<ref<Expr>> vars = createVariables(ac, state.range(0));
+  ConstraintSet cs;
+  for (unsigned i = 0; i < vars.size(); ++i)
+    cs.push_back(UltExpr::create(vars[i], constant(100 + i)));
+  ref<Expr> e = EqExpr::create(vars[vars.size() / 2], constant(1));
+
+  std::unique_ptr<Solver> solver = createIndependentSolver(createZeroSolver());
+  for (auto _ : state) {
+    bool result;
+    benchmark::DoNotOptimize(solver->mustBeTrue(Query(cs, e), result));
+  }
+}
+BENCHMARK(BM_IndependentSolver)->RangeMultiplier(4)->Range(4, 1024);
+
+/// Lookups in a counterexample cache that holds assignments for the given
+/// number of constraint sets, with queries it has not seen in this form.
+void BM_CexCachingSolver(benchmark::State &state) {
+  ArrayCache ac;
+  std::vector<ref<Expr>> vars = createVariables(ac, 16);
+  std::vector<ConstraintSet> sets;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    ConstraintSet cs;
+    cs.push_back(UltExpr::create(vars[i % 16], constant(100 + i)));
+    cs.push_back(UltExpr::create(vars[(i + 5) % 16], constant(200 + i)));
+    sets.push_back(cs);
+  }
+
+  std::unique_ptr<Solver> solver = createCexCachingSolver(createZeroSolver());
+  bool result;
+  for (unsigned i = 0; i < sets.size(); ++i)
+    solver->mustBeTrue(Query(sets[i], EqExpr::create(vars[i % 16],
+                                                     constant(1))),
+                       result);
+
+  uint64_t next = 0;
+  for (auto _ : state) {
+    const ConstraintSet &cs = sets[next % sets.size()];
+    ref<Expr> e = EqExpr::create(vars[next % 16], constant(2 + next % 1000));
+    benchmark::DoNotOptimize(solver->mustBeTrue(Query(cs, e), result));
+    ++next;
+  }
+}
+BENCHMARK(BM_CexCachingSolver)->RangeMultiplier(4)->Range(16, 1024);
+
+} // namespace
@@ -0,0 +1,116 @@
+//===-- PersistentBitSet.h --------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_PERSISTENTBITSET_H
+#define KLEE_PERSISTENTBITSET_H
+
+#include "klee/ADT/ImmutableMap.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace klee {
+
+/// PersistentBitSet - A sparse set of unsigned integers whose copies share
+/// storage.
+///
+/// The integers are kept as bits of 64-bit words in an ImmutableMap from
+/// word index to word, so that only words with bits set take space. Copying
+/// a set takes constant time and inserting an integer copies the path to
+/// one word.
+class PersistentBitSet {
+  using Words = ImmutableMap<std::uint32_t, std::uint64_t>;
+
+  Words words;
+  std::size_t count = 0;
+
+public:
+  class const_iterator {
+    // The iterators of ImmutableTree are not const-correct
+    mutable Words::iterator word;
+    Words::iterator end;
+    /// The bits of the current word not yet visited
+    std::uint64_t bits = 0;
+
+    void skipEmpty() {
+      while (!bits && word != end) {
+        ++word;
+        if (word != end)
+          bits = word->second;
+      }
+    }
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::uint32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::uint32_t *;
+    using reference = std::uint32_t;
+
+    const_iterator(const Words::iterator &word, const Words::iterator &end)
+        : word(word), end(end) {
+      if (this->word != this->end)
+        bits = this->word->second;
+    }
+
+    std::uint32_t operator*() const {
+      return word->first * 64 + __builtin_ctzll(bits);
+    }
+
+    const_iterator &operator++() {
+      bits &= bits - 1;
+      skipEmpty();
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator &b) const {
+      return word == b.word && bits == b.bits;
+    }
+    bool operator!=(const const_iterator &b) const { return !(*this == b); }
+  };
+
+  bool empty() const { return count == 0; }
+  std::size_t size() const { return count; }
+
+  bool contains(std::uint32_t i) const {
+    const auto *w = words.lookup(i / 64);
+    return w && (w->second >> (i % 64) & 1);
+  }
+
+  /// Add \p i to the set, returning whether it was not in the set before.
+  bool insert(std::uint32_t i) {
+    std::uint64_t bit = std::uint64_t(1) << (i % 64);
+    const auto *w = words.lookup(i / 64);
+    if (w && (w->second & bit))
+      return false;
+    words = words.replace({i / 64, (w ? w->second : 0) | bit});
+    ++count;
+    return true;
+  }
+
+  void clear() {
+    words = Words();
+    count = 0;
+  }
+
+  const_iterator begin() const {
+    return const_iterator(words.begin(), words.end());
+  }
+  const_iterator end() const { return const_iterator(words.end(), words.end()); }
+};
+
+} // namespace klee
+
+#endif /* KLEE_PERSISTENTBITSET_H */
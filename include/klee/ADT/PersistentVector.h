@@ -0,0 +1,150 @@
+//===-- PersistentVector.h --------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_PERSISTENTVECTOR_H
+#define KLEE_PERSISTENTVECTOR_H
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+namespace klee {
+
+/// PersistentVector - An append-only vector whose copies share storage.
+///
+/// Elements are kept in immutable chunks of ChunkSize elements, which copies
+/// of a vector share, followed by a short tail of the most recent elements,
+/// which each copy owns. Copying a vector thus costs at most ChunkSize element
+/// copies, however long it is, while appending stays amortized constant time
+/// and reading an element costs one more indirection than in a std::vector.
+template <class T, unsigned ChunkSize = 32> class PersistentVector {
+  using Chunk = std::vector<T>;
+  using Chunks = std::vector<std::shared_ptr<const Chunk>>;
+
+  /// The full chunks, only modified in place while not shared
+  std::shared_ptr<Chunks> chunks;
+  std::vector<T> tail;
+
+  size_t chunkedSize() const { return chunks ? chunks->size() * ChunkSize : 0; }
+
+  void flushTail() {
+    if (!chunks)
+      chunks = std::make_shared<Chunks>();
+    else if (chunks.use_count() > 1)
+      chunks = std::make_shared<Chunks>(*chunks);
+    chunks->push_back(std::make_shared<const Chunk>(std::move(tail)));
+    tail.clear();
+    tail.reserve(ChunkSize);
+  }
+
+public:
+  using value_type = T;
+  using size_type = size_t;
+
+  class const_iterator {
+    const PersistentVector *v;
+    size_t i;
+
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T *;
+    using reference = const T &;
+
+    const_iterator() : v(nullptr), i(0) {}
+    const_iterator(const PersistentVector *v, size_t i) : v(v), i(i) {}
+
+    reference operator*() const { return (*v)[i]; }
+    pointer operator->() const { return &(*v)[i]; }
+
+    const_iterator &operator++() {
+      ++i;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator old = *this;
+      ++i;
+      return old;
+    }
+    const_iterator &operator--() {
+      --i;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator old = *this;
+      --i;
+      return old;
+    }
+
+    bool operator==(const const_iterator &b) const { return i == b.i; }
+    bool operator!=(const const_iterator &b) const { return i != b.i; }
+  };
+
+  PersistentVector() = default;
+
+  template <class InputIterator>
+  PersistentVector(InputIterator begin, InputIterator end) {
+    for (; begin != end; ++begin)
+      push_back(*begin);
+  }
+
+  bool empty() const { return !chunks && tail.empty(); }
+  size_t size() const { return chunkedSize() + tail.size(); }
+
+  const T &operator[](size_t i) const {
+    assert(i < size() && "index out of range");
+    size_t chunked = chunkedSize();
+    if (i >= chunked)
+      return tail[i - chunked];
+    return (*(*chunks)[i / ChunkSize])[i % ChunkSize];
+  }
+
+  const T &back() const {
+    assert(!empty() && "back() of empty vector");
+    return tail.empty() ? chunks->back()->back() : tail.back();
+  }
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, size()); }
+
+  void push_back(const T &value) {
+    tail.push_back(value);
+    if (tail.size() == ChunkSize)
+      flushTail();
+  }
+
+  template <class... Args> void emplace_back(Args &&...args) {
+    tail.emplace_back(std::forward<Args>(args)...);
+    if (tail.size() == ChunkSize)
+      flushTail();
+  }
+
+  void clear() {
+    chunks.reset();
+    tail.clear();
+  }
+
+  bool operator==(const PersistentVector &b) const {
+    if (size() != b.size())
+      return false;
+    // Shared chunks need not be compared element by element
+    for (size_t c = 0, e = chunks ? chunks->size() : 0; c != e; ++c)
+      if ((*chunks)[c] != (*b.chunks)[c] && *(*chunks)[c] != *(*b.chunks)[c])
+        return false;
+    return tail == b.tail;
+  }
+  bool operator!=(const PersistentVector &b) const { return !(*this == b); }
+};
+
+} // namespace klee
+
+#endif /* KLEE_PERSISTENTVECTOR_H */
@@ -0,0 +1,362 @@
+//===-- SetIndex.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SETINDEX_H
+#define KLEE_SETINDEX_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+
+/// SetIndex - A map from sets to values which answers subset and superset
+/// queries, with an optional bound on the number of sets it keeps.
+///
+/// Elements are numbered, and each set is stored as the sorted vector of its
+/// element ids together with a 64-bit signature (the union of one bit per
+/// element), which rules out most non-matching candidates in one comparison.
+///
+/// - For superset queries, every element has a posting list of the sets
+///   containing it. A superset of the query must be in the posting list of
+///   each query element, so only the shortest of these lists is scanned.
+/// - For subset queries, each set is filed under a single representative
+///   element, the rarest one when the set was inserted. A subset of the query
+///   must have its representative among the query elements, so only the sets
+///   filed under those are scanned, each set at most once.
+///
+/// If a maximum size is set, inserting into a full index evicts the least
+/// recently used set, where a set is used by inserting it or by any lookup
+/// that returns it.
+template <class K, class V, class Hash = std::hash<K>,
+          class Equal = std::equal_to<K>>
+class SetIndex {
+  static constexpr uint32_t none = ~0u;
+
+  struct Element {
+    K key;
+    uint64_t bit = 0;
+    /// The sets containing this element.
+    std::vector<uint32_t> sets;
+    /// The sets with this element as their representative.
+    std::vector<uint32_t> represented;
+  };
+
+  struct Entry {
+    std::vector<uint32_t> elements;
+    /// Where this set is in the posting list of each of its elements, so it
+    /// can be removed from them without searching.
+    std::vector<uint32_t> positions;
+    uint64_t signature = 0;
+    uint64_t hash = 0;
+    uint32_t representative = none;
+    uint32_t representedPosition = none;
+    /// Neighbours in the LRU list, towards the most and least recently used.
+    uint32_t newer = none, older = none;
+    V value;
+  };
+
+  std::vector<Element> elements;
+  std::vector<uint32_t> freeElements;
+  std::unordered_map<K, uint32_t, Hash, Equal> elementIds;
+
+  std::vector<Entry> entries;
+  std::vector<uint32_t> freeEntries;
+  std::unordered_multimap<uint64_t, uint32_t> entriesByHash;
+  uint32_t newest = none, oldest = none;
+  size_t numEntries = 0;
+  size_t maxEntries;
+
+  /// A query, translated to element ids.
+  struct Key {
+    std::vector<uint32_t> elements;
+    uint64_t signature = 0;
+    /// Whether some element of the query set is not in the index.
+    bool hasUnknown = false;
+  };
+
+  static uint64_t mix(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+  }
+
+  static uint64_t hashElements(const std::vector<uint32_t> &ids) {
+    uint64_t h = ids.size();
+    for (uint32_t id : ids)
+      h = mix(h ^ (id + 0x9e3779b97f4a7c15ULL));
+    return h;
+  }
+
+  Key makeKey(const std::set<K> &set) const {
+    Key key;
+    key.elements.reserve(set.size());
+    for (const K &k : set) {
+      auto it = elementIds.find(k);
+      if (it == elementIds.end()) {
+        key.hasUnknown = true;
+        continue;
+      }
+      key.elements.push_back(it->second);
+      key.signature |= elements[it->second].bit;
+    }
+    std::sort(key.elements.begin(), key.elements.end());
+    return key;
+  }
+
+  uint32_t getElementId(const K &k) {
+    auto it = elementIds.find(k);
+    if (it != elementIds.end())
+      return it->second;
+    uint32_t id;
+    if (freeElements.empty()) {
+      id = elements.size();
+      elements.emplace_back();
+    } else {
+      id = freeElements.back();
+      freeElements.pop_back();
+    }
+    Element &e = elements[id];
+    e.key = k;
+    e.bit = uint64_t(1) << (mix(id) & 63);
+    elementIds.emplace(k, id);
+    return id;
+  }
+
+  /// Return where the posting list of element \p id holds entry \p index.
+  uint32_t &positionIn(uint32_t index, uint32_t id) {
+    Entry &e = entries[index];
+    auto it = std::lower_bound(e.elements.begin(), e.elements.end(), id);
+    assert(it != e.elements.end() && *it == id && "inconsistent set index");
+    return e.positions[it - e.elements.begin()];
+  }
+
+  void unlink(uint32_t index) {
+    Entry &e = entries[index];
+    (e.newer == none ? newest : entries[e.newer].older) = e.older;
+    (e.older == none ? oldest : entries[e.older].newer) = e.newer;
+    e.newer = e.older = none;
+  }
+
+  void linkNewest(uint32_t index) {
+    Entry &e = entries[index];
+    e.older = newest;
+    e.newer = none;
+    (newest == none ? oldest : entries[newest].newer) = index;
+    newest = index;
+  }
+
+  V *use(uint32_t index) {
+    if (newest != index) {
+      unlink(index);
+      linkNewest(index);
+    }
+    return &entries[index].value;
+  }
+
+  uint32_t findExact(const Key &key) const {
+    if (key.hasUnknown)
+      return none;
+    auto range = entriesByHash.equal_range(hashElements(key.elements));
+    for (auto it = range.first; it != range.second; ++it)
+      if (entries[it->second].elements == key.elements)
+        return it->second;
+    return none;
+  }
+
+  /// Remove the entry at \p index, appending its value to \p evicted.
+  void remove(uint32_t index, std::vector<V> *evicted) {
+    Entry &e = entries[index];
+    unlink(index);
+    auto range = entriesByHash.equal_range(e.hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == index) {
+        entriesByHash.erase(it);
+        break;
+      }
+    }
+    // Lists are unordered, so the last entry takes the place of the removed
+    if (e.representative != none) {
+      std::vector<uint32_t> &list = elements[e.representative].represented;
+      uint32_t moved = list.back();
+      list[e.representedPosition] = moved;
+      entries[moved].representedPosition = e.representedPosition;
+      list.pop_back();
+    }
+    for (size_t i = 0; i < e.elements.size(); ++i) {
+      uint32_t id = e.elements[i];
+      Element &element = elements[id];
+      uint32_t moved = element.sets.back();
+      element.sets[e.positions[i]] = moved;
+      positionIn(moved, id) = e.positions[i];
+      element.sets.pop_back();
+      if (element.sets.empty()) {
+        elementIds.erase(element.key);
+        element = Element();
+        freeElements.push_back(id);
+      }
+    }
+    if (evicted)
+      evicted->push_back(std::move(e.value));
+    e = Entry();
+    freeEntries.push_back(index);
+    --numEntries;
+  }
+
+public:
+  /// \param maxEntries The number of sets to keep at most, or 0 for no bound.
+  explicit SetIndex(size_t maxEntries = 0) : maxEntries(maxEntries) {}
+
+  size_t size() const { return numEntries; }
+
+  void clear() {
+    elements.clear();
+    freeElements.clear();
+    elementIds.clear();
+    entries.clear();
+    freeEntries.clear();
+    entriesByHash.clear();
+    newest = oldest = none;
+    numEntries = 0;
+  }
+
+  /// Map \p set to \p value. The values of sets evicted to make room, or the
+  /// previous value of \p set, are appended to \p removed if given. Returns
+  /// the number of sets evicted, which does not count replacing a value.
+  size_t insert(const std::set<K> &set, const V &value,
+                std::vector<V> *removed = nullptr) {
+    uint32_t existing = findExact(makeKey(set));
+    if (existing != none) {
+      if (removed)
+        removed->push_back(std::move(entries[existing].value));
+      *use(existing) = value;
+      return 0;
+    }
+    size_t evicted = 0;
+    if (maxEntries && numEntries >= maxEntries) {
+      remove(oldest, removed);
+      ++evicted;
+    }
+
+    uint32_t index;
+    if (freeEntries.empty()) {
+      index = entries.size();
+      entries.emplace_back();
+    } else {
+      index = freeEntries.back();
+      freeEntries.pop_back();
+    }
+
+    Entry &e = entries[index];
+    e.value = value;
+    e.elements.reserve(set.size());
+    for (const K &k : set)
+      e.elements.push_back(getElementId(k));
+    std::sort(e.elements.begin(), e.elements.end());
+    e.positions.reserve(e.elements.size());
+    size_t rarest = ~size_t(0);
+    for (uint32_t id : e.elements) {
+      Element &element = elements[id];
+      e.signature |= element.bit;
+      if (element.sets.size() < rarest) {
+        rarest = element.sets.size();
+        e.representative = id;
+      }
+      e.positions.push_back(element.sets.size());
+      element.sets.push_back(index);
+    }
+    if (e.representative != none) {
+      std::vector<uint32_t> &list = elements[e.representative].represented;
+      e.representedPosition = list.size();
+      list.push_back(index);
+    }
+    e.hash = hashElements(e.elements);
+    entriesByHash.emplace(e.hash, index);
+    linkNewest(index);
+    ++numEntries;
+    return evicted;
+  }
+
+  /// Return the value of \p set, or null if it is not in the index.
+  V *lookup(const std::set<K> &set) {
+    uint32_t index = findExact(makeKey(set));
+    return index == none ? nullptr : use(index);
+  }
+
+  /// Return the value of a subset of \p set that satisfies \p p, or null.
+  template <class Predicate>
+  V *findSubset(const std::set<K> &set, const Predicate &p) {
+    Key key = makeKey(set);
+    auto matches = [&](uint32_t index) {
+      const Entry &e = entries[index];
+      return e.elements.size() <= key.elements.size() &&
+             (e.signature & ~key.signature) == 0 &&
+             std::includes(key.elements.begin(), key.elements.end(),
+                           e.elements.begin(), e.elements.end()) &&
+             p(e.value);
+    };
+
+    // The empty set is a subset of everything
+    uint32_t empty = findExact(Key());
+    if (empty != none && matches(empty))
+      return use(empty);
+    for (uint32_t id : key.elements)
+      for (uint32_t index : elements[id].represented)
+        if (matches(index))
+          return use(index);
+    return nullptr;
+  }
+
+  /// Return the value of a superset of \p set that satisfies \p p, or null.
+  template <class Predicate>
+  V *findSuperset(const std::set<K> &set, const Predicate &p) {
+    Key key = makeKey(set);
+    if (key.hasUnknown)
+      return nullptr;
+    auto matches = [&](uint32_t index) {
+      const Entry &e = entries[index];
+      return e.elements.size() >= key.elements.size() &&
+             (key.signature & ~e.signature) == 0 &&
+             std::includes(e.elements.begin(), e.elements.end(),
+                           key.elements.begin(), key.elements.end()) &&
+             p(e.value);
+    };
+
+    if (key.elements.empty()) {
+      for (uint32_t index = newest; index != none; index = entries[index].older)
+        if (matches(index))
+          return use(index);
+      return nullptr;
+    }
+
+    const std::vector<uint32_t> *candidates = nullptr;
+    for (uint32_t id : key.elements)
+      if (!candidates || elements[id].sets.size() < candidates->size())
+        candidates = &elements[id].sets;
+    for (uint32_t index : *candidates)
+      if (matches(index))
+        return use(index);
+    return nullptr;
+  }
+
+  /// Call \p f on all values, from the most to the least recently used.
+  template <class Function> void forEach(const Function &f) const {
+    for (uint32_t index = newest; index != none; index = entries[index].older)
+      f(entries[index].value);
+  }
+};
+
+} // namespace klee
+
+#endif /* KLEE_SETINDEX_H */
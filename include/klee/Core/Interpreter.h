@@ -47,6 +47,11 @@ public:
   virtual void processTestCase(const ExecutionState &state,
                                const char *err,
                                const char *suffix) = 0;
+
+  /// Called once execution has reached the snapshot function (see
+  /// InterpreterOptions::SnapshotFunction). Returning false ends the run
+  /// without exploring any further.
+  virtual bool snapshotReached() { return true; }
 };
 
 class Interpreter {
@@ -60,6 +65,12 @@ public:
     bool Optimize;
     bool CheckDivZero;
     bool CheckOvershift;
+    /// Path prefix of the module cache entry for this run, or empty if the
+    /// prepared module is not cached.
+    std::string ModuleCache;
+    /// True if the modules passed to setModule are the cached, already
+    /// prepared module, so linking and preparation are skipped.
+    bool FromModuleCache = false;
 
     ModuleOptions(const std::string &_LibraryDir,
                   const std::string &_EntryPoint, const std::string &_OptSuffix,
@@ -84,6 +95,11 @@ public:
     /// symbolic execution on concrete programs.
     unsigned MakeConcreteSymbolic;
 
+    /// If set, the initial state runs on its own until it enters the function
+    /// of this name, at which point InterpreterHandler::snapshotReached is
+    /// called before exploration continues.
+    std::string SnapshotFunction;
+
     InterpreterOptions()
       : MakeConcreteSymbolic(false)
     {}
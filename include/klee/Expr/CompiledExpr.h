@@ -0,0 +1,119 @@
+//===-- CompiledExpr.h ------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_COMPILEDEXPR_H
+#define KLEE_COMPILEDEXPR_H
+
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+
+/// CompiledExpr - A list of expressions lowered to a flat, register-based
+/// program, for evaluating the same expressions under many assignments.
+///
+/// Shared subexpressions are computed once per evaluation and each array is
+/// looked up once in the assignment's bindings instead of once per read.
+/// Expressions wider than 64 bits, as well as evaluations that cannot produce
+/// a constant (division by zero, reads of free values), fall back to
+/// Assignment::evaluate, so results always match the interpreter.
+class CompiledExpr {
+public:
+  explicit CompiledExpr(const ref<Expr> &e);
+
+  template <typename InputIterator>
+  CompiledExpr(InputIterator begin, InputIterator end) {
+    for (; begin != end; ++begin)
+      addRoot(*begin);
+  }
+
+  /// Return the number of compiled expressions.
+  unsigned size() const { return roots.size(); }
+
+  /// Evaluate the \p i-th expression under assignment \p a.
+  ref<Expr> evaluate(const Assignment &a, unsigned i = 0) const;
+
+  /// Evaluate every expression under assignment \p a, in order.
+  void evaluate(const Assignment &a, std::vector<ref<Expr>> &results) const;
+
+  /// Evaluate every expression under each of \p assignments at once. The
+  /// value of expression i under assignment a is stored at index
+  /// a * size() + i of \p results.
+  void evaluate(const std::vector<const Assignment *> &assignments,
+                std::vector<ref<Expr>> &results) const;
+
+  /// Return true if every expression evaluates to true under \p a.
+  bool satisfies(const Assignment &a) const;
+
+private:
+  struct Instruction {
+    Expr::Kind kind;
+    Expr::Width width;
+    unsigned dst;
+    unsigned a, b, c;
+  };
+
+  /// An update list node; `next` is the index of the older update, or -1.
+  struct Update {
+    unsigned index;
+    unsigned value;
+    int next;
+  };
+
+  struct Root {
+    ref<Expr> expr;
+    unsigned reg;
+    /// Number of instructions that have to run to compute this root.
+    unsigned end;
+    bool compiled;
+  };
+
+  void addRoot(const ref<Expr> &e);
+  unsigned compile(const ref<Expr> &e);
+  int compileUpdates(const UpdateNode *un);
+  unsigned emit(const Expr &e, unsigned a, unsigned b = 0, unsigned c = 0);
+  unsigned getArraySlot(const Array *array);
+
+  /// Execute the first \p end instructions under \p a. Returns false if some
+  /// value cannot be computed concretely.
+  bool run(const Assignment &a, unsigned end) const;
+
+  /// Execute the first \p end instructions for \p n assignments side by side.
+  /// Register i of lane l lives at r[i * n + l]; lanes that cannot be
+  /// computed concretely are flagged in \p failed.
+  void execute(const Assignment *const *assignments, unsigned n, unsigned end,
+               uint64_t *r, unsigned char *failed) const;
+
+  std::vector<Instruction> code;
+  std::vector<Update> updates;
+  std::vector<const Array *> arrays;
+  std::vector<Root> roots;
+
+  ExprHashMap<unsigned> registerOf;
+  std::unordered_map<const UpdateNode *, int> updateOf;
+  std::unordered_map<const Array *, unsigned> slotOf;
+  /// Set when the expression being compiled is not supported.
+  bool failed = false;
+
+  /// Constants are preloaded; every other register is written by exactly one
+  /// instruction.
+  mutable std::vector<uint64_t> registers;
+  mutable std::vector<const std::vector<unsigned char> *> bindings;
+  mutable std::vector<uint64_t> lanes;
+  mutable std::vector<unsigned char> failedLanes;
+};
+
+} // namespace klee
+
+#endif /* KLEE_COMPILEDEXPR_H */
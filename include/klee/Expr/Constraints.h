@@ -10,18 +10,20 @@
 #ifndef KLEE_CONSTRAINTS_H
 #define KLEE_CONSTRAINTS_H
 
+#include "klee/ADT/PersistentVector.h"
 #include "klee/Expr/Expr.h"
 
 namespace klee {
 
 /// Resembles a set of constraints that can be passed around
 ///
+/// Copies of a set share most of their storage, so that copying the
+/// constraints of a state when it forks is cheap.
 class ConstraintSet {
   friend class ConstraintManager;
 
 public:
-  using constraints_ty = std::vector<ref<Expr>>;
-  using iterator = constraints_ty::iterator;
+  using constraints_ty = PersistentVector<ref<Expr>>;
   using const_iterator = constraints_ty::const_iterator;
 
   using constraint_iterator = const_iterator;
@@ -31,7 +33,8 @@ public:
   constraint_iterator end() const;
   size_t size() const noexcept;
 
-  explicit ConstraintSet(constraints_ty cs) : constraints(std::move(cs)) {}
+  explicit ConstraintSet(const std::vector<ref<Expr>> &cs)
+      : constraints(cs.begin(), cs.end()) {}
   ConstraintSet() = default;
 
   void push_back(const ref<Expr> &e);
@@ -11,6 +11,7 @@
 #define KLEE_EXPR_H
 
 #include "klee/ADT/Bits.h"
+#include "klee/ADT/ImmutableMap.h"
 #include "klee/ADT/Ref.h"
 
 #include "klee/Support/CompilerWarning.h"
@@ -473,13 +474,30 @@ public:
 private:
   /// size of this update sequence, including this update
   unsigned size;
-  
+
+  /// the most recent update in this sequence, including this update, whose
+  /// index is not a constant, or null if there is none
+  UpdateNode *lastSymbolic;
+
+  /// number of updates from this one down to lastSymbolic (excluded)
+  unsigned concreteWrites;
+
+  /// the most recent of those updates for each index, only maintained once
+  /// they are numerous enough to be worth it
+  ImmutableMap<uint64_t, UpdateNode *> concreteIndex;
+
 public:
   UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
              const ref<Expr> &_value);
 
   unsigned getSize() const { return size; }
 
+  /// Return the most recent update in this sequence, including this update,
+  /// that may write to the concrete \p index: either the latest write to
+  /// exactly that index, or the latest write to a symbolic index, whichever
+  /// comes first. Returns null if there is no such update.
+  UpdateNode *findWrite(uint64_t index);
+
   int compare(const UpdateNode &b) const;  
   unsigned hash() const { return hashValue; }
 
@@ -0,0 +1,61 @@
+//===-- IntervalEvaluator.h -------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_INTERVALEVALUATOR_H
+#define KLEE_INTERVALEVALUATOR_H
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+
+#include <cstdint>
+
+namespace klee {
+
+/// IntervalEvaluator - Computes conservative unsigned bounds for expressions
+/// of at most 64 bits without invoking a solver.
+///
+/// Bounds are derived bottom-up from the structure of the expression and are
+/// tightened with every constraint that compares a subexpression against a
+/// constant. Any value the expression may take under the constraints is
+/// guaranteed to lie inside the computed interval.
+class IntervalEvaluator {
+public:
+  struct Interval {
+    uint64_t min;
+    uint64_t max;
+
+    /// Return true if some value in [lo, hi] may lie inside the interval.
+    bool intersects(uint64_t lo, uint64_t hi) const {
+      return lo <= max && min <= hi;
+    }
+  };
+
+  IntervalEvaluator() = default;
+  explicit IntervalEvaluator(const ConstraintSet &constraints);
+
+  /// Record the bounds implied by constraint \p e.
+  void addConstraint(const ref<Expr> &e);
+
+  /// Return bounds for \p e, which must be at most 64 bits wide.
+  Interval evaluate(const ref<Expr> &e);
+
+private:
+  Interval evaluateUncached(const ref<Expr> &e);
+  void addNegatedConstraint(const ref<Expr> &e);
+  void restrict(const ref<Expr> &e, uint64_t min, uint64_t max);
+
+  /// Bounds stated directly by the constraints.
+  ExprHashMap<Interval> known;
+  ExprHashMap<Interval> cache;
+};
+
+} // namespace klee
+
+#endif /* KLEE_INTERVALEVALUATOR_H */
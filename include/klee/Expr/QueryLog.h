@@ -0,0 +1,135 @@
+//===-- QueryLog.h ----------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_QUERYLOG_H
+#define KLEE_QUERYLOG_H
+
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace klee {
+class ArrayCache;
+class ExprBuilder;
+
+/// A solver query as recorded in a binary query log, together with the
+/// outcome the logging solver observed for it.
+struct LoggedQuery {
+  enum Kind : uint8_t { Truth, Validity, Value, InitialValues };
+
+  Kind kind = Truth;
+  std::vector<ref<Expr>> constraints;
+  ref<Expr> expr;
+  /// The arrays to compute values for (InitialValues queries only).
+  std::vector<const Array *> objects;
+
+  bool success = false;
+  /// The SolverImpl::SolverRunStatus of the underlying solver.
+  unsigned status = 0;
+  /// Results, depending on the kind. Only meaningful if success is set.
+  bool isValid = false;
+  int validity = 0;
+  ref<Expr> value;
+  bool hasSolution = false;
+  std::vector<std::vector<unsigned char>> values;
+
+  uint64_t instructions = 0;
+  uint64_t elapsedMicroseconds = 0;
+};
+
+/// QueryLogWriter - Encodes queries into the binary query log format.
+///
+/// Expressions, update nodes and arrays are hash-consed: each is written
+/// once, the first time a query refers to it, and referenced by index
+/// afterwards, so the constraints shared by consecutive queries cost a few
+/// bytes per query. To bound the memory the tables keep alive, they are
+/// cleared (in both the writer and the reader) once more than a given number
+/// of expressions has been written.
+class QueryLogWriter {
+  std::string &out;
+  const unsigned maxTableSize;
+
+  ExprHashMap<uint32_t> exprIds;
+  std::unordered_map<const UpdateNode *, uint32_t> updateIds;
+  /// Keeps the nodes in updateIds alive, so their addresses are not reused.
+  std::vector<ref<UpdateNode>> updates;
+  std::unordered_map<const Array *, uint32_t> arrayIds;
+
+  void writeVarint(uint64_t value);
+  void writeExprRef(const ref<Expr> &e);
+  void writeConstant(const ConstantExpr &ce);
+  void define(const ref<Expr> &e);
+  void define(const UpdateList &ul);
+  void define(const Array *array);
+
+public:
+  /// Append the log header to \p out, which receives all further records.
+  /// The owner may take the bytes appended to \p out at any time.
+  explicit QueryLogWriter(std::string &out, unsigned maxTableSize = 1u << 20);
+
+  void write(const LoggedQuery &query);
+};
+
+/// QueryLogReader - Decodes a binary query log one query at a time, without
+/// holding more of the input in memory than the definitions it refers to.
+class QueryLogReader {
+public:
+  /// Read up to the given number of bytes into the buffer, returning the
+  /// number read, 0 at the end of the input or a negative value on error.
+  using ReadFn = std::function<long(char *, size_t)>;
+
+private:
+  ReadFn read;
+  ExprBuilder *builder;
+  ArrayCache &arrayCache;
+
+  std::vector<char> buffer;
+  size_t pos = 0, end = 0;
+  std::string error;
+
+  std::vector<ref<Expr>> exprs;
+  std::vector<ref<UpdateNode>> updates;
+  std::vector<const Array *> arrays;
+
+  bool fill();
+  bool readByte(uint8_t &byte);
+  bool readVarint(uint64_t &value);
+  bool readBytes(void *dst, size_t size);
+  bool readExprRef(ref<Expr> &e);
+  bool readArrayRef(const Array *&array);
+  bool readConstant(ref<Expr> &e);
+  bool readExpr(unsigned kind);
+  bool readArray();
+  bool readUpdate();
+  bool readQuery(LoggedQuery &query);
+  bool fail(const std::string &message);
+
+public:
+  QueryLogReader(ReadFn read, ExprBuilder *builder, ArrayCache &arrayCache);
+
+  /// Return true if \p data starts like a binary query log.
+  static bool hasMagic(const char *data, size_t size);
+
+  /// Check the header. Must be called before the first call to next().
+  bool readHeader();
+
+  /// Read the next query. Returns false at the end of the log or on error;
+  /// getError() tells them apart.
+  bool next(LoggedQuery &query);
+
+  const std::string &getError() const { return error; }
+};
+} // namespace klee
+
+#endif /* KLEE_QUERYLOG_H */
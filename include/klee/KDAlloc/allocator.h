@@ -25,12 +25,17 @@
 #include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
 #include <ostream>
 #include <type_traits>
 
 namespace klee::kdalloc {
 /// Wraps a mapping and delegates allocation to one of 8 sized-bin slot
 /// allocators (size < 4096) or a large object allocator (size >= 4096).
+///
+/// Copies of an allocator share their state copy-on-write and return the same
+/// addresses for the same sequence of requests. Allocators sharing state may
+/// only be used concurrently if `KDALLOC_THREAD_SAFE` is set.
 class Allocator final : public TaggedLogger<Allocator> {
 public:
   class Control final {
@@ -96,8 +101,17 @@ public:
   static constexpr const auto unlimitedQuarantine =
       Control::unlimitedQuarantine;
 
+  /// The control structure is shared by all allocators of a factory. With
+  /// `KDALLOC_THREAD_SAFE`, allocators may be copied and destroyed by different
+  /// threads, which requires an atomic reference count.
+#if KDALLOC_THREAD_SAFE
+  using ControlPtr = std::shared_ptr<Control>;
+#else
+  using ControlPtr = klee::ref<Control>;
+#endif
+
 private:
-  klee::ref<Control> control;
+  ControlPtr control;
 
   std::array<std::aligned_union_t<0, suballocators::SlotAllocator<false>,
                                   suballocators::SlotAllocator<true>>,
@@ -249,13 +263,13 @@ public:
     return *this;
   }
 
-  Allocator(klee::ref<Control> control) : control(std::move(control)) {
+  Allocator(ControlPtr control) : control(std::move(control)) {
     initializeSizedBins();
   }
 
   ~Allocator() { destroySizedBins(); }
 
-  explicit operator bool() const noexcept { return !control.isNull(); }
+  explicit operator bool() const noexcept { return !!control; }
 
   Mapping &getMapping() noexcept {
     assert(!!*this && "Cannot get mapping of uninitialized allocator.");
@@ -402,7 +416,7 @@ public:
       Allocator::Control::unlimitedQuarantine;
 
 private:
-  klee::ref<Allocator::Control> control;
+  Allocator::ControlPtr control;
 
 public:
   AllocatorFactory() = default;
@@ -420,7 +434,8 @@ public:
                  Allocator::Control::meta.size() * 4096 + 3 * 4096 &&
              "Mapping is *far* too small");
 
-      control = new Allocator::Control(std::move(mapping));
+      control =
+          Allocator::ControlPtr(new Allocator::Control(std::move(mapping)));
       auto const binSize =
           static_cast<std::size_t>(1)
           << (std::numeric_limits<std::size_t>::digits - 1 -
@@ -447,7 +462,7 @@ public:
     }
   }
 
-  explicit operator bool() const noexcept { return !control.isNull(); }
+  explicit operator bool() const noexcept { return !!control; }
 
   Mapping &getMapping() noexcept {
     assert(!!*this && "Cannot get mapping of uninitialized factory.");
@@ -14,4 +14,11 @@
 #define KDALLOC_TRACE 0
 #endif
 
+/// When set, allocators that share copy-on-write state (i.e., that were copied
+/// from one another) may be used concurrently from different threads, as long
+/// as each allocator object itself is only used by one thread at a time.
+#ifndef KDALLOC_THREAD_SAFE
+#define KDALLOC_THREAD_SAFE 0
+#endif
+
 #endif
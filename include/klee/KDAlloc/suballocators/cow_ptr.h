@@ -10,6 +10,8 @@
 #ifndef KDALLOC_UTIL_COW_H
 #define KDALLOC_UTIL_COW_H
 
+#include "reference_count.h"
+
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
@@ -35,8 +37,8 @@ public:
 
   CoWPtr(CoWPtr const &other) noexcept : ptr(other.ptr) {
     if (ptr != nullptr) {
-      ++ptr->referenceCount;
-      assert(ptr->referenceCount > 1);
+      refcount::increment(ptr->referenceCount);
+      assert(refcount::load(ptr->referenceCount) > 1);
     }
   }
 
@@ -46,8 +48,8 @@ public:
 
       ptr = other.ptr;
       if (ptr != nullptr) {
-        ++ptr->referenceCount;
-        assert(ptr->referenceCount > 1);
+        refcount::increment(ptr->referenceCount);
+        assert(refcount::load(ptr->referenceCount) > 1);
       }
     }
     return *this;
@@ -81,7 +83,7 @@ public:
   /// Returns `true` iff `*this` is not in an empty state and owns the CoW
   /// object.
   [[nodiscard]] bool isOwned() const noexcept {
-    return ptr != nullptr && ptr->referenceCount == 1;
+    return ptr != nullptr && refcount::load(ptr->referenceCount) == 1;
   }
 
   /// Accesses an existing object.
@@ -114,11 +116,14 @@ public:
   T &acquire() {
     assert(ptr != nullptr &&
            "May only call `acquire` for an active CoW object");
-    assert(ptr->referenceCount > 0);
-    if (ptr->referenceCount > 1) {
-      --ptr->referenceCount;
-      ptr = new Wrapper{*ptr};
-      ptr->referenceCount = 1;
+    assert(refcount::load(ptr->referenceCount) > 0);
+    if (refcount::load(ptr->referenceCount) > 1) {
+      auto *const shared = ptr;
+      ptr = new Wrapper(1, shared->data);
+      // the other owners may have released `shared` in the meantime
+      if (refcount::decrement(shared->referenceCount) == 0) {
+        delete shared;
+      }
     }
     assert(ptr->referenceCount == 1);
     return ptr->data;
@@ -128,8 +133,7 @@ public:
   /// does not exist. Leaves `*this` in an empty state.
   void release() noexcept(noexcept(delete ptr)) {
     if (ptr != nullptr) {
-      --ptr->referenceCount;
-      if (ptr->referenceCount == 0) {
+      if (refcount::decrement(ptr->referenceCount) == 0) {
         delete ptr;
       }
       ptr = nullptr;
@@ -142,14 +146,15 @@ public:
   /// than the otherwise equivalent `foo = CoWPtr(CoWPtr::in_place_t{}, ...)`.
   template <typename... V> T &emplace(V &&...args) {
     if (ptr) {
-      if (ptr->referenceCount == 1) {
+      if (refcount::load(ptr->referenceCount) == 1) {
         ptr->data = T(std::forward<V>(args)...);
       } else {
         auto *new_ptr = new Wrapper(
             1, std::forward<V>(args)...); // possibly throwing operation
 
-        assert(ptr->referenceCount > 1);
-        --ptr->referenceCount;
+        if (refcount::decrement(ptr->referenceCount) == 0) {
+          delete ptr;
+        }
         ptr = new_ptr;
       }
     } else {
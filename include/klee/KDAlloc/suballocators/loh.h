@@ -13,6 +13,7 @@
 #include "../define.h"
 #include "../location_info.h"
 #include "../tagged_logger.h"
+#include "reference_count.h"
 #include "sized_regions.h"
 
 #include "klee/ADT/Bits.h"
@@ -113,8 +114,7 @@ private:
 
   inline void releaseData() noexcept {
     if (data) {
-      --data->referenceCount;
-      if (data->referenceCount == 0) {
+      if (refcount::decrement(data->referenceCount) == 0) {
         data->~Data();
         std::free(data);
       }
@@ -124,7 +124,7 @@ private:
 
   inline void acquireData(Control const &control) noexcept {
     assert(!!data);
-    if (data->referenceCount > 1) {
+    if (refcount::load(data->referenceCount) > 1) {
       auto newData = static_cast<Data *>(std::malloc(
           sizeof(Data) + control.quarantineSize * sizeof(std::size_t)));
       assert(newData && "allocation failure");
@@ -133,8 +133,11 @@ private:
       std::memcpy(&newData->quarantine[0], &data->quarantine[0],
                   sizeof(Data::QuarantineElement) * control.quarantineSize);
 
-      --data->referenceCount;
-      assert(data->referenceCount > 0);
+      // the other owners may have released the shared data in the meantime
+      if (refcount::decrement(data->referenceCount) == 0) {
+        data->~Data();
+        std::free(data);
+      }
       data = newData;
     }
     assert(data->referenceCount == 1);
@@ -169,8 +172,8 @@ public:
   LargeObjectAllocator(LargeObjectAllocator const &rhs) noexcept
       : data(rhs.data) {
     if (data) {
-      ++data->referenceCount;
-      assert(data->referenceCount > 1);
+      refcount::increment(data->referenceCount);
+      assert(refcount::load(data->referenceCount) > 1);
     }
   }
 
@@ -179,8 +182,8 @@ public:
       releaseData();
       data = rhs.data;
       if (data) {
-        ++data->referenceCount;
-        assert(data->referenceCount > 1);
+        refcount::increment(data->referenceCount);
+        assert(refcount::load(data->referenceCount) > 1);
       }
     }
     return *this;
@@ -189,7 +192,7 @@ public:
   LargeObjectAllocator(LargeObjectAllocator &&rhs) noexcept
       : data(std::exchange(rhs.data, nullptr)) {
     if (data) {
-      assert(data->referenceCount > 0);
+      assert(refcount::load(data->referenceCount) > 0);
     }
   }
 
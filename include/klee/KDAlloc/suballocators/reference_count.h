@@ -0,0 +1,49 @@
+//===-- reference_count.h ---------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KDALLOC_UTIL_REFERENCE_COUNT_H
+#define KDALLOC_UTIL_REFERENCE_COUNT_H
+
+#include "../define.h"
+
+#include <cstddef>
+
+namespace klee::kdalloc::suballocators::refcount {
+// Reference counts of copy-on-write objects are plain `std::size_t`s, so that
+// the objects containing them stay trivial. With `KDALLOC_THREAD_SAFE`, they
+// are accessed atomically: an object whose count is one is owned exclusively
+// and may be modified, while objects with a higher count are only read.
+
+inline void increment(std::size_t &count) noexcept {
+#if KDALLOC_THREAD_SAFE
+  __atomic_fetch_add(&count, 1, __ATOMIC_RELAXED);
+#else
+  ++count;
+#endif
+}
+
+/// Returns the count after decrementing it.
+inline std::size_t decrement(std::size_t &count) noexcept {
+#if KDALLOC_THREAD_SAFE
+  return __atomic_sub_fetch(&count, 1, __ATOMIC_ACQ_REL);
+#else
+  return --count;
+#endif
+}
+
+inline std::size_t load(std::size_t const &count) noexcept {
+#if KDALLOC_THREAD_SAFE
+  return __atomic_load_n(&count, __ATOMIC_ACQUIRE);
+#else
+  return count;
+#endif
+}
+} // namespace klee::kdalloc::suballocators::refcount
+
+#endif
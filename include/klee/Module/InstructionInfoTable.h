@@ -11,7 +11,9 @@
 #define KLEE_INSTRUCTIONINFOTABLE_H
 
 #include <cstdint>
+#include <istream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -20,9 +22,11 @@ namespace llvm {
   class Function;
   class Instruction;
   class Module; 
+  class raw_ostream;
 }
 
 namespace klee {
+  class InstructionInfoTable;
 
   /// @brief InstructionInfo stores debug information for a KInstruction.
   struct InstructionInfo {
@@ -32,15 +36,19 @@ namespace klee {
     unsigned line;
     /// @brief Column number in source file.
     unsigned column;
-    /// @brief Line number in generated assembly.ll.
-    unsigned assemblyLine;
     /// @brief Source file name.
     const std::string &file;
 
+  private:
+    const InstructionInfoTable &table;
+
   public:
     InstructionInfo(unsigned id, const std::string &file, unsigned line,
-                    unsigned column, unsigned assemblyLine)
-        : id{id}, line{line}, column{column}, assemblyLine{assemblyLine}, file{file} {}
+                    unsigned column, const InstructionInfoTable &table)
+        : id{id}, line{line}, column{column}, file{file}, table{table} {}
+
+    /// @brief Line number in generated assembly.ll.
+    unsigned getAssemblyLine() const;
   };
 
   /// @brief FunctionInfo stores debug information for a KFunction.
@@ -49,14 +57,19 @@ namespace klee {
     unsigned id;
     /// @brief Line number in source file.
     unsigned line;
-    /// @brief Line number in generated assembly.ll.
-    uint64_t assemblyLine;
     /// @brief Source file name.
     const std::string &file;
 
+  private:
+    const InstructionInfoTable &table;
+
   public:
-    FunctionInfo(unsigned id, const std::string &file, unsigned line, uint64_t assemblyLine)
-        : id{id}, line{line}, assemblyLine{assemblyLine}, file{file} {}
+    FunctionInfo(unsigned id, const std::string &file, unsigned line,
+                 const InstructionInfoTable &table)
+        : id{id}, line{line}, file{file}, table{table} {}
+
+    /// @brief Line number in generated assembly.ll.
+    uint64_t getAssemblyLine() const;
 
     FunctionInfo(const FunctionInfo &) = delete;
     FunctionInfo &operator=(FunctionInfo const &) = delete;
@@ -65,19 +78,80 @@ namespace klee {
   };
 
   class InstructionInfoTable {
-    std::unordered_map<const llvm::Instruction *,
-                       std::unique_ptr<InstructionInfo>>
+    /// The assembly lines of a function and its instructions, found when
+    /// the module is printed, and their debug information, resolved when
+    /// one of them is first asked for.
+    struct FunctionEntry {
+      const llvm::Function *function;
+      unsigned numInstructions = 0;
+      uint64_t assemblyLine = 0;
+      std::vector<unsigned> instructionLines;
+      /// ID of the first instruction; the others follow in order.
+      unsigned firstID = 0;
+      std::unique_ptr<FunctionInfo> info;
+      std::vector<InstructionInfo> infos;
+      bool resolved = false;
+
+      explicit FunctionEntry(const llvm::Function *f) : function(f) {}
+    };
+
+    const llvm::Module *module = nullptr;
+    /// Where the module goes when it is printed to find assembly lines.
+    mutable std::unique_ptr<llvm::raw_ostream> assembly;
+    mutable bool hasAssemblyLines = false;
+    mutable std::vector<FunctionEntry> entries;
+    std::unordered_map<const llvm::Function *, unsigned> entryOf;
+    mutable std::unordered_map<const llvm::Instruction *,
+                               const InstructionInfo *>
         infos;
-    std::unordered_map<const llvm::Function *, std::unique_ptr<FunctionInfo>>
-        functionInfos;
-    std::vector<std::unique_ptr<std::string>> internedStrings;
+    mutable std::vector<std::unique_ptr<std::string>> internedStrings;
+    mutable std::unordered_map<std::string, const std::string *>
+        internedIndex;
+    mutable std::mutex internLock;
+
+    InstructionInfoTable() = default;
+    void assignIDs();
+    const std::string &getInternedString(const std::string &s) const;
+    void resolve(FunctionEntry &entry) const;
+    void addInfos(FunctionEntry &entry) const;
+    FunctionEntry &getEntry(const llvm::Function &f) const;
+    FunctionEntry &getEntry(unsigned id) const;
+    void computeAssemblyLines() const;
 
   public:
-    explicit InstructionInfoTable(const llvm::Module &m);
+    /// Build the table for \p m. Finding the assembly lines takes printing
+    /// the module once; if \p assembly is given, the module is printed to
+    /// it. With \p lazyAssemblyLines, this happens when an assembly line is
+    /// first asked for, or at the latest when the table is destroyed.
+    explicit InstructionInfoTable(
+        const llvm::Module &m,
+        std::unique_ptr<llvm::raw_ostream> assembly = nullptr,
+        bool lazyAssemblyLines = false);
+    ~InstructionInfoTable();
+
+    /// Resolve the debug information of all functions up front, using
+    /// \p threads threads (0 for one per core).
+    void resolveAll(unsigned threads);
+
+    /// Read a table for \p m as written by write(). Building the table
+    /// from scratch prints the whole module to find assembly lines, which
+    /// this avoids. Returns null if the data does not fit the module.
+    static std::unique_ptr<InstructionInfoTable> read(const llvm::Module &m,
+                                                      std::istream &is);
+
+    /// Write the table for \p m, in module order, for read() to pick up.
+    void write(const llvm::Module &m, llvm::raw_ostream &os) const;
 
     unsigned getMaxID() const;
     const InstructionInfo &getInfo(const llvm::Instruction &) const;
+    /// Return the information of the instruction with id \p id.
+    const InstructionInfo &getInfo(unsigned id) const;
+    /// Return the id of the first instruction of \p f, the others follow in
+    /// order. Unlike getInfo, this does not resolve debug information.
+    unsigned getFirstID(const llvm::Function &f) const;
     const FunctionInfo &getFunctionInfo(const llvm::Function &) const;
+    unsigned getAssemblyLine(const InstructionInfo &ii) const;
+    uint64_t getAssemblyLine(const FunctionInfo &fi) const;
   };
 
 }
@@ -12,10 +12,13 @@
 
 #include "klee/Config/Version.h"
 #include "klee/Core/Interpreter.h"
+#include "klee/Module/Cell.h"
 #include "klee/Module/KCallable.h"
 
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <set>
@@ -31,7 +34,6 @@ namespace llvm {
 }
 
 namespace klee {
-  struct Cell;
   class Executor;
   class Expr;
   class InterpreterHandler;
@@ -97,7 +99,8 @@ namespace klee {
     std::unique_ptr<llvm::Module> module;
     std::unique_ptr<llvm::DataLayout> targetData;
 
-    // Our shadow versions of LLVM structures.
+    // Our shadow versions of LLVM structures. With --lazy-manifest, a
+    // function's shadow is only created by getKFunction.
     std::vector<std::unique_ptr<KFunction>> functions;
     std::map<llvm::Function*, KFunction*> functionMap;
 
@@ -111,7 +114,7 @@ namespace klee {
     std::map<const llvm::Constant *, std::unique_ptr<KConstant>> constantMap;
     KConstant* getKConstant(const llvm::Constant *c);
 
-    std::unique_ptr<Cell[]> constantTable;
+    std::deque<Cell> constantTable;
 
     // Functions which are part of KLEE runtime
     std::set<const llvm::Function*> internalFunctions;
@@ -128,14 +131,30 @@ namespace klee {
     void optimiseAndPrepare(const Interpreter::ModuleOptions &opts,
                             llvm::ArrayRef<const char *>);
 
+    /// Mark the checking functions added during instrumentation as part of
+    /// the KLEE runtime. Done by optimiseAndPrepare, and needed on its own
+    /// for a module that was prepared before.
+    void addInternalFunctions(const Interpreter::ModuleOptions &opts);
+
     /// Manifest the generated module (e.g. assembly.ll, output.bc) and
     /// prepares KModule
     ///
     /// @param ih
     /// @param forceSourceOutput true if assembly.ll should be created
+    /// @param cache path prefix of a module cache entry to take the assembly
+    /// and instruction info from, or empty to compute them
     ///
     // FIXME: ihandler should not be here
-    void manifest(InterpreterHandler *ih, bool forceSourceOutput);
+    void manifest(InterpreterHandler *ih, bool forceSourceOutput,
+                  const std::string &cache = "");
+
+    /// Return the shadow of \p f, creating it on first use.
+    KFunction *getKFunction(llvm::Function *f);
+
+    /// Store the prepared module, its assembly and instruction info under
+    /// the path prefix \p cache, for manifest to start from in a later run.
+    /// Returns false if the entry could not be written.
+    bool writeCache(const std::string &cache) const;
 
     /// Link the provided modules together as one KLEE module.
     ///
@@ -153,6 +172,19 @@ namespace klee {
 
     void instrument(const Interpreter::ModuleOptions &opts);
 
+    /// Surround small single-entry, single-exit regions with calls to
+    /// \p openName and \p closeName, so that states forking inside a region
+    /// can be merged at its exit.
+    ///
+    /// @param functions names of the functions to search for regions
+    /// @param maxBlocks largest number of blocks inside a region
+    /// @param allowLoops true if regions may contain loops
+    /// @return the number of regions found
+    unsigned insertMergePoints(const std::set<std::string> &functions,
+                               llvm::StringRef openName,
+                               llvm::StringRef closeName, unsigned maxBlocks,
+                               bool allowLoops);
+
     /// Return an id for the given constant, creating a new one if necessary.
     unsigned getConstantID(llvm::Constant *c, KInstruction* ki);
 
@@ -191,6 +191,18 @@ namespace klee {
                           const std::vector<const Array*> &objects,
                           std::vector< std::vector<unsigned char> > &result);
 
+    /// getInitialValues - Compute the initial values for a list of objects
+    /// such that the constraints hold and the query expression is false.
+    ///
+    /// \param [out] hasSolution - On success, true iff such an assignment
+    /// exists. The values in \p result are only valid if this is true.
+    ///
+    /// \return True on success, false on solver failure.
+    bool getInitialValues(const Query&,
+                          const std::vector<const Array*> &objects,
+                          std::vector< std::vector<unsigned char> > &result,
+                          bool &hasSolution);
+
     /// getRange - Compute a tight range of possible values for a given
     /// expression.
     ///
@@ -267,6 +279,14 @@ namespace klee {
   createSMTLIBLoggingSolver(std::unique_ptr<Solver> s, std::string path,
                             time::Span minQueryTimeToLog, bool logTimedOut);
 
+  /// createBinaryQueryLoggingSolver - Create a solver which will forward all
+  /// queries after writing them to the given path in the binary query log
+  /// format (see QueryLog.h).
+  std::unique_ptr<Solver>
+  createBinaryQueryLoggingSolver(std::unique_ptr<Solver> s, std::string path,
+                                 time::Span minQueryTimeToLog,
+                                 bool logTimedOut);
+
   /// createDummySolver - Create a dummy solver implementation which always
   /// fails.
   std::unique_ptr<Solver> createDummySolver();
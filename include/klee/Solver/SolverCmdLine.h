@@ -55,7 +55,9 @@ enum QueryLoggingSolverType {
   ALL_KQUERY,    ///< Log all queries in .kquery (KQuery) format
   ALL_SMTLIB,    ///< Log all queries .smt2 (SMT-LIBv2) format
   SOLVER_KQUERY, ///< Log queries passed to solver in .kquery (KQuery) format
-  SOLVER_SMTLIB  ///< Log queries passed to solver in .smt2 (SMT-LIBv2) format
+  SOLVER_SMTLIB, ///< Log queries passed to solver in .smt2 (SMT-LIBv2) format
+  ALL_KQLOG,     ///< Log all queries in binary .kqlog format
+  SOLVER_KQLOG   ///< Log queries passed to solver in binary .kqlog format
 };
 
 extern llvm::cl::bits<QueryLoggingSolverType> QueryLoggingOptions;
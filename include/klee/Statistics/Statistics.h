@@ -12,9 +12,13 @@
 
 #include "Statistic.h"
 
-#include <vector>
+#include <cassert>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string.h>
+#include <unordered_map>
+#include <vector>
 
 namespace klee {
   class Statistic;
@@ -37,12 +41,35 @@ namespace klee {
     StatisticRecord &operator +=(const StatisticRecord &sr);
   };
 
+  /// IndexedStatistic - The per-index values of a single statistic.
+  ///
+  /// Values are kept in 32-bit counters; the few values which do not fit are
+  /// moved to a map of wide values. Statistics which are only touched at a
+  /// small fraction of the indices are sparse and live in the map alone.
+  class IndexedStatistic {
+    /// Marks a counter whose value is in the wide map
+    static constexpr uint32_t Wide = ~0u;
+
+    std::vector<uint32_t> narrow;
+    std::unordered_map<unsigned, uint64_t> wide;
+
+  public:
+    IndexedStatistic(unsigned totalIndices, bool sparse)
+        : narrow(sparse ? 0 : totalIndices, 0) {}
+
+    uint64_t getValue(unsigned index) const;
+    void setValue(unsigned index, uint64_t value);
+    void incrementValue(unsigned index, uint64_t addend);
+  };
+
   class StatisticManager {
   private:
     bool enabled;
     std::vector<Statistic*> stats;
     uint64_t *globalStats;
-    uint64_t *indexedStats;
+    /// The per-index values, null for statistics which are not indexed
+    std::vector<std::unique_ptr<IndexedStatistic>> indexedStats;
+    unsigned totalIndices;
     StatisticRecord *contextStats;
     unsigned index;
 
@@ -50,7 +77,11 @@ namespace klee {
     StatisticManager();
     ~StatisticManager();
 
+    /// Enable per-index statistics for indices below \p totalIndices. Only
+    /// statistics subsequently passed to indexStatistic are kept per index.
     void useIndexedStats(unsigned totalIndices);
+    /// Keep the values of \p s per index, in a map if \p sparse is set.
+    void indexStatistic(const Statistic &s, bool sparse = false);
 
     StatisticRecord *getContext();
     void setContext(StatisticRecord *sr); /* null to reset */
@@ -77,8 +108,9 @@ namespace klee {
                                                    uint64_t addend) {
     if (enabled) {
       globalStats[s.id] += addend;
-      if (indexedStats) {
-        indexedStats[index*stats.size() + s.id] += addend;
+      if (!indexedStats.empty()) {
+        if (IndexedStatistic *is = indexedStats[s.id].get())
+          is->incrementValue(index, addend);
         if (contextStats)
           contextStats->data[s.id] += addend;
       }
@@ -133,21 +165,45 @@ namespace klee {
     return globalStats[s.id];
   }
 
+  inline uint64_t IndexedStatistic::getValue(unsigned index) const {
+    if (!narrow.empty() && narrow[index] != Wide)
+      return narrow[index];
+    auto it = wide.find(index);
+    return it == wide.end() ? 0 : it->second;
+  }
+
+  inline void IndexedStatistic::incrementValue(unsigned index,
+                                               uint64_t addend) {
+    if (!narrow.empty()) {
+      uint32_t &value = narrow[index];
+      uint64_t sum = value + addend;
+      if (value != Wide && sum < Wide) {
+        value = sum;
+        return;
+      }
+    }
+    setValue(index, getValue(index) + addend);
+  }
+
   inline void StatisticManager::incrementIndexedValue(const Statistic &s, 
                                                       unsigned index,
                                                       uint64_t addend) const {
-    indexedStats[index*stats.size() + s.id] += addend;
+    assert(indexedStats[s.id] && "statistic is not indexed");
+    indexedStats[s.id]->incrementValue(index, addend);
   }
 
   inline uint64_t StatisticManager::getIndexedValue(const Statistic &s, 
                                                     unsigned index) const {
-    return indexedStats[index*stats.size() + s.id];
+    if (indexedStats.empty() || !indexedStats[s.id])
+      return 0;
+    return indexedStats[s.id]->getValue(index);
   }
 
   inline void StatisticManager::setIndexedValue(const Statistic &s, 
                                                 unsigned index,
                                                 uint64_t value) {
-    indexedStats[index*stats.size() + s.id] = value;
+    assert(indexedStats[s.id] && "statistic is not indexed");
+    indexedStats[s.id]->setValue(index, value);
   }
 }
 
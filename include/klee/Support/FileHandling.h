@@ -27,6 +27,21 @@ klee_open_output_file(const std::string &path, std::string &error);
 std::unique_ptr<llvm::raw_ostream>
 klee_open_compressed_output_file(const std::string &path, std::string &error);
 #endif
+
+/// A file that is read sequentially, see klee_open_input_file.
+class InputStream {
+public:
+  virtual ~InputStream() = default;
+
+  /// Read up to \p size bytes into \p buffer. Returns the number of bytes
+  /// read, 0 at the end of the file or -1 on error.
+  virtual long read(char *buffer, size_t size) = 0;
+};
+
+/// Open \p path ("-" for stdin) for reading. Files written with
+/// klee_open_compressed_output_file are decompressed on the fly.
+std::unique_ptr<InputStream> klee_open_input_file(const std::string &path,
+                                                  std::string &error);
 } // namespace klee
 
 #endif /* KLEE_FILEHANDLING_H */
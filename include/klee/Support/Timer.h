@@ -86,6 +86,10 @@ namespace klee {
     ///
     /// \param timer The timer object to register.
     void add(std::unique_ptr<Timer> timer);
+    /// Remove a registered timer.
+    ///
+    /// \param timer The timer object to unregister.
+    void remove(const Timer *timer);
     /// Invoke registered timers with current time only if minimum interval exceeded.
     void invoke();
     /// Reset all timers.
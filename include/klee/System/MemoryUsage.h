@@ -16,6 +16,9 @@ namespace klee {
   namespace util {
     /// Get total malloc usage in bytes
     size_t GetTotalMallocUsage();
+
+    /// Get the peak resident set size of the process in bytes
+    size_t GetPeakMemoryUsage();
   }
 }
 
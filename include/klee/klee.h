@@ -121,6 +121,7 @@ extern "C" {
   void klee_warning_once(const char *message);
   void klee_prefer_cex(void *object, uintptr_t condition);
   void klee_posix_prefer_cex(void *object, uintptr_t condition);
+  unsigned klee_posix_copy(void *dest, const void *src, size_t n);
   void klee_mark_global(void *object);
 
   /* Return a possible constant value for the input expression. This
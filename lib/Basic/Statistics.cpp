@@ -16,20 +16,40 @@ using namespace klee;
 StatisticManager::StatisticManager()
   : enabled(true),
     globalStats(0),
-    indexedStats(0),
+    totalIndices(0),
     contextStats(0),
     index(0) {
 }
 
 StatisticManager::~StatisticManager() {
   delete[] globalStats;
-  delete[] indexedStats;
 }
 
-void StatisticManager::useIndexedStats(unsigned totalIndices) {  
-  delete[] indexedStats;
-  indexedStats = new uint64_t[totalIndices * stats.size()];
-  memset(indexedStats, 0, sizeof(*indexedStats) * totalIndices * stats.size());
+void StatisticManager::useIndexedStats(unsigned totalIndices) {
+  this->totalIndices = totalIndices;
+  indexedStats.clear();
+  indexedStats.resize(stats.size());
+}
+
+void StatisticManager::indexStatistic(const Statistic &s, bool sparse) {
+  assert(!indexedStats.empty() && "indexed statistics are not in use");
+  indexedStats[s.id] = std::make_unique<IndexedStatistic>(totalIndices, sparse);
+}
+
+void IndexedStatistic::setValue(unsigned index, uint64_t value) {
+  if (!narrow.empty()) {
+    if (value < Wide) {
+      if (narrow[index] == Wide)
+        wide.erase(index);
+      narrow[index] = value;
+      return;
+    }
+    narrow[index] = Wide;
+  } else if (!value) {
+    wide.erase(index);
+    return;
+  }
+  wide[index] = value;
 }
 
 void StatisticManager::registerStatistic(Statistic &s) {
@@ -0,0 +1,49 @@
+//===-- AdaptiveSolverTimeout.cpp -----------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "AdaptiveSolverTimeout.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace klee;
+
+void AdaptiveSolverTimeout::Distribution::add(double x) {
+  ++count;
+  double delta = x - mean;
+  mean += delta / count;
+  m2 += delta * (x - mean);
+}
+
+double AdaptiveSolverTimeout::Distribution::stddev() const {
+  return count > 1 ? std::sqrt(m2 / (count - 1)) : 0;
+}
+
+time::Span AdaptiveSolverTimeout::getTimeout(const Distribution &d) const {
+  double budget = d.mean + deviations * d.stddev();
+  if (budget >= maxTimeout.toMicroseconds())
+    return maxTimeout;
+  return std::max(minTimeout,
+                  time::microseconds(static_cast<std::uint64_t>(budget)));
+}
+
+time::Span AdaptiveSolverTimeout::getTimeout(unsigned site) const {
+  auto it = sites.find(site);
+  if (it != sites.end() && it->second.count >= minSamples)
+    return getTimeout(it->second);
+  if (all.count >= minSamples)
+    return getTimeout(all);
+  return maxTimeout;
+}
+
+void AdaptiveSolverTimeout::update(unsigned site, time::Span duration) {
+  double x = duration.toMicroseconds();
+  sites[site].add(x);
+  all.add(x);
+}
@@ -0,0 +1,67 @@
+//===-- AdaptiveSolverTimeout.h ---------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_ADAPTIVESOLVERTIMEOUT_H
+#define KLEE_ADAPTIVESOLVERTIMEOUT_H
+
+#include "klee/System/Time.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace klee {
+
+/// AdaptiveSolverTimeout - Derives the timeout of a solver query from the
+/// times earlier queries took at the same instruction.
+///
+/// The times of successful queries are summarized online, per instruction
+/// and over all instructions, by their mean and standard deviation. A query
+/// gets the mean plus a number of standard deviations of the queries at its
+/// instruction, or of all queries while its instruction has too few, clamped
+/// to a minimum and maximum timeout. Until enough queries have been seen, it
+/// gets the maximum.
+class AdaptiveSolverTimeout {
+  /// Running mean and variance of query times in microseconds, as by
+  /// Welford's algorithm
+  struct Distribution {
+    std::uint64_t count = 0;
+    double mean = 0;
+    /// Sum of squared differences from the mean
+    double m2 = 0;
+
+    void add(double x);
+    double stddev() const;
+  };
+
+  time::Span minTimeout, maxTimeout;
+  double deviations;
+  unsigned minSamples;
+
+  Distribution all;
+  std::unordered_map<unsigned, Distribution> sites;
+
+  time::Span getTimeout(const Distribution &d) const;
+
+public:
+  AdaptiveSolverTimeout(time::Span minTimeout, time::Span maxTimeout,
+                        double deviations, unsigned minSamples)
+      : minTimeout(minTimeout), maxTimeout(maxTimeout),
+        deviations(deviations), minSamples(minSamples) {}
+
+  /// The timeout of a query issued by the instruction with id \p site.
+  time::Span getTimeout(unsigned site) const;
+
+  /// Record that a query issued by the instruction with id \p site
+  /// succeeded after \p duration.
+  void update(unsigned site, time::Span duration);
+};
+
+} // namespace klee
+
+#endif /* KLEE_ADAPTIVESOLVERTIMEOUT_H */
@@ -14,12 +14,19 @@
 #include "TimingSolver.h"
 
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/IntervalEvaluator.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 
 #include "CoreStats.h"
 
 using namespace klee;
 
+/// Return the last address a pointer into \p mo may have. Zero-sized objects
+/// still own their base address.
+static uint64_t getLastAddress(const MemoryObject *mo) {
+  return mo->address + (mo->size ? mo->size - 1 : 0);
+}
+
 ///
 
 void AddressSpace::bindObject(const MemoryObject *mo, ObjectState *os) {
@@ -104,8 +111,11 @@ bool AddressSpace::resolveOne(ExecutionState &state,
       }
     }
 
-    // didn't work, now we have to search
-       
+    // didn't work, now we have to search. Objects outside the cheap bounds
+    // of the address are skipped without asking the solver.
+    IntervalEvaluator::Interval bounds =
+        IntervalEvaluator(state.constraints).evaluate(address);
+
     MemoryMap::iterator oi = objects.upper_bound(&hack);
     MemoryMap::iterator begin = objects.begin();
     MemoryMap::iterator end = objects.end();
@@ -115,17 +125,23 @@ bool AddressSpace::resolveOne(ExecutionState &state,
       --oi;
       const auto &mo = oi->first;
 
-      bool mayBeTrue;
-      if (!solver->mayBeTrue(state.constraints,
-                             mo->getBoundsCheckPointer(address), mayBeTrue,
-                             state.queryMetaData))
-        return false;
-      if (mayBeTrue) {
-        result.first = oi->first;
-        result.second = oi->second.get();
-        success = true;
-        return true;
-      } else {
+      if (bounds.intersects(mo->address, getLastAddress(mo))) {
+        bool mayBeTrue;
+        if (!solver->mayBeTrue(state.constraints,
+                               mo->getBoundsCheckPointer(address), mayBeTrue,
+                               state.queryMetaData))
+          return false;
+        if (mayBeTrue) {
+          result.first = oi->first;
+          result.second = oi->second.get();
+          success = true;
+          return true;
+        }
+      }
+
+      if (bounds.min >= mo->address)
+        break;
+      if (bounds.max >= mo->address) {
         bool mustBeTrue;
         if (!solver->mustBeTrue(state.constraints,
                                 UgeExpr::create(address, mo->getBaseExpr()),
@@ -140,14 +156,19 @@ bool AddressSpace::resolveOne(ExecutionState &state,
     for (oi=start; oi!=end; ++oi) {
       const auto &mo = oi->first;
 
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state.constraints,
-                              UltExpr::create(address, mo->getBaseExpr()),
-                              mustBeTrue, state.queryMetaData))
-        return false;
-      if (mustBeTrue) {
+      if (bounds.max < mo->address)
         break;
-      } else {
+      if (bounds.min < mo->address) {
+        bool mustBeTrue;
+        if (!solver->mustBeTrue(state.constraints,
+                                UltExpr::create(address, mo->getBaseExpr()),
+                                mustBeTrue, state.queryMetaData))
+          return false;
+        if (mustBeTrue)
+          break;
+      }
+
+      if (bounds.intersects(mo->address, getLastAddress(mo))) {
         bool mayBeTrue;
 
         if (!solver->mayBeTrue(state.constraints,
@@ -236,6 +257,11 @@ bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
     uint64_t example = cex->getZExtValue();
     MemoryObject hack(example);
 
+    // Cheap bounds on p let us skip objects it cannot point into and stop
+    // searching without a solver query once the bounds are exhausted.
+    IntervalEvaluator::Interval bounds =
+        IntervalEvaluator(state.constraints).evaluate(p);
+
     MemoryMap::iterator oi = objects.upper_bound(&hack);
     MemoryMap::iterator begin = objects.begin();
     MemoryMap::iterator end = objects.end();
@@ -250,20 +276,26 @@ bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
       if (timeout && timeout < timer.delta())
         return true;
 
-      auto op = std::make_pair<>(mo, oi->second.get());
+      if (bounds.intersects(mo->address, getLastAddress(mo))) {
+        auto op = std::make_pair<>(mo, oi->second.get());
 
-      int incomplete =
-          checkPointerInObject(state, solver, p, op, rl, maxResolutions);
-      if (incomplete != 2)
-        return incomplete ? true : false;
+        int incomplete =
+            checkPointerInObject(state, solver, p, op, rl, maxResolutions);
+        if (incomplete != 2)
+          return incomplete ? true : false;
+      }
 
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state.constraints,
-                              UgeExpr::create(p, mo->getBaseExpr()), mustBeTrue,
-                              state.queryMetaData))
-        return true;
-      if (mustBeTrue)
+      if (bounds.min >= mo->address)
         break;
+      if (bounds.max >= mo->address) {
+        bool mustBeTrue;
+        if (!solver->mustBeTrue(state.constraints,
+                                UgeExpr::create(p, mo->getBaseExpr()),
+                                mustBeTrue, state.queryMetaData))
+          return true;
+        if (mustBeTrue)
+          break;
+      }
     }
 
     // search forwards
@@ -272,13 +304,20 @@ bool AddressSpace::resolve(ExecutionState &state, TimingSolver *solver,
       if (timeout && timeout < timer.delta())
         return true;
 
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state.constraints,
-                              UltExpr::create(p, mo->getBaseExpr()), mustBeTrue,
-                              state.queryMetaData))
-        return true;
-      if (mustBeTrue)
+      if (bounds.max < mo->address)
         break;
+      if (bounds.min < mo->address) {
+        bool mustBeTrue;
+        if (!solver->mustBeTrue(state.constraints,
+                                UltExpr::create(p, mo->getBaseExpr()),
+                                mustBeTrue, state.queryMetaData))
+          return true;
+        if (mustBeTrue)
+          break;
+      }
+
+      if (!bounds.intersects(mo->address, getLastAddress(mo)))
+        continue;
       auto op = std::make_pair<>(mo, oi->second.get());
 
       int incomplete =
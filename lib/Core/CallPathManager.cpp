@@ -9,6 +9,7 @@
 
 #include "CallPathManager.h"
 
+#include "klee/Module/InstructionInfoTable.h"
 #include "klee/Statistics/Statistics.h"
 
 #include "klee/Support/CompilerWarning.h"
@@ -19,6 +20,8 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 DISABLE_WARNING_POP
 
 #include <map>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 using namespace klee;
@@ -62,6 +65,33 @@ void CallPathManager::getSummaryStatistics(CallSiteSummaryTable &results) {
   }
 }
 
+void CallPathManager::writeFoldedStacks(llvm::raw_ostream &os,
+                                        const Statistic &s,
+                                        const InstructionInfoTable &infos) {
+  // Parents are created before their children, so the stack of each path
+  // extends the already computed one of its parent
+  std::unordered_map<const CallPathNode *, std::string> stacks;
+  for (auto &path : paths) {
+    std::string frame = path->function->getName().str();
+    if (path->callSite) {
+      const InstructionInfo &ii = infos.getInfo(*path->callSite);
+      if (!ii.file.empty())
+        frame += " (" + ii.file + ":" + std::to_string(ii.line) + ")";
+    }
+    // Semicolons separate frames, and the last space the value
+    for (char &c : frame)
+      if (c == ';')
+        c = ':';
+
+    std::string &stack = stacks[path.get()];
+    auto parent = stacks.find(path->parent);
+    stack = parent == stacks.end() ? frame : parent->second + ";" + frame;
+
+    if (uint64_t value = path->statistics.getValue(s))
+      os << stack << " " << value << "\n";
+  }
+}
+
 CallPathNode *CallPathManager::computeCallPath(CallPathNode *parent,
                                                const llvm::Instruction *cs,
                                                const llvm::Function *f) {
@@ -19,9 +19,11 @@
 namespace llvm {
   class Instruction;
   class Function;
+  class raw_ostream;
 }
 
 namespace klee {
+  class InstructionInfoTable;
   class StatisticRecord;
 
   struct CallSiteInfo {
@@ -77,6 +79,14 @@ namespace klee {
 
     void getSummaryStatistics(CallSiteSummaryTable &result);
 
+    /// Write the values of \p s per call path as collapsed stacks, one
+    /// "main;f (file:line);g (file:line) value" line per call path with a
+    /// non-zero value of its own. Frames name the call site they were called
+    /// from if it has debug information. This is the folded format read by
+    /// flame graph tools, which sum up the values of nested call paths.
+    void writeFoldedStacks(llvm::raw_ostream &os, const Statistic &s,
+                           const InstructionInfoTable &infos);
+
     CallPathNode *getCallPath(CallPathNode *parent,
                               const llvm::Instruction *callSite,
                               const llvm::Function *f);
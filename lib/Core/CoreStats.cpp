@@ -14,6 +14,10 @@
 using namespace klee;
 
 Statistic stats::allocations("Allocations", "Alloc");
+Statistic stats::autoMergeQueriesSaved("AutoMergeQueriesSaved", "AMQSaved");
+Statistic stats::autoMergeRejects("AutoMergeRejects", "AMRejects");
+Statistic stats::autoMergeTimeSaved("AutoMergeTimeSaved", "AMTSaved");
+Statistic stats::autoMerges("AutoMerges", "AMerges");
 Statistic stats::coveredInstructions("CoveredInstructions", "Icov");
 Statistic stats::externalCalls("ExternalCalls", "ExtC");
 Statistic stats::falseBranches("FalseBranches", "Bf");
@@ -25,9 +29,13 @@ Statistic stats::instructionTime("InstructionTimes", "Itime");
 Statistic stats::instructions("Instructions", "I");
 Statistic stats::minDistToReturn("MinDistToReturn", "Rdist");
 Statistic stats::minDistToUncovered("MinDistToUncovered", "UCdist");
+Statistic stats::queriesDeferred("QueriesDeferred", "QDeferred");
+Statistic stats::queriesRetried("QueriesRetried", "QRetried");
 Statistic stats::resolveTime("ResolveTime", "Rtime");
 Statistic stats::solverTime("SolverTime", "Stime");
 Statistic stats::states("States", "States");
+Statistic stats::stateModelHits("StateModelHits", "SMHits");
+Statistic stats::stateModelMisses("StateModelMisses", "SMMisses");
 Statistic stats::trueBranches("TrueBranches", "Bt");
 Statistic stats::uncoveredInstructions("UncoveredInstructions", "Iuncov");
 
@@ -38,6 +38,33 @@ namespace stats {
   /// Number of inhibited forks.
   extern Statistic inhibitedForks;
 
+  /// Number of branch conditions decided by the model of the forking state.
+  extern Statistic stateModelHits;
+
+  /// Number of branch conditions the model of the forking state could not
+  /// decide, either because no model was known or it was invalidated.
+  extern Statistic stateModelMisses;
+
+  /// Number of queries that timed out under an adaptive solver timeout and
+  /// were deferred until their state is selected again.
+  extern Statistic queriesDeferred;
+
+  /// Number of deferred queries that were retried with the full timeout.
+  extern Statistic queriesRetried;
+
+  /// Number of states merged into another state by --auto-merge.
+  extern Statistic autoMerges;
+
+  /// Number of states --auto-merge kept apart because merging them was not
+  /// estimated to pay off.
+  extern Statistic autoMergeRejects;
+
+  /// Estimated number of solver queries saved by --auto-merge.
+  extern Statistic autoMergeQueriesSaved;
+
+  /// Estimated solver time (in microseconds) saved by --auto-merge.
+  extern Statistic autoMergeTimeSaved;
+
   /// Number of states, this is a "fake" statistic used by istats, it
   /// isn't normally up-to-date.
   extern Statistic states;
@@ -23,6 +23,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iomanip>
 #include <map>
@@ -52,24 +53,13 @@ std::uint32_t ExecutionState::nextID = 1;
 
 StackFrame::StackFrame(KInstIterator _caller, KFunction *_kf)
   : caller(_caller), kf(_kf), callPathNode(0), 
-    minDistToUncoveredOnReturn(0), varargs(0) {
-  locals = new Cell[kf->numRegisters];
-}
-
-StackFrame::StackFrame(const StackFrame &s) 
-  : caller(s.caller),
-    kf(s.kf),
-    callPathNode(s.callPathNode),
-    allocas(s.allocas),
-    minDistToUncoveredOnReturn(s.minDistToUncoveredOnReturn),
-    varargs(s.varargs) {
-  locals = new Cell[s.kf->numRegisters];
-  for (unsigned i=0; i<s.kf->numRegisters; i++)
-    locals[i] = s.locals[i];
-}
+    minDistToUncoveredOnReturn(0), varargs(0),
+    locals(new Cell[kf->numRegisters]) {}
 
-StackFrame::~StackFrame() { 
-  delete[] locals; 
+void StackFrame::copyLocals() {
+  std::shared_ptr<Cell[]> copy(new Cell[kf->numRegisters]);
+  std::copy(locals.get(), locals.get() + kf->numRegisters, copy.get());
+  locals = std::move(copy);
 }
 
 /***/
@@ -102,9 +92,10 @@ ExecutionState::ExecutionState(const ExecutionState& state):
     stackAllocator(state.stackAllocator),
     heapAllocator(state.heapAllocator),
     constraints(state.constraints),
+    model(state.model),
     pathOS(state.pathOS),
     symPathOS(state.symPathOS),
-    coveredLines(state.coveredLines),
+    coveredInstructions(state.coveredInstructions),
     symbolics(state.symbolics),
     cexPreferences(state.cexPreferences),
     arrayNames(state.arrayNames),
@@ -128,7 +119,7 @@ ExecutionState *ExecutionState::branch() {
   auto *falseState = new ExecutionState(*this);
   falseState->setID();
   falseState->coveredNew = false;
-  falseState->coveredLines.clear();
+  falseState->coveredInstructions.clear();
 
   return falseState;
 }
@@ -148,12 +139,13 @@ void ExecutionState::popFrame() {
 
 void ExecutionState::deallocate(const MemoryObject *mo) {
   if (SingleObjectResolution) {
-    auto mos_it = base_mos.find(mo->address);
-    if (mos_it != base_mos.end()) {
-      for (auto it = mos_it->second.begin(); it != mos_it->second.end(); ++it) {
-        base_addrs.erase(*it);
-      }
-      base_mos.erase(mos_it->first);
+    auto it = base_mos.lower_bound({mo->address, ref<Expr>()});
+    std::vector<ref<Expr>> bases;
+    for (; it != base_mos.end() && it->first == mo->address; ++it)
+      bases.push_back(it->second);
+    for (const auto &base : bases) {
+      base_addrs = base_addrs.remove(base);
+      base_mos = base_mos.remove({mo->address, base});
     }
   }
 
@@ -201,8 +193,8 @@ bool ExecutionState::merge(const ExecutionState &b) {
     return false;
 
   {
-    std::vector<StackFrame>::const_iterator itA = stack.begin();
-    std::vector<StackFrame>::const_iterator itB = b.stack.begin();
+    stack_ty::const_iterator itA = stack.begin();
+    stack_ty::const_iterator itB = b.stack.begin();
     while (itA!=stack.end() && itB!=b.stack.end()) {
       // XXX vaargs?
       if (itA->caller!=itB->caller || itA->kf!=itB->kf)
@@ -306,19 +298,19 @@ bool ExecutionState::merge(const ExecutionState &b) {
   // it seems like it can make a difference, even though logically
   // they must contradict each other and so inA => !inB
 
-  std::vector<StackFrame>::iterator itA = stack.begin();
-  std::vector<StackFrame>::const_iterator itB = b.stack.begin();
+  stack_ty::iterator itA = stack.begin();
+  stack_ty::const_iterator itB = b.stack.begin();
   for (; itA!=stack.end(); ++itA, ++itB) {
     StackFrame &af = *itA;
     const StackFrame &bf = *itB;
     for (unsigned i=0; i<af.kf->numRegisters; i++) {
-      ref<Expr> &av = af.locals[i].value;
-      const ref<Expr> &bv = bf.locals[i].value;
+      const ref<Expr> &av = af.getLocal(i).value;
+      const ref<Expr> &bv = bf.getLocal(i).value;
       if (!av || !bv) {
         // if one is null then by implication (we are at same pc)
         // we cannot reuse this local, so just ignore
       } else {
-        av = SelectExpr::create(inA, av, bv);
+        af.getWritableLocal(i).value = SelectExpr::create(inA, av, bv);
       }
     }
   }
@@ -340,6 +332,8 @@ bool ExecutionState::merge(const ExecutionState &b) {
     }
   }
 
+  // The model of this state satisfies the common constraints and inA, so it
+  // remains valid for the merged constraints.
   constraints = ConstraintSet();
 
   ConstraintManager m(constraints);
@@ -361,7 +355,7 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
     const InstructionInfo &ii = *target->info;
     out << "\t#" << idx++;
     std::stringstream AssStream;
-    AssStream << std::setw(8) << std::setfill('0') << ii.assemblyLine;
+    AssStream << std::setw(8) << std::setfill('0') << ii.getAssemblyLine();
     out << AssStream.str();
     out << " in " << f->getName().str() << "(";
     // Yawn, we could go up and print varargs if we wanted to.
@@ -373,7 +367,7 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
       if (ai->hasName())
         out << ai->getName().str() << "=";
 
-      ref<Expr> value = sf.locals[sf.kf->getArgRegister(index++)].value;
+      ref<Expr> value = sf.getLocal(sf.kf->getArgRegister(index++)).value;
       if (isa_and_nonnull<ConstantExpr>(value)) {
         out << value;
       } else {
@@ -391,6 +385,9 @@ void ExecutionState::dumpStack(llvm::raw_ostream &out) const {
 void ExecutionState::addConstraint(ref<Expr> e) {
   ConstraintManager c(constraints);
   c.addConstraint(e);
+
+  if (model && !model->evaluate(e)->isTrue())
+    model.reset();
 }
 
 void ExecutionState::addCexPreference(const ref<Expr> &cond) {
@@ -14,15 +14,21 @@
 #include "MemoryManager.h"
 #include "MergeHandler.h"
 
+#include "klee/ADT/ImmutableMap.h"
 #include "klee/ADT/ImmutableSet.h"
+#include "klee/ADT/PersistentBitSet.h"
+#include "klee/ADT/PersistentVector.h"
 #include "klee/ADT/TreeStream.h"
+#include "klee/Expr/Assignment.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
 #include "klee/KDAlloc/kdalloc.h"
+#include "klee/Module/Cell.h"
 #include "klee/Module/KInstIterator.h"
 #include "klee/Solver/Solver.h"
 #include "klee/System/Time.h"
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <set>
@@ -31,8 +37,6 @@
 namespace klee {
 class Array;
 class CallPathNode;
-struct Cell;
-class ExecutionTreeNode;
 struct KFunction;
 struct KInstruction;
 class MemoryObject;
@@ -46,7 +50,6 @@ struct StackFrame {
   CallPathNode *callPathNode;
 
   std::vector<const MemoryObject *> allocas;
-  Cell *locals;
 
   /// Minimum distance to an uncovered instruction once the function
   /// returns. This is not a good place for this but is used to
@@ -62,9 +65,26 @@ struct StackFrame {
   // of intrinsic lowering.
   MemoryObject *varargs;
 
+private:
+  /// The registers of the frame, shared with the copies of the frame made
+  /// when forking until one of them writes to a register.
+  std::shared_ptr<Cell[]> locals;
+
+public:
   StackFrame(KInstIterator caller, KFunction *kf);
-  StackFrame(const StackFrame &s);
-  ~StackFrame();
+
+  const Cell &getLocal(unsigned index) const { return locals[index]; }
+
+  /// Return register \p index for writing, first copying the registers if
+  /// they are shared with another frame.
+  Cell &getWritableLocal(unsigned index) {
+    if (locals.use_count() > 1)
+      copyLocals();
+    return locals[index];
+  }
+
+private:
+  void copyLocals();
 };
 
 /// Contains information related to unwinding (Itanium ABI/2-Phase unwinding)
@@ -191,6 +211,10 @@ public:
   /// @brief Constraints collected so far
   ConstraintSet constraints;
 
+  /// @brief Satisfying assignment of the constraints, if known. It is
+  /// dropped as soon as an added constraint does not hold under it.
+  std::shared_ptr<const Assignment> model;
+
   /// Statistics and information
 
   /// @brief Metadata utilized and collected by solvers for this state
@@ -204,24 +228,24 @@ public:
   /// taken to reach/create this state
   TreeOStream symPathOS;
 
-  /// @brief Set containing which lines in which files are covered by this state
-  std::map<const std::string *, std::set<std::uint32_t>> coveredLines;
+  /// @brief IDs of the instructions this state covered first, since it was
+  /// created or last took the other side of a branch than its sibling
+  PersistentBitSet coveredInstructions;
 
-  /// @brief Pointer to the execution tree of the current state
+  /// @brief Index of the execution tree node of the current state (0 if none)
   /// Copies of ExecutionState should not copy executionTreeNode
-  ExecutionTreeNode *executionTreeNode = nullptr;
+  std::uint32_t executionTreeNode = 0;
 
   /// @brief Ordered list of symbolics: used to generate test cases.
-  //
-  // FIXME: Move to a shared list structure (not critical).
-  std::vector<std::pair<ref<const MemoryObject>, const Array *>> symbolics;
+  PersistentVector<std::pair<ref<const MemoryObject>, const Array *>>
+      symbolics;
 
   /// @brief A set of boolean expressions
   /// the user has requested be true of a counterexample.
   ImmutableSet<ref<Expr>> cexPreferences;
 
   /// @brief Set of used array names for this state.  Used to avoid collisions.
-  std::set<std::string> arrayNames;
+  ImmutableSet<std::string> arrayNames;
 
   /// @brief The objects handling the klee_open_merge calls this state ran through
   std::vector<ref<MergeHandler>> openMergeStack;
@@ -248,11 +272,33 @@ public:
   /// @brief Disables forking for this state. Set by user code
   bool forkDisabled = false;
 
+  /// @brief Whether this state waits in the queue of deferred states, after a
+  /// query of its current instruction timed out under an adaptive timeout
+  bool queryDeferred = false;
+
+  /// @brief Whether the next query with an adaptive timeout is the retry of a
+  /// deferred one, and thus gets the full solver timeout. Cleared once the
+  /// state steps past the deferred instruction.
+  bool retryQuery = false;
+
   /// @brief Mapping symbolic address expressions to concrete base addresses
-  using base_addrs_t = std::map<ref<Expr>, ref<ConstantExpr>>;
+  using base_addrs_t = ImmutableMap<ref<Expr>, ref<ConstantExpr>>;
   base_addrs_t base_addrs;
-  /// @brief Mapping MemoryObject addresses to refs used in the base_addrs map
-  using base_mo_t = std::map<uint64_t, std::set<ref<Expr>>>;
+  /// @brief Mapping MemoryObject addresses to refs used in the base_addrs map,
+  /// as a set of pairs ordered by address first
+  struct BaseMOCompare {
+    bool operator()(const std::pair<uint64_t, ref<Expr>> &a,
+                    const std::pair<uint64_t, ref<Expr>> &b) const {
+      if (a.first != b.first)
+        return a.first < b.first;
+      // A null ref sorts first, to find the refs of an address
+      if (!a.second || !b.second)
+        return !a.second && b.second;
+      return a.second < b.second;
+    }
+  };
+  using base_mo_t =
+      ImmutableSet<std::pair<uint64_t, ref<Expr>>, BaseMOCompare>;
   base_mo_t base_mos;
 
 public:
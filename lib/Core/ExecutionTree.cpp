@@ -40,22 +40,6 @@ llvm::cl::opt<bool> WriteExecutionTree(
     llvm::cl::cat(ExecTreeCat));
 } // namespace
 
-// ExecutionTreeNode
-
-ExecutionTreeNode::ExecutionTreeNode(ExecutionTreeNode *parent,
-                                     ExecutionState *state) noexcept
-    : parent{parent}, left{nullptr}, right{nullptr}, state{state} {
-  state->executionTreeNode = this;
-}
-
-// AnnotatedExecutionTreeNode
-
-AnnotatedExecutionTreeNode::AnnotatedExecutionTreeNode(
-    ExecutionTreeNode *parent, ExecutionState *state) noexcept
-    : ExecutionTreeNode(parent, state) {
-  id = nextID++;
-}
-
 // NoopExecutionTree
 
 void NoopExecutionTree::dump(llvm::raw_ostream &os) noexcept {
@@ -66,74 +50,131 @@ void NoopExecutionTree::dump(llvm::raw_ostream &os) noexcept {
 
 InMemoryExecutionTree::InMemoryExecutionTree(
     ExecutionState &initialState) noexcept {
-  root = ExecutionTreeNodePtr(createNode(nullptr, &initialState));
-  initialState.executionTreeNode = root.getPointer();
+  root = ExecutionTreeNodePtr(createNode(0, &initialState));
+}
+
+ExecutionTreeNodeIndex InMemoryExecutionTree::allocateNode() {
+  if (freeNodes) {
+    ExecutionTreeNodeIndex index = freeNodes;
+    freeNodes = getNode(index).parent;
+    return index;
+  }
+
+  if ((nextNode >> SlabBits) == slabs.size()) {
+    // Scanning the pool pays off if it frees a fixed share of it
+    if (singleChildNodes && singleChildNodes >= nextNode / 4) {
+      compressSingleChildNodes();
+      return allocateNode();
+    }
+    if (nextNode > ExecutionTreeNodePtr::maxIndex)
+      klee_error("ExecutionTree cannot hold more than %u nodes",
+                 ExecutionTreeNodePtr::maxIndex);
+    slabs.emplace_back(new ExecutionTreeNode[SlabSize]);
+  }
+  return nextNode++;
 }
 
-ExecutionTreeNode *InMemoryExecutionTree::createNode(ExecutionTreeNode *parent,
-                                                     ExecutionState *state) {
-  return new ExecutionTreeNode(parent, state);
+void InMemoryExecutionTree::freeNode(ExecutionTreeNodeIndex index) {
+  ExecutionTreeNode &n = getNode(index);
+  n = ExecutionTreeNode();
+  n.parent = freeNodes;
+  freeNodes = index;
 }
 
-void InMemoryExecutionTree::attach(ExecutionTreeNode *node,
+void InMemoryExecutionTree::removeSingleChildNode(
+    ExecutionTreeNodeIndex index) {
+  ExecutionTreeNode &node = getNode(index);
+  ExecutionTreeNodePtr child = node.left.getIndex() ? node.left : node.right;
+  ExecutionTreeNodeIndex parent = node.parent;
+
+  getNode(child.getIndex()).parent = parent;
+  if (!parent) {
+    // We are at the root
+    root = child;
+  } else {
+    ExecutionTreeNode &p = getNode(parent);
+    if (index == p.left.getIndex()) {
+      p.left = child;
+    } else {
+      assert(index == p.right.getIndex());
+      p.right = child;
+    }
+  }
+
+  freeNode(index);
+}
+
+void InMemoryExecutionTree::compressSingleChildNodes() {
+  // Freed nodes and leaves have no children, and a node being attached to
+  // still has its state
+  for (ExecutionTreeNodeIndex i = 1; i < nextNode; ++i) {
+    const ExecutionTreeNode &n = getNode(i);
+    if (!n.state && !n.left.getIndex() != !n.right.getIndex())
+      removeSingleChildNode(i);
+  }
+  singleChildNodes = 0;
+}
+
+ExecutionTreeNodeIndex
+InMemoryExecutionTree::createNode(ExecutionTreeNodeIndex parent,
+                                  ExecutionState *state) {
+  ExecutionTreeNodeIndex index = allocateNode();
+  ExecutionTreeNode &n = getNode(index);
+  n.parent = parent;
+  n.state = state;
+  state->executionTreeNode = index;
+  return index;
+}
+
+void InMemoryExecutionTree::attach(ExecutionTreeNodeIndex node,
                                    ExecutionState *leftState,
                                    ExecutionState *rightState,
                                    BranchType reason) noexcept {
-  assert(node && !node->left.getPointer() && !node->right.getPointer());
+  assert(node && !getNode(node).left.getIndex() &&
+         !getNode(node).right.getIndex());
   assert(node == rightState->executionTreeNode &&
          "Attach assumes the right state is the current state");
-  node->left = ExecutionTreeNodePtr(createNode(node, leftState));
+  // Slabs never move, so n stays valid while children are allocated
+  ExecutionTreeNode &n = getNode(node);
+  n.left = ExecutionTreeNodePtr(createNode(node, leftState));
   // The current node inherits the tag
-  uint8_t currentNodeTag = root.getInt();
-  if (node->parent)
-    currentNodeTag = node->parent->left.getPointer() == node
-                         ? node->parent->left.getInt()
-                         : node->parent->right.getInt();
-  node->right =
-      ExecutionTreeNodePtr(createNode(node, rightState), currentNodeTag);
-  updateBranchingNode(*node, reason);
-  node->state = nullptr;
-}
-
-void InMemoryExecutionTree::remove(ExecutionTreeNode *n) noexcept {
-  assert(!n->left.getPointer() && !n->right.getPointer());
-  updateTerminatingNode(*n);
+  std::uint8_t currentNodeTag = getPtrTo(node).getInt();
+  n.right = ExecutionTreeNodePtr(createNode(node, rightState), currentNodeTag);
+  updateBranchingNode(node, reason);
+  n.state = nullptr;
+}
+
+void InMemoryExecutionTree::remove(ExecutionTreeNodeIndex n) noexcept {
+  assert(!getNode(n).left.getIndex() && !getNode(n).right.getIndex());
+  updateTerminatingNode(n);
+  ExecutionTreeNodeIndex leaf = n;
   do {
-    ExecutionTreeNode *p = n->parent;
+    // Inner nodes lost their other child before
+    if (n != leaf)
+      --singleChildNodes;
+    ExecutionTreeNodeIndex p = getNode(n).parent;
     if (p) {
-      if (n == p->left.getPointer()) {
-        p->left = ExecutionTreeNodePtr(nullptr);
+      ExecutionTreeNode &parent = getNode(p);
+      if (n == parent.left.getIndex()) {
+        parent.left = ExecutionTreeNodePtr();
       } else {
-        assert(n == p->right.getPointer());
-        p->right = ExecutionTreeNodePtr(nullptr);
+        assert(n == parent.right.getIndex());
+        parent.right = ExecutionTreeNodePtr();
       }
     }
-    delete n;
+    freeNode(n);
     n = p;
-  } while (n && !n->left.getPointer() && !n->right.getPointer());
-
-  if (n && CompressExecutionTree) {
-    // We are now at a node that has exactly one child; we've just deleted the
-    // other one. Eliminate the node and connect its child to the parent
-    // directly (if it's not the root).
-    ExecutionTreeNodePtr child = n->left.getPointer() ? n->left : n->right;
-    ExecutionTreeNode *parent = n->parent;
-
-    child.getPointer()->parent = parent;
-    if (!parent) {
-      // We are at the root
-      root = child;
-    } else {
-      if (n == parent->left.getPointer()) {
-        parent->left = child;
-      } else {
-        assert(n == parent->right.getPointer());
-        parent->right = child;
-      }
-    }
-
-    delete n;
-  }
+  } while (n && !getNode(n).left.getIndex() && !getNode(n).right.getIndex());
+
+  if (!n)
+    return;
+  // We are now at a node that has exactly one child; we've just deleted the
+  // other one. Eliminate the node and connect its child to the parent
+  // directly (if it's not the root).
+  if (CompressExecutionTree)
+    removeSingleChildNode(n);
+  else
+    ++singleChildNodes;
 }
 
 void InMemoryExecutionTree::dump(llvm::raw_ostream &os) noexcept {
@@ -146,24 +187,26 @@ void InMemoryExecutionTree::dump(llvm::raw_ostream &os) noexcept {
      << "\tcenter = \"true\";\n"
      << "\tnode [style=\"filled\",width=.1,height=.1,fontname=\"Terminus\"]\n"
      << "\tedge [arrowsize=.3]\n";
-  std::vector<const ExecutionTreeNode *> stack;
-  stack.push_back(root.getPointer());
+  std::vector<ExecutionTreeNodeIndex> stack;
+  if (root.getIndex())
+    stack.push_back(root.getIndex());
   while (!stack.empty()) {
-    const ExecutionTreeNode *n = stack.back();
+    ExecutionTreeNodeIndex index = stack.back();
+    const ExecutionTreeNode &n = getNode(index);
     stack.pop_back();
-    os << "\tn" << n << " [shape=diamond";
-    if (n->state)
+    os << "\tn" << index << " [shape=diamond";
+    if (n.state)
       os << ",fillcolor=green";
     os << "];\n";
-    if (n->left.getPointer()) {
-      os << "\tn" << n << " -> n" << n->left.getPointer() << " [label=0b"
-         << std::bitset<PtrBitCount>(n->left.getInt()).to_string() << "];\n";
-      stack.push_back(n->left.getPointer());
+    if (n.left.getIndex()) {
+      os << "\tn" << index << " -> n" << n.left.getIndex() << " [label=0b"
+         << std::bitset<PtrBitCount>(n.left.getInt()).to_string() << "];\n";
+      stack.push_back(n.left.getIndex());
     }
-    if (n->right.getPointer()) {
-      os << "\tn" << n << " -> n" << n->right.getPointer() << " [label=0b"
-         << std::bitset<PtrBitCount>(n->right.getInt()).to_string() << "];\n";
-      stack.push_back(n->right.getPointer());
+    if (n.right.getIndex()) {
+      os << "\tn" << index << " -> n" << n.right.getIndex() << " [label=0b"
+         << std::bitset<PtrBitCount>(n.right.getInt()).to_string() << "];\n";
+      stack.push_back(n.right.getIndex());
     }
   }
   os << "}\n";
@@ -184,8 +227,7 @@ std::uint8_t InMemoryExecutionTree::getNextId() noexcept {
 PersistentExecutionTree::PersistentExecutionTree(
     ExecutionState &initialState, InterpreterHandler &ih) noexcept
     : writer(ih.getOutputFilename("exec_tree.db")) {
-  root = ExecutionTreeNodePtr(createNode(nullptr, &initialState));
-  initialState.executionTreeNode = root.getPointer();
+  root = ExecutionTreeNodePtr(createNode(0, &initialState));
 }
 
 void PersistentExecutionTree::dump(llvm::raw_ostream &os) noexcept {
@@ -193,39 +235,48 @@ void PersistentExecutionTree::dump(llvm::raw_ostream &os) noexcept {
   InMemoryExecutionTree::dump(os);
 }
 
-ExecutionTreeNode *
-PersistentExecutionTree::createNode(ExecutionTreeNode *parent,
+ExecutionTreeNodeIndex
+PersistentExecutionTree::createNode(ExecutionTreeNodeIndex parent,
                                     ExecutionState *state) {
-  return new AnnotatedExecutionTreeNode(parent, state);
+  ExecutionTreeNodeIndex index =
+      InMemoryExecutionTree::createNode(parent, state);
+  if (index >= annotations.size())
+    annotations.resize(index + 1);
+  annotations[index] = ExecutionTreeNodeAnnotation();
+  annotations[index].id = nextID++;
+  return index;
 }
 
 void PersistentExecutionTree::setTerminationType(ExecutionState &state,
                                                  StateTerminationType type) {
-  auto *annotatedNode =
-      llvm::cast<AnnotatedExecutionTreeNode>(state.executionTreeNode);
-  annotatedNode->kind = type;
+  annotations[state.executionTreeNode].kind = type;
 }
 
-void PersistentExecutionTree::updateBranchingNode(ExecutionTreeNode &node,
+void PersistentExecutionTree::updateBranchingNode(ExecutionTreeNodeIndex node,
                                                   BranchType reason) {
-  auto *annotatedNode = llvm::cast<AnnotatedExecutionTreeNode>(&node);
-  const auto &state = *node.state;
+  ExecutionTreeNode &n = getNode(node);
+  auto &annotation = annotations[node];
+  const auto &state = *n.state;
   const auto prevPC = state.prevPC;
-  annotatedNode->asmLine =
-      prevPC && prevPC->info ? prevPC->info->assemblyLine : 0;
-  annotatedNode->kind = reason;
-  writer.write(*annotatedNode);
+  annotation.asmLine =
+      prevPC && prevPC->info ? prevPC->info->getAssemblyLine() : 0;
+  annotation.kind = reason;
+  writer.write(annotation,
+               n.left.getIndex() ? annotations[n.left.getIndex()].id : 0,
+               n.right.getIndex() ? annotations[n.right.getIndex()].id : 0);
 }
 
-void PersistentExecutionTree::updateTerminatingNode(ExecutionTreeNode &node) {
-  assert(node.state);
-  auto *annotatedNode = llvm::cast<AnnotatedExecutionTreeNode>(&node);
-  const auto &state = *node.state;
+void PersistentExecutionTree::updateTerminatingNode(
+    ExecutionTreeNodeIndex node) {
+  ExecutionTreeNode &n = getNode(node);
+  assert(n.state);
+  auto &annotation = annotations[node];
+  const auto &state = *n.state;
   const auto prevPC = state.prevPC;
-  annotatedNode->asmLine =
-      prevPC && prevPC->info ? prevPC->info->assemblyLine : 0;
-  annotatedNode->stateID = state.getID();
-  writer.write(*annotatedNode);
+  annotation.asmLine =
+      prevPC && prevPC->info ? prevPC->info->getAssemblyLine() : 0;
+  annotation.stateID = state.getID();
+  writer.write(annotation, 0, 0);
 }
 
 // Factory
@@ -17,67 +17,69 @@
 #include "klee/Expr/Expr.h"
 #include "klee/Support/ErrorHandling.h"
 
-#include "llvm/ADT/PointerIntPair.h"
 #include "llvm/Support/Casting.h"
 
+#include <cassert>
 #include <cstdint>
+#include <memory>
 #include <variant>
+#include <vector>
 
 namespace klee {
 class ExecutionState;
 class Executor;
 class InMemoryExecutionTree;
 class InterpreterHandler;
-class ExecutionTreeNode;
 class Searcher;
 
+/// Index of an ExecutionTreeNode in the node pool of an InMemoryExecutionTree,
+/// 0 denotes no node
+using ExecutionTreeNodeIndex = std::uint32_t;
+
 /* ExecutionTreeNodePtr is used by the Random Path Searcher object to
 efficiently record which ExecutionTreeNode belongs to it. ExecutionTree is a
 global structure that captures all  states, whereas a Random Path Searcher might
 only care about a subset. The integer part of ExecutionTreeNodePtr is a bitmask
-(a "tag") of which Random Path Searchers ExecutionTreeNode belongs to. */
+(a "tag") of which Random Path Searchers ExecutionTreeNode belongs to. It is
+packed together with the node index into 32 bits. */
 constexpr std::uint8_t PtrBitCount = 3;
-using ExecutionTreeNodePtr =
-    llvm::PointerIntPair<ExecutionTreeNode *, PtrBitCount, uint8_t>;
 
-class ExecutionTreeNode {
+class ExecutionTreeNodePtr {
+  static constexpr std::uint32_t tagMask = (1U << PtrBitCount) - 1;
+
+  std::uint32_t value{0};
+
 public:
-  enum class NodeType : std::uint8_t { Basic, Annotated };
+  /// Largest node index that can be packed together with a tag
+  static constexpr ExecutionTreeNodeIndex maxIndex =
+      ~std::uint32_t(0) >> PtrBitCount;
+
+  ExecutionTreeNodePtr() noexcept = default;
+  explicit ExecutionTreeNodePtr(ExecutionTreeNodeIndex index,
+                                std::uint8_t tag = 0) noexcept
+      : value{index << PtrBitCount | tag} {}
+
+  [[nodiscard]] ExecutionTreeNodeIndex getIndex() const {
+    return value >> PtrBitCount;
+  }
+  [[nodiscard]] std::uint8_t getInt() const { return value & tagMask; }
+  void setInt(std::uint8_t tag) { value = (value & ~tagMask) | tag; }
+};
 
-  ExecutionTreeNode *parent{nullptr};
+class ExecutionTreeNode {
+public:
+  ExecutionTreeNodeIndex parent{0};
   ExecutionTreeNodePtr left;
   ExecutionTreeNodePtr right;
   ExecutionState *state{nullptr};
-
-  ExecutionTreeNode(ExecutionTreeNode *parent, ExecutionState *state) noexcept;
-  virtual ~ExecutionTreeNode() = default;
-  ExecutionTreeNode(const ExecutionTreeNode &) = delete;
-  ExecutionTreeNode &operator=(ExecutionTreeNode const &) = delete;
-  ExecutionTreeNode(ExecutionTreeNode &&) = delete;
-  ExecutionTreeNode &operator=(ExecutionTreeNode &&) = delete;
-
-  [[nodiscard]] virtual NodeType getType() const { return NodeType::Basic; }
-  static bool classof(const ExecutionTreeNode *N) { return true; }
 };
 
-class AnnotatedExecutionTreeNode : public ExecutionTreeNode {
-  inline static std::uint32_t nextID{1};
-
-public:
+/// Data a PersistentExecutionTree records for each node
+struct ExecutionTreeNodeAnnotation {
   std::uint32_t id{0};
   std::uint32_t stateID{0};
   std::uint32_t asmLine{0};
   std::variant<BranchType, StateTerminationType> kind{BranchType::NONE};
-
-  AnnotatedExecutionTreeNode(ExecutionTreeNode *parent,
-                             ExecutionState *state) noexcept;
-  ~AnnotatedExecutionTreeNode() override = default;
-
-  [[nodiscard]] NodeType getType() const override { return NodeType::Annotated; }
-
-  static bool classof(const ExecutionTreeNode *N) {
-    return N->getType() == NodeType::Annotated;
-  }
 };
 
 class ExecutionTree {
@@ -91,12 +93,12 @@ public:
 
   /// Branch from ExecutionTreeNode and attach states, convention: rightState is
   /// parent
-  virtual void attach(ExecutionTreeNode *node, ExecutionState *leftState,
+  virtual void attach(ExecutionTreeNodeIndex node, ExecutionState *leftState,
                       ExecutionState *rightState, BranchType reason) = 0;
   /// Dump execution tree in .dot format into os (debug)
   virtual void dump(llvm::raw_ostream &os) = 0;
   /// Remove node from tree
-  virtual void remove(ExecutionTreeNode *node) = 0;
+  virtual void remove(ExecutionTreeNodeIndex node) = 0;
   /// Set termination type (on state removal)
   virtual void setTerminationType(ExecutionState &state,
                                   StateTerminationType type){}
@@ -119,10 +121,10 @@ class NoopExecutionTree final : public ExecutionTree {
 public:
   NoopExecutionTree() noexcept = default;
   ~NoopExecutionTree() override = default;
-  void attach(ExecutionTreeNode *node, ExecutionState *leftState,
+  void attach(ExecutionTreeNodeIndex node, ExecutionState *leftState,
               ExecutionState *rightState, BranchType reason) noexcept override {}
   void dump(llvm::raw_ostream &os) noexcept override;
-  void remove(ExecutionTreeNode *node) noexcept override {}
+  void remove(ExecutionTreeNodeIndex node) noexcept override {}
 
   [[nodiscard]] ExecutionTreeType getType() const override {
     return ExecutionTreeType::Noop;
@@ -134,29 +136,74 @@ public:
 };
 
 /// @brief An in-memory execution tree required by RandomPathSearcher
+///
+/// Nodes are allocated from slabs of fixed size and referred to by their
+/// 32-bit index, so that they are densely packed and a random-path walk does
+/// not chase pointers across the heap. Removed nodes are recycled through a
+/// free list.
+///
+/// Without --compress-exec-tree, nodes left with a single child stay in the
+/// tree. Before the pool grows by another slab while such nodes take up a
+/// large part of it, they are removed all at once, as by
+/// --compress-exec-tree.
 class InMemoryExecutionTree : public ExecutionTree {
 public:
   ExecutionTreeNodePtr root;
 
 private:
+  static constexpr unsigned SlabBits = 12;
+  static constexpr ExecutionTreeNodeIndex SlabSize = 1U << SlabBits;
+
+  std::vector<std::unique_ptr<ExecutionTreeNode[]>> slabs;
+  /// Next never allocated node index (0 is reserved for "no node")
+  ExecutionTreeNodeIndex nextNode = 1;
+  /// Head of the list of freed nodes, linked through their parent field
+  ExecutionTreeNodeIndex freeNodes = 0;
+  /// Number of nodes with a single child
+  ExecutionTreeNodeIndex singleChildNodes = 0;
+
   /// Number of registered IDs ("users", e.g. RandomPathSearcher)
   std::uint8_t registeredIds = 0;
 
-  virtual ExecutionTreeNode *createNode(ExecutionTreeNode *parent,
-                                        ExecutionState *state);
-  virtual void updateBranchingNode(ExecutionTreeNode &node, BranchType reason) {}
-  virtual void updateTerminatingNode(ExecutionTreeNode &node) {}
+  ExecutionTreeNodeIndex allocateNode();
+  void freeNode(ExecutionTreeNodeIndex index);
+  /// Connect the only child of \p index to its parent and free \p index
+  void removeSingleChildNode(ExecutionTreeNodeIndex index);
+  /// Remove all nodes with a single child
+  void compressSingleChildNodes();
+
+protected:
+  virtual ExecutionTreeNodeIndex createNode(ExecutionTreeNodeIndex parent,
+                                            ExecutionState *state);
+  virtual void updateBranchingNode(ExecutionTreeNodeIndex node,
+                                   BranchType reason) {}
+  virtual void updateTerminatingNode(ExecutionTreeNodeIndex node) {}
 
 public:
   InMemoryExecutionTree() noexcept = default;
   explicit InMemoryExecutionTree(ExecutionState &initialState) noexcept;
   ~InMemoryExecutionTree() override = default;
 
-  void attach(ExecutionTreeNode *node, ExecutionState *leftState,
+  void attach(ExecutionTreeNodeIndex node, ExecutionState *leftState,
               ExecutionState *rightState, BranchType reason) noexcept override;
   void dump(llvm::raw_ostream &os) noexcept override;
   std::uint8_t getNextId() noexcept;
-  void remove(ExecutionTreeNode *node) noexcept override;
+  void remove(ExecutionTreeNodeIndex node) noexcept override;
+
+  ExecutionTreeNode &getNode(ExecutionTreeNodeIndex index) {
+    assert(index && index < nextNode && "Invalid execution tree node");
+    return slabs[index >> SlabBits][index & (SlabSize - 1)];
+  }
+
+  /// Returns the pointer to node \p index, i.e. the child pointer of its
+  /// parent or the root
+  ExecutionTreeNodePtr &getPtrTo(ExecutionTreeNodeIndex index) {
+    ExecutionTreeNodeIndex parent = getNode(index).parent;
+    if (!parent)
+      return root;
+    ExecutionTreeNode &p = getNode(parent);
+    return p.left.getIndex() == index ? p.left : p.right;
+  }
 
   [[nodiscard]] ExecutionTreeType getType() const override {
     return ExecutionTreeType::InMemory;
@@ -172,11 +219,15 @@ public:
 /// database (exec_tree.db) with a ExecutionTreeWriter
 class PersistentExecutionTree : public InMemoryExecutionTree {
   ExecutionTreeWriter writer;
-
-  ExecutionTreeNode *createNode(ExecutionTreeNode *parent,
-                                ExecutionState *state) override;
-  void updateBranchingNode(ExecutionTreeNode &node, BranchType reason) override;
-  void updateTerminatingNode(ExecutionTreeNode &node) override;
+  /// Annotations of the nodes, by node index
+  std::vector<ExecutionTreeNodeAnnotation> annotations;
+  std::uint32_t nextID{1};
+
+  ExecutionTreeNodeIndex createNode(ExecutionTreeNodeIndex parent,
+                                    ExecutionState *state) override;
+  void updateBranchingNode(ExecutionTreeNodeIndex node,
+                           BranchType reason) override;
+  void updateTerminatingNode(ExecutionTreeNodeIndex node) override;
 
 public:
   explicit PersistentExecutionTree(ExecutionState &initialState,
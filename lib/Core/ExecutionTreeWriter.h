@@ -15,7 +15,7 @@
 #include <string>
 
 namespace klee {
-class AnnotatedExecutionTreeNode;
+struct ExecutionTreeNodeAnnotation;
 
 /// @brief Writes execution tree nodes into an SQLite database
 class ExecutionTreeWriter {
@@ -39,8 +39,9 @@ public:
   ExecutionTreeWriter &operator=(const ExecutionTreeWriter &other) = delete;
   ExecutionTreeWriter &operator=(ExecutionTreeWriter &&other) noexcept = delete;
 
-  /// Write new node into database
-  void write(const AnnotatedExecutionTreeNode &node);
+  /// Write new node with the IDs of its children (0 if none) into database
+  void write(const ExecutionTreeNodeAnnotation &node, std::uint32_t leftID,
+             std::uint32_t rightID);
 };
 
 } // namespace klee
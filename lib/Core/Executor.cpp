@@ -9,6 +9,7 @@
 
 #include "Executor.h"
 
+#include "AdaptiveSolverTimeout.h"
 #include "AddressSpace.h"
 #include "Context.h"
 #include "CoreStats.h"
@@ -17,9 +18,11 @@
 #include "ExternalDispatcher.h"
 #include "ImpliedValue.h"
 #include "Memory.h"
+#include "MergeHandler.h"
 #include "MemoryManager.h"
 #include "Searcher.h"
 #include "SeedInfo.h"
+#include "SlowQueryRecorder.h"
 #include "SpecialFunctionHandler.h"
 #include "StatsTracker.h"
 #include "TimingSolver.h"
@@ -31,7 +34,9 @@
 #include "klee/Core/Interpreter.h"
 #include "klee/Expr/ArrayExprOptimizer.h"
 #include "klee/Expr/Assignment.h"
+#include "klee/Expr/CompiledExpr.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
 #include "klee/Expr/ExprPPrinter.h"
 #include "klee/Expr/ExprSMTLIBPrinter.h"
 #include "klee/Expr/ExprUtil.h"
@@ -86,6 +91,7 @@
 #include <iomanip>
 #include <iosfwd>
 #include <limits>
+#include <set>
 #include <sstream>
 #include <string>
 #include <sys/mman.h>
@@ -162,6 +168,13 @@ cl::opt<unsigned> MaxSymArraySize(
     cl::init(0),
     cl::cat(SolvingCat));
 
+cl::opt<unsigned> MaxSymbolicCallTargets(
+    "max-symbolic-call-targets", cl::init(16),
+    cl::desc("Enumerate at most this many targets of a symbolic function "
+             "pointer at a time. The remaining targets are enumerated when "
+             "the state executes the call again (default=16)"),
+    cl::cat(SolvingCat));
+
 cl::opt<bool>
     SimplifySymIndices("simplify-sym-indices",
                        cl::init(false),
@@ -175,6 +188,70 @@ cl::opt<bool>
                                   "querying the solver (default=true)"),
                          cl::cat(SolvingCat));
 
+cl::opt<bool> UseStateModelCache(
+    "use-state-model-cache", cl::init(false),
+    cl::desc("Keep a satisfying assignment per state and use it to decide "
+             "one side of a branch without querying the solver "
+             "(default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<unsigned> MaxSlowQueries(
+    "max-slow-queries", cl::init(10),
+    cl::desc("Number of slowest solver queries written to slow-query<N>.kquery "
+             "with the state that issued them, along with as many of the "
+             "first failed queries (default=10)"),
+    cl::cat(SolvingCat));
+
+cl::opt<std::string> MinSlowQueryTime(
+    "min-slow-query-time", cl::init("1s"),
+    cl::desc("Only write solver queries taking at least this long to "
+             "slow-query<N>.kquery (default=1s)"),
+    cl::cat(SolvingCat));
+
+cl::opt<bool> AdaptiveSolverTime(
+    "adaptive-solver-time", cl::init(false),
+    cl::desc("Time out branch and bounds-check queries after the mean plus "
+             "--adaptive-solver-time-deviations standard deviations of the "
+             "earlier queries at the same instruction. A state whose query "
+             "times out is deferred until the next "
+             "--adaptive-solver-time-retry or until no other states are "
+             "left, then retries it with --max-solver-time. Requires "
+             "--max-solver-time (default=false)"),
+    cl::cat(SolvingCat));
+
+cl::opt<std::string> AdaptiveSolverTimeRetry(
+    "adaptive-solver-time-retry", cl::init("10s"),
+    cl::desc("Interval at which states deferred by --adaptive-solver-time "
+             "retry their query, even if other states are left. Set to 0s to "
+             "retry only when no other states are left (default=10s)"),
+    cl::cat(SolvingCat));
+
+cl::opt<std::string> AdaptiveSolverTimeMin(
+    "adaptive-solver-time-min", cl::init("100ms"),
+    cl::desc("Minimum timeout for queries under --adaptive-solver-time "
+             "(default=100ms)"),
+    cl::cat(SolvingCat));
+
+cl::opt<std::string> AdaptiveSolverTimeMax(
+    "adaptive-solver-time-max", cl::init(""),
+    cl::desc("Maximum timeout for queries under --adaptive-solver-time, also "
+             "used until enough queries have been observed. Queries timing "
+             "out are still retried with --max-solver-time "
+             "(default=--max-solver-time)"),
+    cl::cat(SolvingCat));
+
+cl::opt<double> AdaptiveSolverTimeDeviations(
+    "adaptive-solver-time-deviations", cl::init(4.0),
+    cl::desc("Standard deviations above the mean query time allowed under "
+             "--adaptive-solver-time (default=4)"),
+    cl::cat(SolvingCat));
+
+cl::opt<unsigned> AdaptiveSolverTimeSamples(
+    "adaptive-solver-time-samples", cl::init(16),
+    cl::desc("Queries to observe before --adaptive-solver-time lowers "
+             "timeouts below --max-solver-time (default=16)"),
+    cl::cat(SolvingCat));
+
 
 /*** External call policy options ***/
 
@@ -483,15 +560,23 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
       ivcEnabled(false), debugLogBuffer(debugBufferString) {
 
 
-  const time::Span maxTime{MaxTime};
-  if (maxTime) timers.add(
-        std::make_unique<Timer>(maxTime, [&]{
-        klee_message("HaltTimer invoked");
-        setHaltExecution(true);
-      }));
+  setHaltTimer(time::Span{MaxTime});
 
   coreSolverTimeout = time::Span{MaxCoreSolverTime};
   if (coreSolverTimeout) UseForkedCoreSolver = true;
+  if (AdaptiveSolverTime) {
+    if (!coreSolverTimeout)
+      klee_error("--adaptive-solver-time requires --max-solver-time");
+    time::Span maxTimeout = coreSolverTimeout;
+    if (const time::Span max{AdaptiveSolverTimeMax})
+      maxTimeout = std::min(max, coreSolverTimeout);
+    adaptiveSolverTimeout = std::make_unique<AdaptiveSolverTimeout>(
+        std::min(time::Span(AdaptiveSolverTimeMin), maxTimeout), maxTimeout,
+        AdaptiveSolverTimeDeviations, AdaptiveSolverTimeSamples);
+    if (const time::Span retry{AdaptiveSolverTimeRetry})
+      timers.add(std::make_unique<Timer>(
+          retry, [&] { retryDeferredStates = !deferredStates.empty(); }));
+  }
   std::unique_ptr<Solver> coreSolver = klee::createCoreSolver(CoreSolverToUse);
   if (!coreSolver) {
     klee_error("Failed to create core solver\n");
@@ -502,7 +587,13 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
       interpreterHandler->getOutputFilename(ALL_QUERIES_SMT2_FILE_NAME),
       interpreterHandler->getOutputFilename(SOLVER_QUERIES_SMT2_FILE_NAME),
       interpreterHandler->getOutputFilename(ALL_QUERIES_KQUERY_FILE_NAME),
-      interpreterHandler->getOutputFilename(SOLVER_QUERIES_KQUERY_FILE_NAME));
+      interpreterHandler->getOutputFilename(SOLVER_QUERIES_KQUERY_FILE_NAME),
+      interpreterHandler->getOutputFilename(ALL_QUERIES_KQLOG_FILE_NAME),
+      interpreterHandler->getOutputFilename(SOLVER_QUERIES_KQLOG_FILE_NAME));
+
+  slowQueries = std::make_unique<SlowQueryRecorder>(
+      MaxSlowQueries, time::Span(MinSlowQueryTime));
+  solver = createSlowQueryRecordingSolver(std::move(solver), *slowQueries);
 
   this->solver = std::make_unique<TimingSolver>(std::move(solver), EqualitySubstitution);
   memory = std::make_unique<MemoryManager>(&arrayCache);
@@ -545,43 +636,73 @@ Executor::setModule(std::vector<std::unique_ptr<llvm::Module>> &modules,
 
   // Preparing the final module happens in multiple stages
 
-  // Link with KLEE intrinsics library before running any optimizations
-  SmallString<128> LibPath(opts.LibraryDir);
-  llvm::sys::path::append(LibPath,
-                          "libkleeRuntimeIntrinsic" + opts.OptSuffix + ".bca");
-  std::string error;
-  if (!klee::loadFile(LibPath.c_str(), modules[0]->getContext(), modules,
-                      error)) {
-    klee_error("Could not load KLEE intrinsic file %s", LibPath.c_str());
-  }
+  if (opts.FromModuleCache) {
+    // The cached module went through all stages up to manifesting before
+    kmodule->link(modules, opts.EntryPoint);
+    specialFunctionHandler = new SpecialFunctionHandler(*this);
+    std::vector<const char *> preservedFunctions;
+    specialFunctionHandler->prepare(preservedFunctions);
+    kmodule->addInternalFunctions(opts);
+    kmodule->manifest(interpreterHandler, StatsTracker::useStatistics(),
+                      opts.ModuleCache);
+  } else {
+    // Only the functions of the program under test, which comes first, get
+    // automatic merge regions, not those of the runtime libraries
+    std::set<std::string> userFunctions;
+    if (AutoMerge) {
+      for (const Function &f : *modules.front())
+        if (!f.isDeclaration())
+          userFunctions.insert(f.getName().str());
+    }
 
-  // 1.) Link the modules together
-  while (kmodule->link(modules, opts.EntryPoint)) {
-    // 2.) Apply different instrumentation
-    kmodule->instrument(opts);
-  }
+    // Link with KLEE intrinsics library before running any optimizations
+    SmallString<128> LibPath(opts.LibraryDir);
+    llvm::sys::path::append(LibPath, "libkleeRuntimeIntrinsic" +
+                                         opts.OptSuffix + ".bca");
+    std::string error;
+    if (!klee::loadFile(LibPath.c_str(), modules[0]->getContext(), modules,
+                        error)) {
+      klee_error("Could not load KLEE intrinsic file %s", LibPath.c_str());
+    }
 
-  // 3.) Optimise and prepare for KLEE
+    // 1.) Link the modules together
+    while (kmodule->link(modules, opts.EntryPoint)) {
+      // 2.) Apply different instrumentation
+      kmodule->instrument(opts);
+    }
+
+    // 3.) Optimise and prepare for KLEE
 
-  // Create a list of functions that should be preserved if used
-  std::vector<const char *> preservedFunctions;
-  specialFunctionHandler = new SpecialFunctionHandler(*this);
-  specialFunctionHandler->prepare(preservedFunctions);
+    // Create a list of functions that should be preserved if used
+    std::vector<const char *> preservedFunctions;
+    specialFunctionHandler = new SpecialFunctionHandler(*this);
+    specialFunctionHandler->prepare(preservedFunctions);
 
-  preservedFunctions.push_back(opts.EntryPoint.c_str());
+    preservedFunctions.push_back(opts.EntryPoint.c_str());
 
-  // Preserve the free-standing library calls
-  preservedFunctions.push_back("memset");
-  preservedFunctions.push_back("memcpy");
-  preservedFunctions.push_back("memcmp");
-  preservedFunctions.push_back("bcmp");
-  preservedFunctions.push_back("memmove");
+    // Preserve the free-standing library calls
+    preservedFunctions.push_back("memset");
+    preservedFunctions.push_back("memcpy");
+    preservedFunctions.push_back("memcmp");
+    preservedFunctions.push_back("bcmp");
+    preservedFunctions.push_back("memmove");
 
-  kmodule->optimiseAndPrepare(opts, preservedFunctions);
-  kmodule->checkModule();
+    kmodule->optimiseAndPrepare(opts, preservedFunctions);
+    if (AutoMerge) {
+      unsigned regions = kmodule->insertMergePoints(
+          userFunctions, "klee_auto_open_merge", "klee_auto_close_merge",
+          AutoMergeMaxBlocks, AutoMergeLoops);
+      klee_message("Inserted %u automatic merge regions", regions);
+    }
+    kmodule->checkModule();
 
-  // 4.) Manifest the module
-  kmodule->manifest(interpreterHandler, StatsTracker::useStatistics());
+    // 4.) Manifest the module
+    kmodule->manifest(interpreterHandler, StatsTracker::useStatistics());
+
+    if (!opts.ModuleCache.empty() && !kmodule->writeCache(opts.ModuleCache))
+      klee_warning("Unable to write module cache entry %s",
+                   opts.ModuleCache.c_str());
+  }
 
   specialFunctionHandler->bind();
 
@@ -894,7 +1015,8 @@ bool Executor::branchingPermitted(const ExecutionState &state) const {
 void Executor::branch(ExecutionState &state,
                       const std::vector<ref<Expr>> &conditions,
                       std::vector<ExecutionState *> &result,
-                      BranchType reason) {
+                      BranchType reason,
+                      const std::vector<std::shared_ptr<const Assignment>> &models) {
   TimerStatIncrementer timer(stats::forkTime);
   unsigned N = conditions.size();
   assert(N);
@@ -937,19 +1059,15 @@ void Executor::branch(ExecutionState &state,
     // Assume each seed only satisfies one condition (necessarily true
     // when conditions are mutually exclusive and their conjunction is
     // a tautology).
+    std::vector<ref<ConstantExpr>> values;
+    getSeedValues(state, seeds, conditions, values);
     for (std::vector<SeedInfo>::iterator siit = seeds.begin(), 
            siie = seeds.end(); siit != siie; ++siit) {
+      const ref<ConstantExpr> *res = &values[(siit - seeds.begin()) * N];
       unsigned i;
-      for (i=0; i<N; ++i) {
-        ref<ConstantExpr> res;
-        bool success = solver->getValue(
-            state.constraints, siit->assignment.evaluate(conditions[i]), res,
-            state.queryMetaData);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void) success;
-        if (res->isTrue())
+      for (i=0; i<N; ++i)
+        if (res[i]->isTrue())
           break;
-      }
       
       // If we didn't find a satisfying condition randomly pick one
       // (the seed will be patched).
@@ -971,9 +1089,13 @@ void Executor::branch(ExecutionState &state,
     }
   }
 
-  for (unsigned i=0; i<N; ++i)
-    if (result[i])
+  for (unsigned i=0; i<N; ++i) {
+    if (result[i]) {
+      if (UseStateModelCache && !models.empty())
+        result[i]->model = models[i];
       addConstraint(*result[i], conditions[i]);
+    }
+  }
 }
 
 ref<Expr> Executor::maxStaticPctChecks(ExecutionState &current,
@@ -1042,18 +1164,54 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
   if (!isSeeding)
     condition = maxStaticPctChecks(current, condition);
 
+  // Only branches are executed again if their query is deferred, which
+  // needs a searcher to take the state out of, unlike seeding
+  bool adaptive = adaptiveSolverTimeout && searcher &&
+                  reason == BranchType::Conditional &&
+                  !isa<ConstantExpr>(condition);
   time::Span timeout = coreSolverTimeout;
   if (isSeeding)
     timeout *= static_cast<unsigned>(it->second.size());
+  else if (adaptive)
+    timeout = getAdaptiveTimeout(current);
+  bool deferrable = adaptive && canDeferQuery(timeout);
+  time::Span queryCost = current.queryMetaData.queryCost;
+  std::uint64_t solverQueries = stats::solverQueries;
+  slowQueries->setFailureDeferred(deferrable);
   solver->setTimeout(timeout);
-  bool success = solver->evaluate(current.constraints, condition, res,
-                                  current.queryMetaData);
+  std::shared_ptr<const Assignment> trueModel, falseModel;
+  bool success;
+  if (UseStateModelCache) {
+    success =
+        solver->evaluate(current.constraints, condition, res,
+                         current.queryMetaData, current.model, trueModel,
+                         falseModel);
+  } else {
+    success = solver->evaluate(current.constraints, condition, res,
+                               current.queryMetaData);
+  }
   solver->setTimeout(time::Span());
+  slowQueries->setFailureDeferred(false);
   if (!success) {
-    current.pc = current.prevPC;
-    terminateStateOnSolverError(current, "Query timed out (fork).");
+    if (deferrable) {
+      deferQuery(current);
+    } else {
+      current.pc = current.prevPC;
+      terminateStateOnSolverError(current, "Query timed out (fork).");
+    }
     return StatePair(nullptr, nullptr);
   }
+  // Answers from the caches would make the core solver look faster
+  if (adaptive && stats::solverQueries != solverQueries)
+    adaptiveSolverTimeout->update(current.prevPC->info->id,
+                                  current.queryMetaData.queryCost - queryCost);
+
+  // Keep the model of the side the current state continues on, in case the
+  // solver had to provide one.
+  if (res == Solver::True && trueModel)
+    current.model = trueModel;
+  else if (res == Solver::False && falseModel)
+    current.model = falseModel;
 
   if (!isSeeding) {
     if (replayPath && !isInternal) {
@@ -1069,9 +1227,11 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
         // add constraints
         if(branch) {
           res = Solver::True;
+          current.model = trueModel;
           addConstraint(current, condition);
         } else  {
           res = Solver::False;
+          current.model = falseModel;
           addConstraint(current, Expr::createIsZero(condition));
         }
       }
@@ -1081,9 +1241,11 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       if (!branchingPermitted(current)) {
         TimerStatIncrementer timer(stats::forkTime);
         if (theRNG.getBool()) {
+          current.model = trueModel;
           addConstraint(current, condition);
           res = Solver::True;        
         } else {
+          current.model = falseModel;
           addConstraint(current, Expr::createIsZero(condition));
           res = Solver::False;
         }
@@ -1099,14 +1261,9 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       res == Solver::Unknown) {
     bool trueSeed=false, falseSeed=false;
     // Is seed extension still ok here?
-    for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
-           siie = it->second.end(); siit != siie; ++siit) {
-      ref<ConstantExpr> res;
-      bool success = solver->getValue(current.constraints,
-                                      siit->assignment.evaluate(condition), res,
-                                      current.queryMetaData);
-      assert(success && "FIXME: Unhandled solver failure");
-      (void) success;
+    std::vector<ref<ConstantExpr>> values;
+    getSeedValues(current, it->second, {condition}, values);
+    for (const auto &res : values) {
       if (res->isTrue()) {
         trueSeed = true;
       } else {
@@ -1119,6 +1276,7 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       assert(trueSeed || falseSeed);
       
       res = trueSeed ? Solver::True : Solver::False;
+      current.model = trueSeed ? trueModel : falseModel;
       addConstraint(current, trueSeed ? condition : Expr::createIsZero(condition));
     }
   }
@@ -1161,15 +1319,11 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       it->second.clear();
       std::vector<SeedInfo> &trueSeeds = seedMap[trueState];
       std::vector<SeedInfo> &falseSeeds = seedMap[falseState];
+      std::vector<ref<ConstantExpr>> values;
+      getSeedValues(current, seeds, {condition}, values);
       for (std::vector<SeedInfo>::iterator siit = seeds.begin(), 
              siie = seeds.end(); siit != siie; ++siit) {
-        ref<ConstantExpr> res;
-        bool success = solver->getValue(current.constraints,
-                                        siit->assignment.evaluate(condition),
-                                        res, current.queryMetaData);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void) success;
-        if (res->isTrue()) {
+        if (values[siit - seeds.begin()]->isTrue()) {
           trueSeeds.push_back(*siit);
         } else {
           falseSeeds.push_back(*siit);
@@ -1187,7 +1341,8 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       }
       if (swapInfo) {
         std::swap(trueState->coveredNew, falseState->coveredNew);
-        std::swap(trueState->coveredLines, falseState->coveredLines);
+        std::swap(trueState->coveredInstructions,
+                  falseState->coveredInstructions);
       }
     }
 
@@ -1211,6 +1366,8 @@ Executor::StatePair Executor::fork(ExecutionState &current, ref<Expr> condition,
       }
     }
 
+    trueState->model = trueModel;
+    falseState->model = falseModel;
     addConstraint(*trueState, condition);
     addConstraint(*falseState, Expr::createIsZero(condition));
 
@@ -1237,11 +1394,12 @@ void Executor::addConstraint(ExecutionState &state, ref<Expr> condition) {
     seedMap.find(&state);
   if (it != seedMap.end()) {
     bool warn = false;
+    CompiledExpr compiled(condition);
     for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
            siie = it->second.end(); siit != siie; ++siit) {
       bool res;
       bool success = solver->mustBeFalse(state.constraints,
-                                         siit->assignment.evaluate(condition),
+                                         compiled.evaluate(siit->assignment),
                                          res, state.queryMetaData);
       assert(success && "FIXME: Unhandled solver failure");
       (void) success;
@@ -1274,8 +1432,8 @@ const Cell& Executor::eval(KInstruction *ki, unsigned index,
     return kmodule->constantTable[index];
   } else {
     unsigned index = vnumber;
-    StackFrame &sf = state.stack.back();
-    return sf.locals[index];
+    const StackFrame &sf = state.stack.back();
+    return sf.getLocal(index);
   }
 }
 
@@ -1344,6 +1502,40 @@ ref<klee::ConstantExpr> Executor::toConstant(ExecutionState &state, ref<Expr> e,
   return cvalue;
 }
 
+void Executor::getSeedValues(ExecutionState &state,
+                             const std::vector<SeedInfo> &seeds,
+                             const std::vector<ref<Expr>> &exprs,
+                             std::vector<ref<ConstantExpr>> &values) {
+  std::vector<const Assignment *> assignments;
+  assignments.reserve(seeds.size());
+  for (const SeedInfo &seed : seeds)
+    assignments.push_back(&seed.assignment);
+
+  std::vector<ref<Expr>> evaluated;
+  CompiledExpr(exprs.begin(), exprs.end()).evaluate(assignments, evaluated);
+
+  // Seeds that leave some bytes free may not fold an expression to a
+  // constant; concretize each distinct residual expression only once.
+  ExprHashMap<ref<ConstantExpr>> residuals;
+  values.resize(evaluated.size());
+  for (std::size_t i = 0; i != evaluated.size(); ++i) {
+    if (ConstantExpr *CE = dyn_cast<ConstantExpr>(evaluated[i])) {
+      values[i] = CE;
+      continue;
+    }
+    auto res = residuals.find(evaluated[i]);
+    if (res == residuals.end()) {
+      ref<ConstantExpr> value;
+      bool success = solver->getValue(state.constraints, evaluated[i], value,
+                                      state.queryMetaData);
+      assert(success && "FIXME: Unhandled solver failure");
+      (void) success;
+      res = residuals.insert(std::make_pair(evaluated[i], value)).first;
+    }
+    values[i] = res->second;
+  }
+}
+
 ref<klee::ConstantExpr> Executor::getValueFromSeeds(ExecutionState &state,
                                                     ref<Expr> e) {
   auto found = seedMap.find(&state);
@@ -1351,8 +1543,9 @@ ref<klee::ConstantExpr> Executor::getValueFromSeeds(ExecutionState &state,
     return nullptr;
 
   auto seeds = found->second;
+  CompiledExpr compiled(e);
   for (auto const &seed : seeds) {
-    auto value = seed.assignment.evaluate(e);
+    auto value = compiled.evaluate(seed.assignment);
     if (isa<ConstantExpr>(value))
       return value;
   }
@@ -1375,9 +1568,10 @@ void Executor::executeGetValue(ExecutionState &state,
     bindLocal(target, state, value);
   } else {
     std::set< ref<Expr> > values;
+    CompiledExpr compiled(e);
     for (std::vector<SeedInfo>::iterator siit = it->second.begin(), 
            siie = it->second.end(); siit != siie; ++siit) {
-      ref<Expr> cond = siit->assignment.evaluate(e);
+      ref<Expr> cond = compiled.evaluate(siit->assignment);
       cond = optimizer.optimizeExpr(cond, true);
       ref<ConstantExpr> value;
       bool success =
@@ -1429,7 +1623,7 @@ void Executor::printDebugInstructions(ExecutionState &state) {
     (*stream) << "     " << state.pc->getSourceLocation() << ':';
   }
 
-  (*stream) << state.pc->info->assemblyLine << ':' << state.getID();
+  (*stream) << state.pc->info->getAssemblyLine() << ':' << state.getID();
 
   if (DebugPrintInstructions.isSet(STDERR_ALL) ||
       DebugPrintInstructions.isSet(FILE_ALL))
@@ -1451,9 +1645,14 @@ void Executor::stepInstruction(ExecutionState &state) {
   printDebugInstructions(state);
   if (statsTracker)
     statsTracker->stepInstruction(state);
+  slowQueries->setState(&state);
 
   ++stats::instructions;
   ++state.steppedInstructions;
+  // Only the instruction a deferred state executes again retries its query,
+  // even if it issues no query with an adaptive timeout this time
+  if (state.pc != state.prevPC)
+    state.retryQuery = false;
   state.prevPC = state.pc;
   ++state.pc;
 
@@ -1461,6 +1660,14 @@ void Executor::stepInstruction(ExecutionState &state) {
     haltExecution = true;
 }
 
+void Executor::rewindInstruction(ExecutionState &state) {
+  state.pc = state.prevPC;
+  if (statsTracker)
+    statsTracker->rewindInstruction(state);
+  stats::instructions += (uint64_t)-1;
+  --state.steppedInstructions;
+}
+
 static inline const llvm::fltSemantics *fpWidthToSemantics(unsigned width) {
   switch (width) {
   case Expr::Int32:
@@ -1642,7 +1849,7 @@ void Executor::unwindToNextLandingpad(ExecutionState &state) {
 
         llvm::Function *personality_fn =
             kmodule->module->getFunction("_klee_eh_cxx_personality");
-        KFunction *kf = kmodule->functionMap[personality_fn];
+        KFunction *kf = getKFunction(personality_fn);
 
         state.pushFrame(state.prevPC, kf);
         state.pc = kf->instructions;
@@ -1711,7 +1918,7 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
     switch (f->getIntrinsicID()) {
     case Intrinsic::not_intrinsic: {
       // state may be destroyed by this call, cannot touch
-      callExternalFunction(state, ki, kmodule->functionMap[f], arguments);
+      callExternalFunction(state, ki, getKFunction(f), arguments);
       break;
     }
     case Intrinsic::fabs: {
@@ -1936,7 +2143,7 @@ void Executor::executeCall(ExecutionState &state, KInstruction *ki, Function *f,
     // guess. This just done to avoid having to pass KInstIterator everywhere
     // instead of the actual instruction, since we can't make a KInstIterator
     // from just an instruction (unlike LLVM).
-    KFunction *kf = kmodule->functionMap[f];
+    KFunction *kf = getKFunction(f);
 
     state.pushFrame(state.prevPC, kf);
     state.pc = kf->instructions;
@@ -2259,7 +2466,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
     ref<Expr> errorCase = ConstantExpr::alloc(1, Expr::Bool);
     SmallPtrSet<BasicBlock *, 5> destinations;
-    // collect and check destinations from label list
+    std::vector<BasicBlock *> candidates;
+    std::vector<ref<Expr>> conditions;
+    // collect destinations from label list
     for (unsigned k = 0; k < numDestinations; ++k) {
       // filter duplicates
       const auto d = bi->getDestination(k);
@@ -2273,28 +2482,31 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       // exclude address from errorCase
       errorCase = AndExpr::create(errorCase, Expr::createIsZero(e));
 
-      // check feasibility
-      bool result;
-      bool success __attribute__((unused)) =
-          solver->mayBeTrue(state.constraints, e, result, state.queryMetaData);
-      assert(success && "FIXME: Unhandled solver failure");
-      if (result) {
-        targets.push_back(d);
-        expressions.push_back(e);
-      }
+      candidates.push_back(d);
+      conditions.push_back(e);
     }
-    // check errorCase feasibility
-    bool result;
-    bool success __attribute__((unused)) = solver->mayBeTrue(
-        state.constraints, errorCase, result, state.queryMetaData);
+    conditions.push_back(errorCase);
+
+    // check feasibility of all destinations and the errorCase at once
+    std::vector<bool> feasible;
+    std::vector<std::shared_ptr<const Assignment>> models, feasibleModels;
+    bool success __attribute__((unused)) = solver->getFeasibleConditions(
+        state.constraints, conditions, feasible, models, state.queryMetaData,
+        state.model);
     assert(success && "FIXME: Unhandled solver failure");
-    if (result) {
-      expressions.push_back(errorCase);
+    for (std::size_t k = 0; k < conditions.size(); ++k) {
+      if (!feasible[k])
+        continue;
+      if (k < candidates.size())
+        targets.push_back(candidates[k]);
+      expressions.push_back(conditions[k]);
+      feasibleModels.push_back(models[k]);
     }
+    const bool result = feasible.back();
 
     // fork states
     std::vector<ExecutionState *> branches;
-    branch(state, expressions, branches, BranchType::Indirect);
+    branch(state, expressions, branches, BranchType::Indirect, feasibleModels);
 
     // terminate error state
     if (result) {
@@ -2348,7 +2560,10 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       // Track default branch values
       ref<Expr> defaultValue = ConstantExpr::alloc(1, Expr::Bool);
 
-      // iterate through all non-default cases but in order of the expressions
+      // Collect the case conditions in order of the expressions, followed by
+      // the default case
+      std::vector<ref<Expr>> matches;
+      std::vector<BasicBlock *> successors;
       for (std::map<ref<Expr>, BasicBlock *>::iterator
                it = expressionOrder.begin(),
                itE = expressionOrder.end();
@@ -2362,61 +2577,60 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         // Make sure that the default value does not contain this target's value
         defaultValue = AndExpr::create(defaultValue, Expr::createIsZero(match));
 
-        // Check if control flow could take this case
-        bool result;
-        match = optimizer.optimizeExpr(match, false);
-        bool success = solver->mayBeTrue(state.constraints, match, result,
-                                         state.queryMetaData);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void) success;
-        if (result) {
-          BasicBlock *caseSuccessor = it->second;
-
-          // Handle the case that a basic block might be the target of multiple
-          // switch cases.
-          // Currently we generate an expression containing all switch-case
-          // values for the same target basic block. We spare us forking too
-          // many times but we generate more complex condition expressions
-          // TODO Add option to allow to choose between those behaviors
-          std::pair<std::map<BasicBlock *, ref<Expr> >::iterator, bool> res =
-              branchTargets.insert(std::make_pair(
-                  caseSuccessor, ConstantExpr::alloc(0, Expr::Bool)));
-
-          res.first->second = OrExpr::create(match, res.first->second);
-
-          // Only add basic blocks which have not been target of a branch yet
-          if (res.second) {
-            bbOrder.push_back(caseSuccessor);
-          }
-        }
+        matches.push_back(optimizer.optimizeExpr(match, false));
+        successors.push_back(it->second);
       }
-
-      // Check if control could take the default case
-      defaultValue = optimizer.optimizeExpr(defaultValue, false);
-      bool res;
-      bool success = solver->mayBeTrue(state.constraints, defaultValue, res,
-                                       state.queryMetaData);
+      matches.push_back(optimizer.optimizeExpr(defaultValue, false));
+      successors.push_back(si->getDefaultDest());
+
+      // Check which cases control flow could take. Rather than one query per
+      // case, this enumerates satisfying assignments, so the number of queries
+      // depends on the number of feasible cases only.
+      std::vector<bool> feasible;
+      std::vector<std::shared_ptr<const Assignment>> models;
+      bool success = solver->getFeasibleConditions(
+          state.constraints, matches, feasible, models, state.queryMetaData,
+          state.model);
       assert(success && "FIXME: Unhandled solver failure");
       (void) success;
-      if (res) {
-        std::pair<std::map<BasicBlock *, ref<Expr> >::iterator, bool> ret =
-            branchTargets.insert(
-                std::make_pair(si->getDefaultDest(), defaultValue));
-        if (ret.second) {
-          bbOrder.push_back(si->getDefaultDest());
+
+      std::map<BasicBlock *, std::shared_ptr<const Assignment>> targetModels;
+      for (std::size_t k = 0; k < matches.size(); ++k) {
+        if (!feasible[k])
+          continue;
+        BasicBlock *caseSuccessor = successors[k];
+
+        // Handle the case that a basic block might be the target of multiple
+        // switch cases.
+        // Currently we generate an expression containing all switch-case
+        // values for the same target basic block. We spare us forking too
+        // many times but we generate more complex condition expressions
+        // TODO Add option to allow to choose between those behaviors
+        std::pair<std::map<BasicBlock *, ref<Expr> >::iterator, bool> res =
+            branchTargets.insert(std::make_pair(
+                caseSuccessor, ConstantExpr::alloc(0, Expr::Bool)));
+
+        res.first->second = OrExpr::create(matches[k], res.first->second);
+
+        // Only add basic blocks which have not been target of a branch yet
+        if (res.second) {
+          bbOrder.push_back(caseSuccessor);
+          targetModels[caseSuccessor] = models[k];
         }
       }
 
       // Fork the current state with each state having one of the possible
       // successors of this switch
       std::vector< ref<Expr> > conditions;
+      std::vector<std::shared_ptr<const Assignment>> conditionModels;
       for (std::vector<BasicBlock *>::iterator it = bbOrder.begin(),
                                                ie = bbOrder.end();
            it != ie; ++it) {
         conditions.push_back(branchTargets[*it]);
+        conditionModels.push_back(targetModels[*it]);
       }
       std::vector<ExecutionState*> branches;
-      branch(state, conditions, branches, BranchType::Switch);
+      branch(state, conditions, branches, BranchType::Switch, conditionModels);
 
       std::vector<ExecutionState*>::iterator bit = branches.begin();
       for (std::vector<BasicBlock *>::iterator it = bbOrder.begin(),
@@ -2504,45 +2718,68 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       executeCall(state, ki, f, arguments);
     } else {
       ref<Expr> v = eval(ki, 0, state).value;
+      v = optimizer.optimizeExpr(v, true);
+
+      // Enumerate a bounded number of targets, using one query per target.
+      // Forking more than one target is pointless if branching is not
+      // permitted.
+      std::size_t maxValues = 1;
+      if (branchingPermitted(state))
+        maxValues = std::max(1u, MaxSymbolicCallTargets.getValue());
+      std::vector<std::pair<ref<ConstantExpr>, std::shared_ptr<const Assignment>>>
+          values;
+      std::shared_ptr<const Assignment> remaining;
+      solver->setTimeout(coreSolverTimeout);
+      bool success =
+          solver->getValues(state.constraints, v, maxValues, values, remaining,
+                            state.queryMetaData, state.model);
+      solver->setTimeout(time::Span());
+      if (!success) {
+        state.pc = state.prevPC;
+        terminateStateOnSolverError(state, "Query timed out (call).");
+        break;
+      }
 
-      ExecutionState *free = &state;
-      bool hasInvalid = false, first = true;
-
-      /* XXX This is wasteful, no need to do a full evaluate since we
-         have already got a value. But in the end the caches should
-         handle it for us, albeit with some overhead. */
-      do {
-        v = optimizer.optimizeExpr(v, true);
-        ref<ConstantExpr> value;
-        bool success =
-            solver->getValue(free->constraints, v, value, free->queryMetaData);
-        assert(success && "FIXME: Unhandled solver failure");
-        (void) success;
-        StatePair res = fork(*free, EqExpr::create(v, value), true, BranchType::Call);
-        if (res.first) {
-          uint64_t addr = value->getZExtValue();
-          auto it = legalFunctions.find(addr);
-          if (it != legalFunctions.end()) {
-            f = it->second;
-
-            // Don't give warning on unique resolution
-            if (res.second || !first)
-              klee_warning_once(reinterpret_cast<void*>(addr),
-                                "resolved symbolic function pointer to: %s",
-                                f->getName().data());
-
-            executeCall(*res.first, ki, f, arguments);
-          } else {
-            if (!hasInvalid) {
-              terminateStateOnExecError(state, "invalid function pointer");
-              hasInvalid = true;
-            }
-          }
-        }
+      std::vector<ref<Expr>> conditions;
+      std::vector<std::shared_ptr<const Assignment>> models;
+      ref<Expr> others = ConstantExpr::alloc(1, Expr::Bool);
+      for (const auto &value : values) {
+        ref<Expr> isValue = EqExpr::create(v, value.first);
+        conditions.push_back(isValue);
+        models.push_back(value.second);
+        others = AndExpr::create(Expr::createIsZero(isValue), others);
+      }
+      // The state taking none of the enumerated targets executes the call
+      // again, so that the main loop gets to check the time and fork limits
+      // before the next targets are enumerated.
+      if (remaining) {
+        conditions.push_back(others);
+        models.push_back(remaining);
+      }
+      std::vector<ExecutionState *> branches;
+      branch(state, conditions, branches, BranchType::Call, models);
+      if (remaining && branches.back())
+        rewindInstruction(*branches.back());
 
-        first = false;
-        free = res.second;
-      } while (free);
+      for (std::size_t k = 0; k < values.size(); ++k) {
+        if (!branches[k])
+          continue;
+        uint64_t addr = values[k].first->getZExtValue();
+        auto it = legalFunctions.find(addr);
+        if (it != legalFunctions.end()) {
+          f = it->second;
+
+          // Don't give warning on unique resolution
+          if (values.size() > 1 || remaining)
+            klee_warning_once(reinterpret_cast<void*>(addr),
+                              "resolved symbolic function pointer to: %s",
+                              f->getName().data());
+
+          executeCall(*branches[k], ki, f, arguments);
+        } else {
+          terminateStateOnExecError(*branches[k], "invalid function pointer");
+        }
+      }
     }
     break;
   }
@@ -2819,10 +3056,10 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         if (state.addressSpace.resolveOne(c_orig_base, op)) {
           // store the address of the MemoryObject associated with this GEP
           // instruction
-          state.base_mos[op.first->address].insert(base);
-          ref<ConstantExpr> r =
-              ConstantExpr::alloc(op.first->address, Expr::Int64);
-          state.base_addrs[base] = r;
+          uint64_t address = op.first->address;
+          state.base_mos = state.base_mos.insert({address, base});
+          ref<ConstantExpr> r = ConstantExpr::alloc(address, Expr::Int64);
+          state.base_addrs = state.base_addrs.replace({base, r});
         } else {
           // this case should not happen - we have a GEP instruction with const
           // base address, so we should be able to find an exact memory object
@@ -2832,17 +3069,14 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         }
 
       } else if (!isa<ConstantExpr>(original_base)) {
-        auto base_it = state.base_addrs.find(original_base);
-        if (base_it != state.base_addrs.end()) {
+        if (auto *entry = state.base_addrs.lookup(original_base)) {
           // we need to update the current entry with a new value
-          uint64_t address = base_it->second->getZExtValue();
-          auto refs_it = state.base_mos[address].find(base_it->first);
-          if (refs_it != state.base_mos[address].end()) {
-            state.base_mos[address].erase(refs_it);
-          }
-          state.base_mos[address].insert(base);
-          state.base_addrs[base] = base_it->second;
-          state.base_addrs.erase(base_it->first);
+          ref<ConstantExpr> r = entry->second;
+          uint64_t address = r->getZExtValue();
+          state.base_mos = state.base_mos.remove({address, original_base})
+                               .insert({address, base});
+          state.base_addrs =
+              state.base_addrs.remove(original_base).replace({base, r});
         }
       }
     }
@@ -3388,8 +3622,30 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 }
 
 void Executor::updateStates(ExecutionState *current) {
+  // Later queries are not issued by an instruction of the current state,
+  // which may be deleted below
+  slowQueries->setState(nullptr);
+
   if (searcher) {
-    searcher->update(current, addedStates, removedStates);
+    auto deferred = removedStates.end();
+    if (!deferredStates.empty()) {
+      // Deferred states are unknown to the searcher
+      deferred = std::stable_partition(
+          removedStates.begin(), removedStates.end(),
+          [](const ExecutionState *es) { return !es->queryDeferred; });
+      for (auto it = deferred; it != removedStates.end(); ++it)
+        deferredStates.erase(
+            std::find(deferredStates.begin(), deferredStates.end(), *it));
+    }
+    if (deferred == removedStates.end()) {
+      searcher->update(current, addedStates, removedStates);
+    } else {
+      searcher->update(current, addedStates,
+                       std::vector<ExecutionState *>(removedStates.begin(),
+                                                     deferred));
+    }
+    if (current && current->queryDeferred)
+      searcher->update(nullptr, {}, {current});
   }
   
   states.insert(addedStates.begin(), addedStates.end());
@@ -3412,6 +3668,31 @@ void Executor::updateStates(ExecutionState *current) {
   removedStates.clear();
 }
 
+time::Span Executor::getAdaptiveTimeout(ExecutionState &state) {
+  if (state.retryQuery) {
+    state.retryQuery = false;
+    ++stats::queriesRetried;
+    return coreSolverTimeout;
+  }
+  return adaptiveSolverTimeout->getTimeout(state.prevPC->info->id);
+}
+
+void Executor::deferQuery(ExecutionState &state) {
+  rewindInstruction(state);
+  ++stats::queriesDeferred;
+  state.queryDeferred = true;
+  state.retryQuery = true;
+  deferredStates.push_back(&state);
+}
+
+void Executor::resumeDeferredStates() {
+  retryDeferredStates = false;
+  for (ExecutionState *es : deferredStates)
+    es->queryDeferred = false;
+  searcher->update(nullptr, deferredStates, {});
+  deferredStates.clear();
+}
+
 template <typename TypeIt>
 void Executor::computeOffsetsSeqTy(KGEPInstruction *kgepi,
                                    ref<ConstantExpr> &constantOffset,
@@ -3511,12 +3792,32 @@ void Executor::bindModuleConstants() {
       bindInstructionConstants(kf->instructions[i]);
   }
 
-  kmodule->constantTable =
-      std::unique_ptr<Cell[]>(new Cell[kmodule->constants.size()]);
+  kmodule->constantTable.clear();
   for (unsigned i=0; i<kmodule->constants.size(); ++i) {
-    Cell &c = kmodule->constantTable[i];
-    c.value = evalConstant(kmodule->constants[i]);
+    kmodule->constantTable.emplace_back();
+    kmodule->constantTable.back().value = evalConstant(kmodule->constants[i]);
   }
+  constantsBound = true;
+}
+
+KFunction *Executor::getKFunction(llvm::Function *f) {
+  auto it = kmodule->functionMap.find(f);
+  if (it != kmodule->functionMap.end())
+    return it->second;
+
+  KFunction *kf = kmodule->getKFunction(f);
+  if (constantsBound) {
+    for (unsigned i = 0; i < kf->numInstructions; ++i)
+      bindInstructionConstants(kf->instructions[i]);
+    // Cells live in a deque, so references to earlier ones stay valid
+    for (unsigned i = kmodule->constantTable.size();
+         i < kmodule->constants.size(); ++i) {
+      kmodule->constantTable.emplace_back();
+      kmodule->constantTable.back().value =
+          evalConstant(kmodule->constants[i]);
+    }
+  }
+  return kf;
 }
 
 bool Executor::checkMemoryUsage() {
@@ -3578,6 +3879,69 @@ void Executor::doDumpStates() {
   updateStates(nullptr);
 }
 
+void Executor::setHaltTimer(time::Span maxTime) {
+  if (haltTimer) {
+    timers.remove(haltTimer);
+    haltTimer = nullptr;
+  }
+  if (!maxTime)
+    return;
+  auto timer = std::make_unique<Timer>(maxTime, [&] {
+    klee_message("HaltTimer invoked");
+    setHaltExecution(true);
+  });
+  haltTimer = timer.get();
+  timers.add(std::move(timer));
+}
+
+bool Executor::runToSnapshot() {
+  const std::string &name = interpreterOpts.SnapshotFunction;
+  Function *f = kmodule->module->getFunction(name);
+  if (!f)
+    klee_error("Snapshot function '%s' not found in module.", name.c_str());
+  KFunction *target = getKFunction(f);
+
+  while (states.size() == 1 && !haltExecution) {
+    ExecutionState &state = **states.begin();
+    if (state.stack.back().kf == target)
+      break;
+    KInstruction *ki = state.pc;
+    stepInstruction(state);
+
+    executeInstruction(state, ki);
+    timers.invoke();
+    if (::dumpStates) dumpStates();
+    if (::dumpExecutionTree)
+      dumpExecutionTree();
+    updateStates(&state);
+  }
+
+  if (states.empty() || haltExecution) {
+    klee_warning("execution ended before reaching snapshot function '%s'",
+                 name.c_str());
+    return true;
+  }
+  if (states.size() > 1)
+    klee_warning("execution forked before reaching snapshot function '%s', "
+                 "taking the snapshot with %zu states",
+                 name.c_str(), states.size());
+  klee_message("snapshot taken after %" PRIu64 " instructions",
+               (uint64_t)stats::instructions);
+
+  const std::string snapshotMaxTime = MaxTime;
+  if (!interpreterHandler->snapshotReached())
+    return false;
+
+  // The handler may have changed options and the output directory for the
+  // rest of this run; time limits count from here.
+  if (statsTracker)
+    statsTracker->reopen();
+  if (MaxTime != snapshotMaxTime)
+    setHaltTimer(time::Span{MaxTime});
+  timers.reset();
+  return true;
+}
+
 void Executor::run(ExecutionState &initialState) {
   bindModuleConstants();
 
@@ -3586,6 +3950,13 @@ void Executor::run(ExecutionState &initialState) {
 
   states.insert(&initialState);
 
+  if (!interpreterOpts.SnapshotFunction.empty() && !runToSnapshot()) {
+    for (ExecutionState *state : states)
+      terminateState(*state, StateTerminationType::SilentExit);
+    updateStates(nullptr);
+    return;
+  }
+
   if (usingSeeds) {
     std::vector<SeedInfo> &v = seedMap[&initialState];
     
@@ -3657,6 +4028,8 @@ void Executor::run(ExecutionState &initialState) {
 
   // main interpreter loop
   while (!states.empty() && !haltExecution) {
+    if (retryDeferredStates || searcher->empty())
+      resumeDeferredStates();
     ExecutionState &state = searcher->selectState();
     KInstruction *ki = state.pc;
     stepInstruction(state);
@@ -3677,6 +4050,8 @@ void Executor::run(ExecutionState &initialState) {
 
   delete searcher;
   searcher = nullptr;
+  deferredStates.clear();
+  retryDeferredStates = false;
 
   doDumpStates();
 }
@@ -3894,7 +4269,7 @@ void Executor::terminateStateOnError(ExecutionState &state,
     if (!ii.file.empty()) {
       msg << "File: " << ii.file << '\n'
           << "Line: " << ii.line << '\n'
-          << "assembly.ll line: " << ii.assemblyLine << '\n'
+          << "assembly.ll line: " << ii.getAssemblyLine() << '\n'
           << "State: " << state.getID() << '\n';
     }
     msg << "Stack: \n";
@@ -4094,7 +4469,11 @@ void Executor::callExternalFunction(ExecutionState &state, KInstruction *target,
       klee_warning_once(callable->getValue(), "%s", os.str().c_str());
   }
 
+  if (statsTracker)
+    statsTracker->blockInstructionTimer(true);
   bool success = externalDispatcher->executeCall(callable, target->inst, args);
+  if (statsTracker)
+    statsTracker->blockInstructionTimer(false);
   if (!success) {
     terminateStateOnExecError(state,
                               "failed external call: " + callable->getName(),
@@ -4413,8 +4792,7 @@ void Executor::executeMemoryOperation(ExecutionState &state,
     // Address is symbolic
 
     resolveSingleObject = false;
-    auto base_it = state.base_addrs.find(address);
-    if (base_it != state.base_addrs.end()) {
+    if (auto *base_it = state.base_addrs.lookup(address)) {
       // Concrete address found in the map, now find the associated memory
       // object
       if (!state.addressSpace.resolveOne(state, solver.get(), base_it->second, op,
@@ -4453,16 +4831,35 @@ void Executor::executeMemoryOperation(ExecutionState &state,
       ref<Expr> check = mo->getBoundsCheckOffset(offset, bytes);
       check = optimizer.optimizeExpr(check, true);
 
+      // Loads and stores are executed again if their query is deferred
+      bool adaptive = adaptiveSolverTimeout && searcher &&
+                      !isa<ConstantExpr>(check) &&
+                      (isa<LoadInst>(state.prevPC->inst) ||
+                       isa<StoreInst>(state.prevPC->inst));
+      time::Span timeout =
+          adaptive ? getAdaptiveTimeout(state) : coreSolverTimeout;
+      bool deferrable = adaptive && canDeferQuery(timeout);
+      time::Span queryCost = state.queryMetaData.queryCost;
+      std::uint64_t solverQueries = stats::solverQueries;
       bool inBounds;
-      solver->setTimeout(coreSolverTimeout);
+      slowQueries->setFailureDeferred(deferrable);
+      solver->setTimeout(timeout);
       bool success = solver->mustBeTrue(state.constraints, check, inBounds,
                                         state.queryMetaData);
       solver->setTimeout(time::Span());
+      slowQueries->setFailureDeferred(false);
       if (!success) {
-        state.pc = state.prevPC;
-        terminateStateOnSolverError(state, "Query timed out (bounds check).");
+        if (deferrable) {
+          deferQuery(state);
+        } else {
+          state.pc = state.prevPC;
+          terminateStateOnSolverError(state, "Query timed out (bounds check).");
+        }
         return;
       }
+      if (adaptive && stats::solverQueries != solverQueries)
+        adaptiveSolverTimeout->update(state.prevPC->info->id,
+                                      state.queryMetaData.queryCost - queryCost);
 
       if (inBounds) {
         const ObjectState *os = op.second;
@@ -4590,9 +4987,10 @@ void Executor::executeMakeSymbolic(ExecutionState &state,
     // or if that fails try adding a unique identifier.
     unsigned id = 0;
     std::string uniqueName = name;
-    while (!state.arrayNames.insert(uniqueName).second) {
+    while (state.arrayNames.count(uniqueName)) {
       uniqueName = name + "_" + llvm::utostr(++id);
     }
+    state.arrayNames = state.arrayNames.insert(uniqueName);
     const Array *array = arrayCache.CreateArray(uniqueName, mo->size);
     bindObjectInState(state, mo, false, array);
     state.addSymbolic(mo, array);
@@ -4674,8 +5072,7 @@ void Executor::runFunctionAsMain(Function *f,
   for (envc=0; envp[envc]; ++envc) ;
 
   unsigned NumPtrBytes = Context::get().getPointerWidth() / 8;
-  KFunction *kf = kmodule->functionMap[f];
-  assert(kf);
+  KFunction *kf = getKFunction(f);
   Function::arg_iterator ai = f->arg_begin(), ae = f->arg_end();
   if (ai!=ae) {
     arguments.push_back(ConstantExpr::alloc(argc, Expr::Int32));
@@ -4702,7 +5099,11 @@ void Executor::runFunctionAsMain(Function *f,
   }
 
   ExecutionState *state =
-      new ExecutionState(kmodule->functionMap[f], memory.get());
+      new ExecutionState(kf, memory.get());
+
+  // The empty assignment trivially satisfies the empty constraint set.
+  if (UseStateModelCache)
+    state->model = std::make_shared<const Assignment>();
 
   if (pathWriter) 
     state->pathOS = pathWriter->open();
@@ -4748,6 +5149,11 @@ void Executor::runFunctionAsMain(Function *f,
 
   executionTree = createExecutionTree(
       *state, userSearcherRequiresInMemoryExecutionTree(), *interpreterHandler);
+  if (!stats::instructions)
+    interpreterHandler->getInfoStream()
+        << "Startup: " << time::getUserTime() << " user time, "
+        << (util::GetPeakMemoryUsage() >> 20)
+        << " MB peak memory before the first instruction\n";
   run(*state);
   executionTree = nullptr;
 
@@ -4756,7 +5162,9 @@ void Executor::runFunctionAsMain(Function *f,
 
   globalObjects.clear();
   globalAddresses.clear();
+  constantsBound = false;
 
+  slowQueries->write(*interpreterHandler);
   if (statsTracker)
     statsTracker->done();
 }
@@ -4856,7 +5264,11 @@ bool Executor::getSymbolicSolution(const ExecutionState &state,
 
 void Executor::getCoveredLines(const ExecutionState &state,
                                std::map<const std::string*, std::set<unsigned> > &res) {
-  res = state.coveredLines;
+  res.clear();
+  for (std::uint32_t id : state.coveredInstructions) {
+    const InstructionInfo &ii = kmodule->infos->getInfo(id);
+    res[&ii.file].insert(ii.line);
+  }
 }
 
 void Executor::doImpliedValueConcretization(ExecutionState &state,
@@ -4966,6 +5378,7 @@ size_t Executor::getAllocationAlignment(const llvm::Value *allocSite) const {
 }
 
 void Executor::prepareForEarlyExit() {
+  slowQueries->write(*interpreterHandler);
   if (statsTracker) {
     // Make sure stats get flushed out
     statsTracker->done();
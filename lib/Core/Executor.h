@@ -58,6 +58,7 @@ namespace llvm {
 }
 
 namespace klee {
+class AdaptiveSolverTimeout;
 class Array;
 struct Cell;
 class ExecutionState;
@@ -75,6 +76,7 @@ class ObjectState;
 class ExecutionTree;
 class Searcher;
 class SeedInfo;
+class SlowQueryRecorder;
 class SpecialFunctionHandler;
 struct StackFrame;
 class StatsTracker;
@@ -110,12 +112,15 @@ private:
 
   ExternalDispatcher *externalDispatcher;
   std::unique_ptr<TimingSolver> solver;
+  std::unique_ptr<SlowQueryRecorder> slowQueries;
   std::unique_ptr<MemoryManager> memory;
   std::set<ExecutionState*, ExecutionStateIDCompare> states;
   StatsTracker *statsTracker;
   TreeStreamWriter *pathWriter, *symPathWriter;
   SpecialFunctionHandler *specialFunctionHandler;
   TimerGroup timers;
+  /// The timer halting execution after --max-time, if any
+  Timer *haltTimer = nullptr;
   std::unique_ptr<ExecutionTree> executionTree;
 
   /// Used to track states that have been added during the current
@@ -129,6 +134,15 @@ private:
   /// \invariant \ref addedStates and \ref removedStates are disjoint.
   std::vector<ExecutionState *> removedStates;
 
+  /// States whose query timed out under an adaptive solver timeout. They
+  /// are taken out of the searcher until the next retry is due or it runs
+  /// out of other states.
+  /// \invariant \ref deferredStates is a subset of \ref states.
+  std::vector<ExecutionState *> deferredStates;
+
+  /// Set by a timer when deferred states are due to retry their query.
+  bool retryDeferredStates = false;
+
   /// When non-empty the Executor is running in "seed" mode. The
   /// states in this map will be executed in an arbitrary order
   /// (outside the normal search interface) until they terminate. When
@@ -175,6 +189,10 @@ private:
   /// step.
   bool haltExecution;  
 
+  /// Whether the constant table holds the values for the current run, so
+  /// that functions prepared from now on have to add theirs right away.
+  bool constantsBound = false;
+
   /// Whether implied-value concretization is enabled. Currently
   /// false, it is buggy (it needs to validate its writes).
   bool ivcEnabled;
@@ -183,6 +201,10 @@ private:
   /// (e.g. for a single STP query)
   time::Span coreSolverTimeout;
 
+  /// Timeouts below coreSolverTimeout for branch and bounds-check queries,
+  /// if enabled by --adaptive-solver-time.
+  std::unique_ptr<AdaptiveSolverTimeout> adaptiveSolverTimeout;
+
   /// Maximum time to allow for a single instruction.
   time::Span maxInstructionTime;
 
@@ -217,6 +239,15 @@ private:
 
   void run(ExecutionState &initialState);
 
+  /// Halt execution after \p maxTime from the next timer reset, replacing
+  /// any earlier limit, or never if \p maxTime is zero.
+  void setHaltTimer(time::Span maxTime);
+
+  /// Execute the initial state on its own until it enters the snapshot
+  /// function, then hand over to the interpreter handler. Returns false if
+  /// the run should end there.
+  bool runToSnapshot();
+
   // Given a concrete object in our [klee's] address space, add it to 
   // objects checked code can reference.
   MemoryObject *addExternalObject(ExecutionState &state, void *addr, 
@@ -232,7 +263,27 @@ private:
   void initializeGlobalObjects(ExecutionState &state);
 
   void stepInstruction(ExecutionState &state);
+
+  /// Undo stepInstruction, so that the current instruction of \p state is
+  /// executed again but counted once, in run.istats as well.
+  void rewindInstruction(ExecutionState &state);
   void updateStates(ExecutionState *current);
+
+  /// Return the adaptive timeout of a query that \p state issues for its
+  /// current instruction, which is executed again if the query times out.
+  time::Span getAdaptiveTimeout(ExecutionState &state);
+
+  /// Whether a query that fails under the adaptive \p timeout is deferred,
+  /// i.e. whether \p timeout is less than the full solver timeout.
+  bool canDeferQuery(time::Span timeout) const {
+    return timeout < coreSolverTimeout;
+  }
+
+  /// Defer the current instruction of \p state after its query failed.
+  void deferQuery(ExecutionState &state);
+
+  /// Hand all deferred states back to the searcher.
+  void resumeDeferredStates();
   void transferToBasicBlock(llvm::BasicBlock *dst, 
 			    llvm::BasicBlock *src,
 			    ExecutionState &state);
@@ -325,9 +376,12 @@ private:
   /// Create a new state where each input condition has been added as
   /// a constraint and return the results. The input state is included
   /// as one of the results. Note that the output vector may include
-  /// NULL pointers for states which were unable to be created.
+  /// NULL pointers for states which were unable to be created. If given,
+  /// models[i] is a satisfying assignment for the state extended by
+  /// conditions[i] and becomes the model of the respective result.
   void branch(ExecutionState &state, const std::vector<ref<Expr>> &conditions,
-              std::vector<ExecutionState *> &result, BranchType reason);
+              std::vector<ExecutionState *> &result, BranchType reason,
+              const std::vector<std::shared_ptr<const Assignment>> &models = {});
 
   /// Fork current and return states in which condition holds / does
   /// not hold, respectively. One of the states is necessarily the
@@ -355,12 +409,12 @@ private:
   Cell& getArgumentCell(ExecutionState &state,
                         KFunction *kf,
                         unsigned index) {
-    return state.stack.back().locals[kf->getArgRegister(index)];
+    return state.stack.back().getWritableLocal(kf->getArgRegister(index));
   }
 
   Cell& getDestCell(ExecutionState &state,
                     KInstruction *target) {
-    return state.stack.back().locals[target->dest];
+    return state.stack.back().getWritableLocal(target->dest);
   }
 
   void bindLocal(KInstruction *target, 
@@ -398,6 +452,13 @@ private:
                                      const std::string &reason,
                                      bool concretize = true);
 
+  /// Evaluate the given expressions under all seeds at once. The value of
+  /// expression i under seed s is stored at values[s * exprs.size() + i];
+  /// results the seeds leave symbolic are concretized with the solver.
+  void getSeedValues(ExecutionState &state, const std::vector<SeedInfo> &seeds,
+                     const std::vector<ref<Expr>> &exprs,
+                     std::vector<ref<klee::ConstantExpr>> &values);
+
   /// Evaluate the given expression under each seed, and return the
   /// first one that results in a constant, if such a seed exist.  Otherwise,
   /// return the non-constant evaluation of the expression under one of the
@@ -479,6 +540,10 @@ private:
   /// bindModuleConstants - Initialize the module constant table.
   void bindModuleConstants();
 
+  /// Return the KFunction of \p f, preparing it and binding its constants
+  /// if it has not been called before.
+  KFunction *getKFunction(llvm::Function *f);
+
   template <typename TypeIt>
   void computeOffsetsSeqTy(KGEPInstruction *kgepi,
                            ref<ConstantExpr> &constantOffset, uint64_t index,
@@ -12,8 +12,12 @@
 #include "CoreStats.h"
 #include "ExecutionState.h"
 #include "Executor.h"
+#include "Memory.h"
 #include "Searcher.h"
 
+#include "klee/Module/KModule.h"
+#include "klee/Solver/SolverStats.h"
+
 namespace klee {
 
 /*** Test generation options ***/
@@ -27,6 +31,26 @@ llvm::cl::opt<bool> UseMerge(
                    "klee_close_merge (default=false)"),
     llvm::cl::cat(klee::MergeCat));
 
+llvm::cl::opt<bool> AutoMerge(
+    "auto-merge", llvm::cl::init(false),
+    llvm::cl::desc("Automatically merge states at the exits of small branching "
+                   "regions when this is estimated to save solver queries; "
+                   "no klee_open_merge/klee_close_merge calls are needed "
+                   "(default=false)"),
+    llvm::cl::cat(klee::MergeCat));
+
+llvm::cl::opt<unsigned> AutoMergeMaxBlocks(
+    "auto-merge-max-blocks", llvm::cl::init(16),
+    llvm::cl::desc("Maximum number of basic blocks in a region merged by "
+                   "--auto-merge (default=16)"),
+    llvm::cl::cat(klee::MergeCat));
+
+llvm::cl::opt<bool> AutoMergeLoops(
+    "auto-merge-loops", llvm::cl::init(true),
+    llvm::cl::desc("Let --auto-merge merge states at loop exits and in regions "
+                   "containing loops (default=true)"),
+    llvm::cl::cat(klee::MergeCat));
+
 llvm::cl::opt<bool> DebugLogMerge(
     "debug-log-merge", llvm::cl::init(false),
     llvm::cl::desc("Debug information for path merging (default=false)"),
@@ -53,6 +77,58 @@ unsigned MergeHandler::getInstructionDistance(ExecutionState *es){
   return es->steppedInstructions - openInstruction;
 }
 
+bool MergeHandler::isMergeProfitable(const ExecutionState &a,
+                                     const ExecutionState &b, double &saved) {
+  if (a.pc != b.pc || a.stack.size() != b.stack.size())
+    return false;
+
+  // Every value that differs between the states turns into an ite expression
+  // in the merged state; count each as one additional query it may cause.
+  uint64_t differing = 0;
+  for (unsigned i = 0; i < a.stack.size(); ++i) {
+    const StackFrame &af = a.stack[i];
+    const StackFrame &bf = b.stack[i];
+    if (af.kf != bf.kf)
+      return false;
+    for (unsigned r = 0; r < af.kf->numRegisters; ++r) {
+      const ref<Expr> &av = af.getLocal(r).value;
+      const ref<Expr> &bv = bf.getLocal(r).value;
+      if (av && bv && av != bv)
+        ++differing;
+    }
+  }
+
+  auto ai = a.addressSpace.objects.begin(), ae = a.addressSpace.objects.end();
+  auto bi = b.addressSpace.objects.begin(), be = b.addressSpace.objects.end();
+  for (; ai != ae && bi != be; ++ai, ++bi) {
+    if (ai->first != bi->first)
+      return false;
+    const ObjectState *aos = ai->second.get();
+    const ObjectState *bos = bi->second.get();
+    if (aos == bos)
+      continue;
+    for (unsigned i = 0; i < ai->first->size; ++i)
+      if (aos->read8(i) != bos->read8(i))
+        ++differing;
+  }
+  if (ai != ae || bi != be)
+    return false;
+
+  // The dropped state would have kept spending solver time at the rate it
+  // did since it entered this region for about as long again, that is, as
+  // much as it spent in the region so far. Convert that time into queries of
+  // average cost.
+  double regionTime =
+      (b.queryMetaData.queryCost - openQueryCost).toMicroseconds();
+  double expected =
+      stats::solverTime ? regionTime * stats::queries / stats::solverTime : 0;
+  if (differing > expected)
+    return false;
+
+  saved = expected - differing;
+  return true;
+}
+
 ExecutionState *MergeHandler::getPrioritizeState(){
   for (ExecutionState *cur_state : openStates) {
     bool stateIsClosed =
@@ -91,6 +167,13 @@ void MergeHandler::addClosedState(ExecutionState *es,
   // Remove from openStates
   removeOpenState(es);
 
+  // No state forked inside this automatic region, so there is nobody to wait
+  // for: let the state continue right away.
+  if (automatic && openStates.empty() && reachedCloseMerge.empty()) {
+    executor->mergingSearcher->inCloseMerge.erase(es);
+    return;
+  }
+
   auto closePoint = reachedCloseMerge.find(mp);
 
   // If no other state has yet encountered this klee_close_merge instruction,
@@ -103,9 +186,22 @@ void MergeHandler::addClosedState(ExecutionState *es,
     // instruction
     auto &cpv = closePoint->second;
     bool mergedSuccessful = false;
+    bool rejected = false;
 
     for (auto& mState: cpv) {
+      double saved = 0;
+      if (automatic && !isMergeProfitable(*mState, *es, saved)) {
+        rejected = true;
+        continue;
+      }
       if (mState->merge(*es)) {
+        if (automatic) {
+          ++stats::autoMerges;
+          stats::autoMergeQueriesSaved += static_cast<uint64_t>(saved);
+          if (stats::queries)
+            stats::autoMergeTimeSaved += static_cast<uint64_t>(
+                saved * stats::solverTime / stats::queries);
+        }
         executor->terminateStateEarlyAlgorithm(*es, "merged state.", StateTerminationType::Merge);
         executor->mergingSearcher->inCloseMerge.erase(es);
         mergedSuccessful = true;
@@ -113,6 +209,8 @@ void MergeHandler::addClosedState(ExecutionState *es,
       }
     }
     if (!mergedSuccessful) {
+      if (rejected)
+        ++stats::autoMergeRejects;
       cpv.push_back(es);
       executor->mergingSearcher->pauseState(*es);
     }
@@ -133,8 +231,11 @@ bool MergeHandler::hasMergedStates() {
   return (!reachedCloseMerge.empty());
 }
 
-MergeHandler::MergeHandler(Executor *_executor, ExecutionState *es)
-    : executor(_executor), openInstruction(es->steppedInstructions),
+MergeHandler::MergeHandler(Executor *_executor, ExecutionState *es,
+                           bool _automatic)
+    : executor(_executor), automatic(_automatic),
+      openInstruction(es->steppedInstructions),
+      openQueryCost(es->queryMetaData.queryCost),
       closedMean(0), closedStateCount(0) {
     executor->mergingSearcher->mergeGroups.push_back(this);
   addOpenState(es);
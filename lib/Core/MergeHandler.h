@@ -64,12 +64,25 @@
  * possible) will be continued without waiting for the remaining states. When a
  * remaining state now enters a close-merge point, it will again wait for the
  * other states, or until the 'timeout' is reached.
+ *
+ * # Automatic Merging
+ *
+ * With `--auto-merge`, KModule surrounds small single-entry, single-exit
+ * regions (a branch up to its immediate post-dominator, a loop up to its exit)
+ * with calls to klee_auto_open_merge() and klee_auto_close_merge(). These
+ * behave like their user-placed counterparts, except that two states are only
+ * merged if a cost estimate predicts fewer solver queries overall: a merge
+ * saves the queries the dropped state would have issued on its own, but every
+ * value that differs between the states becomes an ite expression that
+ * later queries have to reason about. Regions that no state forked in do not
+ * pause the state at the exit.
 */
 
 #ifndef KLEE_MERGEHANDLER_H
 #define KLEE_MERGEHANDLER_H
 
 #include "klee/ADT/Ref.h"
+#include "klee/System/Time.h"
 
 #include "klee/Support/CompilerWarning.h"
 DISABLE_WARNING_PUSH
@@ -88,6 +101,12 @@ class Instruction;
 namespace klee {
 extern llvm::cl::opt<bool> UseMerge;
 
+extern llvm::cl::opt<bool> AutoMerge;
+
+extern llvm::cl::opt<unsigned> AutoMergeMaxBlocks;
+
+extern llvm::cl::opt<bool> AutoMergeLoops;
+
 extern llvm::cl::opt<bool> DebugLogMerge;
 
 extern llvm::cl::opt<bool> DebugLogIncompleteMerge;
@@ -101,9 +120,15 @@ class MergeHandler {
 private:
   Executor *executor;
 
+  /// @brief True if the merge region was inserted by `--auto-merge`
+  bool automatic;
+
   /// @brief The instruction count when the state ran into the klee_open_merge
   uint64_t openInstruction;
 
+  /// @brief The solver time of the state when it ran into the klee_open_merge
+  time::Span openQueryCost;
+
   /// @brief The average number of instructions between the open and close merge of each
   /// state that has finished so far
   double closedMean;
@@ -115,6 +140,11 @@ private:
   /// @brief Get distance of state from the openInstruction
   unsigned getInstructionDistance(ExecutionState *es);
 
+  /// @brief Estimate whether merging \p b into \p a saves solver queries.
+  /// On success, \p saved is set to the estimated number of queries saved.
+  bool isMergeProfitable(const ExecutionState &a, const ExecutionState &b,
+                         double &saved);
+
   /// @brief States that ran through the klee_open_merge, but not yet into a
   /// corresponding klee_close_merge
   std::vector<ExecutionState *> openStates;
@@ -129,6 +159,9 @@ public:
   /// @brief Called when a state runs into a 'klee_close_merge()' call
   void addClosedState(ExecutionState *es, llvm::Instruction *mp);
 
+  /// @brief True if the merge region was inserted by `--auto-merge`
+  bool isAutomatic() const { return automatic; }
+
   /// @brief Return state that should be prioritized to complete this merge
   ExecutionState *getPrioritizeState();
 
@@ -153,7 +186,8 @@ public:
   /// @brief Required by klee::ref-managed objects
   class ReferenceCounter _refCount;
 
-  MergeHandler(Executor *_executor, ExecutionState *es);
+  MergeHandler(Executor *_executor, ExecutionState *es,
+               bool _automatic = false);
   ~MergeHandler();
 };
 }
@@ -164,15 +164,13 @@ namespace klee {
   ///
   /// To support this, RandomPathSearcher has a subgraph view of ExecutionTree,
   /// in that it only walks the ExecutionTreeNodes that it "owns". Ownership is
-  /// stored in the getInt method of the ExecutionTreeNodePtr class (which hides
-  /// it in the pointer itself).
+  /// stored in the getInt method of the ExecutionTreeNodePtr class (which packs
+  /// it next to the node index).
   ///
   /// The current implementation of ExecutionTreeNodePtr supports only 3
-  /// instances of the RandomPathSearcher. This is because the current
-  /// ExecutionTreeNodePtr implementation conforms to C++ and only steals the
-  /// last 3 alignment bits. This restriction could be relaxed slightly by an
-  /// architecture-specific implementation of ExecutionTreeNodePtr that also
-  /// steals the top bits of the pointer.
+  /// instances of the RandomPathSearcher. This is because ExecutionTreeNodePtr
+  /// only reserves 3 bits of its 32 for the tag. This restriction could be
+  /// relaxed by reserving more bits at the cost of fewer addressable nodes.
   ///
   /// The ownership bits are maintained in the update method.
   class RandomPathSearcher final : public Searcher {
@@ -0,0 +1,262 @@
+//===-- SlowQueryRecorder.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SlowQueryRecorder.h"
+
+#include "ExecutionState.h"
+
+#include "klee/Core/Interpreter.h"
+#include "klee/Expr/ExprPPrinter.h"
+#include "klee/Module/InstructionInfoTable.h"
+#include "klee/Module/KInstruction.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverStats.h"
+
+#include "klee/Support/CompilerWarning.h"
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/IR/Function.h"
+#include "llvm/Support/raw_ostream.h"
+DISABLE_WARNING_POP
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+using namespace klee;
+
+namespace {
+auto slowerThan = [](const SlowQueryRecorder::SlowQuery &a,
+                     const SlowQueryRecorder::SlowQuery &b) {
+  return a.duration > b.duration;
+};
+
+const char *kindName(SlowQueryRecorder::Kind kind) {
+  switch (kind) {
+  case SlowQueryRecorder::Kind::Truth:
+    return "Truth";
+  case SlowQueryRecorder::Kind::Validity:
+    return "Validity";
+  case SlowQueryRecorder::Kind::Value:
+    return "Value";
+  case SlowQueryRecorder::Kind::InitialValues:
+    return "InitialValues";
+  }
+  return "Unknown";
+}
+} // namespace
+
+void SlowQueryRecorder::describeState(SlowQuery &query) const {
+  if (!state)
+    return;
+  query.hasState = true;
+  query.depth = state->depth;
+
+  const KInstruction *ki = state->prevPC;
+  const InstructionInfo &ii = *ki->info;
+  llvm::raw_string_ostream instruction(query.instruction);
+  instruction << ki->inst->getFunction()->getName();
+  if (!ii.file.empty())
+    instruction << " at " << ii.file << ":" << ii.line;
+  instruction << " (assembly.ll:" << ii.getAssemblyLine() << ")";
+  instruction.flush();
+
+  llvm::raw_string_ostream stack(query.stack);
+  state->dumpStack(stack);
+  stack.flush();
+}
+
+void SlowQueryRecorder::record(SlowQuery query) {
+  describeState(query);
+  if (!query.success) {
+    if (failed.size() < maxQueries)
+      failed.push_back(std::move(query));
+    return;
+  }
+
+  if (slowest.size() == maxQueries) {
+    std::pop_heap(slowest.begin(), slowest.end(), slowerThan);
+    slowest.pop_back();
+  }
+  slowest.push_back(std::move(query));
+  std::push_heap(slowest.begin(), slowest.end(), slowerThan);
+}
+
+void SlowQueryRecorder::write(InterpreterHandler &handler) const {
+  if (slowest.empty() && failed.empty())
+    return;
+
+  // Failed queries first, in the order they were issued, then the slowest
+  std::vector<const SlowQuery *> queries;
+  for (const SlowQuery &q : failed)
+    queries.push_back(&q);
+  std::size_t numFailed = queries.size();
+  for (const SlowQuery &q : slowest)
+    queries.push_back(&q);
+  std::sort(queries.begin() + numFailed, queries.end(),
+            [](const SlowQuery *a, const SlowQuery *b) {
+              return slowerThan(*a, *b);
+            });
+
+  auto index = handler.openOutputFile("slow-queries.txt");
+  if (!index)
+    return;
+  *index << "# File\tKind\tTime\tStatus\tCexCacheTime\tCoreSolverTime\t"
+            "CoreQueries\tQuery\tDepth\tInstruction\n";
+
+  for (std::size_t i = 0; i < queries.size(); ++i) {
+    const SlowQuery &q = *queries[i];
+    char name[32];
+    std::snprintf(name, sizeof(name), "slow-query%03zu.kquery", i + 1);
+    const char *status =
+        q.success ? "OK" : SolverImpl::getOperationStatusString(q.failure);
+
+    *index << name << "\t" << kindName(q.kind) << "\t" << q.duration << "\t"
+           << status << "\t" << q.cexCacheTime << "\t" << q.coreSolverTime
+           << "\t" << q.coreQueries << "\t" << q.number << "\t";
+    if (q.hasState)
+      *index << q.depth << "\t" << q.instruction << "\n";
+    else
+      *index << "-\t-\n";
+
+    auto os = handler.openOutputFile(name);
+    if (!os)
+      continue;
+    *os << "# Query " << q.number << " -- Type: " << kindName(q.kind)
+        << ", Time: " << q.duration << ", Status: " << status << "\n"
+        << "# Counterexample cache: " << q.cexCacheTime
+        << ", core solver: " << q.coreSolverTime << " in " << q.coreQueries
+        << " queries\n";
+    if (q.hasState) {
+      *os << "# Depth: " << q.depth << ", Instruction: " << q.instruction
+          << "\n# Stack:\n";
+      llvm::StringRef stack(q.stack);
+      while (!stack.empty()) {
+        auto line = stack.split('\n');
+        *os << "# " << line.first << "\n";
+        stack = line.second;
+      }
+    }
+
+    // Printed as by KQueryLoggingSolver, so that kleaver asks the same
+    switch (q.kind) {
+    case Kind::Truth:
+    case Kind::Validity:
+      ExprPPrinter::printQuery(*os, q.constraints, q.expr);
+      break;
+    case Kind::Value:
+      ExprPPrinter::printQuery(*os, q.constraints,
+                               ConstantExpr::alloc(0, Expr::Bool), &q.expr,
+                               &q.expr + 1);
+      break;
+    case Kind::InitialValues:
+      ExprPPrinter::printQuery(*os, q.constraints, q.expr, nullptr, nullptr,
+                               q.objects.data(),
+                               q.objects.data() + q.objects.size());
+      break;
+    }
+  }
+}
+
+///
+
+namespace {
+class SlowQueryRecordingSolver : public SolverImpl {
+  std::unique_ptr<Solver> solver;
+  SlowQueryRecorder &recorder;
+
+  /// Run \p compute on the underlying solver, and keep \p query if it is slow
+  template <class Compute>
+  bool recordQuery(SlowQueryRecorder::Kind kind, const Query &query,
+                   const std::vector<const Array *> *objects,
+                   Compute compute) {
+    std::uint64_t number = recorder.nextQueryNumber();
+    std::uint64_t cexCacheTime = stats::cexCacheTime;
+    std::uint64_t coreSolverTime = stats::queryTime;
+    std::uint64_t coreQueries = stats::solverQueries;
+    time::Point start = time::getWallTime();
+
+    bool success = compute();
+
+    time::Span duration = time::getWallTime() - start;
+    if (!recorder.isSlow(duration, success))
+      return success;
+
+    SlowQueryRecorder::SlowQuery q;
+    q.kind = kind;
+    q.constraints = query.constraints;
+    q.expr = query.expr;
+    if (objects)
+      q.objects = *objects;
+    q.number = number;
+    q.duration = duration;
+    q.success = success;
+    q.failure = success ? SOLVER_RUN_STATUS_FAILURE
+                        : solver->impl->getOperationStatusCode();
+    q.cexCacheTime = time::microseconds(stats::cexCacheTime - cexCacheTime);
+    q.coreSolverTime = time::microseconds(stats::queryTime - coreSolverTime);
+    q.coreQueries = stats::solverQueries - coreQueries;
+    recorder.record(std::move(q));
+    return success;
+  }
+
+public:
+  SlowQueryRecordingSolver(std::unique_ptr<Solver> solver,
+                           SlowQueryRecorder &recorder)
+      : solver(std::move(solver)), recorder(recorder) {}
+
+  bool computeTruth(const Query &query, bool &isValid) override {
+    return recordQuery(SlowQueryRecorder::Kind::Truth, query, nullptr, [&] {
+      return solver->impl->computeTruth(query, isValid);
+    });
+  }
+
+  bool computeValidity(const Query &query, Solver::Validity &result) override {
+    return recordQuery(SlowQueryRecorder::Kind::Validity, query, nullptr, [&] {
+      return solver->impl->computeValidity(query, result);
+    });
+  }
+
+  bool computeValue(const Query &query, ref<Expr> &result) override {
+    return recordQuery(SlowQueryRecorder::Kind::Value, query, nullptr, [&] {
+      return solver->impl->computeValue(query, result);
+    });
+  }
+
+  bool computeInitialValues(const Query &query,
+                            const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char>> &values,
+                            bool &hasSolution) override {
+    return recordQuery(
+        SlowQueryRecorder::Kind::InitialValues, query, &objects, [&] {
+          return solver->impl->computeInitialValues(query, objects, values,
+                                                    hasSolution);
+        });
+  }
+
+  SolverRunStatus getOperationStatusCode() override {
+    return solver->impl->getOperationStatusCode();
+  }
+
+  std::string getConstraintLog(const Query &query) override {
+    return solver->impl->getConstraintLog(query);
+  }
+
+  void setCoreSolverTimeout(time::Span timeout) override {
+    solver->impl->setCoreSolverTimeout(timeout);
+  }
+};
+} // namespace
+
+std::unique_ptr<Solver>
+klee::createSlowQueryRecordingSolver(std::unique_ptr<Solver> solver,
+                                     SlowQueryRecorder &recorder) {
+  return std::make_unique<Solver>(
+      std::make_unique<SlowQueryRecordingSolver>(std::move(solver), recorder));
+}
@@ -0,0 +1,114 @@
+//===-- SlowQueryRecorder.h -------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_SLOWQUERYRECORDER_H
+#define KLEE_SLOWQUERYRECORDER_H
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/System/Time.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace klee {
+class Array;
+class ExecutionState;
+class InterpreterHandler;
+class Solver;
+
+/// SlowQueryRecorder - Keeps the slowest solver queries of a run and the
+/// first queries that fail, e.g. by timing out, together with the state that
+/// issued them. At most maxQueries queries of each are kept.
+///
+/// Queries are recorded by the solver layer created with
+/// createSlowQueryRecordingSolver, which costs little more than reading a
+/// clock unless a query is slow enough to be kept. Kept queries are only
+/// printed by write(), as one kquery file each that kleaver can replay and
+/// an index of all of them.
+class SlowQueryRecorder {
+public:
+  enum class Kind { Truth, Validity, Value, InitialValues };
+
+  struct SlowQuery {
+    Kind kind;
+    ConstraintSet constraints;
+    ref<Expr> expr;
+    std::vector<const Array *> objects;
+    /// Number of the query among all queries of the run
+    std::uint64_t number;
+    time::Span duration;
+    /// Whether the solver answered the query
+    bool success;
+    /// Why the query failed, if it did
+    SolverImpl::SolverRunStatus failure;
+    /// Time spent in the counterexample cache and the core solver
+    time::Span cexCacheTime, coreSolverTime;
+    /// Queries that reached the core solver
+    std::uint64_t coreQueries;
+
+    /// The issuing state, if the query was issued by an instruction: its
+    /// depth, the instruction and the stack as printed by dumpStack
+    bool hasState = false;
+    std::uint32_t depth = 0;
+    std::string instruction;
+    std::string stack;
+  };
+
+private:
+  unsigned maxQueries;
+  time::Span minDuration;
+  const ExecutionState *state = nullptr;
+  bool failureDeferred = false;
+  std::uint64_t numQueries = 0;
+  /// Min-heap of the slowest successful queries, by duration
+  std::vector<SlowQuery> slowest;
+  /// The first failed queries, in the order they were issued
+  std::vector<SlowQuery> failed;
+
+  void describeState(SlowQuery &query) const;
+
+public:
+  SlowQueryRecorder(unsigned maxQueries, time::Span minDuration)
+      : maxQueries(maxQueries), minDuration(minDuration) {}
+
+  /// Attribute subsequent queries to \p state, or to no state if null.
+  void setState(const ExecutionState *state) { this->state = state; }
+
+  /// Do not keep subsequent queries that fail if \p deferred, as their
+  /// state retries them later, e.g. after an adaptive solver timeout.
+  void setFailureDeferred(bool deferred) { failureDeferred = deferred; }
+
+  std::uint64_t nextQueryNumber() { return numQueries++; }
+
+  /// Whether a query taking \p duration is kept.
+  bool isSlow(time::Span duration, bool success) const {
+    if (!success)
+      return !failureDeferred && failed.size() < maxQueries;
+    return maxQueries && duration >= minDuration &&
+           (slowest.size() < maxQueries ||
+            duration > slowest.front().duration);
+  }
+
+  void record(SlowQuery query);
+
+  /// Write the kept queries to slow-query<N>.kquery files and the index to
+  /// slow-queries.txt in the output directory, replacing earlier files.
+  void write(InterpreterHandler &handler) const;
+};
+
+std::unique_ptr<Solver>
+createSlowQueryRecordingSolver(std::unique_ptr<Solver> solver,
+                               SlowQueryRecorder &recorder);
+} // namespace klee
+
+#endif /* KLEE_SLOWQUERYRECORDER_H */
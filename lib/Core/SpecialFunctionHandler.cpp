@@ -36,6 +36,7 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/IR/Module.h"
 DISABLE_WARNING_POP
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
 #include <sstream>
@@ -93,6 +94,8 @@ static constexpr std::array handlerInfo = {
   add("calloc", handleCalloc, true),
   add("free", handleFree, false),
   add("klee_assume", handleAssume, false),
+  add("klee_auto_close_merge", handleAutoCloseMerge, false),
+  add("klee_auto_open_merge", handleAutoOpenMerge, false),
   add("klee_check_memory_access", handleCheckMemoryAccess, false),
   add("klee_get_valuef", handleGetValue, true),
   add("klee_get_valued", handleGetValue, true),
@@ -115,6 +118,7 @@ static constexpr std::array handlerInfo = {
   add("klee_close_merge", handleCloseMerge, false),
   add("klee_prefer_cex", handlePreferCex, false),
   add("klee_posix_prefer_cex", handlePosixPreferCex, false),
+  add("klee_posix_copy", handlePosixCopy, true),
   add("klee_print_expr", handlePrintExpr, false),
   add("klee_print_range", handlePrintRange, false),
   add("klee_set_forking", handleSetForking, false),
@@ -328,19 +332,20 @@ void SpecialFunctionHandler::handleOpenMerge(ExecutionState &state,
     llvm::errs() << "open merge: " << &state << "\n";
 }
 
-void SpecialFunctionHandler::handleCloseMerge(ExecutionState &state,
-    KInstruction *target,
-    std::vector<ref<Expr> > &arguments) {
-  if (!UseMerge) {
-    klee_warning_once(0, "klee_close_merge ignored, use '-use-merge'");
-    return;
-  }
-  Instruction *i = target->inst;
-
+void SpecialFunctionHandler::closeMerge(ExecutionState &state, Instruction *i,
+                                        bool automatic) {
+  // User-placed and automatic regions are matched separately, so that a
+  // klee_open_merge/klee_close_merge pair does not have to nest properly with
+  // the regions found by --auto-merge.
   if (DebugLogMerge)
     llvm::errs() << "close merge: " << &state << " at [" << *i << "]\n";
 
-  if (state.openMergeStack.empty()) {
+  auto it = std::find_if(state.openMergeStack.rbegin(),
+                         state.openMergeStack.rend(),
+                         [automatic](const ref<MergeHandler> &mh) {
+                           return mh->isAutomatic() == automatic;
+                         });
+  if (it == state.openMergeStack.rend()) {
     std::ostringstream warning;
     warning << &state << " ran into a close at " << i << " without a preceding open";
     klee_warning("%s", warning.str().c_str());
@@ -349,9 +354,36 @@ void SpecialFunctionHandler::handleCloseMerge(ExecutionState &state,
                executor.mergingSearcher->inCloseMerge.end() &&
            "State cannot run into close_merge while being closed");
     executor.mergingSearcher->inCloseMerge.insert(&state);
-    state.openMergeStack.back()->addClosedState(&state, i);
-    state.openMergeStack.pop_back();
+    ref<MergeHandler> mh = *it;
+    state.openMergeStack.erase(std::next(it).base());
+    mh->addClosedState(&state, i);
+  }
+}
+
+void SpecialFunctionHandler::handleCloseMerge(ExecutionState &state,
+    KInstruction *target,
+    std::vector<ref<Expr> > &arguments) {
+  if (!UseMerge) {
+    klee_warning_once(0, "klee_close_merge ignored, use '-use-merge'");
+    return;
   }
+  closeMerge(state, target->inst, /*automatic=*/false);
+}
+
+void SpecialFunctionHandler::handleAutoOpenMerge(ExecutionState &state,
+    KInstruction *target,
+    std::vector<ref<Expr> > &arguments) {
+  state.openMergeStack.push_back(ref<MergeHandler>(
+      new MergeHandler(&executor, &state, /*automatic=*/true)));
+
+  if (DebugLogMerge)
+    llvm::errs() << "open automatic merge: " << &state << "\n";
+}
+
+void SpecialFunctionHandler::handleAutoCloseMerge(ExecutionState &state,
+    KInstruction *target,
+    std::vector<ref<Expr> > &arguments) {
+  closeMerge(state, target->inst, /*automatic=*/true);
 }
 
 void SpecialFunctionHandler::handleNew(ExecutionState &state,
@@ -520,6 +552,44 @@ void SpecialFunctionHandler::handlePosixPreferCex(ExecutionState &state,
     return handlePreferCex(state, target, arguments);
 }
 
+void SpecialFunctionHandler::handlePosixCopy(ExecutionState &state,
+                                             KInstruction *target,
+                                             std::vector<ref<Expr> > &arguments) {
+  assert(arguments.size()==3 &&
+         "invalid number of arguments to klee_posix_copy");
+
+  // Copy the bytes directly between the object states when both ranges are
+  // concrete and in bounds, and otherwise let the runtime fall back to
+  // memcpy, which also reports any memory errors.
+  ref<Expr> result = ConstantExpr::create(0, Expr::Int32);
+  auto *dst = dyn_cast<ConstantExpr>(arguments[0]);
+  auto *src = dyn_cast<ConstantExpr>(arguments[1]);
+  auto *n = dyn_cast<ConstantExpr>(arguments[2]);
+  ObjectPair dstOp, srcOp;
+  if (dst && src && n &&
+      state.addressSpace.resolveOne(dst, dstOp) &&
+      state.addressSpace.resolveOne(src, srcOp) &&
+      !dstOp.second->readOnly) {
+    uint64_t size = n->getZExtValue();
+    const MemoryObject *dstMo = dstOp.first;
+    const MemoryObject *srcMo = srcOp.first;
+    if (dstMo->getBoundsCheckPointer(dst, size)->isTrue() &&
+        srcMo->getBoundsCheckPointer(src, size)->isTrue()) {
+      uint64_t dstOffset = dst->getZExtValue() - dstMo->address;
+      uint64_t srcOffset = src->getZExtValue() - srcMo->address;
+      std::vector<ref<Expr> > bytes;
+      bytes.reserve(size);
+      for (uint64_t i = 0; i < size; ++i)
+        bytes.push_back(srcOp.second->read8(srcOffset + i));
+      ObjectState *wos = state.addressSpace.getWriteable(dstMo, dstOp.second);
+      for (uint64_t i = 0; i < size; ++i)
+        wos->write(dstOffset + i, bytes[i]);
+      result = ConstantExpr::create(1, Expr::Int32);
+    }
+  }
+  executor.bindLocal(target, state, result);
+}
+
 void SpecialFunctionHandler::handlePrintExpr(ExecutionState &state,
                                   KInstruction *target,
                                   std::vector<ref<Expr> > &arguments) {
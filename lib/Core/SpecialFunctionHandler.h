@@ -18,6 +18,7 @@
 
 namespace llvm {
   class Function;
+  class Instruction;
 }
 
 namespace klee {
@@ -71,6 +72,11 @@ namespace klee {
     /* Convenience routines */
 
     std::string readStringAtAddress(ExecutionState &state, ref<Expr> address);
+
+    /// Notify the innermost open merge region of the given kind that
+    /// \p state reached its end at \p i.
+    void closeMerge(ExecutionState &state, llvm::Instruction *i,
+                    bool automatic);
     
     /* Handlers */
 
@@ -81,6 +87,8 @@ namespace klee {
     HANDLER(handleAssert);
     HANDLER(handleAssertFail);
     HANDLER(handleAssume);
+    HANDLER(handleAutoCloseMerge);
+    HANDLER(handleAutoOpenMerge);
     HANDLER(handleCalloc);
     HANDLER(handleCheckMemoryAccess);
     HANDLER(handleDefineFixedObject);
@@ -107,6 +115,7 @@ namespace klee {
     HANDLER(handleNewArray);
     HANDLER(handlePreferCex);
     HANDLER(handlePosixPreferCex);
+    HANDLER(handlePosixCopy);
     HANDLER(handlePrintExpr);
     HANDLER(handlePrintRange);
     HANDLER(handleRange);
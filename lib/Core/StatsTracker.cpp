@@ -19,6 +19,7 @@
 #include "klee/Solver/SolverStats.h"
 #include "klee/Statistics/Statistics.h"
 #include "klee/Support/ErrorHandling.h"
+#include "klee/Support/FileHandling.h"
 #include "klee/Support/ModuleUtil.h"
 #include "klee/System/MemoryUsage.h"
 
@@ -36,6 +37,7 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Module.h"
@@ -46,7 +48,12 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/Support/Process.h"
 DISABLE_WARNING_POP
 
+#include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <fstream>
+#include <signal.h>
+#include <sys/time.h>
 #include <unistd.h>
 
 using namespace klee;
@@ -65,6 +72,29 @@ cl::opt<bool> TrackInstructionTime(
         "Enable tracking of time for individual instructions (default=false)"),
     cl::cat(StatsCat));
 
+enum class InstructionTimer { RUsage, Clock, Sampling };
+
+cl::opt<InstructionTimer> InstructionTimerKind(
+    "instruction-timer",
+    cl::desc("How --track-instruction-time measures instructions"),
+    cl::values(
+        clEnumValN(InstructionTimer::RUsage, "rusage",
+                   "Read the user time and the wall clock at every "
+                   "instruction (default)"),
+        clEnumValN(InstructionTimer::Clock, "clock",
+                   "Read the monotonic clock at every instruction and count "
+                   "wall time as user time"),
+        clEnumValN(InstructionTimer::Sampling, "sampling",
+                   "Attribute samples of CPU time taken by a profiling timer "
+                   "to the current instruction")),
+    cl::init(InstructionTimer::RUsage), cl::cat(StatsCat));
+
+cl::opt<std::string> InstructionTimerInterval(
+    "instruction-timer-interval", cl::init("1ms"),
+    cl::desc("CPU time between samples with --instruction-timer=sampling "
+             "(default=1ms)"),
+    cl::cat(StatsCat));
+
 cl::opt<bool>
     OutputStats("output-stats", cl::init(true),
                 cl::desc("Write running stats trace file (default=true)"),
@@ -116,6 +146,13 @@ cl::opt<bool> UseCallPaths("use-call-paths", cl::init(true),
                                     "level statistics (default=true)"),
                            cl::cat(StatsCat));
 
+cl::opt<bool> OutputFlameGraphs(
+    "output-flamegraphs", cl::init(false),
+    cl::desc("Write the query time, forks, instructions and resolve time per "
+             "call path as collapsed stacks for flame graph tools, along with "
+             "run.istats (default=false)"),
+    cl::cat(StatsCat));
+
 } // namespace klee
 
 ///
@@ -128,6 +165,39 @@ bool StatsTracker::useIStats() {
   return OutputIStats;
 }
 
+namespace {
+/// A statistic kept per instruction.
+struct IndexedStatisticInfo {
+  Statistic &statistic;
+  /// Whether it is written to run.istats
+  bool inIStats;
+  /// Whether it is only touched by a few instructions
+  bool sparse;
+};
+} // namespace
+
+/// The statistics kept per instruction, either for run.istats or for the
+/// searchers and the fork limits. All others only have global values.
+static const IndexedStatisticInfo indexedStatistics[] = {
+    {stats::queries, true, true},
+    {stats::queriesValid, true, true},
+    {stats::queriesInvalid, true, true},
+    {stats::queryTime, true, true},
+    {stats::resolveTime, true, true},
+    {stats::instructions, true, false},
+    {stats::instructionTime, true, false},
+    {stats::instructionRealTime, true, false},
+    {stats::forks, true, true},
+    {stats::coveredInstructions, true, false},
+    {stats::uncoveredInstructions, true, false},
+    {stats::states, true, false},
+    {stats::minDistToUncovered, true, false},
+    {stats::minDistToReturn, false, false},
+    {stats::trueBranches, false, true},
+    {stats::falseBranches, false, true},
+    {stats::solverTime, false, true},
+};
+
 /// Check for special cases where we statically know an instruction is
 /// uncoverable. Currently the case is an unreachable instruction
 /// following a noreturn call; the instruction is really only there to
@@ -152,6 +222,14 @@ static bool instructionIsCoverable(Instruction *i) {
   return true;
 }
 
+/// Set by the profiling timer when the next step should be measured
+static std::atomic<bool> timeSamplePending;
+static struct sigaction previousProfAction;
+
+static void takeTimeSample(int) {
+  timeSamplePending.store(true, std::memory_order_relaxed);
+}
+
 std::string sqlite3ErrToStringAndFree(const std::string& prefix , char* sqlite3ErrMsg) {
   std::ostringstream sstream;
   sstream << prefix << sqlite3ErrMsg;
@@ -199,74 +277,36 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     }
   }
 
-  if (useStatistics() || userSearcherRequiresMD2U())
+  if (useStatistics() || userSearcherRequiresMD2U()) {
     theStatisticManager->useIndexedStats(km->infos->getMaxID());
+    for (const IndexedStatisticInfo &info : indexedStatistics)
+      theStatisticManager->indexStatistic(info.statistic, info.sparse);
+  }
 
-  for (auto &kfp : km->functions) {
-    KFunction *kf = kfp.get();
-    kf->trackCoverage = 1;
-
-    for (unsigned i=0; i<kf->numInstructions; ++i) {
-      KInstruction *ki = kf->instructions[i];
+  if (OutputIStats)
+    coveredInstructions = std::make_unique<BitArray>(km->infos->getMaxID());
 
+  // Every function tracks coverage; with --lazy-manifest most of them have
+  // no KFunction yet, so count on the IR
+  for (auto &f : *km->module) {
+    unsigned id = km->infos->getFirstID(f);
+    for (auto &inst : llvm::instructions(f)) {
       if (OutputIStats) {
-        unsigned id = ki->info->id;
-        theStatisticManager->setIndex(id);
-        if (kf->trackCoverage && instructionIsCoverable(ki->inst))
+        theStatisticManager->setIndex(id++);
+        if (instructionIsCoverable(&inst))
           ++stats::uncoveredInstructions;
       }
-      
-      if (kf->trackCoverage) {
-        if (BranchInst *bi = dyn_cast<BranchInst>(ki->inst))
-          if (!bi->isUnconditional())
-            numBranches++;
-      }
+
+      if (BranchInst *bi = dyn_cast<BranchInst>(&inst))
+        if (!bi->isUnconditional())
+          numBranches++;
     }
   }
 
   if (OutputStats) {
     sqlite3_config(SQLITE_CONFIG_SINGLETHREAD);
 
-    // open database
-    auto db_filename = executor.interpreterHandler->getOutputFilename("run.stats");
-    if (sqlite3_open(db_filename.c_str(), &statsFile) != SQLITE_OK) {
-      std::ostringstream errorstream;
-      errorstream << "Can't open database: " << sqlite3_errmsg(statsFile);
-      sqlite3_close(statsFile);
-      klee_error("%s", errorstream.str().c_str());
-    }
-
-    // prepare statements
-    if (sqlite3_prepare_v2(statsFile, "BEGIN TRANSACTION", -1, &transactionBeginStmt, nullptr) != SQLITE_OK) {
-      klee_error("Cannot create prepared statement: %s", sqlite3_errmsg(statsFile));
-    }
-
-    if (sqlite3_prepare_v2(statsFile, "END TRANSACTION", -1, &transactionEndStmt, nullptr) != SQLITE_OK) {
-      klee_error("Cannot create prepared statement: %s", sqlite3_errmsg(statsFile));
-    }
-
-    // set options
-    char *zErrMsg;
-    if (sqlite3_exec(statsFile, "PRAGMA synchronous = OFF", nullptr, nullptr, &zErrMsg) != SQLITE_OK) {
-      klee_error("%s", sqlite3ErrToStringAndFree("Can't set options for database: ", zErrMsg).c_str());
-    }
-
-    // note: we use WAL here a) for speed and b) to prevent creation of new file descriptors (as with TRUNCATE)
-    if (sqlite3_exec(statsFile, "PRAGMA journal_mode = WAL", nullptr, nullptr, &zErrMsg) != SQLITE_OK) {
-      klee_error("%s", sqlite3ErrToStringAndFree("Can't set options for database: ", zErrMsg).c_str());
-    }
-
-    // create table
-    writeStatsHeader();
-
-    // begin transaction
-    auto rc = sqlite3_step(transactionBeginStmt);
-    if (rc != SQLITE_DONE) {
-      klee_warning("Can't begin transaction: %s", sqlite3_errmsg(statsFile));
-    }
-    sqlite3_reset(transactionBeginStmt);
-
-    writeStatsLine();
+    openStatsFile();
 
     if (statsWriteInterval)
       executor.timers.add(std::make_unique<Timer>(statsWriteInterval, [&]{
@@ -282,6 +322,9 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
     }));
   }
 
+  if (OutputIStats && TrackInstructionTime)
+    startInstructionTimer();
+
   if (OutputIStats) {
     istatsFile = executor.interpreterHandler->openOutputFile("run.istats");
     if (istatsFile) {
@@ -295,7 +338,72 @@ StatsTracker::StatsTracker(Executor &_executor, std::string _objectFilename,
   }
 }
 
+void StatsTracker::openStatsFile() {
+  // open database
+  auto db_filename = executor.interpreterHandler->getOutputFilename("run.stats");
+  if (sqlite3_open(db_filename.c_str(), &statsFile) != SQLITE_OK) {
+    std::ostringstream errorstream;
+    errorstream << "Can't open database: " << sqlite3_errmsg(statsFile);
+    sqlite3_close(statsFile);
+    klee_error("%s", errorstream.str().c_str());
+  }
+
+  // prepare statements
+  if (sqlite3_prepare_v2(statsFile, "BEGIN TRANSACTION", -1, &transactionBeginStmt, nullptr) != SQLITE_OK) {
+    klee_error("Cannot create prepared statement: %s", sqlite3_errmsg(statsFile));
+  }
+
+  if (sqlite3_prepare_v2(statsFile, "END TRANSACTION", -1, &transactionEndStmt, nullptr) != SQLITE_OK) {
+    klee_error("Cannot create prepared statement: %s", sqlite3_errmsg(statsFile));
+  }
+
+  // set options
+  char *zErrMsg;
+  if (sqlite3_exec(statsFile, "PRAGMA synchronous = OFF", nullptr, nullptr, &zErrMsg) != SQLITE_OK) {
+    klee_error("%s", sqlite3ErrToStringAndFree("Can't set options for database: ", zErrMsg).c_str());
+  }
+
+  // note: we use WAL here a) for speed and b) to prevent creation of new file descriptors (as with TRUNCATE)
+  if (sqlite3_exec(statsFile, "PRAGMA journal_mode = WAL", nullptr, nullptr, &zErrMsg) != SQLITE_OK) {
+    klee_error("%s", sqlite3ErrToStringAndFree("Can't set options for database: ", zErrMsg).c_str());
+  }
+
+  // create table
+  writeStatsHeader();
+
+  // begin transaction
+  auto rc = sqlite3_step(transactionBeginStmt);
+  if (rc != SQLITE_DONE) {
+    klee_warning("Can't begin transaction: %s", sqlite3_errmsg(statsFile));
+  }
+  sqlite3_reset(transactionBeginStmt);
+
+  writeStatsLine();
+}
+
+void StatsTracker::reopen() {
+  // The database connection and open files are shared with the process that
+  // took the snapshot, so they are left alone rather than closed.
+  startWallTime = time::getWallTime();
+  // Interval timers are not inherited across fork
+  if (OutputIStats && TrackInstructionTime)
+    startInstructionTimer();
+  if (statsFile) {
+    statsFile = nullptr;
+    statsWriteCount = 0;
+    openStatsFile();
+  }
+  if (istatsFile) {
+    istatsFile.release();
+    istatsFile = executor.interpreterHandler->openOutputFile("run.istats");
+    if (!istatsFile)
+      klee_error("Unable to open instruction level stats file (run.istats).");
+  }
+}
+
 StatsTracker::~StatsTracker() {  
+  if (OutputIStats && TrackInstructionTime)
+    stopInstructionTimer();
   if (statsFile) {
     auto rc = sqlite3_step(transactionEndStmt);
     if (rc != SQLITE_DONE) {
@@ -321,25 +429,108 @@ void StatsTracker::done() {
   }
 }
 
-void StatsTracker::stepInstruction(ExecutionState &es) {
-  if (OutputIStats) {
-    if (TrackInstructionTime) {
-      static time::Point lastNowTime(time::getWallTime());
-      static time::Span lastUserTime;
+void StatsTracker::startInstructionTimer() {
+  instructionTimerStarted = false;
+  if (InstructionTimerKind != InstructionTimer::Sampling)
+    return;
+
+  const time::Span interval(InstructionTimerInterval);
+  if (!interval)
+    klee_error("--instruction-timer-interval must be positive");
+
+  struct sigaction action {};
+  action.sa_handler = takeTimeSample;
+  sigemptyset(&action.sa_mask);
+  action.sa_flags = SA_RESTART;
+  itimerval timer{};
+  timer.it_interval = timer.it_value = static_cast<timeval>(interval);
+  if (::sigaction(SIGPROF, &action, &previousProfAction) ||
+      ::setitimer(ITIMER_PROF, &timer, nullptr))
+    klee_error("Unable to start the instruction timer: %s", strerror(errno));
+  samplingInstructionTime = true;
+}
 
-      if (!lastUserTime) {
-        lastUserTime = time::getUserTime();
-      } else {
-        const auto now = time::getWallTime();
-        const auto user = time::getUserTime();
-        const auto delta = user - lastUserTime;
-        const auto deltaNow = now - lastNowTime;
-        stats::instructionTime += delta.toMicroseconds();
-        stats::instructionRealTime += deltaNow.toMicroseconds();
-        lastUserTime = user;
-        lastNowTime = now;
-      }
+void StatsTracker::stopInstructionTimer() {
+  if (InstructionTimerKind != InstructionTimer::Sampling)
+    return;
+  itimerval timer{};
+  ::setitimer(ITIMER_PROF, &timer, nullptr);
+  ::sigaction(SIGPROF, &previousProfAction, nullptr);
+  samplingInstructionTime = false;
+}
+
+void StatsTracker::blockInstructionTimer(bool block) {
+  if (!samplingInstructionTime)
+    return;
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGPROF);
+  ::pthread_sigmask(block ? SIG_BLOCK : SIG_UNBLOCK, &signals, nullptr);
+}
+
+void StatsTracker::updateInstructionTime() {
+  // The time since the last step is attributed to the statistics index and
+  // call path of the previous instruction, which are still current.
+  if (!instructionTimerStarted) {
+    lastInstructionWallTime = time::getWallTime();
+    lastInstructionUserTime = time::getUserTime();
+    pendingInstructionNanos = 0;
+    timeSamplePending = false;
+    instructionTimerStarted = true;
+    return;
+  }
+
+  switch (InstructionTimerKind) {
+  case InstructionTimer::RUsage: {
+    const auto now = time::getWallTime();
+    const auto user = time::getUserTime();
+    stats::instructionTime += (user - lastInstructionUserTime).toMicroseconds();
+    stats::instructionRealTime +=
+        (now - lastInstructionWallTime).toMicroseconds();
+    lastInstructionUserTime = user;
+    lastInstructionWallTime = now;
+    break;
+  }
+  case InstructionTimer::Clock: {
+    // Most instructions take less than a microsecond, so the remainder is
+    // carried over instead of being truncated away
+    const auto now = time::getWallTime();
+    pendingInstructionNanos +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            static_cast<time::Duration>(now - lastInstructionWallTime))
+            .count();
+    lastInstructionWallTime = now;
+    if (pendingInstructionNanos >= 1000) {
+      const uint64_t elapsed = pendingInstructionNanos / 1000;
+      pendingInstructionNanos %= 1000;
+      stats::instructionTime += elapsed;
+      stats::instructionRealTime += elapsed;
     }
+    break;
+  }
+  case InstructionTimer::Sampling: {
+    // The timer only decides when to measure; reading the clocks on the
+    // next step attributes all time since the previous sample to it, and
+    // does not rely on the timer firing at exactly the requested interval
+    if (!timeSamplePending.load(std::memory_order_relaxed))
+      break;
+    timeSamplePending = false;
+    const auto now = time::getWallTime();
+    const auto user = time::getUserTime();
+    stats::instructionTime += (user - lastInstructionUserTime).toMicroseconds();
+    stats::instructionRealTime +=
+        (now - lastInstructionWallTime).toMicroseconds();
+    lastInstructionUserTime = user;
+    lastInstructionWallTime = now;
+    break;
+  }
+  }
+}
+
+void StatsTracker::stepInstruction(ExecutionState &es) {
+  if (OutputIStats) {
+    if (TrackInstructionTime)
+      updateInstructionTime();
 
     Instruction *inst = es.pc->inst;
     const InstructionInfo &ii = *es.pc->info;
@@ -351,19 +542,14 @@ void StatsTracker::stepInstruction(ExecutionState &es) {
     if (es.instsSinceCovNew)
       ++es.instsSinceCovNew;
 
-    if (sf.kf->trackCoverage && instructionIsCoverable(inst)) {
-      if (!theStatisticManager->getIndexedValue(stats::coveredInstructions, ii.id)) {
-        // Checking for actual stoppoints avoids inconsistencies due
-        // to line number propogation.
-        //
-        // FIXME: This trick no longer works, we should fix this in the line
-        // number propogation.
-          es.coveredLines[&ii.file].insert(ii.line);
-	es.coveredNew = true;
-        es.instsSinceCovNew = 1;
-	++stats::coveredInstructions;
-	stats::uncoveredInstructions += (uint64_t)-1;
-      }
+    if (sf.kf->trackCoverage && !coveredInstructions->get(ii.id) &&
+        instructionIsCoverable(inst)) {
+      coveredInstructions->set(ii.id);
+      es.coveredInstructions.insert(ii.id);
+      es.coveredNew = true;
+      es.instsSinceCovNew = 1;
+      ++stats::coveredInstructions;
+      stats::uncoveredInstructions += (uint64_t)-1;
     }
   }
 
@@ -376,6 +562,18 @@ void StatsTracker::stepInstruction(ExecutionState &es) {
     writeIStats();
 }
 
+void StatsTracker::rewindInstruction(ExecutionState &es) {
+  if (!OutputIStats)
+    return;
+
+  theStatisticManager->setIndex(es.pc->info->id);
+  if (UseCallPaths)
+    theStatisticManager->setContext(&es.stack.back().callPathNode->statistics);
+
+  if (es.instsSinceCovNew > 1)
+    --es.instsSinceCovNew;
+}
+
 ///
 
 /* Should be called _after_ the es->pushFrame() */
@@ -463,6 +661,14 @@ void StatsTracker::writeStatsHeader() {
          << "QueryCacheHits INTEGER,"
          << "QueryCexCacheMisses INTEGER,"
          << "QueryCexCacheHits INTEGER,"
+         << "StateModelMisses INTEGER,"
+         << "StateModelHits INTEGER,"
+         << "AutoMerges INTEGER,"
+         << "AutoMergeRejects INTEGER,"
+         << "AutoMergeQueriesSaved INTEGER,"
+         << "AutoMergeTimeSaved INTEGER,"
+         << "QueriesDeferred INTEGER,"
+         << "QueriesRetried INTEGER,"
          << "InhibitedForks INTEGER,"
          << "ExternalCalls INTEGER,"
          << "Allocations INTEGER,"
@@ -509,6 +715,14 @@ void StatsTracker::writeStatsHeader() {
          << "QueryCacheHits,"
          << "QueryCexCacheMisses,"
          << "QueryCexCacheHits,"
+         << "StateModelMisses,"
+         << "StateModelHits,"
+         << "AutoMerges,"
+         << "AutoMergeRejects,"
+         << "AutoMergeQueriesSaved,"
+         << "AutoMergeTimeSaved,"
+         << "QueriesDeferred,"
+         << "QueriesRetried,"
          << "InhibitedForks,"
          << "ExternalCalls,"
          << "Allocations,"
@@ -548,6 +762,14 @@ void StatsTracker::writeStatsHeader() {
          << "?,"
          << "?,"
          << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
+         << "?,"
          BRANCH_TYPES
          TERMINATION_CLASSES
          << "? "
@@ -590,6 +812,14 @@ void StatsTracker::writeStatsLine() {
   sqlite3_bind_int64(insertStmt, arg++, stats::queryCacheHits);
   sqlite3_bind_int64(insertStmt, arg++, stats::queryCexCacheMisses);
   sqlite3_bind_int64(insertStmt, arg++, stats::queryCexCacheHits);
+  sqlite3_bind_int64(insertStmt, arg++, stats::stateModelMisses);
+  sqlite3_bind_int64(insertStmt, arg++, stats::stateModelHits);
+  sqlite3_bind_int64(insertStmt, arg++, stats::autoMerges);
+  sqlite3_bind_int64(insertStmt, arg++, stats::autoMergeRejects);
+  sqlite3_bind_int64(insertStmt, arg++, stats::autoMergeQueriesSaved);
+  sqlite3_bind_int64(insertStmt, arg++, stats::autoMergeTimeSaved);
+  sqlite3_bind_int64(insertStmt, arg++, stats::queriesDeferred);
+  sqlite3_bind_int64(insertStmt, arg++, stats::queriesRetried);
   sqlite3_bind_int64(insertStmt, arg++, stats::inhibitedForks);
   sqlite3_bind_int64(insertStmt, arg++, stats::externalCalls);
   sqlite3_bind_int64(insertStmt, arg++, stats::allocations);
@@ -648,19 +878,9 @@ void StatsTracker::writeIStats() {
   unsigned nStats = sm.getNumStatistics();
   llvm::SmallBitVector istatsMask(nStats);
 
-  istatsMask.set(sm.getStatisticID("Queries"));
-  istatsMask.set(sm.getStatisticID("QueriesValid"));
-  istatsMask.set(sm.getStatisticID("QueriesInvalid"));
-  istatsMask.set(sm.getStatisticID("QueryTime"));
-  istatsMask.set(sm.getStatisticID("ResolveTime"));
-  istatsMask.set(sm.getStatisticID("Instructions"));
-  istatsMask.set(sm.getStatisticID("InstructionTimes"));
-  istatsMask.set(sm.getStatisticID("InstructionRealTimes"));
-  istatsMask.set(sm.getStatisticID("Forks"));
-  istatsMask.set(sm.getStatisticID("CoveredInstructions"));
-  istatsMask.set(sm.getStatisticID("UncoveredInstructions"));
-  istatsMask.set(sm.getStatisticID("States"));
-  istatsMask.set(sm.getStatisticID("MinDistToUncovered"));
+  for (const IndexedStatisticInfo &info : indexedStatistics)
+    if (info.inIStats)
+      istatsMask.set(info.statistic.getID());
 
   of << "positions: instr line\n";
 
@@ -717,7 +937,7 @@ void StatsTracker::writeIStats() {
             of << "fl=" << ii.file << "\n";
             sourceFile = ii.file;
           }
-          of << ii.assemblyLine << " ";
+          of << ii.getAssemblyLine() << " ";
           of << ii.line << " ";
           for (unsigned i=0; i<nStats; i++)
             if (istatsMask.test(i))
@@ -739,10 +959,10 @@ void StatsTracker::writeIStats() {
                   of << "cfl=" << fii.file << "\n";
                 of << "cfn=" << f->getName().str() << "\n";
                 of << "calls=" << csi.count << " ";
-                of << fii.assemblyLine << " ";
+                of << fii.getAssemblyLine() << " ";
                 of << fii.line << "\n";
 
-                of << ii.assemblyLine << " ";
+                of << ii.getAssemblyLine() << " ";
                 of << ii.line << " ";
                 for (unsigned i=0; i<nStats; i++) {
                   if (istatsMask.test(i)) {
@@ -778,6 +998,33 @@ void StatsTracker::writeIStats() {
     of << '\n';
   
   of.flush();
+
+  if (OutputFlameGraphs && UseCallPaths)
+    writeFlameGraphs();
+}
+
+void StatsTracker::writeFlameGraphs() {
+  static const Statistic *const flameGraphStats[] = {
+      &stats::queryTime, &stats::forks, &stats::instructions,
+      &stats::resolveTime};
+
+  // Each file is replaced as a whole, so that it can be read at any time
+  for (const Statistic *s : flameGraphStats) {
+    std::string path = executor.interpreterHandler->getOutputFilename(
+        "run." + s->getName() + ".folded");
+    std::string tmpPath = path + ".tmp", error;
+    auto f = klee_open_output_file(tmpPath, error);
+    if (!f) {
+      klee_warning("Unable to write flame graph %s: %s", path.c_str(),
+                   error.c_str());
+      continue;
+    }
+    callPathManager.writeFoldedStacks(*f, *s, *executor.kmodule->infos);
+    f.reset();
+    if (std::error_code ec = sys::fs::rename(tmpPath, path))
+      klee_warning("Unable to write flame graph %s: %s", path.c_str(),
+                   ec.message().c_str());
+  }
 }
 
 ///
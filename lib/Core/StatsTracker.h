@@ -11,6 +11,7 @@
 #define KLEE_STATSTRACKER_H
 
 #include "CallPathManager.h"
+#include "klee/ADT/BitArray.h"
 #include "klee/System/Time.h"
 
 #include <memory>
@@ -53,17 +54,34 @@ namespace klee {
 
     CallPathManager callPathManager;
 
+    /// The instructions covered by any state, by instruction id
+    std::unique_ptr<BitArray> coveredInstructions;
+
     bool updateMinDistToUncovered;
 
+    /// State of --track-instruction-time: the time of the last step (or
+    /// sample), and nanoseconds not yet counted in whole microseconds
+    bool instructionTimerStarted = false;
+    time::Point lastInstructionWallTime;
+    time::Span lastInstructionUserTime;
+    std::uint64_t pendingInstructionNanos = 0;
+    /// Whether the SIGPROF timer of --instruction-timer=sampling runs
+    bool samplingInstructionTime = false;
+
   public:
     static bool useStatistics();
     static bool useIStats();
 
   private:
     void updateStateStatistics(uint64_t addend);
+    void openStatsFile();
     void writeStatsHeader();
     void writeStatsLine();
     void writeIStats();
+    void writeFlameGraphs();
+    void startInstructionTimer();
+    void stopInstructionTimer();
+    void updateInstructionTime();
 
   public:
     StatsTracker(Executor &_executor, std::string _objectFilename,
@@ -90,10 +108,25 @@ namespace klee {
     // called when execution is done and stats files should be flushed
     void done();
 
+    /// Start over writing run.stats and run.istats into the current output
+    /// directory, e.g. in a process forked from a snapshot.
+    void reopen();
+
     // process stats for a single instruction step, es is the state
     // about to be stepped
     void stepInstruction(ExecutionState &es);
 
+    /// Undo stepInstruction for \p es, whose pc has been reset to the
+    /// instruction it executes again, so that the instruction count about to
+    /// be taken back is attributed to that instruction. Its coverage stays:
+    /// it was reached, and is not counted as newly covered a second time.
+    void rewindInstruction(ExecutionState &es);
+
+    /// Keep the sampling instruction timer from interrupting code outside
+    /// of KLEE, such as external calls, with EINTR while \p block is set.
+    /// Samples due in between are taken once it is unblocked.
+    void blockInstructionTimer(bool block);
+
     /// Return duration since execution start.
     time::Span elapsed();
 
@@ -12,6 +12,7 @@
 #include "ExecutionState.h"
 
 #include "klee/Config/Version.h"
+#include "klee/Expr/ExprUtil.h"
 #include "klee/Statistics/Statistics.h"
 #include "klee/Statistics/TimerStatIncrementer.h"
 #include "klee/Solver/Solver.h"
@@ -19,6 +20,8 @@
 
 #include "CoreStats.h"
 
+#include <algorithm>
+
 using namespace klee;
 using namespace llvm;
 
@@ -46,6 +49,83 @@ bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
   return success;
 }
 
+bool TimingSolver::evaluate(const ConstraintSet &constraints, ref<Expr> expr,
+                            Solver::Validity &result,
+                            SolverQueryMetaData &metaData,
+                            const std::shared_ptr<const Assignment> &model,
+                            std::shared_ptr<const Assignment> &trueModel,
+                            std::shared_ptr<const Assignment> &falseModel) {
+  trueModel.reset();
+  falseModel.reset();
+
+  ++stats::queries;
+  // Fast path, to avoid timer and OS overhead.
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(expr)) {
+    result = CE->isTrue() ? Solver::True : Solver::False;
+    (CE->isTrue() ? trueModel : falseModel) = model;
+    return true;
+  }
+
+  TimerStatIncrementer timer(stats::solverTime);
+
+  if (simplifyExprs)
+    expr = ConstraintManager::simplifyExpr(constraints, expr);
+
+  std::vector<ref<Expr>> exprs(constraints.begin(), constraints.end());
+  exprs.push_back(expr);
+  std::vector<const Array *> objects;
+  findSymbolicObjects(exprs.begin(), exprs.end(), objects);
+
+  bool success;
+  ref<Expr> value = model ? model->evaluate(expr) : expr;
+  if (isa<ConstantExpr>(value)) {
+    // The model satisfies the constraints, so the side it takes is feasible
+    // and only the other side has to be checked by the solver.
+    ++stats::stateModelHits;
+    bool side = value->isTrue();
+    (side ? trueModel : falseModel) = model;
+    std::shared_ptr<const Assignment> &other = side ? falseModel : trueModel;
+    success = getModel(constraints, side ? Expr::createIsZero(expr) : expr,
+                       objects, other);
+    if (other)
+      result = Solver::Unknown;
+    else
+      result = side ? Solver::True : Solver::False;
+  } else {
+    ++stats::stateModelMisses;
+    success = getModel(constraints, expr, objects, trueModel);
+    if (success) {
+      if (!trueModel) {
+        result = Solver::False;
+      } else {
+        success =
+            getModel(constraints, Expr::createIsZero(expr), objects, falseModel);
+        result = falseModel ? Solver::Unknown : Solver::True;
+      }
+    }
+  }
+
+  metaData.queryCost += timer.delta();
+
+  return success;
+}
+
+bool TimingSolver::getModel(const ConstraintSet &constraints, ref<Expr> expr,
+                            const std::vector<const Array *> &objects,
+                            std::shared_ptr<const Assignment> &model) {
+  std::vector<std::vector<unsigned char>> values;
+  bool hasSolution;
+  if (!solver->getInitialValues(Query(constraints, Expr::createIsZero(expr)),
+                                objects, values, hasSolution))
+    return false;
+
+  if (hasSolution)
+    model = std::make_shared<const Assignment>(objects, values);
+  else
+    model.reset();
+  return true;
+}
+
 bool TimingSolver::mustBeTrue(const ConstraintSet &constraints, ref<Expr> expr,
                               bool &result, SolverQueryMetaData &metaData) {
   ++stats::queries;
@@ -139,3 +219,150 @@ TimingSolver::getRange(const ConstraintSet &constraints, ref<Expr> expr,
   metaData.queryCost += timer.delta();
   return result;
 }
+
+bool TimingSolver::getFeasibleConditions(
+    const ConstraintSet &constraints, const std::vector<ref<Expr>> &conditions,
+    std::vector<bool> &feasible,
+    std::vector<std::shared_ptr<const Assignment>> &models,
+    SolverQueryMetaData &metaData,
+    const std::shared_ptr<const Assignment> &model) {
+  feasible.assign(conditions.size(), false);
+  models.assign(conditions.size(), nullptr);
+
+  std::vector<std::size_t> remaining;
+  for (std::size_t i = 0; i < conditions.size(); ++i) {
+    if (conditions[i]->isTrue()) {
+      feasible[i] = true;
+      models[i] = model;
+    } else if (!conditions[i]->isFalse()) {
+      remaining.push_back(i);
+    }
+  }
+  if (remaining.empty())
+    return true;
+
+  TimerStatIncrementer timer(stats::solverTime);
+
+  std::vector<ref<Expr>> exprs(constraints.begin(), constraints.end());
+  for (std::size_t i : remaining)
+    exprs.push_back(conditions[i]);
+  std::vector<const Array *> objects;
+  findSymbolicObjects(exprs.begin(), exprs.end(), objects);
+
+  bool success = true;
+  std::shared_ptr<const Assignment> current = model;
+  bool fromSolver = false;
+  while (!remaining.empty()) {
+    if (current) {
+      auto satisfied = [&](std::size_t i) {
+        if (!current->evaluate(conditions[i])->isTrue())
+          return false;
+        feasible[i] = true;
+        models[i] = current;
+        return true;
+      };
+      auto it = std::remove_if(remaining.begin(), remaining.end(), satisfied);
+      bool progress = it != remaining.end();
+      remaining.erase(it, remaining.end());
+
+      // An assignment provided by the solver satisfies one of the remaining
+      // conditions, unless evaluation could not decide it. To guarantee
+      // termination, query the remaining conditions one by one in that case.
+      if (fromSolver && !progress) {
+        for (std::size_t i : remaining) {
+          ++stats::queries;
+          bool mustBeFalse;
+          success = solver->mustBeFalse(Query(constraints, conditions[i]),
+                                        mustBeFalse);
+          if (!success)
+            break;
+          feasible[i] = !mustBeFalse;
+        }
+        break;
+      }
+      if (remaining.empty())
+        break;
+    }
+
+    ref<Expr> any = ConstantExpr::alloc(0, Expr::Bool);
+    for (std::size_t i : remaining)
+      any = OrExpr::create(conditions[i], any);
+    if (simplifyExprs)
+      any = ConstraintManager::simplifyExpr(constraints, any);
+
+    ++stats::queries;
+    success = getModel(constraints, any, objects, current);
+    // On failure or if none of the remaining conditions can be true
+    if (!success || !current)
+      break;
+    fromSolver = true;
+  }
+
+  metaData.queryCost += timer.delta();
+
+  return success;
+}
+
+bool TimingSolver::getValues(
+    const ConstraintSet &constraints, ref<Expr> expr, std::size_t maxValues,
+    std::vector<std::pair<ref<ConstantExpr>, std::shared_ptr<const Assignment>>>
+        &values,
+    std::shared_ptr<const Assignment> &remaining,
+    SolverQueryMetaData &metaData,
+    const std::shared_ptr<const Assignment> &model) {
+  values.clear();
+  remaining.reset();
+  if (ConstantExpr *CE = dyn_cast<ConstantExpr>(expr)) {
+    values.emplace_back(CE, model);
+    return true;
+  }
+
+  TimerStatIncrementer timer(stats::solverTime);
+
+  if (simplifyExprs)
+    expr = ConstraintManager::simplifyExpr(constraints, expr);
+
+  std::vector<ref<Expr>> exprs(constraints.begin(), constraints.end());
+  exprs.push_back(expr);
+  std::vector<const Array *> objects;
+  findSymbolicObjects(exprs.begin(), exprs.end(), objects);
+
+  bool success = true;
+  std::shared_ptr<const Assignment> current = model;
+  ref<Expr> others = ConstantExpr::alloc(1, Expr::Bool);
+  while (true) {
+    if (current) {
+      ref<Expr> value = current->evaluate(expr);
+      // Evaluation could not decide the value, let the solver pick one
+      // instead. The assignment then does not belong to the value.
+      if (!isa<ConstantExpr>(value)) {
+        ConstraintSet extended(constraints);
+        ConstraintManager(extended).addConstraint(others);
+        ++stats::queries;
+        ref<ConstantExpr> result;
+        success = solver->getValue(Query(extended, expr), result);
+        if (!success)
+          break;
+        value = result;
+        current.reset();
+      }
+      values.emplace_back(cast<ConstantExpr>(value), current);
+      others = AndExpr::create(Expr::createIsZero(EqExpr::create(expr, value)),
+                               others);
+    }
+
+    ++stats::queries;
+    success = getModel(constraints, others, objects, current);
+    // On failure or if no other value is possible
+    if (!success || !current)
+      break;
+    if (values.size() >= maxValues) {
+      remaining = current;
+      break;
+    }
+  }
+
+  metaData.queryCost += timer.delta();
+
+  return success;
+}
@@ -10,6 +10,7 @@
 #ifndef KLEE_TIMINGSOLVER_H
 #define KLEE_TIMINGSOLVER_H
 
+#include "klee/Expr/Assignment.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Solver/Solver.h"
@@ -49,6 +50,19 @@ public:
   bool evaluate(const ConstraintSet &, ref<Expr>, Solver::Validity &result,
                 SolverQueryMetaData &metaData);
 
+  /// Like evaluate(), but first evaluates the expression under \p model, a
+  /// known satisfying assignment of the constraints, which proves one side of
+  /// the branch feasible without querying the solver.
+  ///
+  /// \param [out] trueModel, falseModel - On success, satisfying assignments
+  /// of the constraints extended by the expression and its negation,
+  /// respectively; null if the side is infeasible or no model is known.
+  bool evaluate(const ConstraintSet &, ref<Expr>, Solver::Validity &result,
+                SolverQueryMetaData &metaData,
+                const std::shared_ptr<const Assignment> &model,
+                std::shared_ptr<const Assignment> &trueModel,
+                std::shared_ptr<const Assignment> &falseModel);
+
   bool mustBeTrue(const ConstraintSet &, ref<Expr>, bool &result,
                   SolverQueryMetaData &metaData);
 
@@ -72,6 +86,44 @@ public:
   std::pair<ref<Expr>, ref<Expr>> getRange(const ConstraintSet &,
                                            ref<Expr> query,
                                            SolverQueryMetaData &metaData);
+
+  /// Determine which of \p conditions may be true. Instead of one query per
+  /// condition, satisfying assignments are enumerated: each one proves all
+  /// conditions feasible that hold under it, and the next one is requested
+  /// for the disjunction of the conditions not yet known to be feasible.
+  /// This takes one query per assignment plus a final unsatisfiable one.
+  ///
+  /// \param model - A known satisfying assignment of the constraints or null.
+  /// \param [out] feasible - Whether the respective condition may be true.
+  /// \param [out] models - For feasible conditions, a satisfying assignment of
+  /// the constraints extended by the condition, if one is known.
+  bool getFeasibleConditions(
+      const ConstraintSet &, const std::vector<ref<Expr>> &conditions,
+      std::vector<bool> &feasible,
+      std::vector<std::shared_ptr<const Assignment>> &models,
+      SolverQueryMetaData &metaData,
+      const std::shared_ptr<const Assignment> &model = nullptr);
+
+  /// Enumerate up to \p maxValues values \p expr can take under the
+  /// constraints, using one query per value plus a final one. Each value is
+  /// paired with a satisfying assignment in which \p expr takes that value,
+  /// if one is known. If \p expr can take other values, \p remaining is set
+  /// to a satisfying assignment in which it takes none of the enumerated
+  /// ones, and to null otherwise.
+  bool getValues(const ConstraintSet &, ref<Expr> expr, std::size_t maxValues,
+                 std::vector<std::pair<ref<ConstantExpr>,
+                                       std::shared_ptr<const Assignment>>>
+                     &values,
+                 std::shared_ptr<const Assignment> &remaining,
+                 SolverQueryMetaData &metaData,
+                 const std::shared_ptr<const Assignment> &model = nullptr);
+
+private:
+  /// Compute a satisfying assignment of the constraints extended by \p expr,
+  /// or set \p model to null if there is none.
+  bool getModel(const ConstraintSet &, ref<Expr> expr,
+                const std::vector<const Array *> &objects,
+                std::shared_ptr<const Assignment> &model);
 };
 }
 
@@ -82,9 +82,10 @@ cl::opt<std::string> BatchTime(
 void initializeSearchOptions() {
   // default values
   if (CoreSearch.empty()) {
-    if (UseMerge) {
+    if (UseMerge || AutoMerge) {
       CoreSearch.push_back(Searcher::NURS_CovNew);
-      klee_warning("--use-merge enabled. Using NURS_CovNew as default searcher.");
+      klee_warning("%s enabled. Using NURS_CovNew as default searcher.",
+                   UseMerge ? "--use-merge" : "--auto-merge");
     } else {
       CoreSearch.push_back(Searcher::RandomPath);
       CoreSearch.push_back(Searcher::NURS_CovNew);
@@ -150,7 +151,7 @@ Searcher *klee::constructUserSearcher(Executor &executor) {
     searcher = new IterativeDeepeningTimeSearcher(searcher);
   }
 
-  if (UseMerge) {
+  if (UseMerge || AutoMerge) {
     auto *ms = new MergingSearcher(searcher);
     executor.setMergingSearcher(ms);
 
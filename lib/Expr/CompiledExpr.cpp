@@ -0,0 +1,473 @@
+//===-- CompiledExpr.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/CompiledExpr.h"
+
+#include "klee/ADT/Bits.h"
+
+#include <algorithm>
+#include <iterator>
+
+using namespace klee;
+
+namespace {
+/// Interpret the low \p width bits of \p value as a signed number.
+inline int64_t signExtend(uint64_t value, unsigned width) {
+  unsigned shift = 64 - width;
+  return (int64_t)(value << shift) >> shift;
+}
+
+/// Number of assignments evaluated side by side. Each instruction runs as a
+/// loop over this many lanes, which the compiler can vectorize.
+constexpr unsigned BatchWidth = 64;
+
+template <typename F>
+inline void unary(uint64_t *dst, const uint64_t *a, unsigned n, uint64_t mask,
+                  F f) {
+  for (unsigned l = 0; l != n; ++l)
+    dst[l] = f(a[l]) & mask;
+}
+
+template <typename F>
+inline void binary(uint64_t *dst, const uint64_t *a, const uint64_t *b,
+                   unsigned n, uint64_t mask, F f) {
+  for (unsigned l = 0; l != n; ++l)
+    dst[l] = f(a[l], b[l]) & mask;
+}
+} // namespace
+
+CompiledExpr::CompiledExpr(const ref<Expr> &e) { addRoot(e); }
+
+void CompiledExpr::addRoot(const ref<Expr> &e) {
+  unsigned codeSize = code.size(), registerCount = registers.size(),
+           updateCount = updates.size();
+
+  failed = false;
+  unsigned reg = compile(e);
+  if (failed) {
+    // Forget everything emitted for the unsupported expression; it is
+    // evaluated by the interpreter instead.
+    code.resize(codeSize);
+    registers.resize(registerCount);
+    updates.resize(updateCount);
+    for (auto it = registerOf.begin(); it != registerOf.end();)
+      it = it->second >= registerCount ? registerOf.erase(it) : std::next(it);
+    for (auto it = updateOf.begin(); it != updateOf.end();)
+      it = it->second >= (int)updateCount ? updateOf.erase(it) : std::next(it);
+  }
+
+  roots.push_back({e, reg, (unsigned)code.size(), !failed});
+}
+
+unsigned CompiledExpr::emit(const Expr &e, unsigned a, unsigned b,
+                            unsigned c) {
+  unsigned dst = registers.size();
+  registers.push_back(0);
+  code.push_back({e.getKind(), e.getWidth(), dst, a, b, c});
+  return dst;
+}
+
+unsigned CompiledExpr::getArraySlot(const Array *array) {
+  auto res = slotOf.insert(std::make_pair(array, arrays.size()));
+  if (res.second) {
+    arrays.push_back(array);
+    bindings.push_back(nullptr);
+  }
+  return res.first->second;
+}
+
+int CompiledExpr::compileUpdates(const UpdateNode *un) {
+  // Walk to the newest node that was already compiled, then compile the
+  // remaining nodes from oldest to newest so each can link to its successor.
+  std::vector<const UpdateNode *> pending;
+  int next = -1;
+  for (; un; un = un->next.get()) {
+    auto it = updateOf.find(un);
+    if (it != updateOf.end()) {
+      next = it->second;
+      break;
+    }
+    pending.push_back(un);
+  }
+
+  for (auto it = pending.rbegin(), ie = pending.rend(); it != ie; ++it) {
+    unsigned index = compile((*it)->index);
+    unsigned value = compile((*it)->value);
+    if (failed)
+      return -1;
+    updates.push_back({index, value, next});
+    next = updates.size() - 1;
+    updateOf.insert(std::make_pair(*it, next));
+  }
+  return next;
+}
+
+unsigned CompiledExpr::compile(const ref<Expr> &e) {
+  if (failed)
+    return 0;
+
+  auto it = registerOf.find(e);
+  if (it != registerOf.end())
+    return it->second;
+
+  if (e->getWidth() > 64) {
+    failed = true;
+    return 0;
+  }
+
+  unsigned reg;
+  switch (e->getKind()) {
+  case Expr::Constant:
+    reg = registers.size();
+    registers.push_back(cast<ConstantExpr>(e)->getZExtValue());
+    break;
+
+  case Expr::Read: {
+    const ReadExpr *re = cast<ReadExpr>(e);
+    if (re->index->getWidth() > 64) {
+      failed = true;
+      return 0;
+    }
+    unsigned index = compile(re->index);
+    int head = compileUpdates(re->updates.head.get());
+    unsigned slot = getArraySlot(re->updates.root);
+    if (failed)
+      return 0;
+    reg = emit(*e, index, (unsigned)head, slot);
+    break;
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    if (ee->expr->getWidth() > 64) {
+      failed = true;
+      return 0;
+    }
+    unsigned kid = compile(ee->expr);
+    if (failed)
+      return 0;
+    reg = emit(*e, kid, ee->offset);
+    break;
+  }
+
+  case Expr::Concat: {
+    unsigned left = compile(e->getKid(0)), right = compile(e->getKid(1));
+    if (failed)
+      return 0;
+    reg = emit(*e, left, right, e->getKid(1)->getWidth());
+    break;
+  }
+
+  default: {
+    unsigned kids[3] = {0, 0, 0};
+    for (unsigned i = 0, n = e->getNumKids(); i != n; ++i) {
+      if (e->getKid(i)->getWidth() > 64)
+        failed = true;
+      kids[i] = compile(e->getKid(i));
+    }
+    if (failed)
+      return 0;
+    // Instructions that need the width of their operand receive it in the
+    // last slot.
+    if (e->getKind() == Expr::SExt)
+      kids[1] = e->getKid(0)->getWidth();
+    else if (isa<CmpExpr>(e))
+      kids[2] = e->getKid(0)->getWidth();
+    reg = emit(*e, kids[0], kids[1], kids[2]);
+    break;
+  }
+  }
+
+  registerOf.insert(std::make_pair(e, reg));
+  return reg;
+}
+
+bool CompiledExpr::run(const Assignment &a, unsigned end) const {
+  const Assignment *assignment = &a;
+  unsigned char failed = 0;
+  execute(&assignment, 1, end, registers.data(), &failed);
+  return !failed;
+}
+
+void CompiledExpr::execute(const Assignment *const *assignments, unsigned n,
+                           unsigned end, uint64_t *r,
+                           unsigned char *failed) const {
+  bindings.resize(arrays.size() * n);
+  for (unsigned slot = 0, e = arrays.size(); slot != e; ++slot) {
+    for (unsigned l = 0; l != n; ++l) {
+      const auto &b = assignments[l]->bindings;
+      auto it = b.find(arrays[slot]);
+      bindings[slot * n + l] = it == b.end() ? nullptr : &it->second;
+    }
+  }
+
+  for (unsigned pc = 0; pc != end; ++pc) {
+    const Instruction &I = code[pc];
+    uint64_t *dst = r + I.dst * n;
+    auto lane = [r, n](unsigned reg) -> const uint64_t * { return r + reg * n; };
+    uint64_t mask = bits64::maxValueOfNBits(I.width);
+    unsigned width = I.width;
+
+    switch (I.kind) {
+    case Expr::Read: {
+      const uint64_t *index = lane(I.a);
+      const Array *array = arrays[I.c];
+      for (unsigned l = 0; l != n; ++l) {
+        int u = (int)I.b;
+        for (; u != -1; u = updates[u].next)
+          if (r[updates[u].index * n + l] == index[l])
+            break;
+        const std::vector<unsigned char> *bytes = bindings[I.c * n + l];
+        if (u != -1) {
+          dst[l] = r[updates[u].value * n + l];
+        } else if (array->isConstantArray() && index[l] < array->size) {
+          dst[l] = array->constantValues[index[l]]->getZExtValue();
+        } else if (bytes && index[l] < bytes->size()) {
+          dst[l] = (*bytes)[index[l]];
+        } else {
+          if (assignments[l]->allowFreeValues)
+            failed[l] = 1;
+          dst[l] = 0;
+        }
+      }
+      break;
+    }
+    case Expr::Select: {
+      const uint64_t *c = lane(I.a), *t = lane(I.b), *f = lane(I.c);
+      for (unsigned l = 0; l != n; ++l)
+        dst[l] = c[l] ? t[l] : f[l];
+      break;
+    }
+    case Expr::Concat: {
+      unsigned shift = I.c;
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [shift](uint64_t x, uint64_t y) { return (x << shift) | y; });
+      break;
+    }
+    case Expr::Extract: {
+      unsigned offset = I.b;
+      unary(dst, lane(I.a), n, mask,
+            [offset](uint64_t x) { return x >> offset; });
+      break;
+    }
+    case Expr::NotOptimized:
+    case Expr::ZExt:
+      unary(dst, lane(I.a), n, mask, [](uint64_t x) { return x; });
+      break;
+    case Expr::SExt: {
+      unsigned from = I.b;
+      unary(dst, lane(I.a), n, mask,
+            [from](uint64_t x) { return (uint64_t)signExtend(x, from); });
+      break;
+    }
+    case Expr::Not:
+      unary(dst, lane(I.a), n, mask, [](uint64_t x) { return ~x; });
+      break;
+
+    case Expr::Add:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x + y; });
+      break;
+    case Expr::Sub:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x - y; });
+      break;
+    case Expr::Mul:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x * y; });
+      break;
+    case Expr::UDiv:
+    case Expr::URem:
+    case Expr::SDiv:
+    case Expr::SRem: {
+      const uint64_t *x = lane(I.a), *y = lane(I.b);
+      for (unsigned l = 0; l != n; ++l) {
+        if (!y[l]) {
+          failed[l] = 1;
+          dst[l] = 0;
+          continue;
+        }
+        uint64_t v;
+        int64_t sx = signExtend(x[l], width), sy = signExtend(y[l], width);
+        switch (I.kind) {
+        case Expr::UDiv:
+          v = x[l] / y[l];
+          break;
+        case Expr::URem:
+          v = x[l] % y[l];
+          break;
+        case Expr::SDiv:
+          // Negate as unsigned so that INT_MIN / -1 wraps like APInt does.
+          v = sy == -1 ? -(uint64_t)sx : (uint64_t)(sx / sy);
+          break;
+        default:
+          v = sy == -1 ? 0 : (uint64_t)(sx % sy);
+          break;
+        }
+        dst[l] = v & mask;
+      }
+      break;
+    }
+
+    case Expr::And:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x & y; });
+      break;
+    case Expr::Or:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x | y; });
+      break;
+    case Expr::Xor:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x ^ y; });
+      break;
+    case Expr::Shl:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [width](uint64_t x, uint64_t y) -> uint64_t {
+               return y >= width ? 0 : x << y;
+             });
+      break;
+    case Expr::LShr:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [width](uint64_t x, uint64_t y) -> uint64_t {
+               return y >= width ? 0 : x >> y;
+             });
+      break;
+    case Expr::AShr:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [width](uint64_t x, uint64_t y) -> uint64_t {
+               int64_t sx = signExtend(x, width);
+               return y >= width ? (sx < 0 ? ~UINT64_C(0) : 0) : sx >> y;
+             });
+      break;
+
+    case Expr::Eq:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x == y; });
+      break;
+    case Expr::Ne:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x != y; });
+      break;
+    case Expr::Ult:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x < y; });
+      break;
+    case Expr::Ule:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x <= y; });
+      break;
+    case Expr::Ugt:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x > y; });
+      break;
+    case Expr::Uge:
+      binary(dst, lane(I.a), lane(I.b), n, mask,
+             [](uint64_t x, uint64_t y) { return x >= y; });
+      break;
+    case Expr::Slt: {
+      unsigned w = I.c;
+      binary(dst, lane(I.a), lane(I.b), n, mask, [w](uint64_t x, uint64_t y) {
+        return signExtend(x, w) < signExtend(y, w);
+      });
+      break;
+    }
+    case Expr::Sle: {
+      unsigned w = I.c;
+      binary(dst, lane(I.a), lane(I.b), n, mask, [w](uint64_t x, uint64_t y) {
+        return signExtend(x, w) <= signExtend(y, w);
+      });
+      break;
+    }
+    case Expr::Sgt: {
+      unsigned w = I.c;
+      binary(dst, lane(I.a), lane(I.b), n, mask, [w](uint64_t x, uint64_t y) {
+        return signExtend(x, w) > signExtend(y, w);
+      });
+      break;
+    }
+    case Expr::Sge: {
+      unsigned w = I.c;
+      binary(dst, lane(I.a), lane(I.b), n, mask, [w](uint64_t x, uint64_t y) {
+        return signExtend(x, w) >= signExtend(y, w);
+      });
+      break;
+    }
+
+    default:
+      assert(0 && "unhandled instruction in compiled expression");
+      std::fill(failed, failed + n, 1);
+      return;
+    }
+  }
+}
+
+ref<Expr> CompiledExpr::evaluate(const Assignment &a, unsigned i) const {
+  assert(i < roots.size() && "invalid expression index");
+  const Root &root = roots[i];
+  if (!root.compiled || !run(a, root.end))
+    return a.evaluate(root.expr);
+  return ConstantExpr::create(registers[root.reg], root.expr->getWidth());
+}
+
+void CompiledExpr::evaluate(const Assignment &a,
+                            std::vector<ref<Expr>> &results) const {
+  bool complete = run(a, code.size());
+  results.clear();
+  results.reserve(roots.size());
+  for (const Root &root : roots) {
+    if (root.compiled && complete)
+      results.push_back(
+          ConstantExpr::create(registers[root.reg], root.expr->getWidth()));
+    else
+      results.push_back(a.evaluate(root.expr));
+  }
+}
+
+void CompiledExpr::evaluate(const std::vector<const Assignment *> &assignments,
+                            std::vector<ref<Expr>> &results) const {
+  unsigned count = roots.size();
+  results.assign(assignments.size() * count, nullptr);
+
+  for (std::size_t base = 0; base < assignments.size(); base += BatchWidth) {
+    unsigned n = std::min<std::size_t>(BatchWidth, assignments.size() - base);
+    // Registers are stored lane by lane; broadcast the constants first.
+    lanes.resize(registers.size() * n);
+    for (unsigned reg = 0, e = registers.size(); reg != e; ++reg)
+      std::fill_n(lanes.begin() + reg * n, n, registers[reg]);
+    failedLanes.assign(n, 0);
+    execute(&assignments[base], n, code.size(), lanes.data(),
+            failedLanes.data());
+
+    for (unsigned l = 0; l != n; ++l) {
+      for (unsigned i = 0; i != count; ++i) {
+        const Root &root = roots[i];
+        ref<Expr> &result = results[(base + l) * count + i];
+        if (root.compiled && !failedLanes[l])
+          result = ConstantExpr::create(lanes[root.reg * n + l],
+                                        root.expr->getWidth());
+        else
+          result = assignments[base + l]->evaluate(root.expr);
+      }
+    }
+  }
+}
+
+bool CompiledExpr::satisfies(const Assignment &a) const {
+  bool complete = run(a, code.size());
+  for (const Root &root : roots) {
+    if (root.compiled && complete) {
+      if (!registers[root.reg])
+        return false;
+    } else if (!a.evaluate(root.expr)->isTrue()) {
+      return false;
+    }
+  }
+  return true;
+}
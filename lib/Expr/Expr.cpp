@@ -539,6 +539,13 @@ ref<Expr> ReadExpr::create(const UpdateList &ul, ref<Expr> index) {
   auto un = ul.head.get();
   bool updateListHasSymbolicWrites = false;
   for (; un; un = un->next.get()) {
+    // Skip the writes to other concrete indices
+    if (ConstantExpr *CE = dyn_cast<ConstantExpr>(index)) {
+      un = un->findWrite(CE->getZExtValue());
+      if (!un)
+        break;
+    }
+
     ref<Expr> cond = EqExpr::create(index, un->index);
     if (ConstantExpr *CE = dyn_cast<ConstantExpr>(cond)) {
       if (CE->isTrue())
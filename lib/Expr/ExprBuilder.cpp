@@ -327,8 +327,13 @@ namespace {
                            const ref<Expr> &Index) {
       // Roll back through writes when possible.
       auto UN = Updates.head;
-      while (UN && Eq(Index, UN->index)->isFalse())
+      while (UN) {
+        if (ConstantExpr *CE = dyn_cast<ConstantExpr>(Index))
+          UN = UN->findWrite(CE->getZExtValue());
+        if (!UN || !Eq(Index, UN->index)->isFalse())
+          break;
         UN = UN->next;
+      }
 
       if (ConstantExpr *CE = dyn_cast<ConstantExpr>(Index))
         return Builder.Read(UpdateList(Updates.root, UN), CE);
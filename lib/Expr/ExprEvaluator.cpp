@@ -14,6 +14,10 @@ using namespace klee;
 ExprVisitor::Action ExprEvaluator::evalRead(const UpdateList &ul,
                                             unsigned index) {
   for (auto un = ul.head; un; un = un->next) {
+    un = un->findWrite(index);
+    if (!un)
+      break;
+
     ref<Expr> ui = visit(un->index);
     
     if (ConstantExpr *CE = dyn_cast<ConstantExpr>(ui)) {
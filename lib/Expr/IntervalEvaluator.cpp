@@ -0,0 +1,310 @@
+//===-- IntervalEvaluator.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/IntervalEvaluator.h"
+
+#include "klee/ADT/Bits.h"
+
+#include <algorithm>
+
+using namespace klee;
+
+namespace {
+using Interval = IntervalEvaluator::Interval;
+
+Interval full(Expr::Width width) {
+  return {0, bits64::maxValueOfNBits(width)};
+}
+
+/// Set all bits below the most significant set bit of \p x.
+uint64_t smear(uint64_t x) {
+  for (unsigned shift = 1; shift < 64; shift <<= 1)
+    x |= x >> shift;
+  return x;
+}
+
+/// Reduce the bounds of a sum or difference modulo 2^width. The result is
+/// exact as long as both bounds wrap around the same number of times. For
+/// narrow widths the 64-bit computation cannot overflow, so any bit above the
+/// mask signals the carry (or borrow) instead.
+Interval wrapping(uint64_t lo, bool loCarry, uint64_t hi, bool hiCarry,
+                  Expr::Width width) {
+  uint64_t mask = bits64::maxValueOfNBits(width);
+  if (width < 64) {
+    loCarry = lo & ~mask;
+    hiCarry = hi & ~mask;
+  }
+  if (loCarry != hiCarry)
+    return full(width);
+  return {lo & mask, hi & mask};
+}
+} // namespace
+
+IntervalEvaluator::IntervalEvaluator(const ConstraintSet &constraints) {
+  for (const auto &constraint : constraints)
+    addConstraint(constraint);
+}
+
+void IntervalEvaluator::restrict(const ref<Expr> &e, uint64_t min,
+                                 uint64_t max) {
+  if (isa<ConstantExpr>(e) || e->getWidth() > 64 || min > max)
+    return;
+  auto it = known.find(e);
+  if (it == known.end()) {
+    known.insert(std::make_pair(e, Interval{min, max}));
+  } else {
+    // An empty intersection means the constraints are unsatisfiable; keep the
+    // old bounds rather than reasoning about an infeasible state.
+    uint64_t lo = std::max(min, it->second.min);
+    uint64_t hi = std::min(max, it->second.max);
+    if (lo <= hi)
+      it->second = {lo, hi};
+  }
+  cache.clear();
+}
+
+void IntervalEvaluator::addConstraint(const ref<Expr> &e) {
+  switch (e->getKind()) {
+  case Expr::And:
+    addConstraint(e->getKid(0));
+    addConstraint(e->getKid(1));
+    return;
+
+  case Expr::Eq: {
+    const ConstantExpr *CE = dyn_cast<ConstantExpr>(e->getKid(0));
+    if (!CE || CE->getWidth() > 64)
+      return;
+    if (CE->getWidth() == Expr::Bool) {
+      if (CE->isFalse())
+        addNegatedConstraint(e->getKid(1));
+      return;
+    }
+    uint64_t value = CE->getZExtValue();
+    restrict(e->getKid(1), value, value);
+    return;
+  }
+
+  case Expr::Ult:
+  case Expr::Ule: {
+    ref<Expr> left = e->getKid(0), right = e->getKid(1);
+    if (left->getWidth() > 64)
+      return;
+    uint64_t max = bits64::maxValueOfNBits(left->getWidth());
+    bool strict = e->getKind() == Expr::Ult;
+    if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(right)) {
+      uint64_t value = CE->getZExtValue();
+      if (!strict || value)
+        restrict(left, 0, strict ? value - 1 : value);
+    } else if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(left)) {
+      uint64_t value = CE->getZExtValue();
+      if (!strict || value != max)
+        restrict(right, strict ? value + 1 : value, max);
+    }
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+void IntervalEvaluator::addNegatedConstraint(const ref<Expr> &e) {
+  switch (e->getKind()) {
+  case Expr::Or:
+    addNegatedConstraint(e->getKid(0));
+    addNegatedConstraint(e->getKid(1));
+    return;
+
+  // !(a < b) is b <= a, and !(a <= b) is b < a.
+  case Expr::Ult:
+  case Expr::Ule: {
+    ref<Expr> left = e->getKid(0), right = e->getKid(1);
+    if (left->getWidth() > 64)
+      return;
+    uint64_t max = bits64::maxValueOfNBits(left->getWidth());
+    bool strict = e->getKind() == Expr::Ule;
+    if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(left)) {
+      uint64_t value = CE->getZExtValue();
+      if (!strict || value)
+        restrict(right, 0, strict ? value - 1 : value);
+    } else if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(right)) {
+      uint64_t value = CE->getZExtValue();
+      if (!strict || value != max)
+        restrict(left, strict ? value + 1 : value, max);
+    }
+    return;
+  }
+
+  default:
+    return;
+  }
+}
+
+IntervalEvaluator::Interval IntervalEvaluator::evaluate(const ref<Expr> &e) {
+  assert(e->getWidth() <= 64 && "interval evaluation of wide expression");
+
+  if (const ConstantExpr *CE = dyn_cast<ConstantExpr>(e)) {
+    uint64_t value = CE->getZExtValue();
+    return {value, value};
+  }
+
+  auto it = cache.find(e);
+  if (it != cache.end())
+    return it->second;
+
+  Interval result = evaluateUncached(e);
+  auto kit = known.find(e);
+  if (kit != known.end()) {
+    uint64_t lo = std::max(result.min, kit->second.min);
+    uint64_t hi = std::min(result.max, kit->second.max);
+    if (lo <= hi)
+      result = {lo, hi};
+  }
+
+  cache.insert(std::make_pair(e, result));
+  return result;
+}
+
+IntervalEvaluator::Interval
+IntervalEvaluator::evaluateUncached(const ref<Expr> &e) {
+  Expr::Width width = e->getWidth();
+  uint64_t mask = bits64::maxValueOfNBits(width);
+
+  switch (e->getKind()) {
+  case Expr::Select: {
+    Interval t = evaluate(e->getKid(1)), f = evaluate(e->getKid(2));
+    return {std::min(t.min, f.min), std::max(t.max, f.max)};
+  }
+
+  case Expr::Concat: {
+    ref<Expr> left = e->getKid(0), right = e->getKid(1);
+    Interval l = evaluate(left), r = evaluate(right);
+    unsigned shift = right->getWidth();
+    return {(l.min << shift) | r.min, (l.max << shift) | r.max};
+  }
+
+  case Expr::Extract: {
+    const ExtractExpr *ee = cast<ExtractExpr>(e);
+    if (ee->expr->getWidth() > 64)
+      return full(width);
+    Interval k = evaluate(ee->expr);
+    uint64_t lo = k.min >> ee->offset, hi = k.max >> ee->offset;
+    // Truncation is monotone only if no bound has bits above the result.
+    if (hi > mask)
+      return full(width);
+    return {lo, hi};
+  }
+
+  case Expr::ZExt:
+    return evaluate(e->getKid(0));
+
+  case Expr::SExt: {
+    ref<Expr> kid = e->getKid(0);
+    Interval k = evaluate(kid);
+    if (k.max > bits64::maxValueOfNBits(kid->getWidth() - 1))
+      return full(width);
+    return k;
+  }
+
+  case Expr::Not: {
+    Interval k = evaluate(e->getKid(0));
+    return {mask - k.max, mask - k.min};
+  }
+
+  case Expr::Add: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    uint64_t lo, hi;
+    bool loCarry = __builtin_add_overflow(l.min, r.min, &lo);
+    bool hiCarry = __builtin_add_overflow(l.max, r.max, &hi);
+    return wrapping(lo, loCarry, hi, hiCarry, width);
+  }
+
+  case Expr::Sub: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    uint64_t lo, hi;
+    bool loBorrow = __builtin_sub_overflow(l.min, r.max, &lo);
+    bool hiBorrow = __builtin_sub_overflow(l.max, r.min, &hi);
+    return wrapping(lo, loBorrow, hi, hiBorrow, width);
+  }
+
+  case Expr::Mul: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    uint64_t hi;
+    if (__builtin_mul_overflow(l.max, r.max, &hi) || hi > mask)
+      return full(width);
+    return {l.min * r.min, hi};
+  }
+
+  case Expr::UDiv: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    if (!r.min)
+      return full(width);
+    return {l.min / r.max, l.max / r.min};
+  }
+
+  case Expr::URem: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    if (!r.min)
+      return full(width);
+    if (l.max < r.min)
+      return l;
+    return {0, std::min(l.max, r.max - 1)};
+  }
+
+  case Expr::And: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    return {0, std::min(l.max, r.max)};
+  }
+
+  case Expr::Or: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    return {std::max(l.min, r.min), smear(l.max | r.max)};
+  }
+
+  case Expr::Xor: {
+    Interval l = evaluate(e->getKid(0)), r = evaluate(e->getKid(1));
+    return {0, smear(l.max | r.max)};
+  }
+
+  case Expr::Shl: {
+    const ConstantExpr *CE = dyn_cast<ConstantExpr>(e->getKid(1));
+    if (!CE || CE->getZExtValue() >= width)
+      return full(width);
+    unsigned shift = CE->getZExtValue();
+    Interval k = evaluate(e->getKid(0));
+    if (k.max > (mask >> shift))
+      return full(width);
+    return {k.min << shift, k.max << shift};
+  }
+
+  case Expr::LShr: {
+    Interval k = evaluate(e->getKid(0));
+    const ConstantExpr *CE = dyn_cast<ConstantExpr>(e->getKid(1));
+    if (!CE)
+      return {0, k.max};
+    if (CE->getZExtValue() >= width)
+      return full(width);
+    unsigned shift = CE->getZExtValue();
+    return {k.min >> shift, k.max >> shift};
+  }
+
+  case Expr::AShr: {
+    Interval k = evaluate(e->getKid(0));
+    const ConstantExpr *CE = dyn_cast<ConstantExpr>(e->getKid(1));
+    if (!CE || CE->getZExtValue() >= width ||
+        k.max > bits64::maxValueOfNBits(width - 1))
+      return full(width);
+    unsigned shift = CE->getZExtValue();
+    return {k.min >> shift, k.max >> shift};
+  }
+
+  default:
+    return full(width);
+  }
+}
@@ -0,0 +1,555 @@
+//===-- QueryLog.cpp ------------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The log starts with a magic string and a format version, followed by a
+// sequence of records. Each record starts with a tag byte: tags below
+// TagArray are expression kinds and define the next expression; the others
+// define an array or an update node, clear all definitions, or describe a
+// query. Numbers are LEB128 varints. Expressions refer to earlier ones by the
+// distance back from the next expression to be defined, which keeps
+// references small.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr/QueryLog.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/ExprBuilder.h"
+
+#include <cassert>
+#include <cstring>
+
+using namespace klee;
+
+namespace {
+const char Magic[] = {'K', 'Q', 'L', 'O', 'G'};
+const uint64_t Version = 1;
+
+enum Tag : uint8_t {
+  TagArray = 0x40,
+  TagUpdate,
+  TagReset,
+  TagQuery,
+};
+static_assert(Expr::LastKind < TagArray, "expression kinds overlap tags");
+} // namespace
+
+/***/
+
+QueryLogWriter::QueryLogWriter(std::string &out, unsigned maxTableSize)
+    : out(out), maxTableSize(maxTableSize) {
+  out.append(Magic, sizeof(Magic));
+  writeVarint(Version);
+}
+
+void QueryLogWriter::writeVarint(uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void QueryLogWriter::writeExprRef(const ref<Expr> &e) {
+  auto it = exprIds.find(e);
+  assert(it != exprIds.end() && "expression not defined");
+  writeVarint(exprIds.size() - it->second);
+}
+
+void QueryLogWriter::writeConstant(const ConstantExpr &ce) {
+  const llvm::APInt &value = ce.getAPValue();
+  writeVarint(ce.getWidth());
+  if (ce.getWidth() <= 64) {
+    writeVarint(value.getZExtValue());
+    return;
+  }
+  for (unsigned i = 0; i != value.getNumWords(); ++i)
+    writeVarint(value.getRawData()[i]);
+}
+
+void QueryLogWriter::define(const Array *array) {
+  if (arrayIds.count(array))
+    return;
+  out.push_back(TagArray);
+  writeVarint(array->name.size());
+  out.append(array->name);
+  writeVarint(array->size);
+  writeVarint(array->domain);
+  writeVarint(array->range);
+  writeVarint(array->constantValues.size());
+  for (const ref<ConstantExpr> &ce : array->constantValues)
+    writeConstant(*ce);
+  arrayIds.emplace(array, arrayIds.size());
+}
+
+void QueryLogWriter::define(const UpdateList &ul) {
+  define(ul.root);
+
+  // Update lists can be very long, so walk them iteratively, oldest first.
+  std::vector<ref<UpdateNode>> pending;
+  for (ref<UpdateNode> un = ul.head; un && !updateIds.count(un.get());
+       un = un->next)
+    pending.push_back(un);
+
+  for (auto it = pending.rbegin(), ie = pending.rend(); it != ie; ++it) {
+    const ref<UpdateNode> &un = *it;
+    define(un->index);
+    define(un->value);
+    out.push_back(TagUpdate);
+    writeVarint(un->next ? updateIds.size() - updateIds[un->next.get()] : 0);
+    writeExprRef(un->index);
+    writeExprRef(un->value);
+    updateIds.emplace(un.get(), updateIds.size());
+    updates.push_back(un);
+  }
+}
+
+void QueryLogWriter::define(const ref<Expr> &e) {
+  if (exprIds.count(e))
+    return;
+
+  const ReadExpr *re = dyn_cast<ReadExpr>(e);
+  if (re)
+    define(re->updates);
+  for (unsigned i = 0; i != e->getNumKids(); ++i)
+    define(e->getKid(i));
+
+  out.push_back(static_cast<char>(e->getKind()));
+  switch (e->getKind()) {
+  case Expr::Constant:
+    writeConstant(*cast<ConstantExpr>(e));
+    break;
+  case Expr::Read: {
+    writeVarint(arrayIds[re->updates.root]);
+    const UpdateNode *head = re->updates.head.get();
+    writeVarint(head ? updateIds.size() - updateIds[head] : 0);
+    writeExprRef(re->index);
+    break;
+  }
+  case Expr::Extract:
+    writeVarint(cast<ExtractExpr>(e)->offset);
+    writeVarint(e->getWidth());
+    writeExprRef(e->getKid(0));
+    break;
+  case Expr::ZExt:
+  case Expr::SExt:
+    writeVarint(e->getWidth());
+    writeExprRef(e->getKid(0));
+    break;
+  default:
+    for (unsigned i = 0; i != e->getNumKids(); ++i)
+      writeExprRef(e->getKid(i));
+    break;
+  }
+  exprIds.emplace(e, exprIds.size());
+}
+
+void QueryLogWriter::write(const LoggedQuery &query) {
+  if (exprIds.size() > maxTableSize) {
+    out.push_back(TagReset);
+    exprIds.clear();
+    updateIds.clear();
+    updates.clear();
+    arrayIds.clear();
+  }
+
+  for (const ref<Expr> &constraint : query.constraints)
+    define(constraint);
+  define(query.expr);
+  for (const Array *array : query.objects)
+    define(array);
+  bool hasValue = query.success && query.kind == LoggedQuery::Value;
+  if (hasValue)
+    define(query.value);
+
+  out.push_back(TagQuery);
+  out.push_back(query.kind);
+  writeVarint(query.constraints.size());
+  for (const ref<Expr> &constraint : query.constraints)
+    writeExprRef(constraint);
+  writeExprRef(query.expr);
+  if (query.kind == LoggedQuery::InitialValues) {
+    writeVarint(query.objects.size());
+    for (const Array *array : query.objects)
+      writeVarint(arrayIds[array]);
+  }
+
+  out.push_back(query.success);
+  writeVarint(query.status);
+  if (query.success) {
+    switch (query.kind) {
+    case LoggedQuery::Truth:
+      out.push_back(query.isValid);
+      break;
+    case LoggedQuery::Validity:
+      out.push_back(static_cast<char>(query.validity + 1));
+      break;
+    case LoggedQuery::Value:
+      writeExprRef(query.value);
+      break;
+    case LoggedQuery::InitialValues:
+      out.push_back(query.hasSolution);
+      if (query.hasSolution) {
+        for (const auto &values : query.values)
+          out.append(values.begin(), values.end());
+      }
+      break;
+    }
+  }
+  writeVarint(query.instructions);
+  writeVarint(query.elapsedMicroseconds);
+}
+
+/***/
+
+QueryLogReader::QueryLogReader(ReadFn read, ExprBuilder *builder,
+                               ArrayCache &arrayCache)
+    : read(std::move(read)), builder(builder), arrayCache(arrayCache),
+      buffer(64 * 1024) {}
+
+bool QueryLogReader::hasMagic(const char *data, size_t size) {
+  return size >= sizeof(Magic) && !memcmp(data, Magic, sizeof(Magic));
+}
+
+bool QueryLogReader::fail(const std::string &message) {
+  if (error.empty())
+    error = message;
+  return false;
+}
+
+bool QueryLogReader::fill() {
+  long n = read(buffer.data(), buffer.size());
+  if (n < 0)
+    return fail("read error");
+  pos = 0;
+  end = n;
+  return n > 0;
+}
+
+bool QueryLogReader::readByte(uint8_t &byte) {
+  if (pos == end && !fill())
+    return fail("unexpected end of query log");
+  byte = buffer[pos++];
+  return true;
+}
+
+bool QueryLogReader::readVarint(uint64_t &value) {
+  value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    uint8_t byte;
+    if (!readByte(byte))
+      return false;
+    value |= uint64_t(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return fail("malformed number");
+}
+
+bool QueryLogReader::readBytes(void *dst, size_t size) {
+  char *p = static_cast<char *>(dst);
+  while (size) {
+    if (pos == end && !fill())
+      return fail("unexpected end of query log");
+    size_t n = std::min(size, end - pos);
+    memcpy(p, &buffer[pos], n);
+    pos += n;
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+bool QueryLogReader::readExprRef(ref<Expr> &e) {
+  uint64_t distance;
+  if (!readVarint(distance))
+    return false;
+  if (distance == 0 || distance > exprs.size())
+    return fail("invalid expression reference");
+  e = exprs[exprs.size() - distance];
+  return true;
+}
+
+bool QueryLogReader::readArrayRef(const Array *&array) {
+  uint64_t id;
+  if (!readVarint(id))
+    return false;
+  if (id >= arrays.size())
+    return fail("invalid array reference");
+  array = arrays[id];
+  return true;
+}
+
+bool QueryLogReader::readConstant(ref<Expr> &e) {
+  uint64_t width;
+  if (!readVarint(width))
+    return false;
+  if (width == 0 || width > 1u << 20)
+    return fail("invalid constant width");
+  if (width <= 64) {
+    uint64_t value;
+    if (!readVarint(value))
+      return false;
+    e = ConstantExpr::alloc(llvm::APInt(width, value));
+    return true;
+  }
+  std::vector<uint64_t> words((width + 63) / 64);
+  for (uint64_t &word : words)
+    if (!readVarint(word))
+      return false;
+  e = ConstantExpr::alloc(llvm::APInt(width, words));
+  return true;
+}
+
+bool QueryLogReader::readArray() {
+  uint64_t nameLength, size, domain, range, numValues;
+  if (!readVarint(nameLength))
+    return false;
+  std::string name(nameLength, '\0');
+  if (!readBytes(&name[0], nameLength) || !readVarint(size) ||
+      !readVarint(domain) || !readVarint(range) || !readVarint(numValues))
+    return false;
+  if (numValues && numValues != size)
+    return fail("invalid constant array");
+
+  std::vector<ref<ConstantExpr>> values;
+  values.reserve(numValues);
+  for (uint64_t i = 0; i != numValues; ++i) {
+    ref<Expr> value;
+    if (!readConstant(value))
+      return false;
+    values.push_back(cast<ConstantExpr>(value));
+  }
+  arrays.push_back(arrayCache.CreateArray(
+      name, size, values.data(), values.data() + values.size(), domain,
+      range));
+  return true;
+}
+
+bool QueryLogReader::readUpdate() {
+  uint64_t next;
+  ref<Expr> index, value;
+  if (!readVarint(next) || !readExprRef(index) || !readExprRef(value))
+    return false;
+  if (next > updates.size())
+    return fail("invalid update reference");
+  ref<UpdateNode> nextNode;
+  if (next)
+    nextNode = updates[updates.size() - next];
+  updates.push_back(ref<UpdateNode>(new UpdateNode(nextNode, index, value)));
+  return true;
+}
+
+bool QueryLogReader::readExpr(unsigned kind) {
+  ref<Expr> e, kids[3];
+  uint64_t width, offset;
+
+  switch (kind) {
+  case Expr::Constant:
+    if (!readConstant(e))
+      return false;
+    e = builder->Constant(cast<ConstantExpr>(e)->getAPValue());
+    break;
+
+  case Expr::NotOptimized:
+    if (!readExprRef(kids[0]))
+      return false;
+    e = builder->NotOptimized(kids[0]);
+    break;
+
+  case Expr::Read: {
+    const Array *array;
+    uint64_t head;
+    if (!readArrayRef(array) || !readVarint(head) || !readExprRef(kids[0]))
+      return false;
+    if (head > updates.size())
+      return fail("invalid update reference");
+    UpdateList ul(array, head ? updates[updates.size() - head]
+                              : ref<UpdateNode>());
+    e = builder->Read(ul, kids[0]);
+    break;
+  }
+
+  case Expr::Select:
+    if (!readExprRef(kids[0]) || !readExprRef(kids[1]) ||
+        !readExprRef(kids[2]))
+      return false;
+    e = builder->Select(kids[0], kids[1], kids[2]);
+    break;
+
+  case Expr::Extract:
+    if (!readVarint(offset) || !readVarint(width) || !readExprRef(kids[0]))
+      return false;
+    e = builder->Extract(kids[0], offset, width);
+    break;
+
+  case Expr::ZExt:
+  case Expr::SExt:
+    if (!readVarint(width) || !readExprRef(kids[0]))
+      return false;
+    e = kind == Expr::ZExt ? builder->ZExt(kids[0], width)
+                           : builder->SExt(kids[0], width);
+    break;
+
+  case Expr::Not:
+    if (!readExprRef(kids[0]))
+      return false;
+    e = builder->Not(kids[0]);
+    break;
+
+  default:
+    if (kind < Expr::Concat || kind > Expr::LastKind)
+      return fail("invalid expression kind");
+    if (!readExprRef(kids[0]) || !readExprRef(kids[1]))
+      return false;
+    switch (kind) {
+#define BINARY_CASE(K)                                                         \
+  case Expr::K:                                                                \
+    e = builder->K(kids[0], kids[1]);                                          \
+    break;
+      BINARY_CASE(Concat)
+      BINARY_CASE(Add)
+      BINARY_CASE(Sub)
+      BINARY_CASE(Mul)
+      BINARY_CASE(UDiv)
+      BINARY_CASE(SDiv)
+      BINARY_CASE(URem)
+      BINARY_CASE(SRem)
+      BINARY_CASE(And)
+      BINARY_CASE(Or)
+      BINARY_CASE(Xor)
+      BINARY_CASE(Shl)
+      BINARY_CASE(LShr)
+      BINARY_CASE(AShr)
+      BINARY_CASE(Eq)
+      BINARY_CASE(Ne)
+      BINARY_CASE(Ult)
+      BINARY_CASE(Ule)
+      BINARY_CASE(Ugt)
+      BINARY_CASE(Uge)
+      BINARY_CASE(Slt)
+      BINARY_CASE(Sle)
+      BINARY_CASE(Sgt)
+      BINARY_CASE(Sge)
+#undef BINARY_CASE
+    default:
+      return fail("invalid expression kind");
+    }
+    break;
+  }
+
+  exprs.push_back(e);
+  return true;
+}
+
+bool QueryLogReader::readQuery(LoggedQuery &query) {
+  uint8_t kind, flag;
+  uint64_t count;
+  if (!readByte(kind) || !readVarint(count))
+    return false;
+  if (kind > LoggedQuery::InitialValues)
+    return fail("invalid query kind");
+
+  query = LoggedQuery();
+  query.kind = static_cast<LoggedQuery::Kind>(kind);
+  query.constraints.resize(count);
+  for (ref<Expr> &constraint : query.constraints)
+    if (!readExprRef(constraint))
+      return false;
+  if (!readExprRef(query.expr))
+    return false;
+  if (query.kind == LoggedQuery::InitialValues) {
+    if (!readVarint(count))
+      return false;
+    query.objects.resize(count);
+    for (const Array *&array : query.objects)
+      if (!readArrayRef(array))
+        return false;
+  }
+
+  uint64_t status;
+  if (!readByte(flag) || !readVarint(status))
+    return false;
+  query.success = flag;
+  query.status = status;
+  if (query.success) {
+    switch (query.kind) {
+    case LoggedQuery::Truth:
+      if (!readByte(flag))
+        return false;
+      query.isValid = flag;
+      break;
+    case LoggedQuery::Validity:
+      if (!readByte(flag))
+        return false;
+      query.validity = int(flag) - 1;
+      break;
+    case LoggedQuery::Value:
+      if (!readExprRef(query.value))
+        return false;
+      break;
+    case LoggedQuery::InitialValues:
+      if (!readByte(flag))
+        return false;
+      query.hasSolution = flag;
+      if (query.hasSolution) {
+        for (const Array *array : query.objects) {
+          query.values.emplace_back(array->size);
+          if (!readBytes(query.values.back().data(), array->size))
+            return false;
+        }
+      }
+      break;
+    }
+  }
+  return readVarint(query.instructions) &&
+         readVarint(query.elapsedMicroseconds);
+}
+
+bool QueryLogReader::readHeader() {
+  char magic[sizeof(Magic)];
+  uint64_t version;
+  if (!readBytes(magic, sizeof(magic)) || !hasMagic(magic, sizeof(magic)))
+    return fail("not a binary query log");
+  if (!readVarint(version))
+    return false;
+  if (version != Version)
+    return fail("unsupported query log version " + std::to_string(version));
+  return true;
+}
+
+bool QueryLogReader::next(LoggedQuery &query) {
+  while (true) {
+    if (pos == end && !fill())
+      return false; // end of the log, or a read error
+    uint8_t tag = buffer[pos++];
+    bool ok;
+    switch (tag) {
+    case TagArray:
+      ok = readArray();
+      break;
+    case TagUpdate:
+      ok = readUpdate();
+      break;
+    case TagReset:
+      exprs.clear();
+      updates.clear();
+      arrays.clear();
+      ok = true;
+      break;
+    case TagQuery:
+      return readQuery(query);
+    default:
+      ok = readExpr(tag);
+      break;
+    }
+    if (!ok)
+      return false;
+  }
+}
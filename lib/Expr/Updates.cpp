@@ -13,6 +13,11 @@
 
 using namespace klee;
 
+namespace {
+/// Shorter runs of concrete writes are cheaper to scan than to index.
+constexpr unsigned ConcreteIndexThreshold = 16;
+} // namespace
+
 ///
 
 UpdateNode::UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
@@ -26,6 +31,42 @@ UpdateNode::UpdateNode(const ref<UpdateNode> &_next, const ref<Expr> &_index,
   */
   computeHash();
   size = next ? next->size + 1 : 1;
+
+  ConstantExpr *CE = dyn_cast<ConstantExpr>(index);
+  if (!CE || CE->getWidth() > 64) {
+    lastSymbolic = this;
+    concreteWrites = 0;
+    return;
+  }
+
+  lastSymbolic = next ? next->lastSymbolic : nullptr;
+  concreteWrites = next ? next->concreteWrites + 1 : 1;
+  if (concreteWrites < ConcreteIndexThreshold)
+    return;
+
+  if (!next->concreteIndex.empty()) {
+    concreteIndex = next->concreteIndex.replace({CE->getZExtValue(), this});
+    return;
+  }
+
+  // Index the whole run of concrete writes, keeping the most recent write to
+  // each index.
+  for (UpdateNode *un = this; un != lastSymbolic; un = un->next.get())
+    concreteIndex = concreteIndex.insert(
+        {cast<ConstantExpr>(un->index)->getZExtValue(), un});
+}
+
+UpdateNode *UpdateNode::findWrite(uint64_t index) {
+  if (!concreteIndex.empty()) {
+    if (auto *write = concreteIndex.lookup(index))
+      return write->second;
+    return lastSymbolic;
+  }
+
+  for (UpdateNode *un = this; un != lastSymbolic; un = un->next.get())
+    if (cast<ConstantExpr>(un->index)->getZExtValue() == index)
+      return un;
+  return lastSymbolic;
 }
 
 int UpdateNode::compare(const UpdateNode &b) const {
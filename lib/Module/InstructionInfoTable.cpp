@@ -27,114 +27,130 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 DISABLE_WARNING_POP
 
+#include <algorithm>
 #include <cstdint>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 using namespace klee;
 
-class InstructionToLineAnnotator : public llvm::AssemblyAnnotationWriter {
+namespace {
+/// Records the assembly line each function and instruction is printed at.
+class AssemblyLineRecorder : public llvm::AssemblyAnnotationWriter {
+  std::vector<uint64_t> &functionLines;
+  std::vector<std::vector<unsigned>> &instructionLines;
+
 public:
-  void emitInstructionAnnot(const llvm::Instruction *i,
-                            llvm::formatted_raw_ostream &os) {
-    os << "%%%";
-    os << reinterpret_cast<std::uintptr_t>(i);
+  AssemblyLineRecorder(std::vector<uint64_t> &functionLines,
+                       std::vector<std::vector<unsigned>> &instructionLines)
+      : functionLines(functionLines), instructionLines(instructionLines) {}
+
+  void emitInstructionAnnot(const llvm::Instruction *,
+                            llvm::formatted_raw_ostream &os) override {
+    instructionLines.back().push_back(os.getLine() + 1);
   }
 
-  void emitFunctionAnnot(const llvm::Function *f,
-                         llvm::formatted_raw_ostream &os) {
-    os << "%%%";
-    os << reinterpret_cast<std::uintptr_t>(f);
+  void emitFunctionAnnot(const llvm::Function *,
+                         llvm::formatted_raw_ostream &os) override {
+    functionLines.push_back(os.getLine() + 1);
+    instructionLines.emplace_back();
   }
 };
+} // namespace
 
-static std::map<uintptr_t, uint64_t>
-buildInstructionToLineMap(const llvm::Module &m) {
-
-  std::map<uintptr_t, uint64_t> mapping;
-  InstructionToLineAnnotator a;
-  std::string str;
-
-  llvm::raw_string_ostream os(str);
-  m.print(os, &a);
-  os.flush();
-
-  const char *s;
-
-  unsigned line = 1;
-  for (s=str.c_str(); *s; s++) {
-    if (*s != '\n')
-      continue;
-
-    line++;
-    if (s[1] != '%' || s[2] != '%' || s[3] != '%')
-      continue;
-
-    s += 4;
-    char *end;
-    uint64_t value = strtoull(s, &end, 10);
-    if (end != s) {
-      mapping.insert(std::make_pair(value, line));
-    }
-    s = end;
+InstructionInfoTable::InstructionInfoTable(
+    const llvm::Module &m, std::unique_ptr<llvm::raw_ostream> assembly,
+    bool lazyAssemblyLines)
+    : module(&m), assembly(std::move(assembly)) {
+  entries.reserve(m.size());
+  for (const auto &Func : m) {
+    entryOf[&Func] = entries.size();
+    entries.emplace_back(&Func);
+    entries.back().numInstructions = Func.getInstructionCount();
   }
-
-  return mapping;
+  assignIDs();
+  if (!lazyAssemblyLines)
+    computeAssemblyLines();
 }
 
-class DebugInfoExtractor {
-  std::vector<std::unique_ptr<std::string>> &internedStrings;
-  std::map<uintptr_t, uint64_t> lineTable;
-
-  const llvm::Module &module;
+InstructionInfoTable::~InstructionInfoTable() {
+  // The assembly file is complete even if no line was ever asked for
+  if (assembly)
+    computeAssemblyLines();
+}
 
-public:
-  DebugInfoExtractor(
-      std::vector<std::unique_ptr<std::string>> &_internedStrings,
-      const llvm::Module &_module)
-      : internedStrings(_internedStrings), module(_module) {
-    lineTable = buildInstructionToLineMap(module);
+void InstructionInfoTable::computeAssemblyLines() const {
+  if (hasAssemblyLines)
+    return;
+
+  // Functions and instructions are printed in module order
+  std::vector<uint64_t> functionLines;
+  std::vector<std::vector<unsigned>> instructionLines;
+  AssemblyLineRecorder recorder(functionLines, instructionLines);
+  llvm::raw_null_ostream null;
+  module->print(assembly ? *assembly : null, &recorder);
+  assembly.reset();
+
+  for (unsigned index = 0; index < entries.size(); ++index) {
+    entries[index].assemblyLine = functionLines.at(index);
+    entries[index].instructionLines = std::move(instructionLines.at(index));
   }
+  hasAssemblyLines = true;
+}
 
-  std::string &getInternedString(const std::string &s) {
-    auto found = std::find_if(internedStrings.begin(), internedStrings.end(),
-                              [&s](const std::unique_ptr<std::string> &item) {
-                                return *item.get() == s;
-                              });
-    if (found != internedStrings.end())
-      return *found->get();
-
-    auto newItem = std::unique_ptr<std::string>(new std::string(s));
-    auto result = newItem.get();
-
-    internedStrings.emplace_back(std::move(newItem));
-    return *result;
+void InstructionInfoTable::assignIDs() {
+  // Instructions are numbered in module order, followed by the functions
+  unsigned idCounter = 0;
+  for (auto &entry : entries) {
+    entry.firstID = idCounter;
+    idCounter += entry.numInstructions;
   }
+}
 
-  std::unique_ptr<FunctionInfo> getFunctionInfo(const llvm::Function &Func) {
-    auto asmLine = lineTable.at(reinterpret_cast<std::uintptr_t>(&Func));
-    auto dsub = Func.getSubprogram();
+const std::string &
+InstructionInfoTable::getInternedString(const std::string &s) const {
+  std::lock_guard<std::mutex> lock(internLock);
+  auto found = internedIndex.find(s);
+  if (found != internedIndex.end())
+    return *found->second;
 
-    if (dsub != nullptr) {
-      auto path = dsub->getFilename();
-      return std::make_unique<FunctionInfo>(FunctionInfo(
-          0, getInternedString(path.str()), dsub->getLine(), asmLine));
-    }
+  internedStrings.emplace_back(new std::string(s));
+  internedIndex[s] = internedStrings.back().get();
+  return *internedStrings.back();
+}
+
+void InstructionInfoTable::resolve(FunctionEntry &entry) const {
+  const llvm::Function &Func = *entry.function;
+  const unsigned functionID = getMaxID() - entries.size() + entryOf.at(&Func);
 
+  if (auto dsub = Func.getSubprogram()) {
+    entry.info = std::make_unique<FunctionInfo>(
+        functionID, getInternedString(dsub->getFilename().str()),
+        dsub->getLine(), *this);
+  } else {
     // Fallback: Mark as unknown
-    return std::make_unique<FunctionInfo>(
-        FunctionInfo(0, getInternedString(""), 0, asmLine));
+    entry.info = std::make_unique<FunctionInfo>(
+        functionID, getInternedString(""), 0, *this);
   }
 
-  std::unique_ptr<InstructionInfo>
-  getInstructionInfo(const llvm::Instruction &Inst, const FunctionInfo *f) {
-    auto asmLine = lineTable.at(reinterpret_cast<std::uintptr_t>(&Inst));
+  // Consecutive instructions mostly come from the same file
+  llvm::StringRef lastPath;
+  const std::string *lastFile = nullptr;
+
+  entry.infos.reserve(entry.numInstructions);
+  unsigned i = 0;
+  for (auto it = llvm::inst_begin(Func), ie = llvm::inst_end(Func); it != ie;
+       ++it, ++i) {
+    const unsigned id = entry.firstID + i;
 
     // Retrieve debug information associated with instruction
-    auto dl = Inst.getDebugLoc();
+    auto dl = it->getDebugLoc();
 
     // Check if a valid debug location is assigned to the instruction.
     if (dl.get() != nullptr) {
@@ -151,62 +167,236 @@ public:
           column = LexicalBlock->getColumn();
         }
       }
-      return std::make_unique<InstructionInfo>(InstructionInfo(
-          0, getInternedString(full_path.str()), line, column, asmLine));
+      if (!lastFile || full_path != lastPath) {
+        lastPath = full_path;
+        lastFile = &getInternedString(full_path.str());
+      }
+      entry.infos.emplace_back(id, *lastFile, line, column, *this);
+      continue;
     }
 
-    if (f != nullptr)
-      // If nothing found, use the surrounding function
-      return std::make_unique<InstructionInfo>(
-          InstructionInfo(0, f->file, f->line, 0, asmLine));
     // If nothing found, use the surrounding function
-    return std::make_unique<InstructionInfo>(
-        InstructionInfo(0, getInternedString(""), 0, 0, asmLine));
+    entry.infos.emplace_back(id, entry.info->file, entry.info->line, 0,
+                             *this);
   }
-};
+  entry.resolved = true;
+}
+
+void InstructionInfoTable::addInfos(FunctionEntry &entry) const {
+  unsigned i = 0;
+  for (auto it = llvm::inst_begin(*entry.function),
+            ie = llvm::inst_end(*entry.function);
+       it != ie; ++it)
+    infos[&*it] = &entry.infos[i++];
+}
+
+InstructionInfoTable::FunctionEntry &
+InstructionInfoTable::getEntry(const llvm::Function &f) const {
+  auto found = entryOf.find(&f);
+  if (found == entryOf.end())
+    llvm::report_fatal_error("invalid instruction, not present in "
+                             "initial module!");
+  FunctionEntry &entry = entries[found->second];
+  if (!entry.resolved) {
+    resolve(entry);
+    addInfos(entry);
+  }
+  return entry;
+}
+
+void InstructionInfoTable::resolveAll(unsigned threads) {
+  {
+    // Functions are independent; only interning strings is shared
+    llvm::ThreadPool pool(llvm::hardware_concurrency(threads));
+    for (auto &entry : entries)
+      if (!entry.resolved)
+        pool.async([this, &entry] { resolve(entry); });
+    pool.wait();
+  }
+  for (auto &entry : entries)
+    addInfos(entry);
+}
 
-InstructionInfoTable::InstructionInfoTable(const llvm::Module &m) {
-  // Generate all debug instruction information
-  DebugInfoExtractor DI(internedStrings, m);
+// The serialized table starts with the interned file names, one per line,
+// followed by one line per function and one per instruction in module order:
+//   F <file> <line> <assembly line> <number of instructions>
+//   <file> <line> <column> <assembly line>
+// where <file> is an index into the file names.
+static const char *const infoTableMagic = "KLEE-INFO-TABLE 1";
+
+std::unique_ptr<InstructionInfoTable>
+InstructionInfoTable::read(const llvm::Module &m, std::istream &is) {
+  std::string line;
+  size_t numStrings;
+  if (!std::getline(is, line) || line != infoTableMagic ||
+      !(is >> numStrings) || !std::getline(is, line))
+    return nullptr;
+
+  std::unique_ptr<InstructionInfoTable> table(new InstructionInfoTable());
+  table->module = &m;
+  table->hasAssemblyLines = true;
+  std::vector<const std::string *> strings;
+  for (size_t i = 0; i < numStrings; ++i) {
+    if (!std::getline(is, line))
+      return nullptr;
+    strings.push_back(&table->getInternedString(line));
+  }
+
+  struct Location {
+    size_t file;
+    unsigned line, column;
+  };
+  std::vector<Location> functionLocations;
+  std::vector<std::vector<Location>> instructionLocations;
+  table->entries.reserve(m.size());
   for (const auto &Func : m) {
-    auto F = DI.getFunctionInfo(Func);
-    auto FR = F.get();
-    functionInfos.insert(std::make_pair(&Func, std::move(F)));
-
-    for (auto it = llvm::inst_begin(Func), ie = llvm::inst_end(Func); it != ie;
-         ++it) {
-      auto instr = &*it;
-      infos.insert(std::make_pair(instr, DI.getInstructionInfo(*instr, FR)));
+    std::string tag;
+    Location loc;
+    uint64_t asmLine;
+    size_t numInstructions;
+    if (!(is >> tag >> loc.file >> loc.line >> asmLine >> numInstructions) ||
+        tag != "F" || loc.file >= numStrings ||
+        numInstructions != static_cast<size_t>(std::distance(
+                               llvm::inst_begin(Func), llvm::inst_end(Func))))
+      return nullptr;
+    table->entryOf[&Func] = table->entries.size();
+    table->entries.emplace_back(&Func);
+    FunctionEntry &entry = table->entries.back();
+    entry.numInstructions = numInstructions;
+    entry.assemblyLine = asmLine;
+    functionLocations.push_back(loc);
+
+    instructionLocations.emplace_back();
+    for (size_t i = 0; i < numInstructions; ++i) {
+      unsigned iasmLine;
+      loc.column = 0;
+      if (!(is >> loc.file >> loc.line >> loc.column >> iasmLine) ||
+          loc.file >= numStrings)
+        return nullptr;
+      entry.instructionLines.push_back(iasmLine);
+      instructionLocations.back().push_back(loc);
     }
   }
 
-  // Make sure that every item has a unique ID
-  size_t idCounter = 0;
-  for (auto &item : infos)
-    item.second->id = idCounter++;
-  for (auto &item : functionInfos)
-    item.second->id = idCounter++;
+  std::string rest;
+  if (is >> rest)
+    return nullptr;
+
+  table->assignIDs();
+  const unsigned firstFunctionID = table->getMaxID() - table->entries.size();
+  for (unsigned f = 0; f < table->entries.size(); ++f) {
+    FunctionEntry &entry = table->entries[f];
+    const Location &loc = functionLocations[f];
+    entry.info = std::make_unique<FunctionInfo>(
+        firstFunctionID + f, *strings[loc.file], loc.line, *table);
+    entry.infos.reserve(entry.numInstructions);
+    for (unsigned i = 0; i < entry.numInstructions; ++i) {
+      const Location &iloc = instructionLocations[f][i];
+      entry.infos.emplace_back(entry.firstID + i, *strings[iloc.file],
+                               iloc.line, iloc.column, *table);
+    }
+    entry.resolved = true;
+    table->addInfos(entry);
+  }
+  return table;
+}
+
+void InstructionInfoTable::write(const llvm::Module &m,
+                                 llvm::raw_ostream &os) const {
+  // Resolving may intern further file names, so it has to come first
+  for (const auto &Func : m)
+    getEntry(Func);
+  computeAssemblyLines();
+
+  std::unordered_map<const std::string *, size_t> index;
+  os << infoTableMagic << "\n" << internedStrings.size() << "\n";
+  for (size_t i = 0; i < internedStrings.size(); ++i) {
+    index[internedStrings[i].get()] = i;
+    os << *internedStrings[i] << "\n";
+  }
+
+  for (const auto &Func : m) {
+    const FunctionEntry &entry = getEntry(Func);
+    os << "F " << index.at(&entry.info->file) << " " << entry.info->line
+       << " " << entry.assemblyLine << " " << entry.infos.size() << "\n";
+    for (unsigned i = 0; i < entry.infos.size(); ++i) {
+      const InstructionInfo &ii = entry.infos[i];
+      os << index.at(&ii.file) << " " << ii.line << " " << ii.column << " "
+         << entry.instructionLines[i] << "\n";
+    }
+  }
 }
 
 unsigned InstructionInfoTable::getMaxID() const {
-  return infos.size() + functionInfos.size();
+  if (entries.empty())
+    return 0;
+  const FunctionEntry &last = entries.back();
+  return last.firstID + last.numInstructions + entries.size();
 }
 
 const InstructionInfo &
 InstructionInfoTable::getInfo(const llvm::Instruction &inst) const {
   auto it = infos.find(&inst);
+  if (it != infos.end())
+    return *it->second;
+
+  getEntry(*inst.getFunction());
+  it = infos.find(&inst);
   if (it == infos.end())
     llvm::report_fatal_error("invalid instruction, not present in "
                              "initial module!");
-  return *it->second.get();
+  return *it->second;
+}
+
+unsigned InstructionInfoTable::getFirstID(const llvm::Function &f) const {
+  auto found = entryOf.find(&f);
+  if (found == entryOf.end())
+    llvm::report_fatal_error("invalid function, not present in "
+                             "initial module!");
+  return entries[found->second].firstID;
+}
+
+InstructionInfoTable::FunctionEntry &
+InstructionInfoTable::getEntry(unsigned id) const {
+  // Functions without instructions share the first ID of the next one
+  auto it = std::upper_bound(entries.begin(), entries.end(), id,
+                             [](unsigned id, const FunctionEntry &entry) {
+                               return id < entry.firstID;
+                             });
+  if (it == entries.begin())
+    llvm::report_fatal_error("invalid instruction id");
+  --it;
+  if (id - it->firstID >= it->numInstructions)
+    llvm::report_fatal_error("invalid instruction id");
+  return getEntry(*it->function);
+}
+
+const InstructionInfo &InstructionInfoTable::getInfo(unsigned id) const {
+  const FunctionEntry &entry = getEntry(id);
+  return entry.infos[id - entry.firstID];
 }
 
 const FunctionInfo &
 InstructionInfoTable::getFunctionInfo(const llvm::Function &f) const {
-  auto found = functionInfos.find(&f);
-  if (found == functionInfos.end())
-    llvm::report_fatal_error("invalid instruction, not present in "
-                             "initial module!");
+  return *getEntry(f).info;
+}
+
+unsigned
+InstructionInfoTable::getAssemblyLine(const InstructionInfo &ii) const {
+  computeAssemblyLines();
+  const FunctionEntry &entry = getEntry(ii.id);
+  return entry.instructionLines[ii.id - entry.firstID];
+}
+
+uint64_t InstructionInfoTable::getAssemblyLine(const FunctionInfo &fi) const {
+  computeAssemblyLines();
+  return entries[fi.id - (getMaxID() - entries.size())].assemblyLine;
+}
+
+unsigned InstructionInfo::getAssemblyLine() const {
+  return table.getAssemblyLine(*this);
+}
 
-  return *found->second.get();
+uint64_t FunctionInfo::getAssemblyLine() const {
+  return table.getAssemblyLine(*this);
 }
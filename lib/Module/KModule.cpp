@@ -30,8 +30,10 @@ DISABLE_WARNING_PUSH
 DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/Support/FileSystem.h"
 DISABLE_WARNING_POP
 
+#include <fstream>
 #include <sstream>
 
 using namespace llvm;
@@ -73,6 +75,19 @@ namespace {
                              cl::desc("Allow optimization of functions that "
                                       "contain KLEE calls (default=true)"),
                              cl::init(true), cl::cat(ModuleCat));
+cl::opt<bool> LazyManifest(
+    "lazy-manifest",
+    cl::desc("Prepare functions for execution and resolve their debug "
+             "information when they are first called, instead of for the "
+             "whole module at startup (default=false)"),
+    cl::init(false), cl::cat(ModuleCat));
+
+cl::opt<unsigned> ManifestThreads(
+    "manifest-threads",
+    cl::desc("Number of threads resolving debug information at startup, "
+             "0 for one per core (default=0)"),
+    cl::init(0), cl::cat(ModuleCat));
+
 cl::opt<SwitchImplType> SwitchType(
     "switch-type",
     cl::desc("Select the implementation of switch (default=internal)"),
@@ -196,27 +211,34 @@ void KModule::instrument(const Interpreter::ModuleOptions &opts) {
   klee::instrument(opts.CheckDivZero, opts.CheckOvershift, module.get());
 }
 
-void KModule::optimiseAndPrepare(
-    const Interpreter::ModuleOptions &opts,
-    llvm::ArrayRef<const char *> preservedFunctions) {
+void KModule::addInternalFunctions(const Interpreter::ModuleOptions &opts) {
   // Add internal functions which are not used to check if instructions
   // have been already visited
   if (opts.CheckDivZero)
     addInternalFunction("klee_div_zero_check");
   if (opts.CheckOvershift)
     addInternalFunction("klee_overshift_check");
+}
+
+void KModule::optimiseAndPrepare(
+    const Interpreter::ModuleOptions &opts,
+    llvm::ArrayRef<const char *> preservedFunctions) {
+  addInternalFunctions(opts);
 
   klee::optimiseAndPrepare(OptimiseKLEECall, opts.Optimize, SwitchType,
                            opts.EntryPoint, preservedFunctions, module.get());
 }
 
-void KModule::manifest(InterpreterHandler *ih, bool forceSourceOutput) {
-  if (OutputSource || forceSourceOutput) {
-    std::unique_ptr<llvm::raw_fd_ostream> os(ih->openOutputFile("assembly.ll"));
-    assert(os && !os->has_error() && "unable to open source output");
-    *os << *module;
-  }
+unsigned KModule::insertMergePoints(const std::set<std::string> &functions,
+                                    llvm::StringRef openName,
+                                    llvm::StringRef closeName,
+                                    unsigned maxBlocks, bool allowLoops) {
+  return klee::insertMergePoints(module.get(), functions, openName, closeName,
+                                 maxBlocks, allowLoops);
+}
 
+void KModule::manifest(InterpreterHandler *ih, bool forceSourceOutput,
+                       const std::string &cache) {
   if (OutputModule) {
     std::unique_ptr<llvm::raw_fd_ostream> f(ih->openOutputFile("final.bc"));
     llvm::WriteBitcodeToFile(*module, *f);
@@ -224,37 +246,42 @@ void KModule::manifest(InterpreterHandler *ih, bool forceSourceOutput) {
 
   /* Build shadow structures */
 
-  infos = std::unique_ptr<InstructionInfoTable>(
-      new InstructionInfoTable(*module.get()));
-
-  std::vector<Function *> declarations;
-
-  for (auto &Function : *module) {
-    if (Function.isDeclaration()) {
-      declarations.push_back(&Function);
-    }
-
-    auto kf = std::unique_ptr<KFunction>(new KFunction(&Function, this));
-
-    for (unsigned i=0; i<kf->numInstructions; ++i) {
-      KInstruction *ki = kf->instructions[i];
-      ki->info = &infos->getInfo(*ki->inst);
+  const bool writeSource = OutputSource || forceSourceOutput;
+  if (!cache.empty()) {
+    std::ifstream is(cache + ".info");
+    infos = InstructionInfoTable::read(*module, is);
+    if (!infos)
+      klee_warning("Ignoring corrupt module cache entry %s.info",
+                   cache.c_str());
+    else if (writeSource &&
+             sys::fs::copy_file(cache + ".ll",
+                                ih->getOutputFilename("assembly.ll")))
+      infos.reset();
+  }
+  if (!infos) {
+    // Finding assembly lines prints the module anyway, so assembly.ll is
+    // written in the same pass, which --lazy-manifest puts off until a line
+    // is first needed
+    std::unique_ptr<llvm::raw_fd_ostream> os;
+    if (writeSource) {
+      os = ih->openOutputFile("assembly.ll");
+      assert(os && !os->has_error() && "unable to open source output");
     }
+    infos = std::make_unique<InstructionInfoTable>(*module, std::move(os),
+                                                   LazyManifest);
+  }
 
-    functionMap.insert(std::make_pair(&Function, kf.get()));
-    functions.push_back(std::move(kf));
+  if (!LazyManifest) {
+    infos->resolveAll(ManifestThreads);
+    for (auto &Function : *module)
+      getKFunction(&Function);
   }
 
   /* Compute various interesting properties */
 
-  for (auto &kf : functions) {
-    if (functionEscapes(kf->function))
-      escapingFunctions.insert(kf->function);
-  }
-
-  for (auto &declaration : declarations) {
-    if (functionEscapes(declaration))
-      escapingFunctions.insert(declaration);
+  for (auto &Function : *module) {
+    if (functionEscapes(&Function))
+      escapingFunctions.insert(&Function);
   }
 
   if (DebugPrintEscapingFunctions && !escapingFunctions.empty()) {
@@ -268,6 +295,61 @@ void KModule::manifest(InterpreterHandler *ih, bool forceSourceOutput) {
   }
 }
 
+/// Write the file at \p path through \p write, such that concurrent
+/// readers either see the complete file or none at all.
+static bool writeCacheFile(const std::string &path,
+                           llvm::function_ref<void(raw_ostream &)> write) {
+  auto temp = sys::fs::TempFile::create(path + "-%%%%%%.tmp");
+  if (!temp) {
+    consumeError(temp.takeError());
+    return false;
+  }
+  bool failed;
+  {
+    raw_fd_ostream os(temp->FD, /*shouldClose=*/false);
+    write(os);
+    os.flush();
+    failed = os.has_error();
+    os.clear_error();
+  }
+  if (failed) {
+    consumeError(temp->discard());
+    return false;
+  }
+  if (Error e = temp->keep(path)) {
+    consumeError(std::move(e));
+    return false;
+  }
+  return true;
+}
+
+bool KModule::writeCache(const std::string &cache) const {
+  // The bitcode goes last, as its presence marks a complete entry
+  return writeCacheFile(cache + ".ll",
+                        [this](raw_ostream &os) { os << *module; }) &&
+         writeCacheFile(cache + ".info",
+                        [this](raw_ostream &os) { infos->write(*module, os); }) &&
+         writeCacheFile(cache + ".bc", [this](raw_ostream &os) {
+           WriteBitcodeToFile(*module, os);
+         });
+}
+
+KFunction *KModule::getKFunction(llvm::Function *f) {
+  auto it = functionMap.find(f);
+  if (it != functionMap.end())
+    return it->second;
+
+  auto kf = std::make_unique<KFunction>(f, this);
+  for (unsigned i = 0; i < kf->numInstructions; ++i) {
+    KInstruction *ki = kf->instructions[i];
+    ki->info = &infos->getInfo(*ki->inst);
+  }
+
+  functionMap.insert(std::make_pair(f, kf.get()));
+  functions.push_back(std::move(kf));
+  return functions.back().get();
+}
+
 void KModule::checkModule() { klee::checkModule(DontVerify, module.get()); }
 
 KConstant* KModule::getKConstant(const Constant *c) {
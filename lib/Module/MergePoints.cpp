@@ -0,0 +1,161 @@
+//===-- MergePoints.cpp ---------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Finds regions in which states that forked can be merged again without any
+// help from the program under test. A region either starts at a block ending
+// in a conditional branch or switch and ends at the immediate post-dominator
+// of that block, or starts at the preheader of a loop and ends at its single
+// exit block. Calls to the given open and close functions are inserted at the
+// region boundaries, so the executor can treat them like user-placed
+// klee_open_merge/klee_close_merge pairs.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ModuleHelper.h"
+
+#include "klee/Support/CompilerWarning.h"
+DISABLE_WARNING_PUSH
+DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/Instructions.h"
+DISABLE_WARNING_POP
+
+#include <map>
+#include <set>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+/// Collect the blocks reachable from \p from without passing \p stop. Returns
+/// false if \p from itself is reachable or more than \p limit blocks are.
+bool collectRegion(BasicBlock *from, BasicBlock *stop, unsigned limit,
+                   std::set<BasicBlock *> &region) {
+  std::vector<BasicBlock *> worklist(succ_begin(from), succ_end(from));
+  while (!worklist.empty()) {
+    BasicBlock *bb = worklist.back();
+    worklist.pop_back();
+    if (bb == stop || !region.insert(bb).second)
+      continue;
+    if (bb == from || region.size() > limit)
+      return false;
+    worklist.insert(worklist.end(), succ_begin(bb), succ_end(bb));
+  }
+  return true;
+}
+
+/// Return true if the blocks in \p region contain a cycle.
+bool hasCycle(const std::set<BasicBlock *> &region) {
+  // Iterative DFS; a block on the current path that is reached again closes
+  // a cycle.
+  std::map<BasicBlock *, int> state; // 1 = on path, 2 = finished
+  for (BasicBlock *root : region) {
+    if (state[root])
+      continue;
+    std::vector<std::pair<BasicBlock *, succ_iterator>> stack;
+    stack.emplace_back(root, succ_begin(root));
+    state[root] = 1;
+    while (!stack.empty()) {
+      BasicBlock *bb = stack.back().first;
+      succ_iterator &it = stack.back().second;
+      if (it == succ_end(bb)) {
+        state[bb] = 2;
+        stack.pop_back();
+        continue;
+      }
+      BasicBlock *succ = *it++;
+      if (!region.count(succ))
+        continue;
+      if (state[succ] == 1)
+        return true;
+      if (!state[succ]) {
+        state[succ] = 1;
+        stack.emplace_back(succ, succ_begin(succ));
+      }
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+unsigned klee::insertMergePoints(llvm::Module *module,
+                                 const std::set<std::string> &functions,
+                                 llvm::StringRef openName,
+                                 llvm::StringRef closeName, unsigned maxBlocks,
+                                 bool allowLoops) {
+  LLVMContext &ctx = module->getContext();
+  FunctionType *ty = FunctionType::get(Type::getVoidTy(ctx), false);
+  FunctionCallee openFn = module->getOrInsertFunction(openName, ty);
+  FunctionCallee closeFn = module->getOrInsertFunction(closeName, ty);
+
+  unsigned regions = 0;
+  for (Function &f : *module) {
+    if (f.isDeclaration() || !functions.count(f.getName().str()))
+      continue;
+
+    DominatorTree dt(f);
+    PostDominatorTree pdt(f);
+    LoopInfo li(dt);
+
+    // For every region exit, the outermost block opening a region there.
+    // Regions sharing an exit are nested, and a single close call would not
+    // balance two opens, so only the outermost one is kept.
+    std::map<BasicBlock *, BasicBlock *> entryOf;
+    auto addRegion = [&](BasicBlock *entry, BasicBlock *exit) {
+      // Every path to the exit has to pass the open call exactly once ...
+      if (!exit || exit->isEHPad() || !dt.isReachableFromEntry(entry) ||
+          !dt.dominates(entry, exit))
+        return;
+      std::set<BasicBlock *> region;
+      if (!collectRegion(entry, exit, maxBlocks, region))
+        return;
+      if (!allowLoops && hasCycle(region))
+        return;
+      // ... and every path from the exit back to it has to open again first.
+      std::set<BasicBlock *> afterExit;
+      if (!collectRegion(exit, entry, ~0u, afterExit))
+        return;
+
+      auto res = entryOf.insert(std::make_pair(exit, entry));
+      if (!res.second && dt.getNode(entry)->getLevel() <
+                             dt.getNode(res.first->second)->getLevel())
+        res.first->second = entry;
+    };
+
+    for (BasicBlock &bb : f) {
+      Instruction *term = bb.getTerminator();
+      if (term->getNumSuccessors() < 2 ||
+          !(isa<BranchInst>(term) || isa<SwitchInst>(term)))
+        continue;
+      DomTreeNode *node = pdt.getNode(&bb);
+      if (node && node->getIDom())
+        addRegion(&bb, node->getIDom()->getBlock());
+    }
+
+    if (allowLoops) {
+      for (Loop *loop : li.getLoopsInPreorder()) {
+        BasicBlock *preheader = loop->getLoopPreheader();
+        if (preheader)
+          addRegion(preheader, loop->getExitBlock());
+      }
+    }
+
+    for (auto &region : entryOf) {
+      CallInst::Create(openFn, "", region.second->getTerminator());
+      CallInst::Create(closeFn, "", &*region.first->getFirstInsertionPt());
+      ++regions;
+    }
+  }
+  return regions;
+}
@@ -13,6 +13,9 @@
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/IR/Module.h"
 
+#include <set>
+#include <string>
+
 namespace klee {
 enum class SwitchImplType {
   eSwitchTypeSimple,
@@ -27,6 +30,16 @@ void optimiseAndPrepare(bool OptimiseKLEECall, bool Optimize,
 void checkModule(bool DontVerfify, llvm::Module *module);
 void instrument(bool CheckDivZero, bool CheckOvershift, llvm::Module *module);
 
+/// Insert calls to \p openName and \p closeName around single-entry,
+/// single-exit regions of at most \p maxBlocks blocks in the functions named
+/// in \p functions: from a branch to its immediate post-dominator and, if
+/// \p allowLoops is set, from a loop preheader to the loop exit. Returns the
+/// number of regions.
+unsigned insertMergePoints(llvm::Module *module,
+                           const std::set<std::string> &functions,
+                           llvm::StringRef openName, llvm::StringRef closeName,
+                           unsigned maxBlocks, bool allowLoops);
+
 void injectStaticConstructorsAndDestructors(llvm::Module *m,
                                             llvm::StringRef entryFunction);
 
@@ -9,6 +9,7 @@
 
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Assignment.h"
+#include "klee/Expr/CompiledExpr.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverImpl.h"
 
@@ -64,9 +65,18 @@ bool AssignmentValidatingSolver::computeInitialValues(
   // Use `_allowFreeValues` so that if we are missing an assignment
   // we can't compute a constant and flag this as a problem.
   Assignment assignment(objects, values, /*_allowFreeValues=*/true);
+  // Evaluate the constraints and the query expression together so that
+  // subexpressions shared between them are computed once.
+  std::vector<ref<Expr>> exprs(query.constraints.begin(),
+                               query.constraints.end());
+  exprs.push_back(query.expr);
+  std::vector<ref<Expr>> evaluated;
+  CompiledExpr(exprs.begin(), exprs.end()).evaluate(assignment, evaluated);
+
   // Check computed assignment satisfies query
+  unsigned index = 0;
   for (const auto &constraint : query.constraints) {
-    ref<Expr> constraintEvaluated = assignment.evaluate(constraint);
+    ref<Expr> constraintEvaluated = evaluated[index++];
     ConstantExpr *CE = dyn_cast<ConstantExpr>(constraintEvaluated);
     if (CE == NULL) {
       llvm::errs() << "Constraint did not evalaute to a constant:\n";
@@ -87,7 +97,7 @@ bool AssignmentValidatingSolver::computeInitialValues(
     }
   }
 
-  ref<Expr> queryExprEvaluated = assignment.evaluate(query.expr);
+  ref<Expr> queryExprEvaluated = evaluated.back();
   ConstantExpr *CE = dyn_cast<ConstantExpr>(queryExprEvaluated);
   if (CE == NULL) {
     llvm::errs() << "Query expression did not evalaute to a constant:\n";
@@ -0,0 +1,208 @@
+//===-- BinaryQueryLoggingSolver.cpp --------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "QueryLoggingSolver.h"
+
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/QueryLog.h"
+#include "klee/Solver/Solver.h"
+#include "klee/Solver/SolverImpl.h"
+#include "klee/Statistics/Statistics.h"
+#include "klee/System/Time.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+using namespace klee;
+
+namespace {
+
+/// Logs queries in the binary format of QueryLogWriter. Queries are encoded
+/// on the solver's thread, since expressions are not thread-safe, while the
+/// encoded chunks are written (and compressed) on a background thread.
+class BinaryQueryLoggingSolver : public SolverImpl {
+  /// Hand chunks of this size to the writer thread.
+  static constexpr size_t chunkSize = 256 * 1024;
+  /// Block the solver if the writer thread falls this many chunks behind.
+  static constexpr size_t maxPendingChunks = 64;
+
+  std::unique_ptr<Solver> solver;
+  std::unique_ptr<llvm::raw_ostream> os;
+  std::string chunk;
+  QueryLogWriter writer;
+  time::Span minQueryTimeToLog;
+  bool logTimedOutQueries;
+  Statistic *instructions;
+
+  LoggedQuery current;
+  time::Point startTime;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::string> pending;
+  bool done = false;
+  std::thread thread;
+
+  void writeChunks();
+  void startQuery(LoggedQuery::Kind kind, const Query &query);
+  void finishQuery(bool success);
+
+public:
+  BinaryQueryLoggingSolver(std::unique_ptr<Solver> solver, std::string path,
+                           time::Span queryTimeToLog, bool logTimedOut);
+  ~BinaryQueryLoggingSolver() override;
+
+  bool computeTruth(const Query &query, bool &isValid) override;
+  bool computeValidity(const Query &query, Solver::Validity &result) override;
+  bool computeValue(const Query &query, ref<Expr> &result) override;
+  bool computeInitialValues(const Query &query,
+                            const std::vector<const Array *> &objects,
+                            std::vector<std::vector<unsigned char>> &values,
+                            bool &hasSolution) override;
+  SolverRunStatus getOperationStatusCode() override {
+    return solver->impl->getOperationStatusCode();
+  }
+  std::string getConstraintLog(const Query &query) override {
+    return solver->impl->getConstraintLog(query);
+  }
+  void setCoreSolverTimeout(time::Span timeout) override {
+    solver->impl->setCoreSolverTimeout(timeout);
+  }
+};
+
+BinaryQueryLoggingSolver::BinaryQueryLoggingSolver(
+    std::unique_ptr<Solver> solver, std::string path,
+    time::Span queryTimeToLog, bool logTimedOut)
+    : solver(std::move(solver)), os(openQueryLogFile(std::move(path))),
+      writer(chunk), minQueryTimeToLog(queryTimeToLog),
+      logTimedOutQueries(logTimedOut),
+      instructions(theStatisticManager->getStatisticByName("Instructions")),
+      thread(&BinaryQueryLoggingSolver::writeChunks, this) {}
+
+BinaryQueryLoggingSolver::~BinaryQueryLoggingSolver() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(std::move(chunk));
+    done = true;
+  }
+  cv.notify_all();
+  thread.join();
+  os->flush();
+}
+
+void BinaryQueryLoggingSolver::writeChunks() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    cv.wait(lock, [this] { return done || !pending.empty(); });
+    if (pending.empty())
+      return;
+    std::string data = std::move(pending.front());
+    pending.pop_front();
+    lock.unlock();
+    cv.notify_all();
+    os->write(data.data(), data.size());
+    lock.lock();
+  }
+}
+
+void BinaryQueryLoggingSolver::startQuery(LoggedQuery::Kind kind,
+                                          const Query &query) {
+  current.kind = kind;
+  current.constraints.assign(query.constraints.begin(),
+                             query.constraints.end());
+  current.expr = query.expr;
+  current.objects.clear();
+  current.instructions = instructions ? instructions->getValue() : 0;
+  startTime = time::getWallTime();
+}
+
+void BinaryQueryLoggingSolver::finishQuery(bool success) {
+  time::Span duration = time::getWallTime() - startTime;
+  current.success = success;
+  current.status = solver->impl->getOperationStatusCode();
+  current.elapsedMicroseconds = duration.toMicroseconds();
+
+  bool log =
+      !minQueryTimeToLog || duration > minQueryTimeToLog ||
+      (logTimedOutQueries && current.status == SOLVER_RUN_STATUS_TIMEOUT);
+  if (log)
+    writer.write(current);
+  current.value = ref<Expr>();
+  current.values.clear();
+
+  if (chunk.size() < chunkSize)
+    return;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return pending.size() < maxPendingChunks; });
+    pending.push_back(std::move(chunk));
+  }
+  cv.notify_all();
+  chunk.clear();
+}
+
+bool BinaryQueryLoggingSolver::computeTruth(const Query &query,
+                                            bool &isValid) {
+  startQuery(LoggedQuery::Truth, query);
+  bool success = solver->impl->computeTruth(query, isValid);
+  if (success)
+    current.isValid = isValid;
+  finishQuery(success);
+  return success;
+}
+
+bool BinaryQueryLoggingSolver::computeValidity(const Query &query,
+                                               Solver::Validity &result) {
+  startQuery(LoggedQuery::Validity, query);
+  bool success = solver->impl->computeValidity(query, result);
+  if (success)
+    current.validity = result;
+  finishQuery(success);
+  return success;
+}
+
+bool BinaryQueryLoggingSolver::computeValue(const Query &query,
+                                            ref<Expr> &result) {
+  startQuery(LoggedQuery::Value, query);
+  bool success = solver->impl->computeValue(query, result);
+  if (success)
+    current.value = result;
+  finishQuery(success);
+  return success;
+}
+
+bool BinaryQueryLoggingSolver::computeInitialValues(
+    const Query &query, const std::vector<const Array *> &objects,
+    std::vector<std::vector<unsigned char>> &values, bool &hasSolution) {
+  startQuery(LoggedQuery::InitialValues, query);
+  current.objects = objects;
+  bool success =
+      solver->impl->computeInitialValues(query, objects, values, hasSolution);
+  if (success) {
+    current.hasSolution = hasSolution;
+    if (hasSolution)
+      current.values = values;
+  }
+  finishQuery(success);
+  return success;
+}
+
+} // namespace
+
+std::unique_ptr<Solver>
+klee::createBinaryQueryLoggingSolver(std::unique_ptr<Solver> solver,
+                                     std::string path,
+                                     time::Span minQueryTimeToLog,
+                                     bool logTimedOut) {
+  return std::make_unique<Solver>(std::make_unique<BinaryQueryLoggingSolver>(
+      std::move(solver), std::move(path), minQueryTimeToLog, logTimedOut));
+}
@@ -9,10 +9,12 @@
 
 #include "klee/Solver/Solver.h"
 
-#include "klee/ADT/MapOfSets.h"
+#include "klee/ADT/SetIndex.h"
 #include "klee/Expr/Assignment.h"
+#include "klee/Expr/CompiledExpr.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
+#include "klee/Expr/ExprHashMap.h"
 #include "klee/Expr/ExprUtil.h"
 #include "klee/Expr/ExprVisitor.h"
 #include "klee/Support/OptionCategories.h"
@@ -24,6 +26,7 @@
 #include "llvm/Support/CommandLine.h"
 
 #include <memory>
+#include <unordered_map>
 #include <utility>
 
 using namespace klee;
@@ -48,6 +51,12 @@ cl::opt<bool>
                               "before asking the SMT solver (default=false)"),
                      cl::cat(SolvingCat));
 
+cl::opt<unsigned> MaxCexCacheEntries(
+    "max-cex-cache-entries", cl::init(0),
+    cl::desc("Maximum number of queries kept in the counterexample cache, "
+             "evicting the least recently used ones (default=0 (off))"),
+    cl::cat(SolvingCat));
+
 } // namespace
 
 ///
@@ -66,9 +75,14 @@ class CexCachingSolver : public SolverImpl {
 
   std::unique_ptr<Solver> solver;
   
-  MapOfSets<ref<Expr>, Assignment*> cache;
+  SetIndex<ref<Expr>, Assignment *, util::ExprHash, util::ExprCmp> cache;
   // memo table
   assignmentsTable_ty assignmentsTable;
+  /// The number of cache entries using each assignment, so that assignments
+  /// can be freed once all their entries have been evicted.
+  std::unordered_map<Assignment *, unsigned> assignmentUses;
+
+  void insertAssignment(const KeyType &key, Assignment *binding);
 
   bool searchForAssignment(KeyType &key, 
                            Assignment *&result);
@@ -84,7 +98,7 @@ class CexCachingSolver : public SolverImpl {
   
 public:
   CexCachingSolver(std::unique_ptr<Solver> solver)
-      : solver(std::move(solver)) {}
+      : solver(std::move(solver)), cache(MaxCexCacheEntries) {}
   ~CexCachingSolver();
 
   bool computeTruth(const Query &, bool &isValid) override;
@@ -111,11 +125,18 @@ struct NonNullAssignment {
 
 struct NullOrSatisfyingAssignment {
   KeyType &key;
-  
+  // The key is compiled on first use, as it is usually checked against
+  // several cached assignments.
+  mutable std::unique_ptr<CompiledExpr> compiled;
+
   NullOrSatisfyingAssignment(KeyType &_key) : key(_key) {}
 
   bool operator()(Assignment *a) const { 
-    return !a || a->satisfies(key.begin(), key.end()); 
+    if (!a)
+      return true;
+    if (!compiled)
+      compiled = std::make_unique<CompiledExpr>(key.begin(), key.end());
+    return compiled->satisfies(*a);
   }
 };
 
@@ -127,7 +148,7 @@ struct NullOrSatisfyingAssignment {
 /// unsatisfiable query).
 /// \return - True if a cached result was found.
 bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
-  Assignment * const *lookup = cache.lookup(key);
+  Assignment **lookup = cache.lookup(key);
   if (lookup) {
     result = *lookup;
     return true;
@@ -136,7 +157,6 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
   if (CexCacheTryAll) {
     // Look for a satisfying assignment for a superset, which is trivially an
     // assignment for any subset.
-    Assignment **lookup = 0;
     if (CexCacheSuperSet)
       lookup = cache.findSuperset(key, NonNullAssignment());
 
@@ -152,10 +172,11 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
 
     // Otherwise, iterate through the set of current assignments to see if one
     // of them satisfies the query.
+    CompiledExpr compiled(key.begin(), key.end());
     for (assignmentsTable_ty::iterator it = assignmentsTable.begin(), 
            ie = assignmentsTable.end(); it != ie; ++it) {
       Assignment *a = *it;
-      if (a->satisfies(key.begin(), key.end())) {
+      if (compiled.satisfies(*a)) {
         result = a;
         return true;
       }
@@ -165,7 +186,6 @@ bool CexCachingSolver::searchForAssignment(KeyType &key, Assignment *&result) {
 
     // Look for a satisfying assignment for a superset, which is trivially an
     // assignment for any subset.
-    Assignment **lookup = 0;
     if (CexCacheSuperSet)
       lookup = cache.findSuperset(key, NonNullAssignment());
 
@@ -255,11 +275,29 @@ bool CexCachingSolver::getAssignment(const Query& query, Assignment *&result) {
   }
   
   result = binding;
-  cache.insert(key, binding);
+  insertAssignment(key, binding);
 
   return true;
 }
 
+/// insertAssignment - Cache \arg binding as the result for \arg key, freeing
+/// the assignments no longer used by any entry after evictions.
+void CexCachingSolver::insertAssignment(const KeyType &key,
+                                        Assignment *binding) {
+  if (binding)
+    ++assignmentUses[binding];
+
+  std::vector<Assignment *> removed;
+  stats::cexCacheEvictions += cache.insert(key, binding, &removed);
+  for (Assignment *a : removed) {
+    if (!a || --assignmentUses[a])
+      continue;
+    assignmentUses.erase(a);
+    assignmentsTable.erase(a);
+    delete a;
+  }
+}
+
 ///
 
 CexCachingSolver::~CexCachingSolver() {
@@ -25,7 +25,8 @@ namespace klee {
 std::unique_ptr<Solver> constructSolverChain(
     std::unique_ptr<Solver> coreSolver, std::string querySMT2LogPath,
     std::string baseSolverQuerySMT2LogPath, std::string queryKQueryLogPath,
-    std::string baseSolverQueryKQueryLogPath) {
+    std::string baseSolverQueryKQueryLogPath, std::string queryKQLogPath,
+    std::string baseSolverQueryKQLogPath) {
   Solver *rawCoreSolver = coreSolver.get();
   std::unique_ptr<Solver> solver = std::move(coreSolver);
   const time::Span minQueryTimeToLog(MinQueryTimeToLog);
@@ -46,6 +47,14 @@ std::unique_ptr<Solver> constructSolverChain(
                  baseSolverQuerySMT2LogPath.c_str());
   }
 
+  if (QueryLoggingOptions.isSet(SOLVER_KQLOG)) {
+    solver = createBinaryQueryLoggingSolver(
+        std::move(solver), baseSolverQueryKQLogPath, minQueryTimeToLog,
+        LogTimedOutQueries);
+    klee_message("Logging queries that reach solver in .kqlog format to %s\n",
+                 baseSolverQueryKQLogPath.c_str());
+  }
+
   if (UseAssignmentValidatingSolver)
     solver = createAssignmentValidatingSolver(std::move(solver));
 
@@ -77,6 +86,15 @@ std::unique_ptr<Solver> constructSolverChain(
     klee_message("Logging all queries in .smt2 format to %s\n",
                  querySMT2LogPath.c_str());
   }
+
+  if (QueryLoggingOptions.isSet(ALL_KQLOG)) {
+    solver = createBinaryQueryLoggingSolver(std::move(solver), queryKQLogPath,
+                                            minQueryTimeToLog,
+                                            LogTimedOutQueries);
+    klee_message("Logging all queries in .kqlog format to %s\n",
+                 queryKQLogPath.c_str());
+  }
+
   if (DebugCrossCheckCoreSolverWith != NO_SOLVER) {
     std::unique_ptr<Solver> oracleSolver =
         createCoreSolver(DebugCrossCheckCoreSolverWith);
@@ -811,7 +811,13 @@ public:
       CexObjectData &cod = getObjectData(array);
       CexValueData index = evalRangeForExpr(re->index);
 
-      for (const auto *un = re->updates.head.get(); un; un = un->next.get()) {
+      for (auto *un = re->updates.head.get(); un; un = un->next.get()) {
+        if (index.isFixed()) {
+          un = un->findWrite(index.min());
+          if (!un)
+            break;
+        }
+
         CexValueData ui = evalRangeForExpr(un->index);
 
         // If these indices can't alias, continue propagation
@@ -31,14 +31,8 @@ llvm::cl::opt<bool> CreateCompressedQueryLog(
 #endif
 } // namespace
 
-QueryLoggingSolver::QueryLoggingSolver(std::unique_ptr<Solver> solver,
-                                       std::string path,
-                                       const std::string &commentSign,
-                                       time::Span queryTimeToLog,
-                                       bool logTimedOut)
-    : solver(std::move(solver)), BufferString(""), logBuffer(BufferString),
-      queryCount(0), minQueryTimeToLog(queryTimeToLog),
-      logTimedOutQueries(logTimedOut), queryCommentSign(commentSign) {
+std::unique_ptr<llvm::raw_ostream> openQueryLogFile(std::string path) {
+  std::unique_ptr<llvm::raw_ostream> os;
   std::string error;
 #ifdef HAVE_ZLIB_H
   if (!CreateCompressedQueryLog) {
@@ -53,6 +47,18 @@ QueryLoggingSolver::QueryLoggingSolver(std::unique_ptr<Solver> solver,
   if (!os) {
     klee_error("Could not open file %s : %s", path.c_str(), error.c_str());
   }
+  return os;
+}
+
+QueryLoggingSolver::QueryLoggingSolver(std::unique_ptr<Solver> solver,
+                                       std::string path,
+                                       const std::string &commentSign,
+                                       time::Span queryTimeToLog,
+                                       bool logTimedOut)
+    : solver(std::move(solver)), os(openQueryLogFile(std::move(path))),
+      BufferString(""), logBuffer(BufferString), queryCount(0),
+      minQueryTimeToLog(queryTimeToLog), logTimedOutQueries(logTimedOut),
+      queryCommentSign(commentSign) {
   assert(this->solver);
 }
 
@@ -21,6 +21,10 @@
 
 using namespace klee;
 
+/// Open the query log at \p path, compressed if requested on the command
+/// line. Exits with an error if the file cannot be opened.
+std::unique_ptr<llvm::raw_ostream> openQueryLogFile(std::string path);
+
 /// This abstract class represents a solver that is capable of logging
 /// queries to a file.
 /// Derived classes might specialize this one by providing different formats
@@ -109,6 +109,19 @@ Solver::getInitialValues(const Query& query,
   return success;
 }
 
+bool Solver::getInitialValues(const Query &query,
+                              const std::vector<const Array *> &objects,
+                              std::vector<std::vector<unsigned char>> &values,
+                              bool &hasSolution) {
+  // Maintain invariants implementations expect.
+  if (query.expr->isTrue()) {
+    hasSolution = false;
+    return true;
+  }
+
+  return impl->computeInitialValues(query, objects, values, hasSolution);
+}
+
 std::pair< ref<Expr>, ref<Expr> > Solver::getRange(const Query& query) {
   ref<Expr> e = query.expr;
   Expr::Width width = e->getWidth();
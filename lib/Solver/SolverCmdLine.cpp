@@ -104,7 +104,12 @@ cl::bits<QueryLoggingSolverType> QueryLoggingOptions(
             "All queries reaching the solver in .kquery (KQuery) format"),
         clEnumValN(
             SOLVER_SMTLIB, "solver:smt2",
-            "All queries reaching the solver in .smt2 (SMT-LIBv2) format")),
+            "All queries reaching the solver in .smt2 (SMT-LIBv2) format"),
+        clEnumValN(ALL_KQLOG, "all:kqlog",
+                   "All queries in the compact binary .kqlog format"),
+        clEnumValN(SOLVER_KQLOG, "solver:kqlog",
+                   "All queries reaching the solver in the compact binary "
+                   ".kqlog format")),
     cl::CommaSeparated, cl::cat(SolvingCat));
 
 cl::opt<bool> UseAssignmentValidatingSolver(
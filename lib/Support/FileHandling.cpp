@@ -18,6 +18,11 @@
 #include "klee/Support/CompressionStream.h"
 #endif
 
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace klee {
 
 std::unique_ptr<llvm::raw_fd_ostream>
@@ -46,4 +51,58 @@ klee_open_compressed_output_file(const std::string &path, std::string &error) {
   return f;
 }
 #endif
+
+namespace {
+#ifdef HAVE_ZLIB_H
+/// Reads through zlib, which passes uncompressed files through unchanged.
+class GzInputStream : public InputStream {
+  gzFile file;
+
+public:
+  explicit GzInputStream(gzFile file) : file(file) {}
+  ~GzInputStream() override { gzclose(file); }
+
+  long read(char *buffer, size_t size) override {
+    return gzread(file, buffer, size);
+  }
+};
+#else
+class FdInputStream : public InputStream {
+  int fd;
+
+public:
+  explicit FdInputStream(int fd) : fd(fd) {}
+  ~FdInputStream() override { close(fd); }
+
+  long read(char *buffer, size_t size) override {
+    ssize_t n;
+    do {
+      n = ::read(fd, buffer, size);
+    } while (n < 0 && errno == EINTR);
+    return n;
+  }
+};
+#endif
+} // namespace
+
+std::unique_ptr<InputStream> klee_open_input_file(const std::string &path,
+                                                  std::string &error) {
+  error.clear();
+  int fd = path == "-" ? dup(0) : open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error = strerror(errno);
+    return nullptr;
+  }
+#ifdef HAVE_ZLIB_H
+  gzFile file = gzdopen(fd, "rb");
+  if (!file) {
+    close(fd);
+    error = "could not initialize decompression";
+    return nullptr;
+  }
+  return std::make_unique<GzInputStream>(file);
+#else
+  return std::make_unique<FdInputStream>(fd);
+#endif
+}
 }
@@ -12,6 +12,8 @@
 #include "klee/Config/config.h"
 #include "klee/Support/ErrorHandling.h"
 
+#include <sys/resource.h>
+
 #ifdef HAVE_GPERFTOOLS_MALLOC_EXTENSION_H
 #include "gperftools/malloc_extension.h"
 #endif
@@ -109,3 +111,15 @@ size_t util::GetTotalMallocUsage() {
 
 #endif
 }
+
+size_t util::GetPeakMemoryUsage() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage))
+    return 0;
+#ifdef __APPLE__
+  return usage.ru_maxrss;
+#else
+  // Linux reports kilobytes
+  return usage.ru_maxrss * 1024;
+#endif
+}
@@ -11,6 +11,7 @@
 #include "klee/Support/Timer.h"
 #include "klee/System/Time.h"
 
+#include <algorithm>
 
 using namespace klee;
 
@@ -68,6 +69,14 @@ void TimerGroup::add(std::unique_ptr<klee::Timer> timer) {
   timers.emplace_back(std::move(timer));
 }
 
+void TimerGroup::remove(const Timer *timer) {
+  timers.erase(std::remove_if(timers.begin(), timers.end(),
+                              [timer](const std::unique_ptr<Timer> &t) {
+                                return t.get() == timer;
+                              }),
+               timers.end());
+}
+
 void TimerGroup::invoke() {
   currentTime = time::getWallTime();
   invocationTimer.invoke(currentTime);
@@ -87,6 +87,28 @@ static exe_file_t *__get_file(int fd) {
   return 0;
 }
 
+/* Copies count bytes between buf and the symbolic file df at offset off,
+   into the file if to_file is set and out of it otherwise. The bytes are
+   copied chunk by chunk, directly by KLEE where possible. */
+static void __df_copy(exe_disk_file_t *df, off64_t off, void *buf,
+                      size_t count, int to_file) {
+  char *b = buf;
+  while (count) {
+    char *chunk = df->chunks[off / KLEE_SYM_FILE_CHUNK_SIZE] +
+                  off % KLEE_SYM_FILE_CHUNK_SIZE;
+    size_t n = KLEE_SYM_FILE_CHUNK_SIZE - off % KLEE_SYM_FILE_CHUNK_SIZE;
+    if (n > count)
+      n = count;
+    void *dst = to_file ? chunk : b;
+    const void *src = to_file ? b : chunk;
+    if (!klee_posix_copy(dst, src, n))
+      memcpy(dst, src, n);
+    off += n;
+    b += n;
+    count -= n;
+  }
+}
+
 int access(const char *pathname, int mode) {
   exe_disk_file_t *dfile = __get_sym_file(pathname);
   
@@ -391,7 +413,7 @@ ssize_t read(int fd, void *buf, size_t count) {
       count = f->dfile->size - f->off;
     }
     
-    memcpy(buf, f->dfile->contents + f->off, count);
+    __df_copy(f->dfile, f->off, buf, count, 0);
     f->off += count;
     
     return count;
@@ -461,7 +483,7 @@ ssize_t write(int fd, const void *buf, size_t count) {
     }
     
     if (actual_count)
-      memcpy(f->dfile->contents + f->off, buf, actual_count);
+      __df_copy(f->dfile, f->off, (void *) buf, actual_count, 1);
     
     if (count != actual_count)
       klee_warning("write() ignores bytes.\n");
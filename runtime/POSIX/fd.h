@@ -50,9 +50,14 @@
 #include <sys/vfs.h>
 #endif
 
+/* Symbolic files are split into chunks of this many bytes, each made
+   symbolic separately, so that a query about a file only refers to the
+   chunks it actually touches. */
+#define KLEE_SYM_FILE_CHUNK_SIZE 4096
+
 typedef struct {
   unsigned size;  /* in bytes */
-  char* contents;
+  char** chunks;  /* ceil(size / KLEE_SYM_FILE_CHUNK_SIZE) chunks */
   struct stat64* stat;
 } exe_disk_file_t;
 
@@ -39,6 +39,38 @@ exe_sym_env_t __exe_env = {
   0
 };
 
+/* Names chunk i > 0 of the file called name as name_i. */
+static void __chunk_name(char *cname, const char *name, unsigned i) {
+  char digits[16];
+  unsigned n = 0;
+  const char *sp;
+  for (sp=name; *sp; ++sp)
+    *cname++ = *sp;
+  *cname++ = '_';
+  do {
+    digits[n++] = '0' + i % 10;
+    i /= 10;
+  } while (i);
+  while (n)
+    *cname++ = digits[--n];
+  *cname = '\0';
+}
+
+/* Makes the file symbolic in chunks of KLEE_SYM_FILE_CHUNK_SIZE bytes, so
+   that queries and copy-on-write only involve the chunks a program uses.
+   All chunks are made symbolic here, in a fixed order: the first one under
+   the name of the file, the others as <name>_1, <name>_2, ..., followed by
+   the stat buffer as <name>_stat. Test cases list the objects in this order,
+   and klee-replay and seeding match them by position, so making chunks
+   symbolic on first use would tie replay to the order of accesses.
+
+   Test cases and seeds written before files were split hold a file larger
+   than one chunk as a single object, directly followed by <name>_stat.
+   These no longer fit: klee-replay reports mismatching object names and
+   sizes, and seeding stops at the size mismatch unless
+   --allow-seed-truncation is given, with which the remaining objects are
+   seeded from the wrong inputs. Such seeds have to be generated again, e.g.
+   by ktest-gen, which splits files in the same way. */
 static void __create_new_dfile(exe_disk_file_t *dfile, unsigned size, 
                                const char *name, struct stat64 *defaults) {
   struct stat64 *s = malloc(sizeof(*s));
@@ -54,11 +86,30 @@ static void __create_new_dfile(exe_disk_file_t *dfile, unsigned size,
   assert(size);
 
   dfile->size = size;
-  dfile->contents = malloc(dfile->size);
-  if (!dfile->contents)
+  unsigned num_chunks =
+    (size + KLEE_SYM_FILE_CHUNK_SIZE - 1) / KLEE_SYM_FILE_CHUNK_SIZE;
+  dfile->chunks = malloc(num_chunks * sizeof(*dfile->chunks));
+  if (!dfile->chunks)
     klee_report_error(__FILE__, __LINE__, "out of memory in klee_init_env", "user.err");
-  klee_make_symbolic(dfile->contents, dfile->size, name);
-  
+  for (unsigned i = 0; i < num_chunks; ++i) {
+    unsigned chunk_size = size - i * KLEE_SYM_FILE_CHUNK_SIZE;
+    if (chunk_size > KLEE_SYM_FILE_CHUNK_SIZE)
+      chunk_size = KLEE_SYM_FILE_CHUNK_SIZE;
+    dfile->chunks[i] = malloc(chunk_size);
+    if (!dfile->chunks[i])
+      klee_report_error(__FILE__, __LINE__, "out of memory in klee_init_env", "user.err");
+
+    /* The first chunk keeps the name of the file, so that files of at most
+       one chunk look as before in test cases. */
+    if (i == 0) {
+      klee_make_symbolic(dfile->chunks[i], chunk_size, name);
+    } else {
+      char cname[64];
+      __chunk_name(cname, name, i);
+      klee_make_symbolic(dfile->chunks[i], chunk_size, cname);
+    }
+  }
+
   klee_make_symbolic(s, sizeof(*s), sname);
 
   /* For broken tests */
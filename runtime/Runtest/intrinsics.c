@@ -10,13 +10,17 @@
 /* Straight C for linking simplicity */
 
 #include <assert.h>
+#include <errno.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "klee/klee.h"
 
@@ -177,3 +181,82 @@ void klee_set_forking(unsigned enable) {}
 
 void klee_open_merge() {}
 void klee_close_merge() {}
+
+/* Batch replay server. When KLEE_REPLAY_SERVER_FDS is set to "<in>,<out>",
+   the process stops before main and reads .ktest paths from fd <in>, one per
+   line. For each, it forks a child that replays the test by running main,
+   and writes "<wait status> <microseconds> <timed out>" to fd <out> once the
+   child is gone. Loading and initializing the program thus happens only
+   once per server, not once per test. */
+
+static pid_t server_child = 0;
+
+static void server_timeout(int sig) {
+  if (server_child)
+    kill(server_child, SIGKILL);
+}
+
+__attribute__((constructor)) static void replay_server(void) {
+  const char *fds = getenv("KLEE_REPLAY_SERVER_FDS");
+  int in, out;
+  if (!fds || sscanf(fds, "%d,%d", &in, &out) != 2)
+    return;
+
+  unsigned timeout = 0;
+  const char *t = getenv("KLEE_REPLAY_TIMEOUT");
+  if (t)
+    timeout = atoi(t);
+  signal(SIGALRM, server_timeout);
+
+  FILE *requests = fdopen(in, "r");
+  if (!requests) {
+    perror("KLEE-RUNTIME: fdopen");
+    _exit(1);
+  }
+  dprintf(out, "KTEST-SERVER 1\n");
+
+  char path[4096];
+  while (fgets(path, sizeof path, requests)) {
+    path[strcspn(path, "\n")] = '\0';
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("KLEE-RUNTIME: fork");
+      _exit(1);
+    }
+    if (pid == 0) {
+      fclose(requests);
+      close(out);
+      signal(SIGALRM, SIG_DFL);
+      setenv("KTEST_FILE", path, 1);
+      unsetenv("KLEE_REPLAY_SERVER_FDS");
+      return;
+    }
+
+    server_child = pid;
+    alarm(timeout);
+    int status, res;
+    do {
+      res = waitpid(pid, &status, 0);
+    } while (res < 0 && errno == EINTR);
+    unsigned remaining = alarm(0);
+    server_child = 0;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (res < 0) {
+      perror("KLEE-RUNTIME: waitpid");
+      _exit(1);
+    }
+
+    long long usec = (end.tv_sec - start.tv_sec) * 1000000LL +
+                     (end.tv_nsec - start.tv_nsec) / 1000;
+    int timedOut = timeout && !remaining && WIFSIGNALED(status) &&
+                   WTERMSIG(status) == SIGKILL;
+    dprintf(out, "%d %lld %d\n", status, usec, timedOut);
+  }
+
+  /* Skip exit handlers: anything they record (e.g. coverage) was recorded by
+     the children already. */
+  _exit(0);
+}
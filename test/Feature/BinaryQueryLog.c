@@ -0,0 +1,31 @@
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --use-cex-cache=false --use-query-log=all:kqlog,all:kquery %t.bc
+// RUN: %kleaver %t.klee-out/all-queries.kqlog > %t.eval
+// RUN: FileCheck --input-file=%t.eval %s
+// RUN: %kleaver -print-ast %t.klee-out/all-queries.kqlog | FileCheck --check-prefix=CHECK-AST %s
+
+// kleaver reads back every query KLEE logged
+// RUN: grep -c "^# Query" %t.klee-out/all-queries.kquery > %t.kquery-count
+// RUN: grep -c "^Query" %t.eval > %t.kqlog-count
+// RUN: diff %t.kquery-count %t.kqlog-count
+
+#include "klee/klee.h"
+
+int main(void) {
+  char buf[4];
+  klee_make_symbolic(buf, sizeof buf, "buf");
+  klee_assume(buf[0] > 'a');
+  int n = 0;
+  for (int i = 0; i < 4; ++i)
+    if (buf[i] == 'x')
+      ++n;
+  return n;
+}
+
+// CHECK: Query 0:
+// CHECK-NOT: FAIL
+// CHECK: Array 0: buf[
+
+// CHECK-AST: # Query 0
+// CHECK-AST: (query [
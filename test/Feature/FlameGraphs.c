@@ -0,0 +1,27 @@
+// Check the collapsed stacks written by --output-flamegraphs.
+//
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --output-flamegraphs %t.bc
+// RUN: FileCheck --input-file=%t.klee-out/run.Forks.folded %s
+// RUN: FileCheck --check-prefix=CHECK-INSTRUCTIONS --input-file=%t.klee-out/run.Instructions.folded %s
+// RUN: test -f %t.klee-out/run.QueryTime.folded
+// RUN: test -f %t.klee-out/run.ResolveTime.folded
+
+#include "klee/klee.h"
+
+int classify(int x) {
+  if (x > 10) // forks
+    return 1;
+  return 0;
+}
+
+int main(void) {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  return classify(x);
+}
+
+// CHECK: main;classify ({{.*}}FlameGraphs.c:22) 1
+// CHECK-INSTRUCTIONS: main {{[0-9]+}}
+// CHECK-INSTRUCTIONS: main;classify ({{.*}}FlameGraphs.c:22) {{[0-9]+}}
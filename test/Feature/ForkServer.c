@@ -0,0 +1,52 @@
+// RUN: %clang %s -g -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.klee-out-2 %t.run1 %t.run2 %t.run3
+// RUN: printf -- "--output-dir=%t.run1 --search=dfs\n--output-dir=%t.run2 --max-tests=1\n" > %t.requests
+// RUN: %klee --output-dir=%t.klee-out --fork-server --fork-server-at=init_done %t.bc < %t.requests 2>&1 | FileCheck %s
+// RUN: test -f %t.run1/test000002.ktest
+// RUN: not test -f %t.run1/test000003.ktest
+// RUN: test -f %t.run2/test000001.ktest
+// RUN: not test -f %t.run2/test000002.ktest
+// RUN: not test -f %t.klee-out/test000001.ktest
+
+// Seeds given with a request apply to that run only.
+// RUN: echo "--output-dir=%t.run3 --seed-file=%t.run1/test000001.ktest --only-seed" | %klee --output-dir=%t.klee-out-2 --fork-server --fork-server-at=init_done %t.bc 2>&1 | FileCheck --check-prefix=CHECK-SEED %s
+// RUN: test -f %t.run3/test000001.ktest
+// RUN: not test -f %t.run3/test000002.ktest
+
+// Options used before the snapshot cannot be changed per run.
+// RUN: rm -rf %t.klee-out-3 %t.run4
+// RUN: echo "--output-dir=%t.run4 --max-solver-time=1s" | %klee --output-dir=%t.klee-out-3 --fork-server --fork-server-at=init_done %t.bc 2>&1 | FileCheck --check-prefix=CHECK-REJECT %s
+// RUN: rm -rf %t.klee-out-4
+// RUN: not %klee --output-dir=%t.klee-out-4 --fork-server --use-query-log=all:kqlog %t.bc 2>&1 | FileCheck --check-prefix=CHECK-KQLOG %s
+
+// CHECK: initializing
+// CHECK: snapshot taken
+// CHECK: fork server: run 1 exited with 0
+// CHECK-NOT: initializing
+// CHECK: fork server: run 2 exited with 0
+
+// CHECK-SEED: using 1 seeds
+// CHECK-SEED: fork server: run 1 exited with 0
+
+// CHECK-REJECT: option '--max-solver-time=1s' cannot be changed after the snapshot
+// CHECK-REJECT: fork server: run 1 exited with 1
+
+// CHECK-KQLOG: --fork-server cannot be used with --use-query-log=all:kqlog
+
+#include "klee/klee.h"
+
+#include <stdio.h>
+
+void init_done(void) {}
+
+int main(void) {
+  // Only executed once, before the snapshot is taken.
+  fprintf(stderr, "initializing\n");
+  init_done();
+
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  if (x > 42)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,22 @@
+# Check the per-instruction coverage statistics in a run.istats file. Each
+# event gets a column after the two position columns, in the order of the
+# "events:" line.
+/^events:/ {
+  for (i = 2; i <= NF; ++i) {
+    if ($i == "Icov") icov = i + 1
+    if ($i == "Iuncov") iuncov = i + 1
+    if ($i == "UCdist") ucdist = i + 1
+  }
+}
+/^[0-9]/ {
+  # An instruction is uncovered once at most, and not if it is covered
+  if ($iuncov > 1 || $icov + $iuncov > 1) invalid = 1
+  if ($iuncov == 1) uncovered = 1
+  # Distances are short in a small program, 0 means unreachable
+  if ($ucdist > 1000) far = 1
+  if ($ucdist > 0) reachable = 1
+}
+END {
+  print "Iuncov: " (invalid ? "invalid" : (uncovered ? "uncovered" : "none"))
+  print "UCdist: " (far ? "invalid" : (reachable ? "reachable" : "none"))
+}
@@ -0,0 +1,25 @@
+// Check that each instruction is counted as uncovered by itself, and that
+// the distance to uncovered instructions is derived from these counts.
+//
+// RUN: %clang %s -emit-llvm %O0opt -g -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t.bc
+// RUN: awk -f %S/IStatsUncovered.awk %t.klee-out/run.istats | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --search=nurs:md2u %t.bc
+// RUN: awk -f %S/IStatsUncovered.awk %t.klee-out/run.istats | FileCheck %s
+
+// CHECK: Iuncov: uncovered
+// CHECK: UCdist: reachable
+
+volatile int path;
+
+int main(int argc, char **argv) {
+  path = 1;
+  // Never taken, so its instructions stay uncovered
+  if (argc > 100) {
+    path = 2;
+    path = 3;
+  }
+  return 0;
+}
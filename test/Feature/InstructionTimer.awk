@@ -0,0 +1,15 @@
+# Report whether some instruction in a run.istats file has a non-zero
+# instruction time and real time. Each event gets a column after the two
+# position columns, in the order of the "events:" line.
+/^events:/ {
+  for (i = 2; i <= NF; ++i) {
+    if ($i == "Itime") itime = i + 1
+    if ($i == "Ireal") ireal = i + 1
+  }
+}
+/^[0-9]/ && itime && $itime > 0 { itimeFound = 1 }
+/^[0-9]/ && ireal && $ireal > 0 { irealFound = 1 }
+END {
+  print "Itime: " (itimeFound ? "nonzero" : "zero")
+  print "Ireal: " (irealFound ? "nonzero" : "zero")
+}
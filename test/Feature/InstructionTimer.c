@@ -0,0 +1,27 @@
+// Check that every instruction timer attributes time to instructions in
+// run.istats.
+//
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out-rusage %t.klee-out-clock %t.klee-out-sampling
+// RUN: %klee --output-dir=%t.klee-out-rusage --track-instruction-time --instruction-timer=rusage %t.bc
+// RUN: FileCheck --input-file=%t.klee-out-rusage/run.istats %s
+// RUN: awk -f %S/InstructionTimer.awk %t.klee-out-rusage/run.istats | FileCheck --check-prefix=CHECK-TIME %s
+// RUN: %klee --output-dir=%t.klee-out-clock --track-instruction-time --instruction-timer=clock %t.bc
+// RUN: FileCheck --input-file=%t.klee-out-clock/run.istats %s
+// RUN: awk -f %S/InstructionTimer.awk %t.klee-out-clock/run.istats | FileCheck --check-prefix=CHECK-TIME %s
+// RUN: %klee --output-dir=%t.klee-out-sampling --track-instruction-time --instruction-timer=sampling --instruction-timer-interval=1ms %t.bc
+// RUN: FileCheck --input-file=%t.klee-out-sampling/run.istats %s
+// RUN: awk -f %S/InstructionTimer.awk %t.klee-out-sampling/run.istats | FileCheck --check-prefix=CHECK-TIME %s
+
+// CHECK: event: Itime : InstructionTimes
+// CHECK: event: Ireal : InstructionRealTimes
+
+// CHECK-TIME: Itime: nonzero
+// CHECK-TIME: Ireal: nonzero
+
+int main(void) {
+  unsigned acc = 0;
+  for (unsigned i = 0; i < 100000; ++i)
+    acc = acc * 31 + i;
+  return acc == 42;
+}
@@ -0,0 +1,41 @@
+// RUN: %clang %s -g -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.klee-out-lazy
+// RUN: %klee --output-dir=%t.klee-out --manifest-threads=2 %t.bc 2>&1 | FileCheck %s
+// RUN: %klee --output-dir=%t.klee-out-lazy --lazy-manifest --output-istats %t.bc 2>&1 | FileCheck %s
+// RUN: FileCheck --check-prefix=CHECK-INFO --input-file=%t.klee-out-lazy/info %s
+// RUN: diff %t.klee-out/assembly.ll %t.klee-out-lazy/assembly.ll
+// RUN: grep -q "fn=twice" %t.klee-out-lazy/run.istats
+// Assembly lines are only found once asked for, but are the same
+// RUN: grep "^[0-9]" %t.klee-out/run.istats | cut -d" " -f1-2 > %t.lines
+// RUN: grep "^[0-9]" %t.klee-out-lazy/run.istats | cut -d" " -f1-2 > %t.lines-lazy
+// RUN: diff %t.lines %t.lines-lazy
+
+// Functions are only prepared when first called, including through function
+// pointers and with constants not seen before.
+
+#include "klee/klee.h"
+
+#include <stdio.h>
+
+static const char greeting[] = "never printed";
+
+static int twice(int x) { return 2 * x + 1000000; }
+static int thrice(int x) { return 3 * x + 2000000; }
+static void unused(void) { puts(greeting); }
+
+int (*table[])(int) = {twice, thrice};
+
+int main(void) {
+  int i;
+  klee_make_symbolic(&i, sizeof i, "i");
+  klee_assume(i >= 0 & i < 2);
+  int result = table[i](7);
+  // CHECK-DAG: result 1000014
+  // CHECK-DAG: result 2000021
+  printf("result %d\n", result);
+  if (result == 3)
+    unused();
+  return 0;
+}
+
+// CHECK-INFO: Startup: {{.*}} MB peak memory before the first instruction
@@ -0,0 +1,37 @@
+// RUN: %clang %s -g -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.cache %t.klee-out %t.klee-out-2 %t.klee-out-3
+// RUN: %klee --output-dir=%t.klee-out --module-cache-dir=%t.cache --libc=klee %t.bc 2>&1 | FileCheck --check-prefix=CHECK-MISS %s
+// RUN: FileCheck --check-prefix=CHECK-MISS-INFO --input-file=%t.klee-out/info %s
+// RUN: %klee --output-dir=%t.klee-out-2 --module-cache-dir=%t.cache --libc=klee %t.bc 2>&1 | FileCheck --check-prefix=CHECK-HIT %s
+// RUN: FileCheck --check-prefix=CHECK-HIT-INFO --input-file=%t.klee-out-2/info %s
+// RUN: diff %t.klee-out/assembly.ll %t.klee-out-2/assembly.ll
+// RUN: test -f %t.klee-out-2/test000002.ktest
+
+// Options changing the prepared module select a different entry.
+// RUN: %klee --output-dir=%t.klee-out-3 --module-cache-dir=%t.cache --libc=klee --check-div-zero=false %t.bc 2>&1 | FileCheck --check-prefix=CHECK-MISS %s
+
+// With the POSIX runtime wrapping main, hits and misses still name the same
+// entry function.
+// RUN: rm -rf %t.klee-out-4 %t.klee-out-5
+// RUN: %klee --output-dir=%t.klee-out-4 --module-cache-dir=%t.cache --libc=uclibc --posix-runtime --write-xml-tests --xml-metadata-programfile=ModuleCache.c --xml-metadata-programhash=0 %t.bc 2>&1 | FileCheck --check-prefix=CHECK-MISS %s
+// RUN: %klee --output-dir=%t.klee-out-5 --module-cache-dir=%t.cache --libc=uclibc --posix-runtime --write-xml-tests --xml-metadata-programfile=ModuleCache.c --xml-metadata-programhash=0 %t.bc 2>&1 | FileCheck --check-prefix=CHECK-HIT %s
+// RUN: FileCheck --check-prefix=CHECK-ENTRY --input-file=%t.klee-out-4/metadata.xml %s
+// RUN: FileCheck --check-prefix=CHECK-ENTRY --input-file=%t.klee-out-5/metadata.xml %s
+
+#include "klee/klee.h"
+
+#include <string.h>
+
+int main(void) {
+  char buf[4];
+  klee_make_symbolic(buf, sizeof buf, "buf");
+  // CHECK-MISS-NOT: Using cached module
+  // CHECK-HIT: Using cached module
+  if (strcmp(buf, "abc") == 0)
+    return 1;
+  return 0;
+}
+
+// CHECK-MISS-INFO: Module cache miss
+// CHECK-HIT-INFO: Module cache hit
+// CHECK-ENTRY: <entryfunction>__klee_posix_wrapped_main</entryfunction>
@@ -0,0 +1,32 @@
+// Check that the slowest queries are written with their state and can be
+// replayed by kleaver.
+//
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --max-slow-queries=1 --min-slow-query-time=0s %t.bc
+// RUN: FileCheck --input-file=%t.klee-out/slow-queries.txt %s
+// RUN: FileCheck --check-prefix=CHECK-QUERY --input-file=%t.klee-out/slow-query001.kquery %s
+// RUN: test ! -f %t.klee-out/slow-query002.kquery
+// RUN: %kleaver %t.klee-out/slow-query001.kquery
+
+#include "klee/klee.h"
+
+int classify(int x) {
+  if (x > 10)
+    return 1;
+  return 0;
+}
+
+int main(void) {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  return classify(x);
+}
+
+// CHECK: # File
+// CHECK-NEXT: slow-query001.kquery
+// CHECK-NOT: slow-query
+
+// CHECK-QUERY: # Query {{[0-9]+}} -- Type: {{[A-Za-z]+}}
+// CHECK-QUERY: # Depth: {{[0-9]+}}, Instruction:
+// CHECK-QUERY: (query [
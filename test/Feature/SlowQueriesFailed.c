@@ -0,0 +1,33 @@
+// Check that no more failed queries are kept than --max-slow-queries.
+//
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --max-solver-time=1 --max-slow-queries=2 %t.bc
+// RUN: FileCheck --input-file=%t.klee-out/slow-queries.txt %s
+// RUN: test ! -f %t.klee-out/slow-query003.kquery
+#include "klee/klee.h"
+
+volatile int path;
+
+int main() {
+  long long int x, y = 102*75678 + 78, i = 101;
+  unsigned char s;
+
+  klee_make_symbolic(&x, sizeof(x), "x");
+  klee_make_symbolic(&s, sizeof(s), "s");
+
+  // Four states, each issuing a query that times out
+  if (s & 1)
+    path = 1;
+  if (s & 2)
+    path = 2;
+
+  if (x*x*x*x*x*x*x*x*x*x*x*x*x*x*x*x + (x*x % (x+12)) == y*y*y*y*y*y*y*y*y*y*y*y*y*y*y*y % i)
+    return 1;
+  return 0;
+}
+
+// CHECK: # File
+// CHECK-NEXT: slow-query001.kquery{{.*}}SOLVER TIMEOUT
+// CHECK-NEXT: slow-query002.kquery{{.*}}SOLVER TIMEOUT
+// CHECK-NOT: slow-query
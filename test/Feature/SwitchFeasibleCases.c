@@ -0,0 +1,50 @@
+// RUN: %clang %s -emit-llvm -g -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --switch-type=internal %t.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'BrSwitch' --table-format=csv %t.klee-out | FileCheck --check-prefix=CHECK-STATS %s
+
+// Only three of the many cases are feasible, all others must be pruned
+// without forking.
+
+#include "klee/klee.h"
+#include <stdio.h>
+
+int main(int argc, char **argv) {
+  unsigned char c;
+
+  klee_make_symbolic(&c, sizeof(c), "c");
+  klee_assume(c >= 'a');
+  klee_assume(c <= 'c');
+
+  switch (c) {
+  case 'a':
+    printf("a\n");
+    break;
+  case 'b':
+    printf("b\n");
+    break;
+  case 'c':
+    printf("c\n");
+    break;
+  case 'd': case 'e': case 'f': case 'g': case 'h': case 'i': case 'j':
+  case 'k': case 'l': case 'm': case 'n': case 'o': case 'p': case 'q':
+    printf("d-q\n");
+    break;
+  case 'r': case 's': case 't': case 'u': case 'v': case 'w': case 'x':
+    printf("r-x\n");
+    break;
+  default:
+    printf("default\n");
+    break;
+  }
+
+  return 0;
+}
+
+// CHECK-NOT: d-q
+// CHECK-NOT: r-x
+// CHECK-NOT: default
+// CHECK: KLEE: done: completed paths = 3
+
+// CHECK-STATS: BrSwitch
+// CHECK-STATS-NEXT: {{^2$}}
@@ -0,0 +1,28 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.klee-out-forks
+// RUN: %klee --output-dir=%t.klee-out --max-symbolic-call-targets=2 %t.bc 2>&1 | FileCheck %s
+// RUN: %klee --output-dir=%t.klee-out-forks --max-symbolic-call-targets=2 --max-forks=0 %t.bc 2>&1 | FileCheck --check-prefix=CHECK-FORKS %s
+
+// The targets of a symbolic function pointer are enumerated two at a time,
+// and no more than the fork limit allows.
+
+#include "klee/klee.h"
+
+static int f0(void) { return 0; }
+static int f1(void) { return 1; }
+static int f2(void) { return 2; }
+static int f3(void) { return 3; }
+static int f4(void) { return 4; }
+static int f5(void) { return 5; }
+static int f6(void) { return 6; }
+
+int (*const table[])(void) = {f0, f1, f2, f3, f4, f5, f6};
+
+int main(int argc, char **argv) {
+  unsigned i;
+  klee_make_symbolic(&i, sizeof(i), "i");
+  return table[i % 7]();
+}
+
+// CHECK: KLEE: done: completed paths = 7
+// CHECK-FORKS: KLEE: done: completed paths = 1
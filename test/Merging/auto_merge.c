@@ -0,0 +1,37 @@
+// RUN: %clang -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --auto-merge --debug-log-merge --search=bfs %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --auto-merge --debug-log-merge --search=dfs %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --auto-merge --debug-log-merge %t.bc 2>&1 | FileCheck %s
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --auto-merge --auto-merge-max-blocks=1 %t.bc 2>&1 | FileCheck --check-prefix=CHECK-SMALL %s
+
+// CHECK: Inserted {{[1-9][0-9]*}} automatic merge regions
+// CHECK: open automatic merge:
+// CHECK: close merge:
+// CHECK: close merge:
+// CHECK: generated tests = 1{{$}}
+
+// The branch is too large to become a merge region.
+// CHECK-SMALL: generated tests = 2{{$}}
+
+// Both sides of the branch leave the same values behind, so merging them
+// cannot make later queries harder and the states are always merged.
+
+#include "klee/klee.h"
+
+int main(int argc, char **args) {
+  int a;
+  int b = 0;
+
+  klee_make_symbolic(&a, sizeof(a), "a");
+
+  if (a > 10)
+    b = 1;
+  else
+    b = 1;
+
+  return b;
+}
@@ -0,0 +1,27 @@
+// REQUIRES: uclibc
+// RUN: %clang -emit-llvm -g -c -o %t.bc %s
+// RUN: rm -rf %t.klee-out %t.klee-out-libc
+// RUN: %klee --output-dir=%t.klee-out --auto-merge %t.bc > %t.log 2>&1
+// RUN: %klee --output-dir=%t.klee-out-libc --libc=uclibc --auto-merge %t.bc >> %t.log 2>&1
+// RUN: FileCheck %s < %t.log
+
+// Merge regions are only inserted into the program under test, so linking
+// the C library adds none.
+// CHECK: Inserted [[REGIONS:[0-9]+]] automatic merge regions
+// CHECK: Inserted [[REGIONS]] automatic merge regions
+
+#include "klee/klee.h"
+
+int main(int argc, char **args) {
+  int a;
+  int b = 0;
+
+  klee_make_symbolic(&a, sizeof(a), "a");
+
+  if (a > 10)
+    b = 1;
+  else
+    b = 2;
+
+  return b;
+}
@@ -0,0 +1,30 @@
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t.bc foo
+// RUN: %cc %s %libkleeruntest -Wl,-rpath %libkleeruntestdir -o %t_runner
+
+// Replay all tests at once in two replay servers, with the stored arguments
+// RUN: %klee-replay --batch -j 2 --report=%t.report %t_runner %t.klee-out/*.ktest 2>&1 | FileCheck %s
+// RUN: FileCheck -check-prefix=REPORT %s < %t.report
+
+#include "klee/klee.h"
+#include <stdlib.h>
+
+int main(int argc, char **argv) {
+  int x;
+  klee_make_symbolic(&x, sizeof(x), "x");
+
+  if (x == 1)
+    abort();
+  if (x == 2)
+    return argc + 1;
+  return 0;
+}
+// CHECK-DAG: EXIT STATUS: CRASHED signal 6
+// CHECK-DAG: EXIT STATUS: ABNORMAL 3
+// CHECK: replayed 3 tests with 2 jobs
+// CHECK: EXIT STATUS SUMMARY: NORMAL 1, ABNORMAL 1, CRASHED 1, TIMED OUT 0
+
+// REPORT-DAG: test{{[0-9]+}}.ktest{{.}}NORMAL
+// REPORT-DAG: test{{[0-9]+}}.ktest{{.}}ABNORMAL 3
+// REPORT-DAG: test{{[0-9]+}}.ktest{{.}}CRASHED signal 6
@@ -0,0 +1,18 @@
+// REQUIRES: posix-runtime
+// RUN: %clang %s -emit-llvm -g %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --posix-runtime %t.bc --sym-arg 1
+// RUN: %cc %s %libkleeruntest -Wl,-rpath %libkleeruntestdir -o %t_runner
+
+// Arguments created by the POSIX runtime cannot be replayed in batch mode
+// RUN: not %klee-replay --batch %t_runner %t.klee-out/*.ktest 2>&1 | FileCheck %s
+
+#include "klee/klee.h"
+
+int main(int argc, char **argv) {
+  if (argc > 1 && argv[1][0] == 'a')
+    return 1;
+  return 0;
+}
+// CHECK: KLEE-REPLAY: ERROR: {{.*}}.ktest was generated with the POSIX runtime (--sym-arg)
+// CHECK-NOT: EXIT STATUS
@@ -0,0 +1,44 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out --libc=uclibc --posix-runtime --exit-on-error %t.bc --sym-files 1 5000
+// RUN: %ktest-tool %t.klee-out/test000001.ktest | FileCheck %s
+
+// A file larger than one chunk is made symbolic in two objects, and reads
+// and writes crossing the chunk boundary see one contiguous file.
+
+#include "klee/klee.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+  char buf[8];
+  int fd = open("A", O_RDWR);
+  assert(fd != -1);
+
+  assert(lseek(fd, 4092, SEEK_SET) == 4092);
+  assert(read(fd, buf, sizeof(buf)) == sizeof(buf));
+  assert(klee_is_symbolic(buf[0]) && klee_is_symbolic(buf[7]));
+
+  assert(lseek(fd, 4094, SEEK_SET) == 4094);
+  assert(write(fd, "abcd", 4) == 4);
+  assert(lseek(fd, 4092, SEEK_SET) == 4092);
+  assert(read(fd, buf, sizeof(buf)) == sizeof(buf));
+  assert(klee_is_symbolic(buf[1]) && klee_is_symbolic(buf[6]));
+  assert(memcmp(&buf[2], "abcd", 4) == 0);
+
+  // Reads stop at the end of the last, shorter chunk
+  assert(lseek(fd, 4996, SEEK_SET) == 4996);
+  assert(read(fd, buf, sizeof(buf)) == 4);
+
+  close(fd);
+  return 0;
+}
+
+// CHECK: name: {{b*}}'A_data'
+// CHECK-NEXT: size: 4096
+// CHECK: name: {{b*}}'A_data_1'
+// CHECK-NEXT: size: 904
+// CHECK: name: {{b*}}'A_data_stat'
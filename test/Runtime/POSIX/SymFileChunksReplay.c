@@ -0,0 +1,59 @@
+// Check that a symbolic file of two chunks is replayed and seeded in one
+// piece.
+//
+// RUN: %clang -DKLEE_EXECUTION %s -emit-llvm %O0opt -c -o %t.bc
+// RUN: rm -rf %t.klee-out %t.klee-out-seed
+// RUN: %klee --output-dir=%t.klee-out --libc=uclibc --posix-runtime %t.bc --sym-files 1 5000
+// RUN: %ktest-tool %t.klee-out/test000001.ktest | FileCheck --check-prefix=KTEST %s
+
+// RUN: %cc %s -O0 -o %t2
+// RUN: %klee-replay %t2 %t.klee-out/test000001.ktest | FileCheck --check-prefix=REPLAY %s
+
+// RUN: head -c 100 /dev/zero > %t.file
+// RUN: printf a >> %t.file
+// RUN: head -c 4399 /dev/zero >> %t.file
+// RUN: printf b >> %t.file
+// RUN: head -c 499 /dev/zero >> %t.file
+// RUN: %ktest-gen --bout-file %t.bout --sym-file %t.file
+// RUN: %ktest-tool %t.bout | FileCheck --check-prefix=KTEST %s
+// RUN: %klee --output-dir=%t.klee-out-seed --seed-file=%t.bout --only-seed --allow-seed-extension --libc=uclibc --posix-runtime %t.bc --sym-files 1 5000 > %t.seed.log 2>&1
+// RUN: FileCheck --check-prefix=SEED --input-file=%t.seed.log %s
+
+// KTEST: name: {{b*}}'A_data'
+// KTEST-NEXT: size: 4096
+// KTEST: name: {{b*}}'A_data_1'
+// KTEST-NEXT: size: 904
+// KTEST: name: {{b*}}'A_data_stat'
+
+// REPLAY: Yes
+
+// SEED: Yes
+// SEED: KLEE: done: completed paths = 1
+
+#ifdef KLEE_EXECUTION
+#include "klee/klee.h"
+#define EXIT klee_silent_exit
+#else
+#include <stdlib.h>
+#define EXIT exit
+#endif
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+  char buf[5000];
+  int fd = open("A", O_RDONLY);
+  assert(fd != -1);
+  assert(read(fd, buf, sizeof(buf)) == sizeof(buf));
+
+  /* Generate a single test, with one byte set in each chunk */
+  if (buf[100] == 'a' && buf[4500] == 'b')
+    printf("Yes\n");
+  else
+    EXIT(0);
+
+  return 0;
+}
@@ -0,0 +1,16 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out %t.klee-out-error
+// RUN: %klee --output-dir=%t.klee-out --max-solver-time=10s --adaptive-solver-time --adaptive-solver-time-samples=1 %t1.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'QueriesDeferred,QueriesRetried' --table-format=csv %t.klee-out | FileCheck --check-prefix=CHECK-STATS %s
+// RUN: not %klee --output-dir=%t.klee-out-error --adaptive-solver-time %t1.bc 2>&1 | FileCheck --check-prefix=CHECK-ERROR %s
+
+#include "ExerciseSolver.c.inc"
+
+// CHECK: KLEE: done: completed paths = 15
+// CHECK: KLEE: done: partially completed paths = 0
+
+// No query comes close to the minimum adaptive timeout
+// CHECK-STATS: QueriesDeferred,QueriesRetried
+// CHECK-STATS-NEXT: {{^0,0$}}
+
+// CHECK-ERROR: --adaptive-solver-time requires --max-solver-time
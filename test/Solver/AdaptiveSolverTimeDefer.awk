@@ -0,0 +1,8 @@
+# Sum the per-instruction counts in a run.istats file. Each event gets a
+# column after the two position columns, in the order of the "events:" line.
+/^events:/ {
+  for (i = 2; i <= NF; ++i)
+    if ($i == "I") insts = i + 1
+}
+/^[0-9]/ { sum += $insts }
+END { print "istats instructions = " sum }
@@ -0,0 +1,54 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out %t.klee-out-adaptive
+// RUN: %klee --output-dir=%t.klee-out --max-solver-time=10s %t1.bc > %t.log 2>&1
+// RUN: %klee --output-dir=%t.klee-out-adaptive --max-solver-time=10s --adaptive-solver-time --adaptive-solver-time-max=1ms --adaptive-solver-time-retry=0s %t1.bc >> %t.log 2>&1
+// RUN: awk -f %S/AdaptiveSolverTimeDefer.awk %t.klee-out/run.istats >> %t.log
+// RUN: awk -f %S/AdaptiveSolverTimeDefer.awk %t.klee-out-adaptive/run.istats >> %t.log
+// RUN: FileCheck --input-file=%t.log %s
+// RUN: %klee-stats --print-columns 'QueriesDeferred,QueriesRetried' --table-format=csv %t.klee-out-adaptive | FileCheck --check-prefix=CHECK-STATS %s
+
+// Capping the adaptive timeout at 1ms, below what the last branch takes the
+// solver, times its query out regardless of the times observed before. The
+// states are deferred, and complete once they retry with the full timeout.
+
+#include "klee/klee.h"
+
+volatile int path;
+
+int main(void) {
+  unsigned long long x, y;
+  unsigned char s;
+  klee_make_symbolic(&x, sizeof(x), "x");
+  klee_make_symbolic(&y, sizeof(y), "y");
+  klee_make_symbolic(&s, sizeof(s), "s");
+
+  if (s & 1)
+    path = 1;
+  else
+    path = 2;
+  if (s & 2)
+    path = 3;
+  else
+    path = 4;
+  if (s & 4)
+    path = 5;
+  else
+    path = 6;
+
+  if (x * y * x % 1000000007 == 123456789)
+    return 1;
+  return 0;
+}
+
+// Deferred instructions are counted once, in run.istats as well
+// CHECK: KLEE: done: total instructions = [[INSTRUCTIONS:[0-9]+]]
+// CHECK: KLEE: done: completed paths = 16
+// CHECK: KLEE: done: total instructions = [[INSTRUCTIONS]]
+// CHECK: KLEE: done: completed paths = 16
+// CHECK: KLEE: done: partially completed paths = 0
+// CHECK: istats instructions = [[INSTRUCTIONS]]
+// CHECK: istats instructions = [[INSTRUCTIONS]]
+
+// Every deferred query is retried
+// CHECK-STATS: QueriesDeferred,QueriesRetried
+// CHECK-STATS-NEXT: {{^}}[[DEFERRED:[1-9][0-9]*]],[[DEFERRED]]{{$}}
@@ -0,0 +1,17 @@
+// RUN: %clang %s -emit-llvm %O0opt -c -o %t1.bc
+// RUN: rm -rf %t.klee-out %t.klee-out-nocache
+// RUN: %klee --output-dir=%t.klee-out --use-state-model-cache %t1.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'StateModelHits' --table-format=csv %t.klee-out | FileCheck --check-prefix=CHECK-STATS %s
+// RUN: %klee --output-dir=%t.klee-out-nocache --use-state-model-cache=false %t1.bc 2>&1 | FileCheck %s
+// RUN: %klee-stats --print-columns 'StateModelHits' --table-format=csv %t.klee-out-nocache | FileCheck --check-prefix=CHECK-NOCACHE %s
+
+#include "ExerciseSolver.c.inc"
+
+// CHECK: KLEE: done: completed paths = 15
+// CHECK: KLEE: done: partially completed paths = 0
+
+// CHECK-STATS: StateModelHits
+// CHECK-STATS-NEXT: {{^[1-9][0-9]*$}}
+
+// CHECK-NOCACHE: StateModelHits
+// CHECK-NOCACHE-NEXT: {{^0$}}
@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "klee/Config/Version.h"
+#include "klee/Expr/ArrayCache.h"
 #include "klee/Expr/Constraints.h"
 #include "klee/Expr/Expr.h"
 #include "klee/Expr/ExprBuilder.h"
@@ -16,22 +17,32 @@
 #include "klee/Expr/ExprVisitor.h"
 #include "klee/Expr/Parser/Lexer.h"
 #include "klee/Expr/Parser/Parser.h"
+#include "klee/Expr/QueryLog.h"
 #include "klee/Solver/Common.h"
 #include "klee/Support/OptionCategories.h"
 #include "klee/Statistics/Statistics.h"
 #include "klee/Solver/Solver.h"
 #include "klee/Solver/SolverCmdLine.h"
 #include "klee/Solver/SolverImpl.h"
+#include "klee/Support/FileHandling.h"
 #include "klee/Support/PrintVersion.h"
+#include "klee/System/Time.h"
 
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/JSON.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/Signals.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
 #include <sys/stat.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <utility>
 
@@ -44,7 +55,7 @@ llvm::cl::opt<std::string> InputFile(llvm::cl::desc("<input query log>"),
                                      llvm::cl::Positional, llvm::cl::init("-"),
                                      llvm::cl::cat(klee::ExprCat));
 
-enum ToolActions { PrintTokens, PrintAST, PrintSMTLIBv2, Evaluate };
+enum ToolActions { PrintTokens, PrintAST, PrintSMTLIBv2, Evaluate, Bench };
 
 static llvm::cl::opt<ToolActions> ToolAction(
     llvm::cl::desc("Tool actions:"), llvm::cl::init(Evaluate),
@@ -55,9 +66,26 @@ static llvm::cl::opt<ToolActions> ToolAction(
                      clEnumValN(PrintAST, "print-ast",
                                 "Print parsed AST nodes from the input file."),
                      clEnumValN(Evaluate, "evaluate",
-                                "Evaluate parsed AST nodes from the input file.")),
+                                "Evaluate parsed AST nodes from the input file."),
+                     clEnumValN(Bench, "bench",
+                                "Replay the queries of the input file through "
+                                "the solver chain and report hit rates and "
+                                "timings.")),
     llvm::cl::cat(klee::SolvingCat));
 
+llvm::cl::opt<unsigned> BenchJobs(
+    "bench-jobs",
+    llvm::cl::desc("Number of worker processes that replay the queries in "
+                   "-bench mode, each taking a contiguous part of the input "
+                   "(default=1)"),
+    llvm::cl::init(1), llvm::cl::cat(klee::SolvingCat));
+
+llvm::cl::opt<std::string> BenchOutput(
+    "bench-output",
+    llvm::cl::desc("File to write the -bench report to, as JSON "
+                   "(default=stdout)"),
+    llvm::cl::init("-"), llvm::cl::cat(klee::SolvingCat));
+
 enum BuilderKinds {
   DefaultBuilder,
   ConstantFoldingBuilder,
@@ -180,6 +208,41 @@ static bool PrintInputAST(const char *Filename,
   return success;
 }
 
+static std::unique_ptr<Solver> createSolver() {
+  std::unique_ptr<Solver> coreSolver = klee::createCoreSolver(CoreSolverToUse);
+
+  if (CoreSolverToUse != DUMMY_SOLVER) {
+    const time::Span maxCoreSolverTime(MaxCoreSolverTime);
+    if (maxCoreSolverTime) {
+      coreSolver->setCoreSolverTimeout(maxCoreSolverTime);
+    }
+  }
+
+  return constructSolverChain(
+      std::move(coreSolver), getQueryLogPath(ALL_QUERIES_SMT2_FILE_NAME),
+      getQueryLogPath(SOLVER_QUERIES_SMT2_FILE_NAME),
+      getQueryLogPath(ALL_QUERIES_KQUERY_FILE_NAME),
+      getQueryLogPath(SOLVER_QUERIES_KQUERY_FILE_NAME),
+      getQueryLogPath(ALL_QUERIES_KQLOG_FILE_NAME),
+      getQueryLogPath(SOLVER_QUERIES_KQLOG_FILE_NAME));
+}
+
+static void printSolverStatistics() {
+  if (uint64_t queries = *theStatisticManager->getStatisticByName("SolverQueries")) {
+    llvm::outs()
+      << "--\n"
+      << "total queries = " << queries << '\n'
+      << "total query constructs = "
+      << *theStatisticManager->getStatisticByName("QueryConstructs") << '\n'
+      << "valid queries = " 
+      << *theStatisticManager->getStatisticByName("QueriesValid") << '\n'
+      << "invalid queries = " 
+      << *theStatisticManager->getStatisticByName("QueriesInvalid") << '\n'
+      << "query cex = " 
+      << *theStatisticManager->getStatisticByName("QueriesCEX") << '\n';
+  }
+}
+
 static bool EvaluateInputAST(const char *Filename,
                              const MemoryBuffer *MB,
                              ExprBuilder *Builder) {
@@ -199,20 +262,7 @@ static bool EvaluateInputAST(const char *Filename,
   if (!success)
     return false;
 
-  std::unique_ptr<Solver> coreSolver = klee::createCoreSolver(CoreSolverToUse);
-
-  if (CoreSolverToUse != DUMMY_SOLVER) {
-    const time::Span maxCoreSolverTime(MaxCoreSolverTime);
-    if (maxCoreSolverTime) {
-      coreSolver->setCoreSolverTimeout(maxCoreSolverTime);
-    }
-  }
-
-  std::unique_ptr<Solver> S = constructSolverChain(
-      std::move(coreSolver), getQueryLogPath(ALL_QUERIES_SMT2_FILE_NAME),
-      getQueryLogPath(SOLVER_QUERIES_SMT2_FILE_NAME),
-      getQueryLogPath(ALL_QUERIES_KQUERY_FILE_NAME),
-      getQueryLogPath(SOLVER_QUERIES_KQUERY_FILE_NAME));
+  std::unique_ptr<Solver> S = createSolver();
 
   unsigned Index = 0;
   for (std::vector<Decl*>::iterator it = Decls.begin(),
@@ -293,19 +343,7 @@ static bool EvaluateInputAST(const char *Filename,
     delete *it;
   delete P;
 
-  if (uint64_t queries = *theStatisticManager->getStatisticByName("SolverQueries")) {
-    llvm::outs()
-      << "--\n"
-      << "total queries = " << queries << '\n'
-      << "total query constructs = "
-      << *theStatisticManager->getStatisticByName("QueryConstructs") << '\n'
-      << "valid queries = " 
-      << *theStatisticManager->getStatisticByName("QueriesValid") << '\n'
-      << "invalid queries = " 
-      << *theStatisticManager->getStatisticByName("QueriesInvalid") << '\n'
-      << "query cex = " 
-      << *theStatisticManager->getStatisticByName("QueriesCEX") << '\n';
-  }
+  printSolverStatistics();
 
   return success;
 }
@@ -381,6 +419,527 @@ static bool printInputAsSMTLIBv2(const char *Filename,
 	return true;
 }
 
+/// Return true if \p path holds a binary query log (see QueryLog.h).
+static bool isBinaryQueryLog(const std::string &path) {
+  if (path == "-")
+    return false;
+  std::string error;
+  std::unique_ptr<InputStream> file = klee_open_input_file(path, error);
+  char magic[8];
+  long n = file ? file->read(magic, sizeof(magic)) : 0;
+  return n > 0 && QueryLogReader::hasMagic(magic, n);
+}
+
+/// Read the binary query log at \p path query by query, passing each to
+/// \p process along with its index.
+static bool processQueryLog(
+    const std::string &path, ExprBuilder *Builder,
+    const std::function<void(const LoggedQuery &, unsigned)> &process) {
+  std::string error;
+  std::unique_ptr<InputStream> file = klee_open_input_file(path, error);
+  if (!file) {
+    llvm::errs() << path << ": error: " << error << "\n";
+    return false;
+  }
+
+  ArrayCache arrayCache;
+  QueryLogReader reader(
+      [&file](char *buffer, size_t size) { return file->read(buffer, size); },
+      Builder, arrayCache);
+  LoggedQuery query;
+  unsigned index = 0;
+  if (reader.readHeader()) {
+    while (reader.next(query))
+      process(query, index++);
+  }
+  if (!reader.getError().empty()) {
+    llvm::errs() << path << ": error: " << reader.getError() << " (after "
+                 << index << " queries)\n";
+    return false;
+  }
+  return true;
+}
+
+static bool printQueryLogAsKQuery(const std::string &path,
+                                  ExprBuilder *Builder) {
+  return processQueryLog(path, Builder, [](const LoggedQuery &q,
+                                           unsigned index) {
+    llvm::outs() << "# Query " << index << "\n";
+    ConstraintSet constraints(q.constraints);
+    if (q.kind == LoggedQuery::Value) {
+      ExprPPrinter::printQuery(llvm::outs(), constraints,
+                               ConstantExpr::alloc(0, Expr::Bool), &q.expr,
+                               &q.expr + 1);
+    } else {
+      ExprPPrinter::printQuery(llvm::outs(), constraints, q.expr, nullptr,
+                               nullptr, q.objects.data(),
+                               q.objects.data() + q.objects.size());
+    }
+  });
+}
+
+static bool printQueryLogAsSMTLIBv2(const std::string &path,
+                                    ExprBuilder *Builder) {
+  ExprSMTLIBPrinter printer;
+  printer.setOutput(llvm::outs());
+  return processQueryLog(path, Builder, [&printer](const LoggedQuery &q,
+                                                   unsigned index) {
+    if (index != 0)
+      llvm::outs() << "\n";
+    llvm::outs() << ";SMTLIBv2 Query " << index << "\n";
+    ConstraintSet constraints(q.constraints);
+    Query query(constraints, q.expr);
+    printer.setQuery(query);
+    if (!q.objects.empty())
+      printer.setArrayValuesToGet(q.objects);
+    printer.generateOutput();
+  });
+}
+
+static bool evaluateQueryLog(const std::string &path, ExprBuilder *Builder) {
+  std::unique_ptr<Solver> S = createSolver();
+  auto printFailure = [&S]() {
+    llvm::outs() << "FAIL (reason: "
+                 << SolverImpl::getOperationStatusString(
+                        S->impl->getOperationStatusCode())
+                 << ")";
+  };
+
+  bool success = processQueryLog(path, Builder, [&](const LoggedQuery &q,
+                                                    unsigned index) {
+    llvm::outs() << "Query " << index << ":\t";
+    ConstraintSet constraints(q.constraints);
+    Query query(constraints, q.expr);
+    switch (q.kind) {
+    case LoggedQuery::Truth: {
+      bool result;
+      if (S->mustBeTrue(query, result))
+        llvm::outs() << (result ? "VALID" : "INVALID");
+      else
+        printFailure();
+      break;
+    }
+    case LoggedQuery::Validity: {
+      Solver::Validity result;
+      if (S->evaluate(query, result))
+        llvm::outs() << result;
+      else
+        printFailure();
+      break;
+    }
+    case LoggedQuery::Value: {
+      ref<ConstantExpr> result;
+      if (S->getValue(query, result))
+        llvm::outs() << "INVALID\n\tExpr 0:\t" << result;
+      else
+        printFailure();
+      break;
+    }
+    case LoggedQuery::InitialValues: {
+      std::vector<std::vector<unsigned char>> result;
+      bool hasSolution;
+      if (!S->getInitialValues(query, q.objects, result, hasSolution)) {
+        printFailure();
+      } else if (!hasSolution) {
+        llvm::outs() << "VALID (counterexample request ignored)";
+      } else {
+        llvm::outs() << "INVALID";
+        for (unsigned i = 0, e = result.size(); i != e; ++i) {
+          llvm::outs() << "\n\tArray " << i << ":\t" << q.objects[i]->name
+                       << "[";
+          for (unsigned j = 0; j != q.objects[i]->size; ++j) {
+            llvm::outs() << (unsigned)result[i][j];
+            if (j + 1 != q.objects[i]->size)
+              llvm::outs() << ", ";
+          }
+          llvm::outs() << "]";
+        }
+      }
+      break;
+    }
+    }
+    llvm::outs() << "\n";
+  });
+
+  printSolverStatistics();
+  return success;
+}
+
+using QueryFn = std::function<void(const LoggedQuery &, unsigned)>;
+
+/// Parse the kquery file \p path and pass each of its queries to \p process,
+/// in the same form in which processQueryLog passes logged queries.
+static bool processKQuery(const std::string &path, ExprBuilder *Builder,
+                          const QueryFn &process) {
+  auto MBResult = MemoryBuffer::getFileOrSTDIN(path);
+  if (!MBResult) {
+    llvm::errs() << path << ": error: " << MBResult.getError().message()
+                 << "\n";
+    return false;
+  }
+
+  std::vector<Decl *> Decls;
+  Parser *P = Parser::Create(path == "-" ? "<stdin>" : path, MBResult->get(),
+                             Builder, ClearArrayAfterQuery);
+  P->SetMaxErrors(20);
+  while (Decl *D = P->ParseTopLevelDecl())
+    Decls.push_back(D);
+
+  bool success = true;
+  if (unsigned N = P->GetNumErrors()) {
+    llvm::errs() << path << ": parse failure: " << N << " errors.\n";
+    success = false;
+  }
+
+  unsigned index = 0;
+  LoggedQuery query;
+  for (Decl *D : Decls) {
+    QueryCommand *QC = dyn_cast<QueryCommand>(D);
+    if (!success || !QC)
+      continue;
+    query.constraints = QC->Constraints;
+    query.objects = QC->Objects;
+    if (!QC->Values.empty()) {
+      query.kind = LoggedQuery::Value;
+      query.expr = QC->Values[0];
+    } else {
+      query.kind = QC->Objects.empty() ? LoggedQuery::Truth
+                                       : LoggedQuery::InitialValues;
+      query.expr = QC->Query;
+    }
+    process(query, index++);
+  }
+
+  for (Decl *D : Decls)
+    delete D;
+  delete P;
+  return success;
+}
+
+static bool processQueries(const std::string &path, ExprBuilder *Builder,
+                           const QueryFn &process) {
+  if (isBinaryQueryLog(path))
+    return processQueryLog(path, Builder, process);
+  return processKQuery(path, Builder, process);
+}
+
+namespace {
+/// The outcome of replaying one query in -bench mode. Workers pass these to
+/// the parent process as raw bytes.
+struct BenchResult {
+  unsigned index;
+  LoggedQuery::Kind kind;
+  bool success;
+  /// Whether the query got past all caches to the core solver.
+  bool reachedSolver;
+  /// Whether the result matches the logged one, or -1 if none was logged.
+  int agrees;
+  unsigned status;
+  uint64_t microseconds;
+  uint64_t loggedMicroseconds;
+};
+} // namespace
+
+/// Run \p q on \p S. Sets \p agrees as described for BenchResult.
+static bool replayQuery(Solver &S, const LoggedQuery &q, int &agrees) {
+  ConstraintSet constraints(q.constraints);
+  Query query(constraints, q.expr);
+  bool success = false, same = false;
+  switch (q.kind) {
+  case LoggedQuery::Truth: {
+    bool result;
+    success = S.mustBeTrue(query, result);
+    same = result == q.isValid;
+    break;
+  }
+  case LoggedQuery::Validity: {
+    Solver::Validity result;
+    success = S.evaluate(query, result);
+    same = result == q.validity;
+    break;
+  }
+  case LoggedQuery::Value: {
+    // Any model is a valid answer, so there is nothing to compare
+    ref<ConstantExpr> result;
+    agrees = -1;
+    return S.getValue(query, result);
+  }
+  case LoggedQuery::InitialValues: {
+    std::vector<std::vector<unsigned char>> result;
+    bool hasSolution;
+    success = S.getInitialValues(query, q.objects, result, hasSolution);
+    same = hasSolution == q.hasSolution;
+    break;
+  }
+  }
+  agrees = success && q.success ? same : -1;
+  return success;
+}
+
+/// Replay the queries with indices in [begin, end) through the solver chain
+/// configured on the command line.
+static bool runBench(const std::string &path, ExprBuilder *Builder,
+                     unsigned begin, unsigned end,
+                     std::vector<BenchResult> &results) {
+  std::unique_ptr<Solver> S = createSolver();
+  Statistic *solverQueries =
+      theStatisticManager->getStatisticByName("SolverQueries");
+
+  return processQueries(path, Builder, [&](const LoggedQuery &q,
+                                           unsigned index) {
+    if (index < begin || index >= end)
+      return;
+    BenchResult r;
+    r.index = index;
+    r.kind = q.kind;
+    r.loggedMicroseconds = q.elapsedMicroseconds;
+    uint64_t queriesBefore = solverQueries->getValue();
+    time::Point start = time::getWallTime();
+    r.success = replayQuery(*S, q, r.agrees);
+    r.microseconds = (time::getWallTime() - start).toMicroseconds();
+    r.reachedSolver = solverQueries->getValue() != queriesBefore;
+    r.status = S->impl->getOperationStatusCode();
+    results.push_back(r);
+  });
+}
+
+static std::vector<uint64_t> getStatisticValues() {
+  std::vector<uint64_t> values;
+  for (unsigned i = 0; i < theStatisticManager->getNumStatistics(); ++i)
+    values.push_back(theStatisticManager->getStatistic(i).getValue());
+  return values;
+}
+
+template <typename T>
+static void writeVector(FILE *f, const std::vector<T> &v) {
+  size_t size = v.size();
+  fwrite(&size, sizeof(size), 1, f);
+  fwrite(v.data(), sizeof(T), size, f);
+}
+
+template <typename T> static bool readVector(FILE *f, std::vector<T> &v) {
+  size_t size;
+  if (fread(&size, sizeof(size), 1, f) != 1)
+    return false;
+  v.resize(size);
+  return fread(v.data(), sizeof(T), size, f) == size;
+}
+
+/// Replay the queries on BenchJobs worker processes, each of which takes a
+/// contiguous range of the input, so that caches see the queries in their
+/// original order. Collects the results and the summed statistics.
+static bool runBenchWorkers(const std::string &path, ExprBuilder *Builder,
+                            std::vector<BenchResult> &results,
+                            std::vector<uint64_t> &statistics) {
+  unsigned numQueries = 0;
+  if (!processQueries(path, Builder,
+                      [&](const LoggedQuery &, unsigned) { ++numQueries; }))
+    return false;
+
+  std::vector<std::pair<pid_t, FILE *>> workers;
+  bool success = true;
+  llvm::outs().flush();
+  for (unsigned i = 0; i < BenchJobs; ++i) {
+    FILE *f = tmpfile();
+    pid_t pid = f ? fork() : -1;
+    if (pid < 0) {
+      llvm::errs() << "error: could not start worker: " << strerror(errno)
+                   << "\n";
+      if (f)
+        fclose(f);
+      success = false;
+      break;
+    }
+    if (pid == 0) {
+      std::vector<BenchResult> workerResults;
+      bool ok = runBench(path, Builder,
+                         (uint64_t)numQueries * i / BenchJobs,
+                         (uint64_t)numQueries * (i + 1) / BenchJobs,
+                         workerResults);
+      writeVector(f, workerResults);
+      writeVector(f, getStatisticValues());
+      ok = fflush(f) == 0 && ok;
+      _exit(ok ? 0 : 1);
+    }
+    workers.emplace_back(pid, f);
+  }
+
+  statistics.assign(theStatisticManager->getNumStatistics(), 0);
+  for (auto &worker : workers) {
+    int status;
+    std::vector<BenchResult> workerResults;
+    std::vector<uint64_t> workerStatistics;
+    // The file offset is shared with the worker, so only seek once it exited
+    if (waitpid(worker.first, &status, 0) < 0 || !WIFEXITED(status) ||
+        WEXITSTATUS(status) != 0 || fseek(worker.second, 0, SEEK_SET) != 0 ||
+        !readVector(worker.second, workerResults) ||
+        !readVector(worker.second, workerStatistics) ||
+        workerStatistics.size() != statistics.size()) {
+      llvm::errs() << "error: worker " << worker.first << " failed\n";
+      success = false;
+    }
+    fclose(worker.second);
+    results.insert(results.end(), workerResults.begin(), workerResults.end());
+    for (unsigned i = 0; i < workerStatistics.size(); ++i)
+      statistics[i] += workerStatistics[i];
+  }
+  return success;
+}
+
+static const char *getKindName(LoggedQuery::Kind kind) {
+  switch (kind) {
+  case LoggedQuery::Truth:
+    return "truth";
+  case LoggedQuery::Validity:
+    return "validity";
+  case LoggedQuery::Value:
+    return "value";
+  case LoggedQuery::InitialValues:
+    return "initial-values";
+  }
+  return "unknown";
+}
+
+/// Nearest-rank percentile of the sorted, non-empty \p values.
+static uint64_t percentile(const std::vector<uint64_t> &values, unsigned p) {
+  size_t rank = (values.size() * p + 99) / 100;
+  return values[rank ? rank - 1 : 0];
+}
+
+static void writeBenchReport(llvm::raw_ostream &os,
+                             const std::vector<BenchResult> &results,
+                             const std::vector<uint64_t> &statistics,
+                             time::Span wallTime) {
+  auto getStatistic = [&](const char *name) -> uint64_t {
+    int id = theStatisticManager->getStatisticID(name);
+    return id < 0 ? 0 : statistics[id];
+  };
+
+  std::vector<uint64_t> latencies;
+  uint64_t total = 0;
+  unsigned failures = 0, disagreements = 0, reachedSolver = 0;
+  for (const BenchResult &r : results) {
+    latencies.push_back(r.microseconds);
+    total += r.microseconds;
+    failures += !r.success;
+    disagreements += r.agrees == 0;
+    reachedSolver += r.reachedSolver;
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  llvm::json::OStream J(os, 2);
+  J.object([&] {
+    J.attribute("input", InputFile);
+    J.attribute("jobs", (int64_t)BenchJobs);
+    J.attribute("queries", (int64_t)results.size());
+    J.attribute("failures", (int64_t)failures);
+    J.attribute("disagreements", (int64_t)disagreements);
+    J.attribute("wall_time_us", (int64_t)wallTime.toMicroseconds());
+
+    // Layers that were not part of the chain see no lookups and are left out
+    J.attributeArray("layers", [&] {
+      const char *caches[][3] = {
+          {"branch-cache", "QueryCacheHits", "QueryCacheMisses"},
+          {"cex-cache", "QueryCexCacheHits", "QueryCexCacheMisses"}};
+      for (auto &cache : caches) {
+        uint64_t hits = getStatistic(cache[1]);
+        uint64_t misses = getStatistic(cache[2]);
+        if (hits + misses == 0)
+          continue;
+        J.object([&] {
+          J.attribute("name", cache[0]);
+          J.attribute("hits", (int64_t)hits);
+          J.attribute("misses", (int64_t)misses);
+          J.attribute("hit_rate", double(hits) / (hits + misses));
+        });
+      }
+      J.object([&] {
+        J.attribute("name", "core-solver");
+        J.attribute("queries", (int64_t)getStatistic("SolverQueries"));
+        J.attribute("reached_by", (int64_t)reachedSolver);
+        J.attribute("time_us", (int64_t)getStatistic("QueryTime"));
+      });
+    });
+
+    J.attributeObject("latency_us", [&] {
+      if (latencies.empty())
+        return;
+      J.attribute("total", (int64_t)total);
+      J.attribute("mean", double(total) / latencies.size());
+      J.attribute("min", (int64_t)latencies.front());
+      for (unsigned p : {50, 90, 99})
+        J.attribute("p" + std::to_string(p),
+                    (int64_t)percentile(latencies, p));
+      J.attribute("max", (int64_t)latencies.back());
+    });
+
+    J.attributeObject("statistics", [&] {
+      for (unsigned i = 0; i < statistics.size(); ++i)
+        if (statistics[i])
+          J.attribute(theStatisticManager->getStatistic(i).getName(),
+                      (int64_t)statistics[i]);
+    });
+
+    J.attributeArray("per_query", [&] {
+      for (const BenchResult &r : results) {
+        J.object([&] {
+          J.attribute("index", (int64_t)r.index);
+          J.attribute("kind", getKindName(r.kind));
+          J.attribute("time_us", (int64_t)r.microseconds);
+          J.attribute("logged_time_us", (int64_t)r.loggedMicroseconds);
+          J.attribute("solver", r.reachedSolver);
+          if (r.agrees >= 0)
+            J.attribute("agrees", r.agrees == 1);
+          if (!r.success)
+            J.attribute("failure",
+                        SolverImpl::getOperationStatusString(
+                            (SolverImpl::SolverRunStatus)r.status));
+        });
+      }
+    });
+  });
+  os << "\n";
+}
+
+/// Replay a query corpus (a .kquery file or a binary query log) through the
+/// solver chain configured on the command line, and report per-layer hit
+/// rates, latency percentiles and per-query timings as JSON.
+static bool benchQueries(const std::string &path, ExprBuilder *Builder) {
+  if (BenchJobs == 0) {
+    llvm::errs() << "error: -bench-jobs must be positive\n";
+    return false;
+  }
+  if (BenchJobs > 1 && path == "-") {
+    llvm::errs() << "error: -bench-jobs needs an input file, not stdin\n";
+    return false;
+  }
+
+  std::unique_ptr<llvm::raw_ostream> file;
+  if (BenchOutput != "-") {
+    std::string error;
+    file = klee_open_output_file(BenchOutput, error);
+    if (!file) {
+      llvm::errs() << BenchOutput << ": error: " << error << "\n";
+      return false;
+    }
+  }
+
+  std::vector<BenchResult> results;
+  std::vector<uint64_t> statistics;
+  time::Point start = time::getWallTime();
+  bool success;
+  if (BenchJobs == 1) {
+    success = runBench(path, Builder, 0, ~0u, results);
+    statistics = getStatisticValues();
+  } else {
+    success = runBenchWorkers(path, Builder, results, statistics);
+  }
+
+  writeBenchReport(file ? *file : llvm::outs(), results, statistics,
+                   time::getWallTime() - start);
+  return success;
+}
+
 int main(int argc, char **argv) {
   KCommandLine::KeepOnlyCategories({&ExprCat, &SolvingCat});
 
@@ -391,15 +950,7 @@ int main(int argc, char **argv) {
   llvm::cl::ParseCommandLineOptions(argc, argv);
 
   std::string ErrorStr;
-  
-  auto MBResult = MemoryBuffer::getFileOrSTDIN(InputFile.c_str());
-  if (!MBResult) {
-    llvm::errs() << argv[0] << ": error: " << MBResult.getError().message()
-                 << "\n";
-    return 1;
-  }
-  std::unique_ptr<MemoryBuffer> &MB = *MBResult;
-  
+
   ExprBuilder *Builder = 0;
   switch (BuilderKind) {
   case DefaultBuilder:
@@ -416,23 +967,52 @@ int main(int argc, char **argv) {
     break;
   }
 
-  switch (ToolAction) {
-  case PrintTokens:
-    PrintInputTokens(MB.get());
-    break;
-  case PrintAST:
-    success = PrintInputAST(InputFile=="-" ? "<stdin>" : InputFile.c_str(), MB.get(),
-                            Builder);
-    break;
-  case Evaluate:
-    success = EvaluateInputAST(InputFile=="-" ? "<stdin>" : InputFile.c_str(),
-                               MB.get(), Builder);
-    break;
-  case PrintSMTLIBv2:
-    success = printInputAsSMTLIBv2(InputFile=="-"? "<stdin>" : InputFile.c_str(), MB.get(),Builder);
-    break;
-  default:
-    llvm::errs() << argv[0] << ": error: Unknown program action!\n";
+  if (ToolAction == Bench) {
+    success = benchQueries(InputFile, Builder);
+  } else if (isBinaryQueryLog(InputFile)) {
+    // Binary logs are streamed rather than loaded into memory at once
+    switch (ToolAction) {
+    case PrintAST:
+      success = printQueryLogAsKQuery(InputFile, Builder);
+      break;
+    case Evaluate:
+      success = evaluateQueryLog(InputFile, Builder);
+      break;
+    case PrintSMTLIBv2:
+      success = printQueryLogAsSMTLIBv2(InputFile, Builder);
+      break;
+    default:
+      llvm::errs() << argv[0]
+                   << ": error: Cannot tokenize a binary query log!\n";
+      success = false;
+    }
+  } else {
+    auto MBResult = MemoryBuffer::getFileOrSTDIN(InputFile.c_str());
+    if (!MBResult) {
+      llvm::errs() << argv[0] << ": error: " << MBResult.getError().message()
+                   << "\n";
+      return 1;
+    }
+    std::unique_ptr<MemoryBuffer> &MB = *MBResult;
+
+    switch (ToolAction) {
+    case PrintTokens:
+      PrintInputTokens(MB.get());
+      break;
+    case PrintAST:
+      success = PrintInputAST(InputFile=="-" ? "<stdin>" : InputFile.c_str(), MB.get(),
+                              Builder);
+      break;
+    case Evaluate:
+      success = EvaluateInputAST(InputFile=="-" ? "<stdin>" : InputFile.c_str(),
+                                 MB.get(), Builder);
+      break;
+    case PrintSMTLIBv2:
+      success = printInputAsSMTLIBv2(InputFile=="-"? "<stdin>" : InputFile.c_str(), MB.get(),Builder);
+      break;
+    default:
+      llvm::errs() << argv[0] << ": error: Unknown program action!\n";
+    }
   }
 
   delete Builder;
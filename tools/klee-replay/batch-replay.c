@@ -0,0 +1,312 @@
+//===-- batch-replay.c ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Replays many .ktest files against a program linked with libkleeRuntest.
+// Instead of executing the program once per test, a few replay servers are
+// started (see runtime/Runtest/intrinsics.c), which stop before main and fork
+// a child per test. Tests are handed to whichever server is idle, and the
+// results of all of them are summarized in one report.
+//
+// A server runs the program with the arguments stored in the test it was
+// started for, and is restarted for a test with different arguments. Tests
+// generated with the POSIX runtime, whose arguments and files are created by
+// klee_init_env, are rejected.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee-replay.h"
+
+#include "klee/ADT/KTest.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+enum test_result { RESULT_NORMAL, RESULT_ABNORMAL, RESULT_CRASHED,
+                   RESULT_TIMEOUT, NUM_RESULTS };
+
+static const char *result_names[NUM_RESULTS] = {"NORMAL", "ABNORMAL",
+                                                "CRASHED", "TIMED OUT"};
+
+struct replay_server {
+  pid_t pid;
+  /* The arguments the program was started with. */
+  char **argv;
+  FILE *requests;
+  FILE *responses;
+  /* Index of the test being replayed, or -1 if idle. */
+  int test;
+};
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Options klee_init_env interprets, see runtime/POSIX/klee_init_env.c */
+static const char *posix_options[] = {
+    "sym-arg", "sym-args", "sym-files", "sym-stdin", "sym-stdout",
+    "save-all-writes", "fd-fail", "bout-file", "max-fail", NULL};
+
+static const char *get_posix_option(const KTest *test) {
+  for (unsigned i = 1; i < test->numArgs; ++i) {
+    const char *arg = test->args[i];
+    if (arg[0] != '-')
+      continue;
+    arg += arg[1] == '-' ? 2 : 1;
+    for (const char **option = posix_options; *option; ++option)
+      if (!strcmp(arg, *option))
+        return test->args[i];
+  }
+  return NULL;
+}
+
+/* Return the program arguments stored in the test at path, with executable as
+   the program name. */
+static char **load_arguments(const char *executable, const char *path) {
+  KTest *test = kTest_fromFile(path);
+  if (!test) {
+    fprintf(stderr, "KLEE-REPLAY: ERROR: input file %s not valid.\n", path);
+    exit(1);
+  }
+  const char *option = get_posix_option(test);
+  if (option) {
+    fprintf(stderr, "KLEE-REPLAY: ERROR: %s was generated with the POSIX "
+                    "runtime (%s), which --batch cannot replay; replay it "
+                    "without --batch.\n", path, option);
+    exit(1);
+  }
+
+  unsigned argc = test->numArgs ? test->numArgs : 1;
+  char **argv = calloc(argc + 1, sizeof(*argv));
+  argv[0] = strdup(executable);
+  for (unsigned i = 1; i < argc; ++i)
+    argv[i] = strdup(test->args[i]);
+  kTest_free(test);
+  return argv;
+}
+
+static int same_arguments(char **a, char **b) {
+  for (; *a && *b; ++a, ++b)
+    if (strcmp(*a, *b))
+      return 0;
+  return !*a && !*b;
+}
+
+static void start_server(struct replay_server *server,
+                         const char *executable, char **argv) {
+  int requests[2], responses[2];
+  if (pipe(requests) || pipe(responses)) {
+    perror("pipe");
+    exit(1);
+  }
+  /* Later servers must not hold this one's pipes open, or it never sees EOF */
+  fcntl(requests[1], F_SETFD, FD_CLOEXEC);
+  fcntl(responses[0], F_SETFD, FD_CLOEXEC);
+
+  server->pid = fork();
+  if (server->pid < 0) {
+    perror("fork");
+    exit(1);
+  }
+  if (server->pid == 0) {
+    close(requests[1]);
+    close(responses[0]);
+    char fds[32];
+    snprintf(fds, sizeof(fds), "%d,%d", requests[0], responses[1]);
+    setenv("KLEE_REPLAY_SERVER_FDS", fds, 1);
+
+    /* The tests' output would interleave */
+    int null = open("/dev/null", O_RDWR);
+    if (null >= 0) {
+      dup2(null, 0);
+      dup2(null, 1);
+    }
+
+    /* klee-replay ignores SIGPIPE, the program should not */
+    signal(SIGPIPE, SIG_DFL);
+    execv(executable, argv);
+    perror("execv");
+    _exit(66);
+  }
+
+  close(requests[0]);
+  close(responses[1]);
+  server->argv = argv;
+  server->requests = fdopen(requests[1], "w");
+  server->responses = fdopen(responses[0], "r");
+  server->test = -1;
+
+  char line[64];
+  if (!fgets(line, sizeof(line), server->responses) ||
+      strcmp(line, "KTEST-SERVER 1\n") != 0) {
+    fprintf(stderr, "KLEE-REPLAY: ERROR: %s did not start a replay server, "
+                    "is it linked with libkleeRuntest?\n", executable);
+    exit(1);
+  }
+}
+
+static void stop_server(struct replay_server *server) {
+  int status;
+  fclose(server->requests);
+  fclose(server->responses);
+  while (waitpid(server->pid, &status, 0) < 0 && errno == EINTR)
+    ;
+}
+
+static void send_test(struct replay_server *server, const char *executable,
+                      char **ktests, char ***arguments, int test) {
+  if (!server->argv) {
+    start_server(server, executable, arguments[test]);
+  } else if (!same_arguments(server->argv, arguments[test])) {
+    stop_server(server);
+    start_server(server, executable, arguments[test]);
+  }
+
+  server->test = test;
+  fprintf(server->requests, "%s\n", ktests[test]);
+  if (fflush(server->requests)) {
+    fprintf(stderr, "KLEE-REPLAY: ERROR: replay server died before "
+                    "replaying %s\n", ktests[test]);
+    exit(1);
+  }
+}
+
+int replay_batch(const char *executable, char **ktests, int num_tests,
+                 int jobs, const char *report_file) {
+  FILE *report = NULL;
+  if (report_file && !(report = fopen(report_file, "w"))) {
+    perror(report_file);
+    exit(1);
+  }
+
+  if (jobs > num_tests)
+    jobs = num_tests;
+  if (jobs < 1)
+    jobs = 1;
+
+  /* A server exiting early must not take klee-replay with it */
+  signal(SIGPIPE, SIG_IGN);
+
+  /* Tests the servers cannot replay are rejected before any test runs */
+  char ***arguments = calloc(num_tests, sizeof(*arguments));
+  for (int i = 0; i != num_tests; ++i)
+    arguments[i] = load_arguments(executable, ktests[i]);
+
+  double start = now();
+  struct replay_server *servers = calloc(jobs, sizeof(*servers));
+  struct pollfd *pollfds = calloc(jobs, sizeof(*pollfds));
+  int next = 0, busy = 0;
+  for (int i = 0; i != jobs; ++i) {
+    send_test(&servers[i], executable, ktests, arguments, next++);
+    ++busy;
+  }
+
+  unsigned counts[NUM_RESULTS] = {0};
+  double total = 0, slowest = -1;
+  int slowest_test = -1;
+  while (busy) {
+    for (int i = 0; i != jobs; ++i) {
+      pollfds[i].fd = servers[i].test >= 0 ? fileno(servers[i].responses) : -1;
+      pollfds[i].events = POLLIN;
+    }
+    if (poll(pollfds, jobs, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      perror("poll");
+      exit(1);
+    }
+
+    for (int i = 0; i != jobs; ++i) {
+      if (!pollfds[i].revents)
+        continue;
+      struct replay_server *server = &servers[i];
+      const char *test = ktests[server->test];
+
+      char line[128];
+      int status, timed_out;
+      long long usec;
+      if (!fgets(line, sizeof(line), server->responses) ||
+          sscanf(line, "%d %lld %d", &status, &usec, &timed_out) != 3) {
+        fprintf(stderr, "KLEE-REPLAY: ERROR: replay server died while "
+                        "replaying %s\n", test);
+        exit(1);
+      }
+
+      enum test_result result;
+      char detail[64] = "";
+      if (timed_out) {
+        result = RESULT_TIMEOUT;
+      } else if (WIFSIGNALED(status)) {
+        result = RESULT_CRASHED;
+        snprintf(detail, sizeof(detail), " signal %d", WTERMSIG(status));
+      } else if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+        result = RESULT_ABNORMAL;
+        snprintf(detail, sizeof(detail), " %d", WEXITSTATUS(status));
+      } else {
+        result = RESULT_NORMAL;
+      }
+
+      double seconds = usec / 1e6;
+      ++counts[result];
+      total += seconds;
+      if (seconds > slowest) {
+        slowest = seconds;
+        slowest_test = server->test;
+      }
+      if (result != RESULT_NORMAL)
+        fprintf(stderr, "KLEE-REPLAY: NOTE: %s: EXIT STATUS: %s%s (%.3f "
+                        "seconds)\n", test, result_names[result], detail,
+                seconds);
+      if (report)
+        fprintf(report, "%s\t%s%s\t%.6f\n", test, result_names[result],
+                detail, seconds);
+
+      if (next < num_tests) {
+        send_test(server, executable, ktests, arguments, next++);
+      } else {
+        server->test = -1;
+        --busy;
+      }
+    }
+  }
+
+  for (int i = 0; i != jobs; ++i)
+    stop_server(&servers[i]);
+  for (int i = 0; i != num_tests; ++i) {
+    for (char **arg = arguments[i]; *arg; ++arg)
+      free(*arg);
+    free(arguments[i]);
+  }
+  free(arguments);
+  free(servers);
+  free(pollfds);
+  if (report)
+    fclose(report);
+
+  fprintf(stderr, "KLEE-REPLAY: NOTE: replayed %d tests with %d jobs in "
+                  "%.2f seconds (%.2f seconds in tests)\n",
+          num_tests, jobs, now() - start, total);
+  fputs("KLEE-REPLAY: NOTE: EXIT STATUS SUMMARY:", stderr);
+  for (int r = 0; r != NUM_RESULTS; ++r)
+    fprintf(stderr, " %s %u%s", result_names[r], counts[r],
+            r + 1 != NUM_RESULTS ? "," : "\n");
+  if (slowest_test >= 0)
+    fprintf(stderr, "KLEE-REPLAY: NOTE: slowest test: %s (%.3f seconds)\n",
+            ktests[slowest_test], slowest);
+  return 0;
+}
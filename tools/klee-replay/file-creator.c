@@ -41,6 +41,23 @@ static void create_file(int target_fd,
 static void check_file(int index, exe_disk_file_t *dfile);
 
 
+/* Joins the chunks of dfile into a newly allocated buffer. */
+static char *get_contents(exe_disk_file_t *dfile) {
+  char *contents = malloc(dfile->size);
+  if (!contents) {
+    fputs("KLEE-REPLAY: ERROR: out of memory\n", stderr);
+    exit(1);
+  }
+  unsigned pos;
+  for (pos = 0; pos < dfile->size; pos += KLEE_SYM_FILE_CHUNK_SIZE) {
+    unsigned n = dfile->size - pos;
+    if (n > KLEE_SYM_FILE_CHUNK_SIZE)
+      n = KLEE_SYM_FILE_CHUNK_SIZE;
+    memcpy(&contents[pos], dfile->chunks[pos / KLEE_SYM_FILE_CHUNK_SIZE], n);
+  }
+  return contents;
+}
+
 #define __STDIN (-1)
 #define __STDOUT (-2)
 
@@ -107,7 +124,7 @@ static int create_char_dev(const char *fname, exe_disk_file_t *dfile,
                            const char *tmpdir) {
   struct stat64 *s = dfile->stat;
   unsigned flen = dfile->size;
-  char* contents = dfile->contents;
+  char* contents = get_contents(dfile);
 
   // Assume tty, kinda broken, need an actual device id or something
   struct termios term, *ts=&term;
@@ -163,6 +180,7 @@ static int create_char_dev(const char *fname, exe_disk_file_t *dfile,
       perror("fork failed\n");
       exit(1);
     } else if (pid == 0) {
+      free(contents);
       close(amaster);
 
       fputs("KLEE-REPLAY: NOTE: pty slave: setting raw mode\n", stderr);
@@ -206,6 +224,7 @@ static int create_char_dev(const char *fname, exe_disk_file_t *dfile,
           pos += res;
         }
       }
+      free(contents);
 
       if (wait_for_timeout_or_exit(pid, "pty master", &status))
         goto pty_exit;
@@ -234,7 +253,7 @@ static int create_pipe(const char *fname, exe_disk_file_t *dfile,
                        const char *tmpdir) {
   //struct stat64 *s = dfile->stat;
   unsigned flen = dfile->size;
-  char* contents = dfile->contents;
+  char* contents = get_contents(dfile);
 
   // XXX what is direction ? need more data
   pid_t pid;
@@ -250,6 +269,7 @@ static int create_pipe(const char *fname, exe_disk_file_t *dfile,
     perror("fork");
     exit(1);
   } else if (pid == 0) {
+    free(contents);
     close(fds[1]);
     return fds[0];
   } else {
@@ -267,6 +287,7 @@ static int create_pipe(const char *fname, exe_disk_file_t *dfile,
         pos += res;
       }
     }
+    free(contents);
 
     if (wait_for_timeout_or_exit(pid, "pipe master", &status))
       goto pipe_exit;
@@ -294,7 +315,7 @@ int futimes(int fd, const struct timeval tv[2]);
 static int create_reg_file(const char *fname, exe_disk_file_t *dfile,
                            const char *tmpdir) {
   struct stat64 *s = dfile->stat;
-  char* contents = dfile->contents;
+  char* contents = get_contents(dfile);
   unsigned flen = dfile->size;
   unsigned mode = s->st_mode & 0777;
 
@@ -312,6 +333,7 @@ static int create_reg_file(const char *fname, exe_disk_file_t *dfile,
   }
 
   ssize_t r = write(fd, contents, flen);
+  free(contents);
   if (r < 0 || (unsigned) r != flen) {
     fprintf(stderr, "KLEE-REPLAY: ERROR: Cannot write file %s\n", fname);
     exit(1);
@@ -57,6 +57,9 @@ static struct option long_options[] = {
   {"chroot-to-dir", required_argument, 0, 'r'},
   {"help", no_argument, 0, 'h'},
   {"keep-replay-dir", no_argument, 0, 'k'},
+  {"batch", no_argument, 0, 'b'},
+  {"jobs", required_argument, 0, 'j'},
+  {"report", required_argument, 0, 'o'},
   {0, 0, 0, 0},
 };
 
@@ -274,6 +277,14 @@ static void usage(void) {
     "\n"
     "-r, --chroot-to-dir=DIR  use chroot jail, requires CAP_SYS_CHROOT\n"
     "-k, --keep-replay-dir    do not delete replay directory\n"
+    "-b, --batch              replay all tests in persistent replay servers;\n"
+    "                         the executable has to be linked with\n"
+    "                         libkleeRuntest, tests generated with the POSIX\n"
+    "                         runtime are not supported\n"
+    "-j, --jobs=N             number of replay servers in batch mode\n"
+    "                         (default: number of CPUs)\n"
+    "    --report=FILE        write the result of every test to FILE in\n"
+    "                         batch mode\n"
     "-h, --help               display this help and exit\n"
     "\n"
     "Use KLEE_REPLAY_TIMEOUT environment variable to set a timeout (in seconds).\n",
@@ -283,6 +294,9 @@ static void usage(void) {
 
 
 int keep_temps = 0;
+static int batch = 0;
+static int jobs = 0;
+static const char *report_file = NULL;
 
 int main(int argc, char** argv) {
   int prg_argc;
@@ -294,7 +308,7 @@ int main(int argc, char** argv) {
     usage();
 
   int c, opt_index;
-  while ((c = getopt_long(argc, argv, "f:r:k", long_options, &opt_index)) != -1) {
+  while ((c = getopt_long(argc, argv, "f:r:kbj:", long_options, &opt_index)) != -1) {
     switch (c) {
     case 'f': {
       /* Special case hack for only creating files and not actually executing
@@ -328,6 +342,23 @@ int main(int argc, char** argv) {
     case 'k':
       keep_temps = 1;
       break;
+
+    case 'b':
+      batch = 1;
+      break;
+
+    case 'j':
+      jobs = atoi(optarg);
+      if (jobs < 1) {
+        fprintf(stderr, "KLEE-REPLAY: ERROR: invalid number of jobs (%s)\n",
+                optarg);
+        exit(1);
+      }
+      break;
+
+    case 'o':
+      report_file = optarg;
+      break;
     }
   }
 
@@ -340,6 +371,21 @@ int main(int argc, char** argv) {
     perror(executable);
     exit(1);
   }
+
+  if (batch) {
+    if (optind + 1 >= argc)
+      usage();
+    if (rootdir) {
+      fputs("KLEE-REPLAY: ERROR: --batch cannot be combined with "
+            "--chroot-to-dir.\n", stderr);
+      exit(1);
+    }
+    if (!jobs)
+      jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    return replay_batch(executable, argv + optind + 1, argc - optind - 1,
+                        jobs, report_file);
+  }
+
   /* Normal execution path ... */
 
   /* make sure this process has the CAP_SYS_CHROOT capability, if possible. */
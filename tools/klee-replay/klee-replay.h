@@ -25,6 +25,10 @@ extern int keep_temps;
 void replay_create_files(exe_file_system_t *exe_fs);
 void replay_delete_files();
 
+// replay the given tests in batch mode (see batch-replay.c)
+int replay_batch(const char *executable, char **ktests, int num_tests,
+                 int jobs, const char *report_file);
+
 void process_status(int status,
 		    time_t elapsed,
 		    const char *pfx)
@@ -27,6 +27,7 @@
 #include "klee/Support/CompilerWarning.h"
 DISABLE_WARNING_PUSH
 DISABLE_WARNING_DEPRECATED_DECLARATIONS
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Bitcode/BitcodeReader.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/IRBuilder.h"
@@ -34,6 +35,7 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Type.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Errno.h"
@@ -46,6 +48,7 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/SHA1.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "llvm/Support/Signals.h"
@@ -53,16 +56,20 @@ DISABLE_WARNING_DEPRECATED_DECLARATIONS
 DISABLE_WARNING_POP
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <signal.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <ctime>
 #include <fstream>
 #include <iomanip>
+#include <iostream>
 #include <iterator>
+#include <set>
 #include <sstream>
 
 using namespace llvm;
@@ -162,6 +169,32 @@ namespace {
 		 cl::init(false),
                  cl::cat(StartCat));
 
+  cl::opt<bool>
+  ForkServer("fork-server",
+             cl::desc("Prepare the module and run until --fork-server-at is "
+                      "entered once, then fork a new run from there for every "
+                      "line read from standard input. Each line lists options "
+                      "(e.g. --output-dir, --seed-file, --search, --max-time) "
+                      "that replace their values for that run (default=false)"),
+             cl::init(false),
+             cl::cat(StartCat));
+
+  cl::opt<std::string>
+  ForkServerAt("fork-server-at",
+               cl::desc("Function whose entry is the snapshot point of "
+                        "--fork-server (default=main)"),
+               cl::init("main"),
+               cl::cat(StartCat));
+
+  cl::opt<std::string>
+  ModuleCacheDir("module-cache-dir",
+                 cl::desc("Keep the linked and prepared module in the given "
+                          "directory and reuse it for runs with the same "
+                          "program, runtime libraries and module options "
+                          "(default=off)"),
+                 cl::value_desc("directory"),
+                 cl::cat(StartCat));
+
   cl::opt<bool>
   WarnAllExternals("warn-all-external-symbols",
                    cl::desc("Issue a warning on startup for all external symbols (default=false)."),
@@ -341,6 +374,12 @@ private:
   int m_argc;
   char **m_argv;
 
+  // seeds of a run forked from a snapshot
+  std::vector<KTest *> m_seeds;
+
+  void createOutputDirectory();
+  void applyForkServerRequest(const std::vector<std::string> &args);
+
 public:
   KleeHandler(int argc, char **argv);
   ~KleeHandler();
@@ -359,6 +398,7 @@ public:
   void processTestCase(const ExecutionState  &state,
                        const char *errorMessage,
                        const char *errorSuffix);
+  bool snapshotReached();
   bool writeTestCaseKTest(
       const std::vector<std::pair<std::string, std::vector<unsigned char>>>
           &out,
@@ -381,6 +421,8 @@ public:
   static void getKTestFilesInDir(std::string directoryPath,
                                  std::vector<std::string> &results);
 
+  static void loadSeeds(std::vector<KTest *> &seeds);
+
   static std::string getRunTimeLibraryPath(const char *argv0);
 };
 
@@ -388,7 +430,10 @@ KleeHandler::KleeHandler(int argc, char **argv)
     : m_interpreter(0), m_pathWriter(0), m_symPathWriter(0),
       m_outputDirectory(), m_numTotalTests(0), m_numGeneratedTests(0),
       m_pathsCompleted(0), m_pathsExplored(0), m_argc(argc), m_argv(argv) {
+  createOutputDirectory();
+}
 
+void KleeHandler::createOutputDirectory() {
   // create output directory (OutputDir or "klee-out-<i>")
   bool dir_given = OutputDir != "";
   SmallString<128> directory(dir_given ? OutputDir : InputFile);
@@ -465,6 +510,139 @@ KleeHandler::~KleeHandler() {
   delete m_symPathWriter;
   fclose(klee_warning_file);
   fclose(klee_message_file);
+  for (KTest *seed : m_seeds)
+    kTest_free(seed);
+}
+
+/// Return whether \p option took effect while the module and the interpreter
+/// were set up, before the fork server took its snapshot.
+static bool isSnapshotOption(const cl::Option &option) {
+  if (&option == &OutputDir)
+    return false;
+  if (option.ArgStr == "timer-interval")
+    return true;
+  static const StringRef categories[] = {"Startup options",
+                                         "Linking options",
+                                         "Checks options",
+                                         "Module-related options",
+                                         "Memory management options",
+                                         "Constraint solving options",
+                                         "Execution tree related options",
+                                         "Statistics options",
+                                         "Replaying options"};
+  for (const cl::OptionCategory *category : option.Categories)
+    for (StringRef name : categories)
+      if (category->getName() == name)
+        return true;
+  return false;
+}
+
+/// Replace the values of the options named in \p args, given as on the
+/// command line, and start over in a new output directory.
+void KleeHandler::applyForkServerRequest(const std::vector<std::string> &args) {
+  StringMap<cl::Option *> &options = cl::getRegisteredOptions();
+  std::set<cl::Option *> replaced;
+  for (unsigned i = 0; i < args.size(); ++i) {
+    StringRef arg = args[i];
+    if (!arg.consume_front("-"))
+      klee_error("fork server: expected an option, got '%s'", args[i].c_str());
+    arg.consume_front("-");
+    StringRef name, value;
+    std::tie(name, value) = arg.split('=');
+    auto it = options.find(name);
+    if (it == options.end())
+      klee_error("fork server: unknown option '%s'", args[i].c_str());
+    cl::Option *option = it->second;
+    if (isSnapshotOption(*option))
+      klee_error("fork server: option '%s' cannot be changed after the "
+                 "snapshot", args[i].c_str());
+    if (replaced.insert(option).second)
+      option->reset();
+    if (!arg.contains('=') &&
+        option->getValueExpectedFlag() == cl::ValueRequired) {
+      if (i + 1 == args.size())
+        klee_error("fork server: option '%s' requires a value",
+                   args[i].c_str());
+      value = args[++i];
+    }
+
+    SmallVector<StringRef, 4> values;
+    if (option->getMiscFlags() & cl::CommaSeparated)
+      value.split(values, ',');
+    else
+      values.push_back(value);
+    for (unsigned j = 0; j < values.size(); ++j)
+      if (option->addOccurrence(i, name, values[j], j > 0))
+        klee_error("fork server: invalid option '%s'", args[i].c_str());
+  }
+
+  // Messages until the new files are open only go to the console
+  fclose(klee_warning_file);
+  fclose(klee_message_file);
+  klee_warning_file = klee_message_file = nullptr;
+  m_numTotalTests = m_numGeneratedTests = 0;
+  m_pathsCompleted = m_pathsExplored = 0;
+  createOutputDirectory();
+
+  for (KTest *seed : m_seeds)
+    kTest_free(seed);
+  m_seeds.clear();
+  loadSeeds(m_seeds);
+  if (!m_seeds.empty())
+    klee_message("KLEE: using %zu seeds\n", m_seeds.size());
+  m_interpreter->useSeeds(m_seeds.empty() ? nullptr : &m_seeds);
+}
+
+bool KleeHandler::snapshotReached() {
+  if (!ForkServer)
+    return true;
+
+  klee_message("fork server ready, reading runs from standard input");
+  std::string line;
+  for (unsigned run = 1; std::getline(std::cin, line); ++run) {
+    std::istringstream ss(line);
+    std::vector<std::string> args{std::istream_iterator<std::string>(ss),
+                                  std::istream_iterator<std::string>()};
+
+    // Anything still buffered would otherwise be written by both processes.
+    m_infoFile->flush();
+    fflush(klee_warning_file);
+    fflush(klee_message_file);
+    llvm::outs().flush();
+    llvm::errs().flush();
+
+    pid_t pid = fork();
+    if (pid < 0)
+      klee_error("fork server: unable to fork: %s", strerror(errno));
+    if (pid == 0) {
+      // Exiting would otherwise move the parent's position in the requests
+      // back to where the buffered input of the child ends.
+      int devNull = open("/dev/null", O_RDONLY);
+      if (devNull < 0 || dup2(devNull, STDIN_FILENO) < 0)
+        klee_error("fork server: unable to detach standard input: %s",
+                   strerror(errno));
+      close(devNull);
+      applyForkServerRequest(args);
+      *m_infoFile << "Fork server run " << run << ":";
+      for (const auto &arg : args)
+        *m_infoFile << ' ' << arg;
+      *m_infoFile << "\nPID: " << getpid() << "\n";
+      return true;
+    }
+
+    int status;
+    while (waitpid(pid, &status, 0) < 0)
+      if (errno != EINTR)
+        klee_error("fork server: waitpid failed: %s", strerror(errno));
+    if (WIFEXITED(status))
+      llvm::outs() << "KLEE: fork server: run " << run << " exited with "
+                   << WEXITSTATUS(status) << '\n';
+    else
+      llvm::outs() << "KLEE: fork server: run " << run
+                   << " terminated by signal " << WTERMSIG(status) << '\n';
+    llvm::outs().flush();
+  }
+  return false;
 }
 
 void KleeHandler::setInterpreter(Interpreter *i) {
@@ -759,6 +937,36 @@ void KleeHandler::getKTestFilesInDir(std::string directoryPath,
   }
 }
 
+void KleeHandler::loadSeeds(std::vector<KTest *> &seeds) {
+  for (std::vector<std::string>::iterator
+         it = SeedOutFile.begin(), ie = SeedOutFile.end();
+       it != ie; ++it) {
+    KTest *out = kTest_fromFile(it->c_str());
+    if (!out) {
+      klee_error("unable to open: %s\n", (*it).c_str());
+    }
+    seeds.push_back(out);
+  }
+  for (std::vector<std::string>::iterator
+         it = SeedOutDir.begin(), ie = SeedOutDir.end();
+       it != ie; ++it) {
+    std::vector<std::string> kTestFiles;
+    KleeHandler::getKTestFilesInDir(*it, kTestFiles);
+    for (std::vector<std::string>::iterator
+           it2 = kTestFiles.begin(), ie = kTestFiles.end();
+         it2 != ie; ++it2) {
+      KTest *out = kTest_fromFile(it2->c_str());
+      if (!out) {
+        klee_error("unable to open: %s\n", (*it2).c_str());
+      }
+      seeds.push_back(out);
+    }
+    if (kTestFiles.empty()) {
+      klee_error("seeds directory is empty: %s\n", (*it).c_str());
+    }
+  }
+}
+
 std::string KleeHandler::getRunTimeLibraryPath(const char *argv0) {
   // allow specifying the path to the runtime library
   const char *env = getenv("KLEE_RUNTIME_LIBRARY_PATH");
@@ -898,6 +1106,7 @@ static const char *modelledExternals[] = {
   "klee_close_merge",
   "klee_prefer_cex",
   "klee_posix_prefer_cex",
+  "klee_posix_copy",
   "klee_print_expr",
   "klee_print_range",
   "klee_report_error",
@@ -1239,6 +1448,104 @@ linkWithUclibc(StringRef libDir, std::string opt_suffix,
                FortifyPath.c_str(), errorMsg.c_str());
 }
 
+/// Return the path prefix of the module cache entry for this run, or an
+/// empty string if there is none. The key covers everything the prepared
+/// module depends on: the KLEE binary, the program, all runtime libraries
+/// and the options affecting linking and preparation.
+static std::string getModuleCachePath(int argc, char **argv,
+                                      const std::string &LibraryDir) {
+  llvm::SHA1 hash;
+  auto addString = [&hash](llvm::StringRef s) {
+    hash.update(s);
+    hash.update(llvm::StringRef("", 1));
+  };
+  auto addFile = [&](const std::string &path) {
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer)
+      klee_error("unable to read '%s' for --module-cache-dir: %s",
+                 path.c_str(), buffer.getError().message().c_str());
+    addString(path);
+    addString(buffer.get()->getBuffer());
+  };
+
+  // A rebuilt KLEE may prepare modules differently
+  addString(PACKAGE_STRING);
+  void *MainExecAddr = (void *)(intptr_t)getModuleCachePath;
+  llvm::sys::fs::file_status status;
+  if (!llvm::sys::fs::status(
+          llvm::sys::fs::getMainExecutable(argv[0], MainExecAddr), status)) {
+    addString(std::to_string(status.getSize()));
+    addString(std::to_string(
+        status.getLastModificationTime().time_since_epoch().count()));
+  }
+
+  addFile(InputFile);
+  for (const auto &library : LinkLibraries)
+    addFile(library);
+
+  // Rather than following which runtime libraries get linked, hash all of
+  // them
+  std::vector<std::string> runtimes;
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(LibraryDir, ec), ie;
+       it != ie && !ec; it.increment(ec)) {
+    llvm::StringRef ext = llvm::sys::path::extension(it->path());
+    if (ext == ".bca" || ext == ".bc")
+      runtimes.push_back(it->path());
+  }
+  std::sort(runtimes.begin(), runtimes.end());
+  for (const auto &runtime : runtimes)
+    addFile(runtime);
+#ifdef SUPPORT_KLEE_LIBCXX
+  if (Libcxx) {
+    SmallString<128> LibcxxBC(LibraryDir);
+    llvm::sys::path::append(LibcxxBC, KLEE_LIBCXX_BC_NAME);
+    addFile(LibcxxBC.c_str());
+  }
+#endif
+
+  // Options as given on the command line, up to the program under test
+  const std::vector<const cl::OptionCategory *> moduleCategories = {
+      &LinkCat, &ModuleCat, &ChecksCat, &MergeCat};
+  auto &options = cl::getRegisteredOptions();
+  for (int i = 1; i < argc; ++i) {
+    llvm::StringRef arg = argv[i];
+    if (arg.startswith("@")) {
+      klee_warning("--module-cache-dir is ignored with response files");
+      return "";
+    }
+    if (!arg.startswith("-") || arg == "-" || arg == "--")
+      break;
+
+    llvm::StringRef name = arg.ltrim('-'), value;
+    std::tie(name, value) = name.split('=');
+    auto it = options.find(name);
+    if (it == options.end())
+      continue;
+    cl::Option *option = it->second;
+    bool relevant = option == &EntryPoint || option == &OptimizeModule;
+    for (const cl::OptionCategory *cat : option->Categories)
+      relevant |= std::find(moduleCategories.begin(), moduleCategories.end(),
+                            cat) != moduleCategories.end();
+    if (relevant)
+      addString(arg);
+    if (!arg.contains('=') &&
+        option->getValueExpectedFlag() == cl::ValueRequired && i + 1 < argc) {
+      ++i;
+      if (relevant)
+        addString(argv[i]);
+    }
+  }
+
+  ec = llvm::sys::fs::create_directories(ModuleCacheDir);
+  if (ec)
+    klee_error("unable to create --module-cache-dir '%s': %s",
+               ModuleCacheDir.c_str(), ec.message().c_str());
+  SmallString<128> path(ModuleCacheDir);
+  llvm::sys::path::append(path, llvm::toHex(hash.final()));
+  return path.c_str();
+}
+
 int main(int argc, char **argv, char **envp) {
   atexit(llvm_shutdown); // Call llvm_shutdown() on exit
 
@@ -1328,154 +1635,179 @@ int main(int argc, char **argv, char **envp) {
   // We have to force the upgrade to opaque pointer explicitly for LLVM 15.
   ctx.setOpaquePointers(true);
 #endif
+  std::string LibraryDir = KleeHandler::getRunTimeLibraryPath(argv[0]);
   std::vector<std::unique_ptr<llvm::Module>> loadedModules;
-  if (!klee::loadFile(InputFile, ctx, loadedModules, errorMsg)) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               errorMsg.c_str());
-  }
-  // Load and link the whole files content. The assumption is that this is the
-  // application under test.
-  // Nothing gets removed in the first place.
-  std::unique_ptr<llvm::Module> M(klee::linkModules(
-      loadedModules, "" /* link all modules together */, errorMsg));
-  if (!M) {
-    klee_error("error loading program '%s': %s", InputFile.c_str(),
-               errorMsg.c_str());
+  std::string moduleCache;
+  if (!ModuleCacheDir.empty())
+    moduleCache = getModuleCachePath(argc, argv, LibraryDir);
+  bool cacheHit = false;
+  std::string opt_suffix;
+  auto moduleStart = time::getWallTime();
+  if (!moduleCache.empty() && llvm::sys::fs::exists(moduleCache + ".bc")) {
+    cacheHit =
+        klee::loadFile(moduleCache + ".bc", ctx, loadedModules, errorMsg);
+    if (cacheHit)
+      klee_message("NOTE: Using cached module: %s.bc", moduleCache.c_str());
+    else
+      klee_warning("Ignoring unreadable module cache entry %s.bc: %s",
+                   moduleCache.c_str(), errorMsg.c_str());
   }
+  if (!cacheHit) {
+    if (!klee::loadFile(InputFile, ctx, loadedModules, errorMsg)) {
+      klee_error("error loading program '%s': %s", InputFile.c_str(),
+                 errorMsg.c_str());
+    }
+    // Load and link the whole files content. The assumption is that this is the
+    // application under test.
+    // Nothing gets removed in the first place.
+    std::unique_ptr<llvm::Module> M(klee::linkModules(
+        loadedModules, "" /* link all modules together */, errorMsg));
+    if (!M) {
+      klee_error("error loading program '%s': %s", InputFile.c_str(),
+                 errorMsg.c_str());
+    }
 
-  llvm::Module *mainModule = M.get();
+    llvm::Module *mainModule = M.get();
 
-  const std::string &module_triple = mainModule->getTargetTriple();
-  std::string host_triple = llvm::sys::getDefaultTargetTriple();
+    const std::string &module_triple = mainModule->getTargetTriple();
+    std::string host_triple = llvm::sys::getDefaultTargetTriple();
 
-  if (module_triple != host_triple)
-    klee_warning("Module and host target triples do not match: '%s' != '%s'\n"
-                 "This may cause unexpected crashes or assertion violations.",
-                 module_triple.c_str(), host_triple.c_str());
+    if (module_triple != host_triple)
+      klee_warning("Module and host target triples do not match: '%s' != '%s'\n"
+                   "This may cause unexpected crashes or assertion violations.",
+                   module_triple.c_str(), host_triple.c_str());
 
-  // Detect architecture
-  std::string opt_suffix = "64"; // Fall back to 64bit
-  if (module_triple.find("i686") != std::string::npos ||
-      module_triple.find("i586") != std::string::npos ||
-      module_triple.find("i486") != std::string::npos ||
-      module_triple.find("i386") != std::string::npos)
-    opt_suffix = "32";
+    // Detect architecture
+    opt_suffix = "64"; // Fall back to 64bit
+    if (module_triple.find("i686") != std::string::npos ||
+        module_triple.find("i586") != std::string::npos ||
+        module_triple.find("i486") != std::string::npos ||
+        module_triple.find("i386") != std::string::npos)
+      opt_suffix = "32";
 
-  // Add additional user-selected suffix
-  opt_suffix += "_" + RuntimeBuild.getValue();
+    // Add additional user-selected suffix
+    opt_suffix += "_" + RuntimeBuild.getValue();
 
-  // Push the module as the first entry
-  loadedModules.emplace_back(std::move(M));
+    // Push the module as the first entry
+    loadedModules.emplace_back(std::move(M));
 
-  std::string LibraryDir = KleeHandler::getRunTimeLibraryPath(argv[0]);
-  Interpreter::ModuleOptions Opts(LibraryDir.c_str(), EntryPoint, opt_suffix,
-                                  /*Optimize=*/OptimizeModule,
-                                  /*CheckDivZero=*/CheckDivZero,
-                                  /*CheckOvershift=*/CheckOvershift);
+    // Get the main function
+    for (auto &module : loadedModules) {
+      mainFn = module->getFunction("main");
+      if (mainFn)
+        break;
+    }
 
-  // Get the main function
-  for (auto &module : loadedModules) {
-    mainFn = module->getFunction("main");
-    if (mainFn)
-      break;
-  }
+    // Get the entry point function
+    if (EntryPoint.empty())
+      klee_error("entry-point cannot be empty");
 
-  // Get the entry point function
-  if (EntryPoint.empty())
-    klee_error("entry-point cannot be empty");
+    for (auto &module : loadedModules) {
+      entryFn = module->getFunction(EntryPoint);
+      if (entryFn)
+        break;
+    }
 
-  for (auto &module : loadedModules) {
-    entryFn = module->getFunction(EntryPoint);
-    if (entryFn)
-      break;
-  }
+    if (!entryFn)
+      klee_error("Entry function '%s' not found in module.", EntryPoint.c_str());
 
-  if (!entryFn)
-    klee_error("Entry function '%s' not found in module.", EntryPoint.c_str());
 
+    if (WithPOSIXRuntime) {
+      SmallString<128> Path(LibraryDir);
+      llvm::sys::path::append(Path, "libkleeRuntimePOSIX" + opt_suffix + ".bca");
+      klee_message("NOTE: Using POSIX model: %s", Path.c_str());
+      if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
+                          errorMsg))
+        klee_error("error loading POSIX support '%s': %s", Path.c_str(),
+                   errorMsg.c_str());
 
-  if (WithPOSIXRuntime) {
-    SmallString<128> Path(Opts.LibraryDir);
-    llvm::sys::path::append(Path, "libkleeRuntimePOSIX" + opt_suffix + ".bca");
-    klee_message("NOTE: Using POSIX model: %s", Path.c_str());
-    if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
-                        errorMsg))
-      klee_error("error loading POSIX support '%s': %s", Path.c_str(),
-                 errorMsg.c_str());
+      std::string libcPrefix = (Libc == LibcType::UcLibc ? "__user_" : "");
+      if (mainFn)
+        preparePOSIX(loadedModules, libcPrefix);
+    }
 
-    std::string libcPrefix = (Libc == LibcType::UcLibc ? "__user_" : "");
-    if (mainFn)
-      preparePOSIX(loadedModules, libcPrefix);
-  }
+    if (WithUBSanRuntime) {
+      SmallString<128> Path(LibraryDir);
+      llvm::sys::path::append(Path, "libkleeUBSan" + opt_suffix + ".bca");
+      if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
+                          errorMsg))
+        klee_error("error loading UBSan support '%s': %s", Path.c_str(),
+                   errorMsg.c_str());
+    }
 
-  if (WithUBSanRuntime) {
-    SmallString<128> Path(Opts.LibraryDir);
-    llvm::sys::path::append(Path, "libkleeUBSan" + opt_suffix + ".bca");
-    if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
-                        errorMsg))
-      klee_error("error loading UBSan support '%s': %s", Path.c_str(),
-                 errorMsg.c_str());
-  }
+    if (Libcxx) {
+  #ifndef SUPPORT_KLEE_LIBCXX
+      klee_error("KLEE was not compiled with libc++ support");
+  #else
+      SmallString<128> LibcxxBC(LibraryDir);
+      llvm::sys::path::append(LibcxxBC, KLEE_LIBCXX_BC_NAME);
+      if (!klee::loadFile(LibcxxBC.c_str(), mainModule->getContext(), loadedModules,
+                          errorMsg))
+        klee_error("error loading libc++ '%s': %s", LibcxxBC.c_str(),
+                   errorMsg.c_str());
+      klee_message("NOTE: Using libc++ : %s", LibcxxBC.c_str());
+  #ifdef SUPPORT_KLEE_EH_CXX
+      SmallString<128> EhCxxPath(LibraryDir);
+      llvm::sys::path::append(EhCxxPath, "libkleeeh-cxx" + opt_suffix + ".bca");
+      if (!klee::loadFile(EhCxxPath.c_str(), mainModule->getContext(),
+                          loadedModules, errorMsg))
+        klee_error("error loading libklee-eh-cxx '%s': %s", EhCxxPath.c_str(),
+                   errorMsg.c_str());
+      klee_message("NOTE: Enabled runtime support for C++ exceptions");
+  #else
+      klee_message("NOTE: KLEE was not compiled with support for C++ exceptions");
+  #endif
+  #endif
+    }
 
-  if (Libcxx) {
-#ifndef SUPPORT_KLEE_LIBCXX
-    klee_error("KLEE was not compiled with libc++ support");
-#else
-    SmallString<128> LibcxxBC(Opts.LibraryDir);
-    llvm::sys::path::append(LibcxxBC, KLEE_LIBCXX_BC_NAME);
-    if (!klee::loadFile(LibcxxBC.c_str(), mainModule->getContext(), loadedModules,
-                        errorMsg))
-      klee_error("error loading libc++ '%s': %s", LibcxxBC.c_str(),
-                 errorMsg.c_str());
-    klee_message("NOTE: Using libc++ : %s", LibcxxBC.c_str());
-#ifdef SUPPORT_KLEE_EH_CXX
-    SmallString<128> EhCxxPath(Opts.LibraryDir);
-    llvm::sys::path::append(EhCxxPath, "libkleeeh-cxx" + opt_suffix + ".bca");
-    if (!klee::loadFile(EhCxxPath.c_str(), mainModule->getContext(),
-                        loadedModules, errorMsg))
-      klee_error("error loading libklee-eh-cxx '%s': %s", EhCxxPath.c_str(),
-                 errorMsg.c_str());
-    klee_message("NOTE: Enabled runtime support for C++ exceptions");
-#else
-    klee_message("NOTE: KLEE was not compiled with support for C++ exceptions");
-#endif
-#endif
-  }
+    switch (Libc) {
+    case LibcType::KleeLibc: {
+      // FIXME: Find a reasonable solution for this.
+      SmallString<128> Path(LibraryDir);
+      llvm::sys::path::append(Path,
+                              "libkleeRuntimeKLEELibc" + opt_suffix + ".bca");
+      if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
+                          errorMsg))
+        klee_error("error loading klee libc '%s': %s", Path.c_str(),
+                   errorMsg.c_str());
+    }
+    /* Falls through. */
+    case LibcType::FreestandingLibc: {
+      SmallString<128> Path(LibraryDir);
+      llvm::sys::path::append(Path,
+                              "libkleeRuntimeFreestanding" + opt_suffix + ".bca");
+      if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
+                          errorMsg))
+        klee_error("error loading freestanding support '%s': %s", Path.c_str(),
+                   errorMsg.c_str());
+      break;
+    }
+    case LibcType::UcLibc:
+      linkWithUclibc(LibraryDir, opt_suffix, loadedModules);
+      break;
+    }
 
-  switch (Libc) {
-  case LibcType::KleeLibc: {
-    // FIXME: Find a reasonable solution for this.
-    SmallString<128> Path(Opts.LibraryDir);
-    llvm::sys::path::append(Path,
-                            "libkleeRuntimeKLEELibc" + opt_suffix + ".bca");
-    if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
-                        errorMsg))
-      klee_error("error loading klee libc '%s': %s", Path.c_str(),
-                 errorMsg.c_str());
-  }
-  /* Falls through. */
-  case LibcType::FreestandingLibc: {
-    SmallString<128> Path(Opts.LibraryDir);
-    llvm::sys::path::append(Path,
-                            "libkleeRuntimeFreestanding" + opt_suffix + ".bca");
-    if (!klee::loadFile(Path.c_str(), mainModule->getContext(), loadedModules,
-                        errorMsg))
-      klee_error("error loading freestanding support '%s': %s", Path.c_str(),
-                 errorMsg.c_str());
-    break;
-  }
-  case LibcType::UcLibc:
-    linkWithUclibc(LibraryDir, opt_suffix, loadedModules);
-    break;
-  }
+    for (const auto &library : LinkLibraries) {
+      if (!klee::loadFile(library, mainModule->getContext(), loadedModules,
+                          errorMsg))
+        klee_error("error loading bitcode library '%s': %s", library.c_str(),
+                   errorMsg.c_str());
+    }
 
-  for (const auto &library : LinkLibraries) {
-    if (!klee::loadFile(library, mainModule->getContext(), loadedModules,
-                        errorMsg))
-      klee_error("error loading bitcode library '%s': %s", library.c_str(),
-                 errorMsg.c_str());
+    // Remember the main function by name so that it is found the same way in
+    // the final module, whether it comes from the module cache or not
+    if (mainFn)
+      mainModule->getOrInsertNamedMetadata("klee.main_function")
+          ->addOperand(MDNode::get(ctx, MDString::get(ctx, mainFn->getName())));
   }
 
+  Interpreter::ModuleOptions Opts(LibraryDir.c_str(), EntryPoint, opt_suffix,
+                                  /*Optimize=*/OptimizeModule,
+                                  /*CheckDivZero=*/CheckDivZero,
+                                  /*CheckOvershift=*/CheckOvershift);
+  Opts.ModuleCache = moduleCache;
+  Opts.FromModuleCache = cacheHit;
+
   // FIXME: Change me to std types.
   int pArgc;
   char **pArgv;
@@ -1517,6 +1849,19 @@ int main(int argc, char **argv, char **envp) {
 
   Interpreter::InterpreterOptions IOpts;
   IOpts.MakeConcreteSymbolic = MakeConcreteSymbolic;
+  if (ForkServer) {
+    if (!ReplayKTestDir.empty() || !ReplayKTestFile.empty())
+      klee_error("--fork-server cannot be used with --replay-ktest-*");
+    if (WritePaths || WriteSymPaths)
+      klee_error("--fork-server cannot be used with --write-paths or "
+                 "--write-sym-paths");
+    // Forked runs would not inherit the thread writing the binary query log
+    if (QueryLoggingOptions.isSet(ALL_KQLOG) ||
+        QueryLoggingOptions.isSet(SOLVER_KQLOG))
+      klee_error("--fork-server cannot be used with --use-query-log=all:kqlog "
+                 "or solver:kqlog");
+    IOpts.SnapshotFunction = ForkServerAt;
+  }
   KleeHandler *handler = new KleeHandler(pArgc, pArgv);
   Interpreter *interpreter =
     theInterpreter = Interpreter::create(ctx, IOpts, handler);
@@ -1534,6 +1879,14 @@ int main(int argc, char **argv, char **envp) {
   entryFn = finalModule->getFunction(EntryPoint);
   if (!entryFn)
     klee_error("Entry function '%s' not found in module.", EntryPoint.c_str());
+  std::string mainFnName;
+  if (auto *md = finalModule->getNamedMetadata("klee.main_function"))
+    mainFnName = cast<MDString>(md->getOperand(0)->getOperand(0))->getString();
+  if (!moduleCache.empty())
+    handler->getInfoStream()
+        << "Module cache " << (cacheHit ? "hit" : "miss") << " ("
+        << moduleCache << "): module ready after "
+        << (time::getWallTime() - moduleStart).toSeconds() << "s\n";
 
   externalsAndGlobalsCheck(finalModule);
 
@@ -1575,7 +1928,7 @@ int main(int argc, char **argv, char **envp) {
                << "</programfile>\n";
     *meta_file << "\t<programhash>" << XMLMetadataProgramHash
                << "</programhash>\n";
-    *meta_file << "\t<entryfunction>" << mainFn->getName().str()
+    *meta_file << "\t<entryfunction>" << mainFnName
                << "</entryfunction>\n";
     *meta_file << "\t<architecture>"
                << finalModule->getDataLayout().getPointerSizeInBits()
@@ -1644,33 +1997,7 @@ int main(int argc, char **argv, char **envp) {
     }
   } else {
     std::vector<KTest *> seeds;
-    for (std::vector<std::string>::iterator
-           it = SeedOutFile.begin(), ie = SeedOutFile.end();
-         it != ie; ++it) {
-      KTest *out = kTest_fromFile(it->c_str());
-      if (!out) {
-        klee_error("unable to open: %s\n", (*it).c_str());
-      }
-      seeds.push_back(out);
-    }
-    for (std::vector<std::string>::iterator
-           it = SeedOutDir.begin(), ie = SeedOutDir.end();
-         it != ie; ++it) {
-      std::vector<std::string> kTestFiles;
-      KleeHandler::getKTestFilesInDir(*it, kTestFiles);
-      for (std::vector<std::string>::iterator
-             it2 = kTestFiles.begin(), ie = kTestFiles.end();
-           it2 != ie; ++it2) {
-        KTest *out = kTest_fromFile(it2->c_str());
-        if (!out) {
-          klee_error("unable to open: %s\n", (*it2).c_str());
-        }
-        seeds.push_back(out);
-      }
-      if (kTestFiles.empty()) {
-        klee_error("seeds directory is empty: %s\n", (*it).c_str());
-      }
-    }
+    KleeHandler::loadSeeds(seeds);
 
     if (!seeds.empty()) {
       klee_message("KLEE: using %lu seeds\n", seeds.size());
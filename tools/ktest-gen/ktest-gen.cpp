@@ -26,10 +26,25 @@
 
 
 #define MAX 64
+// Returns a new object at the end of b->objects. The array starts out with
+// room for MAX objects and doubles whenever it is full.
+static KTestObject *new_obj(KTest *b) {
+  unsigned n = b->numObjects;
+  if (n >= MAX && (n & (n - 1)) == 0) {
+    KTestObject *objects =
+        (KTestObject *)realloc(b->objects, 2 * n * sizeof *b->objects);
+    if (!objects) {
+      fprintf(stderr, "Could not allocate more memory\n");
+      exit(1);
+    }
+    b->objects = objects;
+  }
+  return &b->objects[b->numObjects++];
+}
+
 static void push_obj(KTest *b, const char *name, unsigned total_bytes,
                      unsigned char *bytes) {
-  KTestObject *o = &b->objects[b->numObjects++];
-  assert(b->numObjects < MAX);
+  KTestObject *o = new_obj(b);
 
   o->name = strdup(name);
   o->numBytes = total_bytes;
@@ -38,6 +53,30 @@ static void push_obj(KTest *b, const char *name, unsigned total_bytes,
   memcpy(o->bytes, bytes, total_bytes);
 }
 
+// Symbolic files are made symbolic in chunks of this many bytes by the POSIX
+// runtime, see KLEE_SYM_FILE_CHUNK_SIZE in runtime/POSIX/fd.h
+#define SYM_FILE_CHUNK_SIZE 4096
+
+// Pushes the contents of a symbolic file as one object per chunk, named as
+// the POSIX runtime names them.
+static void push_file_obj(KTest *b, const char *name, unsigned total_bytes,
+                          unsigned char *bytes) {
+  unsigned pos = 0, i = 0;
+  do {
+    char chunk_name[64];
+    unsigned n = total_bytes - pos;
+    if (n > SYM_FILE_CHUNK_SIZE)
+      n = SYM_FILE_CHUNK_SIZE;
+    if (i == 0)
+      snprintf(chunk_name, sizeof(chunk_name), "%s", name);
+    else
+      snprintf(chunk_name, sizeof(chunk_name), "%s_%u", name, i);
+    push_obj(b, chunk_name, n, bytes + pos);
+    pos += n;
+    ++i;
+  } while (pos < total_bytes);
+}
+
 void print_usage_and_exit(char *program_name) {
   fprintf(stderr,
     "%s: Tool for generating a ktest file from concrete input, e.g., for using a concrete crashing input as a ktest seed.\n"
@@ -190,7 +229,7 @@ int main(int argc, char *argv[]) {
       // Push obj to ktest file
       filename[0] = sym_file_name;
       statname[0] = sym_file_name;
-      push_obj(&b, filename, max_file_size, file_content[current_file]);
+      push_file_obj(&b, filename, max_file_size, file_content[current_file]);
       push_obj(&b, statname, sizeof(struct stat64),
                (unsigned char *)&file_stat[current_file]);
       free(file_content[current_file]);
@@ -238,7 +277,7 @@ int main(int argc, char *argv[]) {
       fptr++;
     }
 
-    push_obj(&b, filename, file_stat.st_size, file_content);
+    push_file_obj(&b, filename, file_stat.st_size, file_content);
     push_obj(&b, statname, sizeof(struct stat64), (unsigned char *)&file_stat);
 
     free(file_content);
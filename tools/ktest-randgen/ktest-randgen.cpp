@@ -52,10 +52,24 @@ static unsigned get_unsigned(char *i) {
 }
 
 #define MAX 64
+// Returns a new object at the end of b->objects. The array starts out with
+// room for MAX objects and doubles whenever it is full.
+static KTestObject *new_obj(KTest *b) {
+  unsigned n = b->numObjects;
+  if (n >= MAX && (n & (n - 1)) == 0) {
+    KTestObject *objects =
+        (KTestObject *)realloc(b->objects, 2 * n * sizeof *b->objects);
+    if (objects == NULL) {
+      error_exit("%s:%d: realloc() failure\n", __FILE__, __LINE__);
+    }
+    b->objects = objects;
+  }
+  return &b->objects[b->numObjects++];
+}
+
 static void push_random_obj(KTest *b, const char *name, unsigned non_zero_bytes,
                             unsigned total_bytes) {
-  KTestObject *o = &b->objects[b->numObjects++];
-  assert(b->numObjects < MAX);
+  KTestObject *o = new_obj(b);
 
   if ((o->name = strdup(name)) == NULL) {
     error_exit("%s:%d: strdup() failure\n", __FILE__, __LINE__);
@@ -76,8 +90,7 @@ static void push_random_obj(KTest *b, const char *name, unsigned non_zero_bytes,
 
 static void push_obj(KTest *b, const char *name, unsigned total_bytes,
                      unsigned char *content) {
-  KTestObject *o = &b->objects[b->numObjects++];
-  assert(b->numObjects < MAX);
+  KTestObject *o = new_obj(b);
 
   if ((o->name = strdup(name)) == NULL) {
     error_exit("%s:%d: strdup() failure\n", __FILE__, __LINE__);
@@ -89,6 +102,30 @@ static void push_obj(KTest *b, const char *name, unsigned total_bytes,
   memcpy(o->bytes, content, total_bytes);
 }
 
+// Symbolic files are made symbolic in chunks of this many bytes by the POSIX
+// runtime, see KLEE_SYM_FILE_CHUNK_SIZE in runtime/POSIX/fd.h
+#define SYM_FILE_CHUNK_SIZE 4096
+
+// Pushes random contents of a symbolic file as one object per chunk, named
+// as the POSIX runtime names them.
+static void push_random_file_obj(KTest *b, const char *name,
+                                 unsigned total_bytes) {
+  unsigned pos = 0, i = 0;
+  do {
+    char chunk_name[SMALL_BUFFER_SIZE];
+    unsigned n = total_bytes - pos;
+    if (n > SYM_FILE_CHUNK_SIZE)
+      n = SYM_FILE_CHUNK_SIZE;
+    if (i == 0)
+      snprintf(chunk_name, sizeof(chunk_name), "%s", name);
+    else
+      snprintf(chunk_name, sizeof(chunk_name), "%s_%u", name, i);
+    push_random_obj(b, chunk_name, n, n);
+    pos += n;
+    ++i;
+  } while (pos < total_bytes);
+}
+
 static void push_range(KTest *b, const char *name, unsigned value) {
   push_obj(b, name, 4, (unsigned char *)&value);
 }
@@ -258,7 +295,7 @@ int main(int argc, char *argv[]) {
 
     create_stat(nbytes, &s);
 
-    push_random_obj(&b, filename, nbytes, nbytes);
+    push_random_file_obj(&b, filename, nbytes);
     push_obj(&b, file_stat, sizeof(struct stat), (unsigned char *)&s);
   }
 
@@ -268,7 +305,7 @@ int main(int argc, char *argv[]) {
     // Using disk file works well with klee-replay.
     create_stat(stdin_size, &s);
 
-    push_random_obj(&b, "stdin", stdin_size, stdin_size);
+    push_random_file_obj(&b, "stdin", stdin_size);
     push_obj(&b, "stdin-stat", sizeof(struct stat), (unsigned char *)&s);
   }
   if (sym_stdout) {
@@ -0,0 +1,153 @@
+//===-- CompiledExprTest.cpp ----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Assignment.h"
+#include "klee/Expr/CompiledExpr.h"
+#include "klee/Expr/Expr.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> constant(uint64_t value, Expr::Width width) {
+  return ConstantExpr::create(value, width);
+}
+
+/// Build a collection of expressions over two 4-byte arrays that exercises
+/// every instruction kind.
+std::vector<ref<Expr>> buildExprs(const Array *a, const Array *b) {
+  ref<Expr> x = Expr::createTempRead(a, Expr::Int32);
+  ref<Expr> y = Expr::createTempRead(b, Expr::Int32);
+  ref<Expr> byte = Expr::createTempRead(a, Expr::Int8);
+  ref<Expr> wide = ConcatExpr::create(x, y);
+
+  std::vector<ref<Expr>> exprs = {
+      AddExpr::create(x, y),
+      SubExpr::create(x, y),
+      MulExpr::create(x, y),
+      UDivExpr::create(x, OrExpr::create(y, constant(1, Expr::Int32))),
+      SDivExpr::create(x, OrExpr::create(y, constant(1, Expr::Int32))),
+      URemExpr::create(x, OrExpr::create(y, constant(1, Expr::Int32))),
+      SRemExpr::create(x, OrExpr::create(y, constant(1, Expr::Int32))),
+      AndExpr::create(x, y),
+      XorExpr::create(x, y),
+      NotExpr::create(x),
+      ShlExpr::create(x, AndExpr::create(y, constant(63, Expr::Int32))),
+      LShrExpr::create(x, AndExpr::create(y, constant(63, Expr::Int32))),
+      AShrExpr::create(x, AndExpr::create(y, constant(63, Expr::Int32))),
+      ZExtExpr::create(byte, Expr::Int64),
+      SExtExpr::create(byte, Expr::Int64),
+      ExtractExpr::create(wide, 12, Expr::Int16),
+      AddExpr::create(wide, constant(0x1234567890ULL, Expr::Int64)),
+      SelectExpr::create(UltExpr::create(x, y), x, y),
+      SltExpr::create(x, y),
+      SleExpr::create(y, x),
+      EqExpr::create(ExtractExpr::create(x, 0, Expr::Int8), byte),
+  };
+
+  // A read through a symbolic update.
+  UpdateList ul(b, nullptr);
+  ul.extend(ExtractExpr::create(x, 0, Expr::Int32),
+            constant(0xab, Expr::Int8));
+  exprs.push_back(ReadExpr::create(
+      ul, ExtractExpr::create(y, 0, Expr::Int32)));
+  return exprs;
+}
+
+TEST(CompiledExprTest, MatchesInterpreter) {
+  ArrayCache ac;
+  const Array *a = ac.CreateArray("a", 4);
+  const Array *b = ac.CreateArray("b", 4);
+  std::vector<ref<Expr>> exprs = buildExprs(a, b);
+  CompiledExpr compiled(exprs.begin(), exprs.end());
+  ASSERT_EQ(exprs.size(), compiled.size());
+
+  const std::vector<std::vector<unsigned char>> inputs = {
+      {0, 0, 0, 0},       {1, 0, 0, 0},         {0xff, 0xff, 0xff, 0xff},
+      {0, 0, 0, 0x80},    {0x7f, 0xff, 0xff, 0xff}, {3, 2, 1, 0},
+      {0x21, 0, 0, 0x90}, {2, 0, 0, 0},         {0x80, 0, 0, 0},
+  };
+
+  std::vector<Assignment> assignments;
+  for (const auto &va : inputs) {
+    for (const auto &vb : inputs) {
+      std::vector<const Array *> objects = {a, b};
+      std::vector<std::vector<unsigned char>> values = {va, vb};
+      assignments.emplace_back(objects, values);
+    }
+  }
+
+  for (const Assignment &assignment : assignments)
+    for (unsigned i = 0; i < exprs.size(); ++i)
+      EXPECT_EQ(assignment.evaluate(exprs[i]), compiled.evaluate(assignment, i))
+          << "expression " << i;
+
+  // Evaluating all assignments at once spans more than one batch.
+  std::vector<const Assignment *> batch;
+  for (const Assignment &assignment : assignments)
+    batch.push_back(&assignment);
+  std::vector<ref<Expr>> results;
+  compiled.evaluate(batch, results);
+  ASSERT_EQ(batch.size() * exprs.size(), results.size());
+  for (unsigned j = 0; j < batch.size(); ++j)
+    for (unsigned i = 0; i < exprs.size(); ++i)
+      EXPECT_EQ(batch[j]->evaluate(exprs[i]), results[j * exprs.size() + i])
+          << "assignment " << j << ", expression " << i;
+}
+
+TEST(CompiledExprTest, Fallback) {
+  ArrayCache ac;
+  const Array *a = ac.CreateArray("a", 4);
+  const Array *b = ac.CreateArray("b", 4);
+  ref<Expr> x = Expr::createTempRead(a, Expr::Int32);
+  ref<Expr> y = Expr::createTempRead(b, Expr::Int32);
+
+  std::vector<const Array *> objects = {a};
+  std::vector<std::vector<unsigned char>> values = {{5, 0, 0, 0}};
+
+  // Free values and division by zero cannot be folded to a constant.
+  Assignment partial(objects, values, /*_allowFreeValues=*/true);
+  CompiledExpr sum(AddExpr::create(x, y));
+  EXPECT_EQ(partial.evaluate(AddExpr::create(x, y)), sum.evaluate(partial));
+  EXPECT_FALSE(isa<ConstantExpr>(sum.evaluate(partial)));
+
+  Assignment complete(objects, values);
+  ref<Expr> div = UDivExpr::create(x, y);
+  CompiledExpr quotient(div);
+  EXPECT_EQ(complete.evaluate(div), quotient.evaluate(complete));
+
+  // Lanes that cannot be computed fall back individually.
+  std::vector<std::vector<unsigned char>> nonZero = {{5, 0, 0, 0},
+                                                     {2, 0, 0, 0}};
+  Assignment divisible({a, b}, nonZero);
+  std::vector<ref<Expr>> results;
+  quotient.evaluate({&complete, &divisible}, results);
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(complete.evaluate(div), results[0]);
+  EXPECT_EQ(constant(2, Expr::Int32), results[1]);
+
+  // Unbound arrays read as zero without free values.
+  EXPECT_EQ(constant(5, Expr::Int32), sum.evaluate(complete));
+
+  std::vector<ref<Expr>> constraints = {
+      UltExpr::create(constant(4, Expr::Int32), x),
+      EqExpr::create(y, constant(0, Expr::Int32)),
+  };
+  CompiledExpr cs(constraints.begin(), constraints.end());
+  EXPECT_TRUE(cs.satisfies(complete));
+  constraints.push_back(UltExpr::create(x, constant(5, Expr::Int32)));
+  CompiledExpr unsat(constraints.begin(), constraints.end());
+  EXPECT_FALSE(unsat.satisfies(complete));
+}
+} // namespace
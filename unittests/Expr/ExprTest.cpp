@@ -264,4 +264,48 @@ TEST(ExprTest, ReadExprFoldingSymbolicIndexUpdate) {
     EXPECT_EQ(Expr::Read, read.get()->getKind());
   }
 }
+
+TEST(ExprTest, ReadExprFoldingLongUpdateList) {
+  unsigned size = 64;
+
+  std::vector<ref<ConstantExpr> > Contents(size);
+  for (unsigned i = 0; i < size; ++i)
+    Contents[i] = ConstantExpr::create(i, Expr::Int8);
+  ArrayCache ac;
+  const Array *array =
+      ac.CreateArray("arr", size, &Contents[0], &Contents[0] + size);
+  const Array *array2 = ac.CreateArray("arr2", 256);
+  ref<Expr> symbolicIndex = ReadExpr::createTempRead(array2, Expr::Int32);
+
+  // Long runs of concrete writes, which get indexed, separated by a
+  // symbolic write
+  UpdateList ul(array, 0);
+  for (unsigned i = 0; i < 300; ++i) {
+    if (i == 150)
+      ul.extend(symbolicIndex, ConstantExpr::create(0, Expr::Int8));
+    else
+      ul.extend(ConstantExpr::create(i * 7 % 50, Expr::Int32),
+                ConstantExpr::create(i % 256, Expr::Int8));
+
+    for (unsigned index = 0; index < size; ++index) {
+      // Find the expected write by walking the list
+      const UpdateNode *expected = ul.head.get();
+      for (; expected; expected = expected->next.get()) {
+        const ConstantExpr *CE = dyn_cast<ConstantExpr>(expected->index);
+        if (!CE || CE->getZExtValue() == index)
+          break;
+      }
+      EXPECT_EQ(expected, ul.head->findWrite(index));
+
+      ref<Expr> read =
+          ReadExpr::create(ul, ConstantExpr::create(index, Expr::Int32));
+      if (!expected)
+        EXPECT_EQ(ref<Expr>(Contents[index]), read);
+      else if (isa<ConstantExpr>(expected->index))
+        EXPECT_EQ(expected->value, read);
+      else
+        EXPECT_EQ(expected, cast<ReadExpr>(read)->updates.head.get());
+    }
+  }
+}
 }
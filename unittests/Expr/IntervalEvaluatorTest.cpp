@@ -0,0 +1,98 @@
+//===-- IntervalEvaluatorTest.cpp -----------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/Constraints.h"
+#include "klee/Expr/Expr.h"
+#include "klee/Expr/IntervalEvaluator.h"
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> constant(uint64_t value, Expr::Width width) {
+  return ConstantExpr::create(value, width);
+}
+
+TEST(IntervalEvaluatorTest, Structural) {
+  ArrayCache ac;
+  const Array *array = ac.CreateArray("arr", 4);
+  ref<Expr> byte = Expr::createTempRead(array, Expr::Int8);
+  ref<Expr> word = Expr::createTempRead(array, Expr::Int32);
+  IntervalEvaluator ie;
+
+  auto r = ie.evaluate(ZExtExpr::create(byte, Expr::Int64));
+  EXPECT_EQ(0U, r.min);
+  EXPECT_EQ(255U, r.max);
+
+  // base + 4 * zext(byte), as produced for an array access
+  ref<Expr> ptr = AddExpr::create(
+      constant(0x1000, Expr::Int64),
+      MulExpr::create(constant(4, Expr::Int64),
+                      ZExtExpr::create(byte, Expr::Int64)));
+  r = ie.evaluate(ptr);
+  EXPECT_EQ(0x1000U, r.min);
+  EXPECT_EQ(0x1000U + 4 * 255, r.max);
+
+  // A 32-bit word can take any value.
+  r = ie.evaluate(word);
+  EXPECT_EQ(0U, r.min);
+  EXPECT_EQ(0xffffffffU, r.max);
+
+  // Wrapping by the same amount on both ends is precise.
+  r = ie.evaluate(AddExpr::create(constant(0xff00, 16),
+                                  ZExtExpr::create(byte, 16)));
+  EXPECT_EQ(0xff00U, r.min);
+  EXPECT_EQ(0xffffU, r.max);
+  r = ie.evaluate(AddExpr::create(constant(0xff01, 16),
+                                  ZExtExpr::create(byte, 16)));
+  EXPECT_EQ(0U, r.min);
+  EXPECT_EQ(0xffffU, r.max);
+
+  r = ie.evaluate(AndExpr::create(word, constant(0xf0, Expr::Int32)));
+  EXPECT_EQ(0U, r.min);
+  EXPECT_EQ(0xf0U, r.max);
+}
+
+TEST(IntervalEvaluatorTest, Constraints) {
+  ArrayCache ac;
+  const Array *array = ac.CreateArray("arr", 4);
+  ref<Expr> word = Expr::createTempRead(array, Expr::Int32);
+  ref<Expr> index = ZExtExpr::create(word, Expr::Int64);
+  ref<Expr> ptr = AddExpr::create(
+      constant(0x1000, Expr::Int64),
+      MulExpr::create(constant(8, Expr::Int64), index));
+
+  // word < 16 && !(word < 2)
+  ConstraintSet constraints;
+  constraints.push_back(UltExpr::create(word, constant(16, Expr::Int32)));
+  constraints.push_back(Expr::createIsZero(
+      UltExpr::create(word, constant(2, Expr::Int32))));
+
+  IntervalEvaluator ie(constraints);
+  auto r = ie.evaluate(word);
+  EXPECT_EQ(2U, r.min);
+  EXPECT_EQ(15U, r.max);
+
+  r = ie.evaluate(ptr);
+  EXPECT_EQ(0x1000U + 8 * 2, r.min);
+  EXPECT_EQ(0x1000U + 8 * 15, r.max);
+  EXPECT_TRUE(r.intersects(0x1000, 0x1010));
+  EXPECT_FALSE(r.intersects(0x1000, 0x100f));
+  EXPECT_FALSE(r.intersects(0x1080, 0x2000));
+
+  // Bounds on the full pointer are used directly.
+  ie.addConstraint(UleExpr::create(ptr, constant(0x1020, Expr::Int64)));
+  r = ie.evaluate(ptr);
+  EXPECT_EQ(0x1010U, r.min);
+  EXPECT_EQ(0x1020U, r.max);
+}
+} // namespace
@@ -0,0 +1,191 @@
+//===-- QueryLogTest.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Expr/ArrayCache.h"
+#include "klee/Expr/ExprBuilder.h"
+#include "klee/Expr/QueryLog.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+ref<Expr> constant(uint64_t value, Expr::Width width) {
+  return ConstantExpr::create(value, width);
+}
+
+std::string str(const ref<Expr> &e) {
+  std::string s;
+  llvm::raw_string_ostream os(s);
+  os << e;
+  return os.str();
+}
+
+/// Read \p log back in chunks of \p chunkSize bytes.
+std::vector<LoggedQuery> readLog(const std::string &log, size_t chunkSize,
+                                 ArrayCache &ac, std::string &error) {
+  size_t pos = 0;
+  std::unique_ptr<ExprBuilder> builder(createDefaultExprBuilder());
+  QueryLogReader reader(
+      [&](char *buffer, size_t size) -> long {
+        size_t n = std::min({size, chunkSize, log.size() - pos});
+        memcpy(buffer, log.data() + pos, n);
+        pos += n;
+        return n;
+      },
+      builder.get(), ac);
+
+  std::vector<LoggedQuery> queries;
+  LoggedQuery query;
+  if (reader.readHeader())
+    while (reader.next(query))
+      queries.push_back(query);
+  error = reader.getError();
+  return queries;
+}
+
+TEST(QueryLogTest, RoundTrip) {
+  ArrayCache ac;
+  const Array *a = ac.CreateArray("a", 8);
+  std::vector<ref<ConstantExpr>> init;
+  for (unsigned i = 0; i < 4; ++i)
+    init.push_back(ConstantExpr::create(i + 1, Expr::Int8));
+  const Array *c = ac.CreateArray("c", 4, init.data(), init.data() + 4);
+
+  ref<Expr> x = Expr::createTempRead(a, Expr::Int32);
+  UpdateList ul(c, nullptr);
+  for (unsigned i = 0; i < 100; ++i)
+    ul.extend(constant(i % 4, Expr::Int32), ExtractExpr::create(x, 0, 8));
+  ref<Expr> sym =
+      ReadExpr::create(ul, ZExtExpr::create(ExtractExpr::create(x, 8, 8), 32));
+  ref<Expr> wide = ConcatExpr::create(constant(0x123456789ULL, Expr::Int64),
+                                      ConcatExpr::create(x, x));
+
+  std::vector<LoggedQuery> queries(4);
+  queries[0].kind = LoggedQuery::Truth;
+  queries[0].constraints = {UltExpr::create(x, constant(10, Expr::Int32))};
+  queries[0].expr = EqExpr::create(sym, constant(3, Expr::Int8));
+  queries[0].success = true;
+  queries[0].isValid = true;
+  queries[0].instructions = 1234;
+  queries[0].elapsedMicroseconds = 56;
+
+  queries[1] = queries[0];
+  queries[1].kind = LoggedQuery::Validity;
+  queries[1].expr = SltExpr::create(SExtExpr::create(sym, 32), x);
+  queries[1].validity = -1;
+
+  queries[2].kind = LoggedQuery::Value;
+  queries[2].constraints = queries[0].constraints;
+  queries[2].expr = ExtractExpr::create(wide, 4, 96);
+  queries[2].success = true;
+  queries[2].value = ConstantExpr::alloc(llvm::APInt(96, 42));
+
+  queries[3].kind = LoggedQuery::InitialValues;
+  queries[3].constraints = queries[0].constraints;
+  queries[3].expr = ConstantExpr::alloc(0, Expr::Bool);
+  queries[3].objects = {a};
+  queries[3].success = true;
+  queries[3].hasSolution = true;
+  queries[3].values = {{1, 2, 3, 4, 5, 6, 7, 8}};
+
+  // A tiny table size forces resets in between
+  for (unsigned tableSize : {1u << 20, 4u}) {
+    std::string log;
+    QueryLogWriter writer(log, tableSize);
+    for (const LoggedQuery &q : queries)
+      writer.write(q);
+
+    for (size_t chunkSize : {size_t(1), size_t(7), log.size()}) {
+      std::string error;
+      std::vector<LoggedQuery> read = readLog(log, chunkSize, ac, error);
+      EXPECT_EQ("", error);
+      ASSERT_EQ(queries.size(), read.size());
+      for (unsigned i = 0; i < queries.size(); ++i) {
+        EXPECT_EQ(queries[i].kind, read[i].kind);
+        ASSERT_EQ(queries[i].constraints.size(), read[i].constraints.size());
+        for (unsigned j = 0; j < queries[i].constraints.size(); ++j)
+          EXPECT_EQ(str(queries[i].constraints[j]),
+                    str(read[i].constraints[j]));
+        EXPECT_EQ(str(queries[i].expr), str(read[i].expr));
+        EXPECT_EQ(queries[i].success, read[i].success);
+        EXPECT_EQ(queries[i].instructions, read[i].instructions);
+        EXPECT_EQ(queries[i].elapsedMicroseconds,
+                  read[i].elapsedMicroseconds);
+      }
+      EXPECT_TRUE(read[0].isValid);
+      EXPECT_EQ(-1, read[1].validity);
+      EXPECT_EQ(queries[2].value, read[2].value);
+      ASSERT_EQ(1u, read[3].objects.size());
+      EXPECT_EQ("a", read[3].objects[0]->name);
+      EXPECT_EQ(queries[3].values, read[3].values);
+
+      // The constant array is restored with its contents
+      const Array *root =
+          cast<ReadExpr>(cast<EqExpr>(read[0].expr)->right)->updates.root;
+      ASSERT_TRUE(root->isConstantArray());
+      EXPECT_EQ(init[3], root->constantValues[3]);
+    }
+  }
+}
+
+TEST(QueryLogTest, SharedSubterms) {
+  ArrayCache ac;
+  const Array *a = ac.CreateArray("a", 4);
+  ref<Expr> x = Expr::createTempRead(a, Expr::Int32);
+  ref<Expr> e = x;
+  for (unsigned i = 0; i < 200; ++i)
+    e = AddExpr::create(MulExpr::create(e, e), constant(i, Expr::Int32));
+
+  LoggedQuery q;
+  q.constraints = {EqExpr::create(e, constant(0, Expr::Int32))};
+  q.expr = UltExpr::create(x, constant(5, Expr::Int32));
+
+  std::string log;
+  QueryLogWriter writer(log);
+  writer.write(q);
+  size_t first = log.size();
+  writer.write(q);
+
+  // The DAG is written once, in size linear in its number of nodes, and
+  // repeating the query only costs references to it.
+  EXPECT_LT(first, 200u * 16);
+  EXPECT_LT(log.size() - first, 16u);
+}
+
+TEST(QueryLogTest, Malformed) {
+  ArrayCache ac;
+  std::string error;
+  EXPECT_TRUE(readLog("KQUERY", 1, ac, error).empty());
+  EXPECT_EQ("not a binary query log", error);
+
+  LoggedQuery q;
+  q.expr = EqExpr::create(Expr::createTempRead(ac.CreateArray("a", 4), 32),
+                          constant(1, Expr::Int32));
+  std::string log;
+  QueryLogWriter writer(log);
+  writer.write(q);
+  writer.write(q);
+
+  EXPECT_EQ(2u, readLog(log, 3, ac, error).size());
+  EXPECT_EQ("", error);
+  log.pop_back();
+  EXPECT_EQ(1u, readLog(log, 3, ac, error).size());
+  EXPECT_EQ("unexpected end of query log", error);
+}
+} // namespace
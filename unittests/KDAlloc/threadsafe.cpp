@@ -0,0 +1,117 @@
+//===-- threadsafe.cpp ----------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/KDAlloc/kdalloc.h"
+#include "xoshiro.h"
+
+#if !KDALLOC_THREAD_SAFE
+#error "This test requires KDALLOC_THREAD_SAFE"
+#endif
+
+#if defined(USE_GTEST_INSTEAD_OF_MAIN)
+#include "gtest/gtest.h"
+#endif
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+/// Runs a random sequence of allocations and deallocations on its own copy of
+/// an allocator, forking off (and dropping) further copies along the way.
+/// Returns the addresses of all allocations in order.
+std::vector<void *> run(klee::kdalloc::Allocator const &base,
+                        std::uint64_t const seed) {
+  xoshiro512 rng(seed);
+  klee::kdalloc::Allocator allocator = base;
+  std::vector<klee::kdalloc::Allocator> forks;
+  std::vector<std::pair<void *, std::size_t>> allocations;
+  std::vector<void *> trace;
+
+  std::uniform_int_distribution<std::uint32_t> choice(0, 999);
+  std::uniform_int_distribution<std::size_t> smallSize(1, 4096);
+  std::uniform_int_distribution<std::size_t> largeSize(4097, 1 << 16);
+  for (std::size_t i = 0; i < 20'000; ++i) {
+    auto chosen = choice(rng);
+    if (chosen < 600) {
+      auto size = smallSize(rng);
+      allocations.emplace_back(allocator.allocate(size), size);
+      trace.emplace_back(allocations.back().first);
+    } else if (chosen < 650) {
+      auto size = largeSize(rng);
+      allocations.emplace_back(allocator.allocate(size), size);
+      trace.emplace_back(allocations.back().first);
+    } else if (chosen < 990) {
+      if (!allocations.empty()) {
+        auto victim = std::uniform_int_distribution<std::size_t>(
+            0, allocations.size() - 1)(rng);
+        allocator.free(allocations[victim].first, allocations[victim].second);
+        allocations[victim] = allocations.back();
+        allocations.pop_back();
+      }
+    } else if (chosen < 995) {
+      forks.emplace_back(allocator);
+    } else if (!forks.empty()) {
+      forks.pop_back();
+    }
+  }
+  return trace;
+}
+
+void thread_safe_test() {
+  static const std::size_t threads = 8;
+
+  auto base =
+      static_cast<klee::kdalloc::Allocator>(klee::kdalloc::AllocatorFactory(
+          static_cast<std::size_t>(1) << 32, 8));
+  // populate the shared state
+  std::vector<std::pair<void *, std::size_t>> allocations;
+  for (std::size_t size = 1; size < (1 << 16); size += size / 2 + 1) {
+    allocations.emplace_back(base.allocate(size), size);
+  }
+  for (std::size_t i = 0; i < allocations.size(); i += 2) {
+    base.free(allocations[i].first, allocations[i].second);
+  }
+
+  // every seed is explored by two threads concurrently
+  std::vector<std::vector<void *>> traces(threads);
+  std::vector<std::thread> workers;
+  for (std::size_t i = 0; i < threads; ++i) {
+    workers.emplace_back(
+        [&base, &traces, i]() { traces[i] = run(base, 0x31337 + i / 2); });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+
+  for (std::size_t i = 0; i < threads; ++i) {
+    auto expected = run(base, 0x31337 + i / 2);
+    if (traces[i] != expected) {
+      std::cerr << "thread " << i << " diverged from sequential run\n";
+      std::exit(1);
+    }
+  }
+
+  std::exit(0);
+}
+} // namespace
+
+#if defined(USE_GTEST_INSTEAD_OF_MAIN)
+TEST(KDAllocDeathTest, ThreadSafe) {
+  ASSERT_EXIT(thread_safe_test(), ::testing::ExitedWithCode(0), "");
+}
+#else
+int main() { thread_safe_test(); }
+#endif
@@ -0,0 +1,65 @@
+//===-- PersistentBitSetTest.cpp ------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/PersistentBitSet.h"
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+std::vector<std::uint32_t> toVector(const PersistentBitSet &s) {
+  return std::vector<std::uint32_t>(s.begin(), s.end());
+}
+
+TEST(PersistentBitSetTest, Insert) {
+  PersistentBitSet s;
+  std::set<std::uint32_t> expected;
+  EXPECT_TRUE(s.empty());
+  EXPECT_EQ(s.begin(), s.end());
+
+  for (std::uint32_t i : {5u, 0u, 63u, 64u, 1000u, 5u, 127u, 64u, 4096u}) {
+    EXPECT_EQ(expected.insert(i).second, s.insert(i));
+    EXPECT_TRUE(s.contains(i));
+    ASSERT_EQ(expected.size(), s.size());
+  }
+  EXPECT_FALSE(s.contains(1));
+  EXPECT_FALSE(s.contains(65));
+  EXPECT_FALSE(s.contains(100000));
+  EXPECT_EQ(std::vector<std::uint32_t>(expected.begin(), expected.end()),
+            toVector(s));
+
+  s.clear();
+  EXPECT_TRUE(s.empty());
+  EXPECT_EQ(0u, s.size());
+  EXPECT_FALSE(s.contains(5));
+}
+
+TEST(PersistentBitSetTest, CopiesAreIndependent) {
+  PersistentBitSet a;
+  for (std::uint32_t i = 0; i < 200; i += 3)
+    a.insert(i);
+
+  PersistentBitSet b = a;
+  EXPECT_TRUE(b.insert(1));
+  EXPECT_TRUE(a.insert(2));
+  b.clear();
+  EXPECT_TRUE(b.insert(7));
+
+  EXPECT_TRUE(a.contains(2));
+  EXPECT_FALSE(a.contains(1));
+  EXPECT_FALSE(a.contains(7));
+  EXPECT_EQ(68u, a.size());
+  EXPECT_EQ(std::vector<std::uint32_t>{7}, toVector(b));
+}
+} // namespace
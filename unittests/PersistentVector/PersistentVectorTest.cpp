@@ -0,0 +1,77 @@
+//===-- PersistentVectorTest.cpp ------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/PersistentVector.h"
+#include "gtest/gtest.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+template <class T, unsigned N>
+std::vector<T> toVector(const PersistentVector<T, N> &v) {
+  return std::vector<T>(v.begin(), v.end());
+}
+
+TEST(PersistentVectorTest, Append) {
+  PersistentVector<int, 4> v;
+  std::vector<int> expected;
+  EXPECT_TRUE(v.empty());
+  for (int i = 0; i < 37; ++i) {
+    v.push_back(i);
+    expected.push_back(i);
+    ASSERT_EQ(expected.size(), v.size());
+    EXPECT_EQ(i, v.back());
+  }
+  EXPECT_FALSE(v.empty());
+  EXPECT_EQ(expected, toVector(v));
+  for (unsigned i = 0; i < expected.size(); ++i)
+    EXPECT_EQ(expected[i], v[i]);
+
+  v.clear();
+  EXPECT_TRUE(v.empty());
+  EXPECT_EQ(0u, v.size());
+}
+
+TEST(PersistentVectorTest, CopiesAreIndependent) {
+  PersistentVector<int, 4> a;
+  for (int i = 0; i < 10; ++i)
+    a.push_back(i);
+
+  // Both copies append past the shared chunks
+  PersistentVector<int, 4> b = a;
+  EXPECT_EQ(a, b);
+  for (int i = 0; i < 10; ++i) {
+    a.push_back(100 + i);
+    b.emplace_back(200 + i);
+  }
+  PersistentVector<int, 4> c = b;
+  c.push_back(300);
+
+  ASSERT_EQ(20u, a.size());
+  ASSERT_EQ(20u, b.size());
+  ASSERT_EQ(21u, c.size());
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(i, a[i]);
+    EXPECT_EQ(i, b[i]);
+    EXPECT_EQ(100 + i, a[10 + i]);
+    EXPECT_EQ(200 + i, b[10 + i]);
+    EXPECT_EQ(200 + i, c[10 + i]);
+  }
+  EXPECT_EQ(300, c.back());
+  EXPECT_NE(a, b);
+  EXPECT_NE(b, c);
+
+  // Equal contents in distinct chunks
+  PersistentVector<int, 4> d(b.begin(), b.end());
+  EXPECT_EQ(b, d);
+}
+} // namespace
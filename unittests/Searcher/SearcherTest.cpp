@@ -118,9 +118,9 @@ TEST(SearcherTest, TwoRandomPath) {
 
 TEST(SearcherTest, TwoRandomPathDot) {
   std::stringstream modelExecutionTreeDot;
-  ExecutionTreeNode *rootExecutionTreeNode, *rightLeafExecutionTreeNode,
-      *esParentExecutionTreeNode, *es1LeafExecutionTreeNode,
-      *esLeafExecutionTreeNode;
+  ExecutionTreeNodeIndex rootExecutionTreeNode, rightLeafExecutionTreeNode,
+      esParentExecutionTreeNode, es1LeafExecutionTreeNode,
+      esLeafExecutionTreeNode;
 
   // Root state
   ExecutionState root;
@@ -201,6 +201,35 @@ TEST(SearcherTest, TwoRandomPathDot) {
   executionTree.remove(root.executionTreeNode);
 }
 
+TEST(SearcherTest, RandomPathSingleChildChain) {
+  // A state that keeps forking off states that terminate right away leaves
+  // a chain of nodes with a single child, which is removed before the
+  // execution tree grows by another slab
+  ExecutionState es;
+  InMemoryExecutionTree executionTree(es);
+
+  RNG rng;
+  RandomPathSearcher rp(&executionTree, rng);
+  rp.update(nullptr, {&es}, {});
+
+  ExecutionState es1(es);
+  for (int i = 0; i < 5000; ++i) {
+    executionTree.attach(es.executionTreeNode, &es1, &es, BranchType::NONE);
+    executionTree.remove(es1.executionTreeNode);
+  }
+  EXPECT_EQ(&rp.selectState(), &es);
+
+  std::string executionTreeDot;
+  llvm::raw_string_ostream executionTreeDotStream(executionTreeDot);
+  executionTree.dump(executionTreeDotStream);
+  llvm::StringRef dot(executionTreeDotStream.str());
+  // Without compression, the chain alone would have 5000 nodes
+  EXPECT_LT(dot.count("shape=diamond"), 4096U);
+
+  rp.update(&es, {}, {&es});
+  executionTree.remove(es.executionTreeNode);
+}
+
 TEST(SearcherDeathTest, TooManyRandomPaths) {
   // First state
   ExecutionState es;
@@ -0,0 +1,168 @@
+//===-- SetIndexTest.cpp --------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/ADT/SetIndex.h"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+typedef std::set<int> Set;
+
+bool any(int) { return true; }
+
+TEST(SetIndexTest, Lookup) {
+  SetIndex<int, int> index;
+  index.insert({1, 2, 3}, 10);
+  index.insert({}, 20);
+  index.insert({2}, 30);
+
+  EXPECT_EQ(3u, index.size());
+  ASSERT_NE(nullptr, index.lookup({1, 2, 3}));
+  EXPECT_EQ(10, *index.lookup({1, 2, 3}));
+  EXPECT_EQ(20, *index.lookup({}));
+  EXPECT_EQ(nullptr, index.lookup({1, 2}));
+  EXPECT_EQ(nullptr, index.lookup({1, 2, 3, 4}));
+
+  std::vector<int> replaced;
+  index.insert({2}, 40, &replaced);
+  EXPECT_EQ(std::vector<int>{30}, replaced);
+  EXPECT_EQ(40, *index.lookup({2}));
+  EXPECT_EQ(3u, index.size());
+}
+
+TEST(SetIndexTest, SubsetAndSuperset) {
+  SetIndex<int, int> index;
+  index.insert({1, 2, 3}, 1);
+  index.insert({3, 4}, 2);
+
+  EXPECT_EQ(1, *index.findSuperset({1, 3}, any));
+  EXPECT_EQ(2, *index.findSuperset({4}, any));
+  EXPECT_EQ(nullptr, index.findSuperset({1, 4}, any));
+  EXPECT_EQ(nullptr, index.findSuperset({5}, any));
+  EXPECT_NE(nullptr, index.findSuperset({}, any));
+
+  EXPECT_EQ(2, *index.findSubset({3, 4, 5}, any));
+  EXPECT_EQ(nullptr, index.findSubset({1, 2, 4}, any));
+  EXPECT_EQ(nullptr, index.findSubset({1, 2, 3, 4},
+                                      [](int v) { return v == 3; }));
+  index.insert({}, 3);
+  EXPECT_EQ(3, *index.findSubset({1, 2, 3, 4}, [](int v) { return v == 3; }));
+  EXPECT_EQ(3, *index.findSubset({7}, any));
+}
+
+TEST(SetIndexTest, MatchesBruteForce) {
+  std::mt19937 rng(42);
+  std::vector<Set> sets;
+  SetIndex<int, unsigned> index;
+  for (unsigned i = 0; i < 500; ++i) {
+    Set s;
+    for (unsigned n = rng() % 6; n; --n)
+      s.insert(rng() % 40);
+    if (index.lookup(s))
+      continue;
+    index.insert(s, sets.size());
+    sets.push_back(s);
+  }
+
+  for (unsigned i = 0; i < 2000; ++i) {
+    Set q;
+    for (unsigned n = rng() % 8; n; --n)
+      q.insert(rng() % 45);
+    bool odd = rng() % 2;
+    auto p = [&](unsigned v) { return v % 2 == odd; };
+
+    bool hasSubset = false, hasSuperset = false;
+    for (unsigned v = 0; v < sets.size(); ++v) {
+      if (!p(v))
+        continue;
+      const Set &s = sets[v];
+      hasSubset |= std::includes(q.begin(), q.end(), s.begin(), s.end());
+      hasSuperset |= std::includes(s.begin(), s.end(), q.begin(), q.end());
+    }
+
+    unsigned *subset = index.findSubset(q, p);
+    ASSERT_EQ(hasSubset, subset != nullptr);
+    if (subset)
+      EXPECT_TRUE(std::includes(q.begin(), q.end(), sets[*subset].begin(),
+                                sets[*subset].end()));
+    unsigned *superset = index.findSuperset(q, p);
+    ASSERT_EQ(hasSuperset, superset != nullptr);
+    if (superset)
+      EXPECT_TRUE(std::includes(sets[*superset].begin(),
+                                sets[*superset].end(), q.begin(), q.end()));
+  }
+}
+
+TEST(SetIndexTest, Eviction) {
+  SetIndex<int, int> index(2);
+  std::vector<int> evicted;
+  EXPECT_EQ(0u, index.insert({1}, 1, &evicted));
+  EXPECT_EQ(0u, index.insert({1, 2}, 2, &evicted));
+  EXPECT_TRUE(evicted.empty());
+
+  // Using {1} makes {1, 2} the least recently used set
+  EXPECT_EQ(1, *index.findSubset({1, 5}, any));
+  EXPECT_EQ(1u, index.insert({3}, 3, &evicted));
+  EXPECT_EQ(std::vector<int>{2}, evicted);
+  EXPECT_EQ(2u, index.size());
+  EXPECT_EQ(nullptr, index.lookup({1, 2}));
+  EXPECT_EQ(nullptr, index.findSuperset({2}, any));
+
+  index.insert({4}, 4, &evicted);
+  EXPECT_EQ((std::vector<int>{2, 1}), evicted);
+  EXPECT_EQ(nullptr, index.findSubset({1, 2}, any));
+  EXPECT_EQ(3, *index.lookup({3}));
+  EXPECT_EQ(4, *index.lookup({4}));
+
+  std::vector<int> values;
+  index.forEach([&](int v) { values.push_back(v); });
+  EXPECT_EQ((std::vector<int>{4, 3}), values);
+
+  // Replacing a value hands back the old one, but evicts nothing
+  evicted.clear();
+  EXPECT_EQ(0u, index.insert({3}, 5, &evicted));
+  EXPECT_EQ(std::vector<int>{3}, evicted);
+  EXPECT_EQ(5, *index.lookup({3}));
+  EXPECT_EQ(2u, index.size());
+
+  index.clear();
+  EXPECT_EQ(0u, index.size());
+  EXPECT_EQ(nullptr, index.lookup({3}));
+}
+
+TEST(SetIndexTest, RemoveFromSharedElements) {
+  // Sets sharing elements are evicted in an order different from the one
+  // they were added to the posting lists in
+  SetIndex<int, int> index(3);
+  index.insert({1, 2, 3}, 1);
+  index.insert({1, 2}, 2);
+  index.insert({2, 3}, 3);
+  EXPECT_EQ(2, *index.lookup({1, 2}));
+  index.insert({1, 3}, 4);
+  EXPECT_EQ(nullptr, index.lookup({1, 2, 3}));
+  index.insert({1}, 5);
+  EXPECT_EQ(nullptr, index.lookup({2, 3}));
+
+  EXPECT_EQ(2, *index.findSuperset({2}, any));
+  EXPECT_EQ(nullptr, index.findSuperset({2, 3}, any));
+  EXPECT_EQ(4, *index.findSuperset({3}, any));
+  EXPECT_EQ(5, *index.findSubset({1, 7}, any));
+  index.insert({2}, 6);
+  EXPECT_EQ(nullptr, index.lookup({1, 2}));
+  EXPECT_EQ(6, *index.findSuperset({2}, any));
+  EXPECT_EQ(4, *index.findSuperset({1, 3}, any));
+}
+} // namespace
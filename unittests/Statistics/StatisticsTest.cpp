@@ -0,0 +1,60 @@
+//===-- StatisticsTest.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Statistics/Statistics.h"
+#include "gtest/gtest.h"
+
+using namespace klee;
+
+namespace {
+
+Statistic indexed("TestIndexed", "TI");
+Statistic global("TestGlobal", "TG");
+
+TEST(StatisticsTest, IndexedValuesWiden) {
+  for (bool sparse : {false, true}) {
+    IndexedStatistic s(8, sparse);
+    EXPECT_EQ(0u, s.getValue(3));
+
+    s.incrementValue(3, 5);
+    s.incrementValue(3, 0xfffffff0ULL);
+    EXPECT_EQ(0xfffffff5ULL, s.getValue(3));
+    s.incrementValue(3, 0x10);
+    EXPECT_EQ(0x100000005ULL, s.getValue(3));
+
+    // Decrements wrap around as for plain 64-bit counters
+    s.incrementValue(3, (uint64_t)-6);
+    EXPECT_EQ(0xffffffffULL, s.getValue(3));
+    s.setValue(3, 7);
+    s.incrementValue(3, (uint64_t)-7);
+    EXPECT_EQ(0u, s.getValue(3));
+    s.incrementValue(3, (uint64_t)-1);
+    EXPECT_EQ(~0ULL, s.getValue(3));
+
+    s.setValue(5, 42);
+    EXPECT_EQ(42u, s.getValue(5));
+    EXPECT_EQ(0u, s.getValue(4));
+  }
+}
+
+TEST(StatisticsTest, OnlyIndexedStatisticsHaveIndexedValues) {
+  StatisticManager &sm = *theStatisticManager;
+  sm.useIndexedStats(4);
+  sm.indexStatistic(indexed);
+
+  sm.setIndex(2);
+  indexed += 3;
+  global += 4;
+  EXPECT_EQ(3u, sm.getIndexedValue(indexed, 2));
+  EXPECT_EQ(0u, sm.getIndexedValue(indexed, 1));
+  EXPECT_EQ(0u, sm.getIndexedValue(global, 2));
+  EXPECT_EQ(3u, indexed.getValue());
+  EXPECT_EQ(4u, global.getValue());
+}
+} // namespace